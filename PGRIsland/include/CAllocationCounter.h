@@ -0,0 +1,32 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CAllocationCounter.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class counting heap allocations
+ *
+ * Counts calls of the global operator new on the calling thread
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Counter of heap allocations
+ *
+ * the global operator new is replaced by one that counts its calls before allocating
+ * with malloc, every thread has its own count, so the worker threads do not show up
+ * in the render thread's numbers
+ */
+class CAllocationCounter
+{
+public:
+	/**
+	 * Getter of the number of allocations
+	 *
+	 * \return number of allocations made by the calling thread since it started
+	 */
+	static size_t GetAllocations();
+};
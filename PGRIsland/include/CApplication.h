@@ -16,31 +16,47 @@
 #include "CGameState.h"
 
 #include "CCatmulRomSpline.h"
+#include "CHeadlessContext.h"
 
 /** 
  * Display function callback for GLUT's glutDisplayFunc
  * 
- * clears color, depth and stencil buffer so 
- * draws each object to screen and also writes an identifier of 
- * drawn object for mouse picking purposes
+ * draws a frame between the last two simulation steps and swaps the buffers
  */
 void Draw();
 
 /** 
- * Timer function callback for GLUT's glutTimerFunc
+ * Frame drawing function
+ * 
+ * clears color, depth and stencil buffer of the bound framebuffer so 
+ * draws each object to it and also writes an identifier of 
+ * drawn object for mouse picking purposes
+ * 
+ * \param interpolation - fraction of the last simulation step to draw, 1 draws the simulated state
+ */
+void DrawFrame(const float& interpolation);
+
+/** 
+ * Idle function callback for GLUT's glutIdleFunc
+ * 
+ * calculates current frame time from a monotonic clock, runs the fixed
+ * simulation steps the elapsed time covers and redisplays content of screen,
+ * so the frame rate is not capped and does not change the simulation
+ */
+void Idle();
+
+/** 
+ * Simulation step
  * 
- * calculates current frame time and time delta for fluid animations
  * updates each objects time member variable
  * 
  * Checks key map if any key is pressed. If yes, make an corresponding action.
  * 
  * If current scene view is set to flight or boat ride, set player's position.
  * 
- * Calls Timer function using glutTimerFunc and redisplays content of screen.
- * 
- * \param int value - integer passed by GLUT's glutTimerFunc
+ * \param delta - length of the step in seconds, always SIMULATION_STEP
  */
-void Timer(int value);
+void Step(const float& delta);
 
 /** 
  * Windows reshape function for GLUT's glutReshapeFunc
@@ -168,8 +184,18 @@ private:
 	 * OpenGL and game content initialize  function 
 	 * 
 	 * initilizes OpenGL and game content
+	 * 
+	 * \param  width - width of the drawn framebuffer
+	 * \param height - height of the drawn framebuffer
+	 */
+	void ApplicationInit(const int& width, const int& height);
+
+	/** 
+	 * Game content deinitialize function
+	 * 
+	 * destroys OpenGL objects of the scene while the context is current
 	 */
-	void ApplicationInit();
+	void ApplicationDestroy();
 public:
 	/** 
 	 * Window initilize function
@@ -182,5 +208,21 @@ public:
 	 * \return zero on success and non-zero on failure
 	 */
 	int WindowInit(int argc, char* argv[]);
+
+	/** 
+	 * Headless run function
+	 * 
+	 * creates an offscreen context without a window, renders into a framebuffer object,
+	 * waits for the streamed scene and replays the flight view along CAMERA_CONTROL_POINTS,
+	 * every frame is one simulation step, so every run draws the same frames
+	 * 
+	 * frame times are measured until the GPU finished the frame, the statistics
+	 * are printed and the time of every frame is written as CSV
+	 * 
+	 * \param argc - number of arguments starting with HEADLESS_SWITCH
+	 * \param argv - HEADLESS_SWITCH [frames] [output], HEADLESS_FRAMES and HEADLESS_OUTPUT if missing
+	 * \return zero on success and non-zero on failure
+	 */
+	int HeadlessInit(int argc, char* argv[]);
 };
 
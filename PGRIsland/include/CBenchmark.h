@@ -0,0 +1,169 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CBenchmark.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class running benchmarks from the command line
+ *
+ * Measures parts of the application that do not need a window
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "pgr.h"
+
+/**
+ * Benchmark class
+ *
+ * runs a benchmark selected by the first argument after BENCHMARK_SWITCH,
+ * results are printed to the standard output
+ *
+ * benchmarks:
+ *   mesh-cache [model...] - ASSIMP import compared to loading the mesh cache
+ *   water [side]          - buffered water grid compared to the procedural one and the clipmap
+ *   fft [resolution...]   - ocean FFT with every supported instruction set, single and multithreaded
+ *   transforms [count...] - recursive scene node transforms compared to the transform system
+ *   model-matrix [count]  - inverse of lookAt compared to the closed form model matrix, scalar and SSE
+ *   hierarchy [count...]  - bounding volume hierarchy queries compared to linear scans, refit and reinsertion
+ *   instancing [count...] - draw calls and per-frame CPU work of a school of fish drawn one by one and instanced
+ *   arena [model...]      - draw calls of the models without and with batches, usage and fragmentation of the geometry arena
+ *   timestep [render ms...] - frame times and camera motion of the timer driven loop compared to the fixed timestep
+ *
+ * \see HConstants.h
+ */
+class CBenchmark
+{
+private:
+	/**
+	 * Mesh cache benchmark
+	 *
+	 * measures ASSIMP import and cooking of a model against mapping
+	 * and reading its mesh cache, the cache is written during the benchmark
+	 *
+	 * \param arguments - paths to the models, all models of the scene if empty
+	 *
+	 * \return zero on success and non-zero on failure
+	 */
+	int MeshCacheBenchmark(const std::vector<std::string>& arguments);
+
+	/**
+	 * Water grid benchmark
+	 *
+	 * measures building the buffered water grid on the CPU and the memory it needs
+	 * before the upload, the procedural grid needs neither, then compares triangles
+	 * and vertex shader invocations per frame of the uniform grid and the clipmap
+	 *
+	 * \param arguments - number of vertices on one side, WATER_PLANE_SIDE_SIZE if empty
+	 *
+	 * \return zero on success and non-zero on failure
+	 */
+	int WaterBenchmark(const std::vector<std::string>& arguments);
+
+	/**
+	 * Ocean FFT benchmark
+	 *
+	 * measures a single threaded 2D FFT of the given size with every supported
+	 * instruction set and a whole ocean step on one thread and on a thread pool
+	 *
+	 * \param arguments - numbers of samples on one side, OCEAN_BENCHMARK_RESOLUTIONS if empty
+	 *
+	 * \return zero on success and non-zero on failure
+	 */
+	int FourierBenchmark(const std::vector<std::string>& arguments);
+
+	/**
+	 * Transform benchmark
+	 *
+	 * moves a fraction of the nodes of a tree and reads every model matrix,
+	 * once with the nodes overwriting their subtrees and rebuilding every matrix
+	 * like the scene nodes used to, once with CTransformSystem updating only the moved subtrees
+	 *
+	 * \param arguments - numbers of nodes, TRANSFORM_BENCHMARK_COUNTS if empty
+	 *
+	 * \return zero on success and non-zero on failure
+	 */
+	int TransformBenchmark(const std::vector<std::string>& arguments);
+
+	/**
+	 * Model matrix benchmark
+	 *
+	 * measures the cost per node of inverse(lookAt) * scale, of the closed form
+	 * and of the closed form in SSE batches, compares their errors against a reference
+	 * computed in double precision and checks the batches are bit identical to the closed form
+	 *
+	 * \param arguments - number of nodes, MODEL_MATRIX_BENCHMARK_NODES if empty
+	 *
+	 * \return zero on success, non-zero on failure or an error over MODEL_MATRIX_TOLERANCE_ULPS
+	 */
+	int ModelMatrixBenchmark(const std::vector<std::string>& arguments);
+
+	/**
+	 * Bounding volume hierarchy benchmark
+	 *
+	 * builds a hierarchy of random boxes, moves a fraction of them once refitting
+	 * and once reinserting them, and measures frustum, sphere and ray queries against
+	 * linear scans of the boxes, every query has to return the same objects as the scan
+	 *
+	 * \param arguments - numbers of objects, HIERARCHY_BENCHMARK_COUNTS if empty
+	 *
+	 * \return zero on success, non-zero on failure or a query differing from the scan
+	 */
+	int HierarchyBenchmark(const std::vector<std::string>& arguments);
+
+	/**
+	 * Instancing benchmark
+	 *
+	 * moves a school of fish along the fish splines like CSplineSceneNode and measures
+	 * building their model matrices and gathering them into the instance stream,
+	 * the draw calls of both ways follow from the index segments of the fish mesh,
+	 * OpenGL's side is measured in the running scene with FISH_SCHOOL_SWITCH
+	 *
+	 * \param arguments - numbers of fish, INSTANCING_BENCHMARK_COUNTS if empty
+	 *
+	 * \return zero on success and non-zero on failure
+	 */
+	int InstancingBenchmark(const std::vector<std::string>& arguments);
+
+	/**
+	 * Geometry arena benchmark
+	 *
+	 * counts draw calls of the models' meshes drawn one by one and in batches,
+	 * places the meshes of all models into the pages of the arena, then frees and
+	 * places again a fraction of them in random order for a number of rounds
+	 * and reports usage and fragmentation of the pages after loading and after the churn,
+	 * OpenGL's side is reported by the running scene
+	 *
+	 * \param arguments - paths to the models, all models of the scene if empty
+	 *
+	 * \return zero on success and non-zero on failure
+	 */
+	int ArenaBenchmark(const std::vector<std::string>& arguments);
+
+	/**
+	 * Timestep benchmark
+	 *
+	 * simulates the loop driven by glutTimerFunc and the loop with the fixed timestep
+	 * over the same jittered render times and compares the shown frames, their
+	 * times and how evenly and how fast a moving camera appears to move in them,
+	 * no frame is drawn, the running scene prints its frame times itself
+	 *
+	 * \param arguments - mean render times of a frame in milliseconds, TIMESTEP_BENCHMARK_RENDER_TIMES if empty
+	 *
+	 * \return zero on success and non-zero on failure
+	 */
+	int TimestepBenchmark(const std::vector<std::string>& arguments);
+public:
+	/**
+	 * Runs a benchmark
+	 *
+	 * \param argc - number of arguments following BENCHMARK_SWITCH
+	 * \param argv - arguments following BENCHMARK_SWITCH, first one is the benchmark name
+	 *
+	 * \return zero on success and non-zero on failure
+	 */
+	int Run(int argc, char* argv[]);
+};
@@ -20,6 +20,20 @@
  */
 class CBillboardSceneNode : public CSceneNode
 {
+protected:
+    /**
+     * Help method setting the node's bounding box from its mesh
+     * 
+     * the mesh turns around the node's origin, so the box covers it in every rotation
+     */
+    void UpdateBounds() override;
+
+    /**
+     * Help method checking whether the node's mesh can be drawn by a draw shared with other nodes
+     * 
+     * \return false, the model matrix turns the mesh to the camera
+     */
+    bool IsBatchable() const override;
 public:
     /**
      * Constructor for a billboard
@@ -32,7 +46,9 @@ public:
      * Draw function
      * 
      * handles drawing the object so that it faces the camera 
+     * 
+     * \param state - state the binds go through
      */
-    void Draw() override;
+    void DrawMesh(CRenderState& state) override;
 };
 
@@ -0,0 +1,288 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CBoundingVolumeHierarchy.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class representing a dynamic bounding volume hierarchy
+ *
+ * Keeps axis aligned boxes of objects in a balanced binary tree for fast spatial queries
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+
+#include "pgr.h"
+
+#include "CFrustum.h"
+
+/**
+ * Node of the hierarchy
+ */
+struct CHierarchyNode
+{
+	/**
+	 * Corners of the node's box, enlarged by the margin for leaves
+	 */
+	glm::vec3 MMinimum;
+	glm::vec3 MMaximum;
+
+	/**
+	 * Corners of the object's own box, used only by leaves
+	 */
+	glm::vec3 MObjectMinimum;
+	glm::vec3 MObjectMaximum;
+
+	/**
+	 * Parent of the node, -1 for the root, next free node for free nodes
+	 */
+	int MParent;
+
+	/**
+	 * Children of the node, -1 for leaves
+	 */
+	int MChildren[2];
+
+	/**
+	 * Height of the node's subtree, 0 for leaves, -1 for free nodes
+	 */
+	int MHeight;
+
+	/**
+	 * Object of a leaf
+	 */
+	int MObject;
+};
+
+/**
+ * Dynamic bounding volume hierarchy
+ *
+ * every object is a leaf holding its box enlarged by a margin, so objects
+ * moving inside the enlarged box keep their place in the tree, a leaf is inserted
+ * next to the sibling giving the smallest surface area and the tree is kept
+ * balanced by rotations on the way up
+ *
+ * moved objects are either reinserted one by one through Move or their boxes
+ * are replaced in place through SetBox and all ancestors are refitted at once
+ * through Refit, which is cheaper for many moves but keeps the old structure
+ *
+ * queries test the enlarged boxes while descending and the objects' own boxes at the leaves,
+ * so they return exactly the objects a linear scan of the boxes would return
+ */
+class CBoundingVolumeHierarchy
+{
+private:
+	/**
+	 * All nodes, free ones are linked through MParent
+	 */
+	std::vector<CHierarchyNode> MNodes;
+
+	/**
+	 * Root node, -1 for an empty hierarchy
+	 */
+	int MRoot = -1;
+
+	/**
+	 * First free node, -1 if all nodes are used
+	 */
+	int MFreeNode = -1;
+
+	/**
+	 * Number of leaves
+	 */
+	int MLeafCount = 0;
+
+	/**
+	 * Enlargement of the leaves' boxes on every side
+	 */
+	float MMargin = 0.0f;
+
+	/**
+	 * Leaves whose boxes were replaced since the last refit
+	 */
+	std::vector<int> MRefit;
+
+	/**
+	 * Help method taking a node from the free ones
+	 *
+	 * \return index of the node
+	 */
+	int AllocateNode();
+
+	/**
+	 * Help method giving a node back to the free ones
+	 *
+	 * \param node - index of the node
+	 */
+	void FreeNode(const int& node);
+
+	/**
+	 * Help method linking a leaf into the tree
+	 *
+	 * \param leaf - index of the leaf
+	 */
+	void InsertLeaf(const int& leaf);
+
+	/**
+	 * Help method unlinking a leaf from the tree, the leaf stays allocated
+	 *
+	 * \param leaf - index of the leaf
+	 */
+	void RemoveLeaf(const int& leaf);
+
+	/**
+	 * Help method balancing a subtree by one rotation
+	 *
+	 * \param node - root of the subtree
+	 *
+	 * \return new root of the subtree
+	 */
+	int Balance(const int& node);
+
+	/**
+	 * Help method recomputing the boxes and heights of a node and its ancestors
+	 *
+	 * \param node - first node to be recomputed
+	 */
+	void FixUpwards(int node);
+
+	/**
+	 * Help method collecting all objects of a subtree
+	 *
+	 * \param    node - root of the subtree
+	 * \param objects - objects, new ones are appended
+	 */
+	void CollectObjects(const int& node, std::vector<int>& objects) const;
+public:
+	/**
+	 * Constructor of a hierarchy
+	 *
+	 * \param margin - enlargement of the leaves' boxes on every side
+	 */
+	CBoundingVolumeHierarchy(const float& margin = 0.0f);
+
+	/**
+	 * Inserts an object
+	 *
+	 * \param minimum - minimal corner of the object's box
+	 * \param maximum - maximal corner of the object's box
+	 * \param  object - object returned by the queries
+	 *
+	 * \return leaf of the object
+	 */
+	int Insert(const glm::vec3& minimum, const glm::vec3& maximum, const int& object);
+
+	/**
+	 * Removes an object
+	 *
+	 * \param leaf - leaf of the object
+	 */
+	void Remove(const int& leaf);
+
+	/**
+	 * Moves an object
+	 *
+	 * the object is reinserted only if its box leaves the enlarged box of its leaf
+	 *
+	 * \param    leaf - leaf of the object
+	 * \param minimum - minimal corner of the object's new box
+	 * \param maximum - maximal corner of the object's new box
+	 *
+	 * \return true if the object was reinserted else false
+	 */
+	bool Move(const int& leaf, const glm::vec3& minimum, const glm::vec3& maximum);
+
+	/**
+	 * Replaces an object's box without changing the tree
+	 *
+	 * ancestors of the leaf are stale until the next Refit
+	 *
+	 * \param    leaf - leaf of the object
+	 * \param minimum - minimal corner of the object's new box
+	 * \param maximum - maximal corner of the object's new box
+	 */
+	void SetBox(const int& leaf, const glm::vec3& minimum, const glm::vec3& maximum);
+
+	/**
+	 * Refits ancestors of all leaves changed by SetBox
+	 *
+	 * walks up from every changed leaf until a box stays the same
+	 */
+	void Refit();
+
+	/**
+	 * Removes all objects
+	 */
+	void Clear();
+
+	/**
+	 * Collects objects whose boxes intersect a frustum
+	 *
+	 * a subtree inside the frustum is collected without further tests
+	 *
+	 * \param frustum - tested frustum
+	 * \param objects - objects, new ones are appended
+	 */
+	void QueryFrustum(const CFrustum& frustum, std::vector<int>& objects) const;
+
+	/**
+	 * Collects objects whose boxes overlap a sphere
+	 *
+	 * \param  center - center of the sphere
+	 * \param  radius - radius of the sphere
+	 * \param objects - objects, new ones are appended
+	 */
+	void QuerySphere(const glm::vec3& center, const float& radius, std::vector<int>& objects) const;
+
+	/**
+	 * Collects objects whose boxes are hit by a ray
+	 *
+	 * \param    origin - origin of the ray
+	 * \param direction - direction of the ray, distances are in its multiples
+	 * \param  distance - largest distance of a hit
+	 * \param   objects - objects ordered from the nearest hit, new ones are appended
+	 */
+	void QueryRay(const glm::vec3& origin, const glm::vec3& direction, const float& distance, std::vector<int>& objects) const;
+
+	/**
+	 * Getter of the number of objects
+	 *
+	 * \return number of leaves
+	 */
+	int GetLeafCount() const;
+
+	/**
+	 * Getter of the height of the tree
+	 *
+	 * \return height of the root, 0 for a single leaf and -1 for an empty hierarchy
+	 */
+	int GetHeight() const;
+
+	/**
+	 * Tests a box against a sphere
+	 *
+	 * \param minimum - minimal corner of the box
+	 * \param maximum - maximal corner of the box
+	 * \param  center - center of the sphere
+	 * \param  radius - radius of the sphere
+	 *
+	 * \return true if they overlap else false
+	 */
+	static bool IsBoxInSphere(const glm::vec3& minimum, const glm::vec3& maximum, const glm::vec3& center, const float& radius);
+
+	/**
+	 * Tests a box against a ray
+	 *
+	 * \param   minimum - minimal corner of the box
+	 * \param   maximum - maximal corner of the box
+	 * \param    origin - origin of the ray
+	 * \param   inverse - inverse of the ray's direction
+	 * \param  distance - largest distance of a hit
+	 * \param       hit - distance where the ray enters the box, zero if it starts inside
+	 *
+	 * \return true if the ray hits the box else false
+	 */
+	static bool IsBoxOnRay(const glm::vec3& minimum, const glm::vec3& maximum, const glm::vec3& origin,
+		const glm::vec3& inverse, const float& distance, float& hit);
+};
@@ -104,5 +104,19 @@ struct CCamera
 	 * \param angle - tilting angle
 	 */
 	void Tilt(float angle);
+
+	/**
+	 * Blends two cameras
+	 * 
+	 * the positions are blended linearly, the directions and up vectors
+	 * are blended and normalized
+	 * 
+	 * \param          from - camera before the simulation step
+	 * \param            to - camera after the simulation step
+	 * \param interpolation - fraction of the step, 0 gives from and 1 gives to
+	 * 
+	 * \return camera the frame is drawn from
+	 */
+	static CCamera Interpolate(const CCamera& from, const CCamera& to, const float& interpolation);
 };
 
@@ -0,0 +1,209 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CCookedTexture.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class representing a cooked texture container
+ *
+ * Holds pre-built mipmap levels of an image, optionally block compressed,
+ * the container is memory mapped so levels are uploaded without decoding
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pgr.h"
+
+#include "CMappedFile.h"
+
+/**
+ * Cooked texture container
+ *
+ * the container is written by CTextureCooker next to the source image,
+ * it is valid only for the same version and source file content
+ *
+ * \see CTextureCooker
+ */
+class CCookedTexture
+{
+public:
+	/**
+	 * Version of the container format, increase whenever the layout changes
+	 */
+	static const uint32_t VERSION = 1;
+
+	/**
+	 * Pixel formats of the levels
+	 */
+	enum EFormat
+	{
+		FORMAT_RGBA8 = 0,
+		FORMAT_BC1 = 1,
+		FORMAT_BC3 = 2,
+		FORMAT_BC7 = 3,
+		FORMAT_COUNT
+	};
+
+	/**
+	 * Level of the container
+	 */
+	struct CLevel
+	{
+		uint32_t MWidth;
+		uint32_t MHeight;
+		uint64_t MOffset;
+		uint64_t MSize;
+	};
+
+	/**
+	 * Default constructor
+	 *
+	 * represents an empty container
+	 */
+	CCookedTexture() = default;
+
+	CCookedTexture(const CCookedTexture&) = delete;
+	CCookedTexture& operator=(const CCookedTexture&) = delete;
+
+	/**
+	 * Getter of the container file path
+	 *
+	 * \param file - path to the source image
+	 *
+	 * \return path of the container belonging to the image
+	 */
+	static std::string GetCookedPath(const std::string& file);
+
+	/**
+	 * Computes size of a level
+	 *
+	 * \param format - pixel format
+	 * \param  width - width of the level
+	 * \param height - height of the level
+	 *
+	 * \return size in bytes
+	 */
+	static uint64_t ComputeLevelSize(const EFormat& format, const uint32_t& width, const uint32_t& height);
+
+	/**
+	 * Getter of the format name
+	 *
+	 * \param format - pixel format
+	 *
+	 * \return readable name of the format
+	 */
+	static const char* GetFormatName(const EFormat& format);
+
+	/**
+	 * Maps the container of an image
+	 *
+	 * does not touch OpenGL, so it can run on any thread
+	 *
+	 * \param file - path to the source image
+	 *
+	 * \return true if a valid up to date container was mapped else false
+	 */
+	bool Load(const std::string& file);
+
+	/**
+	 * Writes a container
+	 *
+	 * \param              file - path to the source image
+	 * \param            format - pixel format of the levels
+	 * \param sourceComponents - number of bytes per pixel of the source image
+	 * \param            levels - sizes of the levels, offsets are assigned while writing
+	 * \param              data - content of the levels in the same order
+	 *
+	 * \return true if the container was written else false
+	 */
+	static bool Save(const std::string& file, const EFormat& format, const uint32_t& sourceComponents,
+		std::vector<CLevel> levels, const std::vector<std::vector<unsigned char>>& data);
+
+	/**
+	 * Getter whether the current OpenGL context can sample the container's format
+	 *
+	 * must be called on the OpenGL thread
+	 *
+	 * \return true if supported else false
+	 */
+	bool IsSupported() const;
+
+	/**
+	 * Uploads all levels to the bound texture target
+	 *
+	 * \param target - OpenGL target of the bound texture or a cubemap face
+	 * \param levels - maximal number of uploaded levels
+	 *
+	 * \return uploaded bytes
+	 */
+	size_t Upload(const GLenum& target, const uint32_t& levels) const;
+
+	/**
+	 * Getter of the pixel format
+	 *
+	 * \return pixel format of the levels
+	 */
+	EFormat GetFormat() const;
+
+	/**
+	 * Getter of the number of levels
+	 *
+	 * \return number of levels
+	 */
+	uint32_t GetLevelCount() const;
+
+	/**
+	 * Getter of a level
+	 *
+	 * \param level - index of the level
+	 *
+	 * \return level description
+	 */
+	const CLevel& GetLevel(const uint32_t& level) const;
+
+	/**
+	 * Getter of the number of bytes per pixel of the source image
+	 *
+	 * \return number of bytes per pixel
+	 */
+	uint32_t GetSourceComponents() const;
+private:
+	/**
+	 * Header at the start of every container
+	 */
+	struct CHeader
+	{
+		char MMagic[4];
+		uint32_t MVersion;
+		uint32_t MFormat;
+		uint32_t MLevelCount;
+		uint32_t MSourceComponents;
+		uint32_t MReserved;
+		uint64_t MSourceHash;
+		uint64_t MSourceSize;
+	};
+
+	/**
+	 * Mapped container
+	 */
+	CMappedFile MFile;
+
+	/**
+	 * Pixel format of the levels
+	 */
+	EFormat MFormat = FORMAT_RGBA8;
+
+	/**
+	 * Number of bytes per pixel of the source image
+	 */
+	uint32_t MSourceComponents = 0;
+
+	/**
+	 * Levels of the container
+	 */
+	std::vector<CLevel> MLevels;
+};
@@ -0,0 +1,145 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CFixedTimestep.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class dividing the elapsed time into simulation steps of a fixed length
+ *
+ * Decouples the simulation rate from the frame rate and measures the frame times
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Mean, deviation and maximum of frame times
+ *
+ * the running variance is accumulated by Welford's method, so long runs of similar
+ * frame times do not lose precision
+ */
+struct CFrameTimeStatistics
+{
+	/**
+	 * Number of measured frames
+	 */
+	size_t MFrames = 0;
+
+	/**
+	 * Mean frame time
+	 */
+	double MMean = 0.0;
+
+	/**
+	 * Sum of the squared differences from the mean
+	 */
+	double MSquares = 0.0;
+
+	/**
+	 * Longest frame time
+	 */
+	double MMaximum = 0.0;
+
+	/**
+	 * Adds a frame
+	 *
+	 * \param frameTime - time of the frame
+	 */
+	void Add(const double& frameTime);
+
+	/**
+	 * Getter of the standard deviation
+	 *
+	 * \return standard deviation of the frame times, 0 for less than two frames
+	 */
+	double GetDeviation() const;
+
+	/**
+	 * Starts measuring from zero
+	 */
+	void Reset();
+};
+
+/**
+ * Fixed timestep
+ *
+ * the time of every frame is added to an accumulator, which is spent in steps
+ * of a fixed length, the simulation then behaves the same at any frame rate and
+ * the rest of the accumulator is the fraction of a step the drawn state is blended by
+ *
+ * a frame time is clamped and the steps of a frame are limited, so a long stall
+ * does not make the simulation run behind forever, the time over the limit is dropped
+ */
+class CFixedTimestep
+{
+private:
+	/**
+	 * Length of a step in seconds
+	 */
+	double MStep;
+
+	/**
+	 * Longest frame time taken into account in seconds
+	 */
+	double MMaxFrameTime;
+
+	/**
+	 * Most steps run in a frame
+	 */
+	int MMaxSteps;
+
+	/**
+	 * Time not spent in steps yet, always less than a step after Advance
+	 */
+	double MAccumulator = 0.0;
+
+	/**
+	 * Time dropped by the limits since the last reset
+	 */
+	double MDropped = 0.0;
+public:
+	/**
+	 * Constructor of a fixed timestep
+	 *
+	 * \param         step - length of a step in seconds
+	 * \param maxFrameTime - longest frame time taken into account in seconds
+	 * \param     maxSteps - most steps run in a frame
+	 */
+	CFixedTimestep(const double& step, const double& maxFrameTime, const int& maxSteps);
+
+	/**
+	 * Adds the time of a frame
+	 *
+	 * \param frameTime - time since the previous frame in seconds
+	 *
+	 * \return number of steps to run before the frame is drawn
+	 */
+	int Advance(const double& frameTime);
+
+	/**
+	 * Getter of the length of a step
+	 *
+	 * \return length of a step in seconds
+	 */
+	double GetStep() const;
+
+	/**
+	 * Getter of the interpolation factor
+	 *
+	 * \return fraction of the step between the state before and after the last step to draw
+	 */
+	float GetInterpolation() const;
+
+	/**
+	 * Getter of the dropped time
+	 *
+	 * \return time dropped by the limits since the last reset in seconds
+	 */
+	double GetDropped() const;
+
+	/**
+	 * Starts dropping from zero
+	 */
+	void ResetDropped();
+};
@@ -0,0 +1,124 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CFourierTransform.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class computing fast Fourier transforms of square grids
+ *
+ * Radix-2 transforms of rows and columns with SSE, AVX or scalar butterflies
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+
+/**
+ * Instruction set used by the butterflies
+ *
+ *	FOURIER_KERNEL_SCALAR - plain C++, available everywhere
+ *	   FOURIER_KERNEL_SSE - 4 butterflies at once
+ *	   FOURIER_KERNEL_AVX - 8 butterflies at once
+ */
+enum EFourierKernel { FOURIER_KERNEL_SCALAR, FOURIER_KERNEL_SSE, FOURIER_KERNEL_AVX };
+
+/**
+ * Fast Fourier transform of a square grid
+ *
+ * the grid is stored row by row as separate arrays of real and imaginary parts,
+ * so consecutive butterflies read consecutive floats and map directly onto SIMD registers,
+ * rows are transformed one by one, columns are transformed all at once row against row,
+ * both can be split into ranges transformed by different threads
+ */
+class CFourierTransform
+{
+private:
+	/**
+	 * Number of elements on one side of the grid
+	 */
+	int MSize = 0;
+
+	/**
+	 * Instruction set used by the butterflies
+	 */
+	EFourierKernel MKernel = FOURIER_KERNEL_SCALAR;
+
+	/**
+	 * Bit reversed index of every element
+	 */
+	std::vector<int> MReversed;
+
+	/**
+	 * Twiddle factors of all stages, the stage combining halves of size h starts at h - 1
+	 */
+	std::vector<float> MTwiddleReal;
+	std::vector<float> MTwiddleImaginary;
+public:
+	/**
+	 * Initializer of the transform
+	 *
+	 * \param    size - number of elements on one side, a power of two
+	 * \param inverse - whether the inverse transform is computed, it is not normalized
+	 * \param  kernel - instruction set, unsupported ones fall back to the best supported
+	 */
+	void Initialize(const int& size, const bool& inverse, const EFourierKernel& kernel);
+
+	/**
+	 * Getter of the grid size
+	 *
+	 * \return number of elements on one side
+	 */
+	int GetSize() const;
+
+	/**
+	 * Getter of the used instruction set
+	 *
+	 * \return kernel of the butterflies
+	 */
+	EFourierKernel GetKernel() const;
+
+	/**
+	 * Transforms rows of the grid in place
+	 *
+	 * \param      real - real parts of the grid
+	 * \param imaginary - imaginary parts of the grid
+	 * \param  firstRow - first transformed row
+	 * \param  rowCount - number of transformed rows
+	 */
+	void TransformRows(float* real, float* imaginary, const int& firstRow, const int& rowCount) const;
+
+	/**
+	 * Transforms columns of the grid in place
+	 *
+	 * \param        real - real parts of the grid
+	 * \param   imaginary - imaginary parts of the grid
+	 * \param firstColumn - first transformed column
+	 * \param columnCount - number of transformed columns
+	 */
+	void TransformColumns(float* real, float* imaginary, const int& firstColumn, const int& columnCount) const;
+
+	/**
+	 * Checks whether the processor and the operating system support an instruction set
+	 *
+	 * \param kernel - instruction set to be checked
+	 *
+	 * \return true if the kernel can be used else false
+	 */
+	static bool IsKernelSupported(const EFourierKernel& kernel);
+
+	/**
+	 * Getter of the fastest supported instruction set
+	 *
+	 * \return best supported kernel
+	 */
+	static EFourierKernel GetBestKernel();
+
+	/**
+	 * Getter of the name of an instruction set
+	 *
+	 * \param kernel - instruction set
+	 *
+	 * \return name of the kernel
+	 */
+	static const char* GetKernelName(const EFourierKernel& kernel);
+};
@@ -0,0 +1,104 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CFrameUniforms.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class representing a uniform buffer with per-frame data
+ *
+ * Uploads camera and light state once per frame for all shader programs
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include "pgr.h"
+
+#include "CLight.h"
+
+/**
+ * Light in the std140 layout, every vec3 takes a whole vec4
+ */
+struct CFrameLight
+{
+	glm::vec4 MVector;
+	glm::vec4 MAmbient;
+	glm::vec4 MDiffuse;
+	glm::vec4 MSpecular;
+	glm::vec4 MDim;
+};
+
+/**
+ * Contents of the uniform block Frame in the std140 layout
+ *
+ * members are in the order of the block, offsets are in the comments
+ */
+struct CFrameData
+{
+	glm::mat4 MView;                 // 0
+	glm::mat4 MProjection;           // 64
+	CFrameLight MLight;              // 128
+	CFrameLight MDirLight;           // 208
+	glm::vec4 MLightPosition;        // 288
+	glm::vec4 MCameraEye;            // 304
+	glm::vec3 MCameraDirection;      // 320
+	float MCutOff;                   // 332
+	float MOuterCutOff;              // 336
+	float MPadding[3];               // 340
+};
+
+/**
+ * Per-frame uniform buffer
+ *
+ * camera and light state used to be set on every program before every draw,
+ * now it is written into one buffer at the start of a frame, the buffer stays
+ * bound to FRAME_UNIFORM_BINDING and every program reads it through its block
+ */
+class CFrameUniforms
+{
+private:
+	/**
+	 * OpenGL id of the uniform buffer
+	 */
+	GLuint MBuffer = 0;
+
+	/**
+	 * Data of the last update
+	 */
+	CFrameData MData = CFrameData();
+
+	/**
+	 * Help method converting a light into the std140 layout
+	 *
+	 * \param light - converted light
+	 *
+	 * \return light with padded vectors
+	 */
+	static CFrameLight ConvertLight(const CLight& light);
+public:
+	/**
+	 * Initializer of the buffer
+	 *
+	 * creates the buffer and binds it to FRAME_UNIFORM_BINDING
+	 */
+	void Initialize();
+
+	/**
+	 * Deinitializer of the buffer
+	 *
+	 * deletes OpenGL's buffer
+	 */
+	void Destroy();
+
+	/**
+	 * Uploads the data of a frame
+	 *
+	 * \param       view - view matrix
+	 * \param projection - projection matrix
+	 * \param      light - point light
+	 * \param   dirLight - directional light
+	 * \param  cameraEye - position of the camera
+	 * \param  cameraDir - direction of the camera
+	 */
+	void Update(const glm::mat4& view, const glm::mat4& projection, const CLight& light, const CLight& dirLight,
+		const glm::vec3& cameraEye, const glm::vec3& cameraDir);
+};
@@ -0,0 +1,66 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CFrustum.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class representing a view frustum
+ *
+ * Tests bounding boxes against the planes of the view frustum
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include "pgr.h"
+
+/**
+ * View frustum
+ *
+ * the planes are extracted from a clip matrix, they lie in the space
+ * the matrix transforms from, e.g. projection * view * model gives planes in model space
+ */
+class CFrustum
+{
+private:
+	/**
+	 * Left, right, bottom, top, near and far plane, normals point inside
+	 */
+	glm::vec4 MPlanes[6];
+public:
+	/**
+	 * Default constructor
+	 *
+	 * a frustum containing everything
+	 */
+	CFrustum();
+
+	/**
+	 * Constructor of a frustum
+	 *
+	 * \param clip - matrix transforming into the clip space
+	 */
+	CFrustum(const glm::mat4& clip);
+
+	/**
+	 * Tests an axis aligned bounding box against the frustum
+	 *
+	 * the box is rejected only if it lies behind one of the planes,
+	 * so a few boxes near the frustum's edges pass even though they are outside
+	 *
+	 * \param minimum - minimal corner of the box
+	 * \param maximum - maximal corner of the box
+	 *
+	 * \return false if the box is outside else true
+	 */
+	bool IsBoxVisible(const glm::vec3& minimum, const glm::vec3& maximum) const;
+
+	/**
+	 * Tests whether an axis aligned bounding box lies inside the frustum
+	 *
+	 * \param minimum - minimal corner of the box
+	 * \param maximum - maximal corner of the box
+	 *
+	 * \return true if the box is in front of every plane else false
+	 */
+	bool IsBoxInside(const glm::vec3& minimum, const glm::vec3& maximum) const;
+};
@@ -0,0 +1,67 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CGLCallCounter.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class counting OpenGL calls
+ *
+ * Counts OpenGL calls issued while drawing a frame
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Counter of OpenGL calls
+ *
+ * the drawing code adds its calls right where it issues them, the counter
+ * only counts, reading and resetting it once per frame is up to the caller
+ */
+class CGLCallCounter
+{
+private:
+	/**
+	 * Number of calls since the last reset
+	 */
+	static size_t MCalls;
+
+	/**
+	 * Number of draw calls since the last reset, they are counted in MCalls as well
+	 */
+	static size_t MDrawCalls;
+public:
+	/**
+	 * Adds issued calls
+	 *
+	 * \param calls - number of issued calls
+	 */
+	static void Add(const size_t& calls = 1);
+
+	/**
+	 * Adds issued draw calls
+	 *
+	 * \param calls - number of issued draw calls
+	 */
+	static void AddDraw(const size_t& calls = 1);
+
+	/**
+	 * Getter of the number of calls
+	 *
+	 * \return number of calls since the last reset
+	 */
+	static size_t GetCalls();
+
+	/**
+	 * Getter of the number of draw calls
+	 *
+	 * \return number of draw calls since the last reset
+	 */
+	static size_t GetDrawCalls();
+
+	/**
+	 * Starts counting from zero
+	 */
+	static void Reset();
+};
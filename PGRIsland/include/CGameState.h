@@ -11,6 +11,8 @@
 //----------------------------------------------------------------------------------------
 #pragma once
 
+#include <chrono>
+
 #include "pgr.h"
 
 #include "HConstants.h"
@@ -27,6 +29,18 @@
 #include "CSkyboxSceneNode.h"
 #include "CSplineSceneNode.h"
 #include "CBillboardSceneNode.h"
+#include "CInstancedSceneNode.h"
+#include "CThreadPool.h"
+#include "CTransformSystem.h"
+#include "CTextureRegistry.h"
+#include "CStreamingLoader.h"
+#include "CFrameUniforms.h"
+#include "CGLCallCounter.h"
+#include "CAllocationCounter.h"
+#include "CRenderQueue.h"
+#include "CRenderState.h"
+#include "CGeometryArena.h"
+#include "CFixedTimestep.h"
 
 /**
  * Game state struct
@@ -98,6 +112,20 @@ private:
 	 */
 	void InitializeExplosion();
 
+	/**
+	 * Help method initializing a school of MFishSchoolSize fish to the scene
+	 * 
+	 * the fish follow the splines of the other fish in groups of FISH_SCHOOL_GROUP_SIZE,
+	 * every group is offset from its spline and every fish starts at its own phase,
+	 * the school stresses drawing many nodes sharing one mesh
+	 */
+	void InitializeFishSchool();
+
+	/**
+	 * Help method starting the averages printed by EndFrame from zero
+	 */
+	void ResetFrameReport();
+
 	/**
 	 * Shader program for drawing generic objects
 	 */
@@ -147,6 +175,11 @@ public:
 	 */
 	void InitializeGame();
 
+	/**
+	 * Prints CPU and GPU memory of every mesh in the scene
+	 */
+	void PrintMemoryReport();
+
 	/**
 	 * Boolean representing if it is day or night
 	 */
@@ -178,19 +211,24 @@ public:
 	int MView = -1;
 
 	/**
-	 * Help variable for counting time delta.
+	 * Help variable for counting time delta, read from a monotonic clock
 	 */
-	int MLastFrameTime = 0;
+	std::chrono::steady_clock::time_point MLastFrameTime;
 
 	/**
-	 * Current time delta
+	 * Fixed timestep of the simulation
 	 */
-	float MTimeDelta = 0.0f;
+	CFixedTimestep MTimestep = CFixedTimestep(SIMULATION_STEP, SIMULATION_MAX_FRAME_TIME, SIMULATION_MAX_STEPS);
 
 	/**
 	 * Camera of the scene
 	 */
 	CCamera MCamera;
+
+	/**
+	 * Camera of the scene before the current simulation step
+	 */
+	CCamera MPreviousCamera;
 	
 	/**
 	 * Key map for keyboard input handling
@@ -258,6 +296,190 @@ public:
 	 */
 	glm::mat4 GetProjectionMatrix();
 
+	/**
+	 * Culls all objects against the view frustum
+	 * 
+	 * makes no OpenGL call, the statistics are printed every CULLING_REPORT_FRAMES frames
+	 * 
+	 * \param clip - projection matrix times view matrix
+	 */
+	void CullScene(const glm::mat4& clip);
+
+	/**
+	 * Draws all objects
+	 * 
+	 * with the render queue the draws are sorted by their state and redundant binds
+	 * are dropped, otherwise the objects are drawn in the scene's order binding everything,
+	 * every top level node writes its index + 1 to the stencil buffer for picking
+	 */
+	void DrawScene();
+
+	/**
+	 * Switch for MRenderQueueEnabled
+	 * 
+	 * \return switched MRenderQueueEnabled value
+	 */
+	bool SwitchRenderQueue();
+
+	/**
+	 * Switch for MInstancingEnabled
+	 * 
+	 * \return switched MInstancingEnabled value
+	 */
+	bool SwitchInstancing();
+
+	/**
+	 * Switch for MMultiDrawEnabled
+	 * 
+	 * \return switched MMultiDrawEnabled value
+	 */
+	bool SwitchMultiDraw();
+
+	/**
+	 * Checks collisions of an object with the scene
+	 * 
+	 * only nodes whose boxes in the scene's bounding volume hierarchy
+	 * touch the object are checked, their boxes cover their collision spheres
+	 * 
+	 * \param position - position of the object
+	 * \param     size - size of the object, its x is the radius
+	 * 
+	 * \return true if the object collides with any node else false
+	 */
+	bool CheckCollision(const glm::vec3& position, const glm::vec3& size);
+
+	/**
+	 * Uploads the per-frame uniform buffer
+	 * 
+	 * called once at the start of a frame, before any program is used
+	 */
+	void BeginFrame();
+
+	/**
+	 * Counts OpenGL calls, heap allocations and binds of the finished frame
+	 * 
+	 * the averages and the frame times are printed every GL_CALL_REPORT_FRAMES frames
+	 */
+	void EndFrame();
+
+	/**
+	 * Render queue collecting the draws of a frame
+	 */
+	CRenderQueue MRenderQueue;
+
+	/**
+	 * Shadow state all draws bind through
+	 */
+	CRenderState MRenderState;
+
+	/**
+	 * Boolean showing whether the scene is drawn through the render queue
+	 */
+	bool MRenderQueueEnabled = RENDER_QUEUE_ENABLED;
+
+	/**
+	 * Binds of the frames since the average was last printed
+	 */
+	CRenderStatistics MRenderStatistics;
+
+	/**
+	 * Nodes drawing groups of nodes sharing mesh, material and program as instances,
+	 * ordered by the top level nodes they are drawn with
+	 */
+	std::vector<std::shared_ptr<CInstancedSceneNode>> MInstancedNodes;
+
+	/**
+	 * Boolean showing whether the instanced nodes draw their instances
+	 */
+	bool MInstancingEnabled = INSTANCING_ENABLED;
+
+	/**
+	 * Boolean showing whether the render queue merges neighbouring draws into multi-draw calls
+	 */
+	bool MMultiDrawEnabled = MULTI_DRAW_ENABLED;
+
+	/**
+	 * Number of fish of the school added to the scene, set by FISH_SCHOOL_SWITCH
+	 */
+	int MFishSchoolSize = 0;
+
+	/**
+	 * Uniform buffer with camera and light state shared by all programs
+	 */
+	CFrameUniforms MFrameUniforms;
+
+	/**
+	 * OpenGL calls of the frames since the average was last printed
+	 */
+	size_t MGLCalls = 0;
+
+	/**
+	 * Draw calls of the frames since the average was last printed
+	 */
+	size_t MDrawCalls = 0;
+
+	/**
+	 * Number of frames since the average of OpenGL calls was last printed
+	 */
+	int MGLCallFrames = 0;
+
+	/**
+	 * Frame times in milliseconds since the average was last printed
+	 */
+	CFrameTimeStatistics MFrameTimes;
+
+	/**
+	 * Simulation steps since the average was last printed
+	 */
+	int MSimulationSteps = 0;
+
+	/**
+	 * Allocations of the render thread when the current frame began
+	 */
+	size_t MFrameAllocations = 0;
+
+	/**
+	 * Heap allocations of the frames since the average was last printed
+	 */
+	size_t MAllocations = 0;
+
+	/**
+	 * Counters of the last culling pass
+	 */
+	CCullStatistics MCullStatistics;
+
+	/**
+	 * Number of culling passes since the statistics were last printed
+	 */
+	int MCullFrames = 0;
+
+	/**
+	 * Transforms of all scene nodes
+	 * 
+	 * declared before every member holding nodes, so it outlives them
+	 */
+	CTransformSystem MTransforms;
+
+	/**
+	 * Worker threads for loading
+	 */
+	CThreadPool MThreadPool;
+
+	/**
+	 * Registry of textures shared by the scene nodes
+	 */
+	CTextureRegistry MTextureRegistry;
+
+	/**
+	 * Arena holding the vertices and indices of the meshes
+	 */
+	CGeometryArena MGeometryArena;
+
+	/**
+	 * Loader streaming objects in the background
+	 */
+	CStreamingLoader MStreamingLoader;
+
 	/**
 	 * Root scene node
 	 * 
@@ -271,6 +493,13 @@ public:
 	 * used for calculating position of the camera during ship view
 	 */
 	std::shared_ptr<CSceneNode> MShip = nullptr;
+
+	/**
+	 * Water pointer
+	 * 
+	 * used for switching the faceted water
+	 */
+	std::shared_ptr<CWaterPlaneSceneNode> MWater = nullptr;
 };
 
 /**
@@ -0,0 +1,383 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CGeometryArena.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class sharing large vertex and index buffers between meshes
+ *
+ * Suballocates meshes from pages of shared buffers and submits their draws in batches
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+
+#include "pgr.h"
+
+#include "CVertex.h"
+
+/**
+ * Draw record in the layout of glMultiDrawElementsIndirect
+ */
+struct CDrawElementsIndirectCommand
+{
+	/**
+	 * Number of indices
+	 */
+	GLuint MCount;
+
+	/**
+	 * Number of instances
+	 */
+	GLuint MInstanceCount;
+
+	/**
+	 * Position of the first index in the EBO, in indices
+	 */
+	GLuint MFirstIndex;
+
+	/**
+	 * Value added to every index
+	 */
+	GLint MBaseVertex;
+
+	/**
+	 * First instance, always 0 in OpenGL 3.3
+	 */
+	GLuint MBaseInstance;
+};
+
+/**
+ * Free range of a suballocated buffer
+ */
+struct CFreeRange
+{
+	/**
+	 * Start of the range
+	 */
+	size_t MOffset;
+
+	/**
+	 * Length of the range
+	 */
+	size_t MSize;
+};
+
+/**
+ * Suballocator of ranges in a buffer
+ *
+ * free ranges are kept ordered by their offsets, a range is taken from the smallest
+ * free one it fits and freed ranges are merged with their free neighbours,
+ * units are up to the caller, vertices for vertex buffers and bytes for index buffers
+ */
+class CRangeAllocator
+{
+private:
+	/**
+	 * Free ranges ordered by their offsets
+	 */
+	std::vector<CFreeRange> MFree;
+
+	/**
+	 * Length of the whole buffer
+	 */
+	size_t MCapacity = 0;
+
+	/**
+	 * Length of the taken ranges
+	 */
+	size_t MUsed = 0;
+public:
+	/**
+	 * Constructor of an allocator
+	 *
+	 * \param capacity - length of the whole buffer, all of it is free
+	 */
+	CRangeAllocator(const size_t& capacity = 0);
+
+	/**
+	 * Takes a range
+	 *
+	 * \param   size - length of the range
+	 * \param offset - start of the taken range
+	 *
+	 * \return true if a free range was big enough else false
+	 */
+	bool Allocate(const size_t& size, size_t& offset);
+
+	/**
+	 * Gives a range back
+	 *
+	 * \param offset - start of the range
+	 * \param   size - length of the range
+	 */
+	void Free(const size_t& offset, const size_t& size);
+
+	/**
+	 * Getter of the length of the whole buffer
+	 *
+	 * \return capacity
+	 */
+	size_t GetCapacity() const;
+
+	/**
+	 * Getter of the length of the taken ranges
+	 *
+	 * \return used length
+	 */
+	size_t GetUsed() const;
+
+	/**
+	 * Getter of the number of free ranges
+	 *
+	 * \return number of free ranges
+	 */
+	size_t GetFreeRangeCount() const;
+
+	/**
+	 * Getter of the longest free range
+	 *
+	 * \return length of the longest free range
+	 */
+	size_t GetLargestFree() const;
+
+	/**
+	 * Getter of the fragmentation
+	 *
+	 * \return part of the free length outside the longest free range, 0 for no free length
+	 */
+	float GetFragmentation() const;
+};
+
+/**
+ * Page of the arena, buffers shared by meshes of one vertex format
+ */
+struct CArenaPage
+{
+	/**
+	 * Vertex format of the page's vertex buffer
+	 */
+	EVertexFormat MFormat;
+
+	/**
+	 * VAO with the attributes of the format, VBO and EBO of the page
+	 */
+	GLuint MVertexArray;
+	GLuint MVertexBuffer;
+	GLuint MElementBuffer;
+
+	/**
+	 * Suballocators of the VBO in vertices and of the EBO in bytes
+	 */
+	CRangeAllocator MVertices;
+	CRangeAllocator MIndices;
+
+	/**
+	 * Number of meshes in the page
+	 */
+	size_t MMeshCount;
+};
+
+/**
+ * Place of a mesh in the arena
+ */
+struct CArenaAllocation
+{
+	/**
+	 * Page of the mesh, -1 for a mesh with its own buffers
+	 */
+	int MPage = -1;
+
+	/**
+	 * First vertex and number of vertices in the page's VBO
+	 */
+	size_t MFirstVertex = 0;
+	size_t MVertexCount = 0;
+
+	/**
+	 * Offset and number of bytes in the page's EBO, both multiples of four
+	 */
+	size_t MIndexOffset = 0;
+	size_t MIndexSize = 0;
+};
+
+/**
+ * Counters of the draws submitted in batches
+ */
+struct CBatchStatistics
+{
+	/**
+	 * Number of nodes drawn by batches
+	 */
+	size_t MNodes = 0;
+
+	/**
+	 * Number of draw records of the batches
+	 */
+	size_t MCommands = 0;
+
+	/**
+	 * Number of multi-draw calls
+	 */
+	size_t MBatches = 0;
+};
+
+/**
+ * Geometry arena
+ *
+ * meshes are not given their own VAO, VBO and EBO, they are suballocated from pages
+ * of large buffers, one VAO per page holds the attributes of the page's vertex format,
+ * a mesh is addressed by its base vertex and the offset of its indices, so all meshes
+ * of a page are drawn without binding another VAO
+ *
+ * neighbouring draws sharing the page and the state are merged into one multi-draw call,
+ * glMultiDrawElementsIndirect reading the records from a buffer where OpenGL 4.3 or
+ * ARB_multi_draw_indirect is available, glMultiDrawElementsBaseVertex of OpenGL 3.2 elsewhere
+ *
+ * meshes too big for a page keep their own buffers
+ */
+class CGeometryArena
+{
+private:
+	/**
+	 * Pages of all vertex formats
+	 */
+	std::vector<CArenaPage> MPages;
+
+	/**
+	 * Buffer with the records of the indirect draws
+	 */
+	GLuint MIndirectBuffer = 0;
+
+	/**
+	 * Size of the indirect buffer in bytes
+	 */
+	size_t MIndirectSize = 0;
+
+	/**
+	 * Number of meshes with their own buffers
+	 */
+	size_t MSeparateMeshes = 0;
+
+	/**
+	 * Arrays of the multi-draw without indirect records, the capacity is kept between batches
+	 */
+	std::vector<GLsizei> MCounts;
+	std::vector<const void*> MOffsets;
+	std::vector<GLint> MBaseVertices;
+
+	/**
+	 * Counters since the last reset
+	 */
+	CBatchStatistics MStatistics;
+
+	/**
+	 * Help method creating a page
+	 *
+	 * \param format - vertex format of the page
+	 *
+	 * \return index of the page
+	 */
+	int CreatePage(const EVertexFormat& format);
+public:
+	/**
+	 * Places a mesh into a page
+	 *
+	 * a page of the format with enough free space is taken, a new one is created if there is none
+	 *
+	 * \param        format - vertex format of the mesh
+	 * \param   vertexCount - number of vertices
+	 * \param     indexSize - bytes of the indices, a multiple of four
+	 * \param    allocation - place of the mesh
+	 * \param   vertexArray - OpenGL id of the page's VAO
+	 * \param  vertexBuffer - OpenGL id of the page's VBO
+	 * \param elementBuffer - OpenGL id of the page's EBO
+	 *
+	 * \return true if the mesh was placed, false if it is bigger than a page
+	 */
+	bool Allocate(const EVertexFormat& format, const size_t& vertexCount, const size_t& indexSize, CArenaAllocation& allocation,
+		GLuint& vertexArray, GLuint& vertexBuffer, GLuint& elementBuffer);
+
+	/**
+	 * Takes a mesh out of its page
+	 *
+	 * \param allocation - place of the mesh, reset to a mesh with its own buffers
+	 */
+	void Free(CArenaAllocation& allocation);
+
+	/**
+	 * Checks whether the draw records are read from a buffer
+	 *
+	 * \return true if glMultiDrawElementsIndirect is available else false
+	 */
+	bool IsIndirectSupported() const;
+
+	/**
+	 * Uploads the draw records of a pass
+	 *
+	 * \param commands - records of all batches of the pass
+	 *
+	 * \return true if the records were uploaded for indirect draws else false
+	 */
+	bool UploadCommands(const std::vector<CDrawElementsIndirectCommand>& commands);
+
+	/**
+	 * Draws records with one call
+	 *
+	 * the VAO of the records' page has to be bound
+	 *
+	 * \param indexType - type of the indices of all records
+	 * \param  commands - draw records
+	 * \param     first - first drawn record
+	 * \param     count - number of drawn records
+	 * \param  indirect - true if the records were uploaded by UploadCommands
+	 */
+	void MultiDraw(const GLenum& indexType, const std::vector<CDrawElementsIndirectCommand>& commands,
+		const size_t& first, const size_t& count, const bool& indirect);
+
+	/**
+	 * Counts nodes drawn by a batch
+	 *
+	 * \param nodes - number of nodes of the batch
+	 */
+	void AddBatchedNodes(const size_t& nodes);
+
+	/**
+	 * Counts a mesh which did not fit into a page
+	 */
+	void AddSeparateMesh();
+
+	/**
+	 * Getter of the counters
+	 *
+	 * \return counters since the last reset
+	 */
+	const CBatchStatistics& GetStatistics() const;
+
+	/**
+	 * Starts counting from zero
+	 */
+	void ResetStatistics();
+
+	/**
+	 * Prints usage and fragmentation of the pages
+	 */
+	void Report() const;
+
+	/**
+	 * Deinitializer of the arena
+	 *
+	 * deletes all pages, meshes still placed in them must not be drawn anymore
+	 */
+	void Destroy();
+
+	/**
+	 * Sets the attributes of a vertex format
+	 *
+	 * the VAO and the VBO have to be bound, attributes start at the VBO's beginning
+	 *
+	 * \param format - vertex format of the VBO
+	 */
+	static void SetupVertexAttributes(const EVertexFormat& format);
+};
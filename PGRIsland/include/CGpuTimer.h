@@ -0,0 +1,108 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CGpuTimer.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class measuring GPU time of draw calls
+ *
+ * Averages GL_TIME_ELAPSED queries over a number of frames
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+
+#include "pgr.h"
+
+/**
+ * GPU timer
+ *
+ * queries are kept in a ring and read a few frames later, so reading a result
+ * never waits for the GPU, a frame whose query is still in flight is not measured
+ */
+class CGpuTimer
+{
+private:
+	/**
+	 * Ring of the timer queries
+	 */
+	std::vector<GLuint> MQueries;
+
+	/**
+	 * Whether a query of the ring waits for its result
+	 */
+	std::vector<bool> MPending;
+
+	/**
+	 * Query used by the next measurement
+	 */
+	size_t MNext = 0;
+
+	/**
+	 * Boolean showing whether a measurement was begun and not ended
+	 */
+	bool MRunning = false;
+
+	/**
+	 * Sum of the read results in nanoseconds
+	 */
+	GLuint64 MElapsed = 0;
+
+	/**
+	 * Number of the read results
+	 */
+	int MSamples = 0;
+
+	/**
+	 * Help method reading finished queries
+	 *
+	 * \param wait - whether to wait for the results of all pending queries
+	 */
+	void Collect(const bool& wait);
+public:
+	/**
+	 * Initializer of the timer
+	 *
+	 * \param queries - number of queries in the ring
+	 */
+	void Initialize(const int& queries);
+
+	/**
+	 * Deinitializer of the timer
+	 *
+	 * deletes OpenGL's queries
+	 */
+	void Destroy();
+
+	/**
+	 * Begins measuring draw calls
+	 *
+	 * skipped if the next query of the ring is still in flight
+	 */
+	void Begin();
+
+	/**
+	 * Ends measuring draw calls
+	 */
+	void End();
+
+	/**
+	 * Getter of the number of read results
+	 *
+	 * \return number of measured frames
+	 */
+	int GetSamples() const;
+
+	/**
+	 * Getter of the average time
+	 *
+	 * \return average time of the read results in milliseconds
+	 */
+	double GetAverage() const;
+
+	/**
+	 * Drops the read results and the queries in flight
+	 */
+	void Reset();
+};
@@ -0,0 +1,97 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CHeadlessContext.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class creating an OpenGL context without a window
+ *
+ * Creates an offscreen context and a framebuffer the headless mode renders into
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <string>
+
+#include "pgr.h"
+
+#if defined(__linux__)
+// older EGL headers pull in Xlib, whose macros clash with the scene's names
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#define HEADLESS_EGL
+#endif
+
+/**
+ * Offscreen OpenGL context
+ *
+ * on Linux the context is created by EGL on Mesa's surfaceless platform, which needs
+ * no display server and falls back to llvmpipe on machines without a GPU, the default
+ * EGL display is tried if the platform is missing, elsewhere a hidden GLUT window
+ * provides the context
+ *
+ * the context has no default framebuffer to draw into, the frames are drawn into
+ * a framebuffer object with color and depth-stencil renderbuffers, the stencil keeps
+ * the picking identifiers written as in the window
+ */
+class CHeadlessContext
+{
+private:
+#ifdef HEADLESS_EGL
+	/**
+	 * EGL display and context
+	 */
+	EGLDisplay MDisplay = EGL_NO_DISPLAY;
+	EGLContext MContext = EGL_NO_CONTEXT;
+#else
+	/**
+	 * GLUT's id of the hidden window, 0 for none
+	 */
+	int MWindow = 0;
+#endif
+
+	/**
+	 * Framebuffer object and its color and depth-stencil renderbuffers
+	 */
+	GLuint MFramebuffer = 0;
+	GLuint MColorBuffer = 0;
+	GLuint MDepthStencilBuffer = 0;
+public:
+	/**
+	 * Creates the context and makes it current
+	 *
+	 * OpenGL functions are not loaded yet, pgr::initialize has to follow
+	 *
+	 * \param argc - argc given from main function, passed to GLUT without EGL
+	 * \param argv - argv given from main function, passed to GLUT without EGL
+	 *
+	 * \return true if the context is current else false
+	 */
+	bool CreateContext(int argc, char* argv[]);
+
+	/**
+	 * Creates the framebuffer object and binds it for drawing and reading
+	 *
+	 * \param  width - width of the framebuffer in pixels
+	 * \param height - height of the framebuffer in pixels
+	 *
+	 * \return true if the framebuffer is complete else false
+	 */
+	bool CreateFramebuffer(const int& width, const int& height);
+
+	/**
+	 * Getter of the name of the context's renderer
+	 *
+	 * \return renderer reported by OpenGL, e.g. llvmpipe
+	 */
+	std::string GetRenderer() const;
+
+	/**
+	 * Deinitializer of the context
+	 *
+	 * deletes the framebuffer object and destroys the context
+	 */
+	void Destroy();
+};
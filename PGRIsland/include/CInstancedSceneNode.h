@@ -0,0 +1,132 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CInstancedSceneNode.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Scene node drawing meshes of other nodes as instances
+ *
+ * Draws nodes sharing mesh, material and program with a single instanced draw call
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "pgr.h"
+
+#include "CSceneNode.h"
+
+/**
+ * Scene node drawing the meshes of other nodes as instances
+ *
+ * the instances share mesh, material and program, the first instance's mesh is drawn
+ * once by glDrawElementsInstanced and every instance reads its model matrix
+ * from a buffer streamed every frame, so the draw calls do not grow with the instances
+ *
+ * the node is not a part of the scene's tree, it is drawn in the place of the top level
+ * node holding its first instance and with its stencil reference, the instances
+ * stay in the tree, are updated and culled there and skip drawing their own meshes
+ */
+class CInstancedSceneNode : public CSceneNode
+{
+private:
+	/**
+	 * Nodes drawn as instances, the first one's mesh is drawn
+	 */
+	std::vector<CSceneNode*> MInstances;
+
+	/**
+	 * Model matrices of the visible instances, the capacity is kept between frames
+	 */
+	std::vector<glm::mat4> MMatrices;
+
+	/**
+	 * Buffer with the model matrices, orphaned every frame
+	 */
+	GLuint MInstanceBuffer = 0;
+
+	/**
+	 * Index of the top level node the instanced node is drawn with
+	 */
+	int MSlot = 0;
+
+	/**
+	 * Help function checking whether a node's mesh would be drawn
+	 *
+	 * \param node - instance
+	 *
+	 * \return true if the node and all its ancestors are on and passed the last culling else false
+	 */
+	static bool IsDrawn(const CSceneNode* node);
+
+	/**
+	 * Help function collecting nodes which can be instanced
+	 *
+	 * \param  node - root of the searched subtree
+	 * \param  slot - index of the top level node holding the subtree
+	 * \param nodes - found nodes with their slots, new ones are appended
+	 */
+	static void CollectInstanceable(CSceneNode* node, const int& slot, std::vector<std::pair<CSceneNode*, int>>& nodes);
+public:
+	/**
+	 * Constructor for an instanced node
+	 *
+	 * attaches the buffer of model matrices to the first instance's mesh
+	 * and marks the instances as instanced
+	 *
+	 * \param instances - nodes sharing mesh, material and program
+	 * \param      slot - index of the top level node holding the first instance
+	 */
+	CInstancedSceneNode(const std::vector<CSceneNode*>& instances, const int& slot);
+
+	/**
+	 * Deinitializer of the instanced node
+	 *
+	 * destroys the buffer of model matrices, the instances' meshes belong to the instances
+	 */
+	void Destroy() override;
+
+	/**
+	 * Draw method
+	 *
+	 * streams model matrices of the instances drawn this frame and draws them at once
+	 *
+	 * \param state - state the binds go through
+	 */
+	void DrawMesh(CRenderState& state) override;
+
+	/**
+	 * Switches between drawing the instances at once and one by one
+	 *
+	 * \param instancing - true if the instances are drawn by this node else false
+	 */
+	void SetInstancing(const bool& instancing);
+
+	/**
+	 * Getter of the slot
+	 *
+	 * \return index of the top level node the instanced node is drawn with
+	 */
+	int GetSlot() const;
+
+	/**
+	 * Getter of the number of instances
+	 *
+	 * \return number of nodes drawn by the instanced node
+	 */
+	size_t GetInstanceCount() const;
+
+	/**
+	 * Finds nodes sharing mesh, material and program
+	 *
+	 * every group of at least INSTANCING_MIN_NODES instanceable nodes under the root
+	 * gets its instanced node, the nodes are ordered by their slots
+	 *
+	 * \param root - root of the scene
+	 *
+	 * \return instanced nodes
+	 */
+	static std::vector<std::shared_ptr<CInstancedSceneNode>> CreateInstancedNodes(CSceneNode& root);
+};
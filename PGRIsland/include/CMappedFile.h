@@ -0,0 +1,105 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CMappedFile.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class representing a read-only memory mapped file
+ *
+ * Maps a whole file into the address space so its content can be read without copying
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <string>
+
+/**
+ * Read-only memory mapped file
+ *
+ * maps the whole file on Open and unmaps it on Close or destruction,
+ * the object cannot be copied as it owns the mapping
+ */
+class CMappedFile
+{
+public:
+	/**
+	 * Default constructor
+	 *
+	 * represents a file that is not mapped
+	 */
+	CMappedFile() = default;
+
+	/**
+	 * Destructor
+	 *
+	 * unmaps the file
+	 */
+	~CMappedFile();
+
+	CMappedFile(const CMappedFile&) = delete;
+	CMappedFile& operator=(const CMappedFile&) = delete;
+
+	/**
+	 * Maps a file
+	 *
+	 * previously mapped file is unmapped first
+	 *
+	 * \param path - path to the file
+	 *
+	 * \return true if the file was mapped else false
+	 */
+	bool Open(const std::string& path);
+
+	/**
+	 * Unmaps the file
+	 */
+	void Close();
+
+	/**
+	 * Getter of the mapped data
+	 *
+	 * \return pointer to the first byte of the file, nullptr if nothing is mapped
+	 */
+	const char* GetData() const;
+
+	/**
+	 * Getter of the mapped size
+	 *
+	 * \return size of the file in bytes
+	 */
+	size_t GetSize() const;
+
+	/**
+	 * Getter whether a file is mapped
+	 *
+	 * \return true if a file is mapped else false
+	 */
+	bool IsOpen() const;
+private:
+	/**
+	 * Mapped content of the file
+	 */
+	const char* MData = nullptr;
+
+	/**
+	 * Size of the mapped content
+	 */
+	size_t MSize = 0;
+
+#ifdef _WIN32
+	/**
+	 * Handle of the opened file
+	 */
+	void* MFileHandle = nullptr;
+
+	/**
+	 * Handle of the file mapping
+	 */
+	void* MMappingHandle = nullptr;
+#else
+	/**
+	 * Descriptor of the opened file
+	 */
+	int MFileDescriptor = -1;
+#endif
+};
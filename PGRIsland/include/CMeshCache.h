@@ -0,0 +1,339 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CMeshCache.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class representing a binary cache of imported object geometry
+ *
+ * Stores post-processed vertices, indices and materials of an object so that
+ * following runs can skip ASSIMP and upload the memory mapped data directly
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pgr.h"
+
+#include "CVertex.h"
+#include "CMaterial.h"
+#include "CMappedFile.h"
+#include "CMeshOptimizer.h"
+
+/**
+ * Mesh read from the cache
+ *
+ * vertices and indices point directly into the cache content
+ * and are valid as long as the cache is alive
+ */
+struct CCachedMesh
+{
+	/**
+	 * Vertices of the mesh
+	 */
+	const CVertex* MVertices = nullptr;
+
+	/**
+	 * Number of vertices
+	 */
+	unsigned int MVertexCount = 0;
+
+	/**
+	 * Indices of the faces
+	 */
+	const unsigned int* MIndices = nullptr;
+
+	/**
+	 * Number of indices
+	 */
+	unsigned int MIndexCount = 0;
+
+	/**
+	 * Material of the mesh
+	 */
+	CMaterial MMaterial;
+
+	/**
+	 * Diffuse texture paths relative to the object's directory
+	 */
+	std::vector<std::string> MTexturePaths;
+};
+
+/**
+ * Binary cache of an object's geometry
+ *
+ * the cache mirrors the node layout created by CSceneNode, each node record holds
+ * number of meshes and number of child nodes followed by the meshes and the child nodes,
+ * the cache file is valid only for the same version, ASSIMP flags and content of the source
+ * file and its material libraries
+ *
+ * \see CSceneNode
+ */
+class CMeshCache
+{
+public:
+	/**
+	 * Version of the cache format, increase whenever the layout or the cooking changes
+	 */
+	static const uint32_t VERSION = 4;
+
+	/**
+	 * Default constructor
+	 *
+	 * represents an empty cache
+	 */
+	CMeshCache() = default;
+
+	CMeshCache(const CMeshCache&) = delete;
+	CMeshCache& operator=(const CMeshCache&) = delete;
+
+	/**
+	 * Hashes a file's content with 64-bit FNV-1a
+	 *
+	 * used to detect outdated cache files
+	 *
+	 * \param file - path to the file
+	 * \param hash - hash of the content
+	 * \param size - size of the content
+	 *
+	 * \return true if the file was read else false
+	 */
+	static bool HashFile(const std::string& file, uint64_t& hash, uint64_t& size);
+
+	/**
+	 * Hashes an object's file together with the material libraries it references
+	 *
+	 * the libraries are found through the object's mtllib statements and hashed
+	 * in their order after the object, missing ones are skipped
+	 *
+	 * \param file - path to the object's file
+	 * \param hash - hash of the content
+	 * \param size - size of the content
+	 *
+	 * \return true if the object's file was read else false
+	 */
+	static bool HashSource(const std::string& file, uint64_t& hash, uint64_t& size);
+
+	/**
+	 * Getter of the cache file path
+	 *
+	 * \param file - path to the object's file
+	 *
+	 * \return path of the cache file belonging to the object
+	 */
+	static std::string GetCachePath(const std::string& file);
+
+	/**
+	 * Maps a cache file of an object
+	 *
+	 * \param        file - path to the object's file
+	 * \param importFlags - ASSIMP post processing flags the cache has to be made with
+	 *
+	 * \return true if a valid cache was mapped else false
+	 */
+	bool Load(const std::string& file, const unsigned int& importFlags);
+
+	/**
+	 * Imports an object through ASSIMP and cooks it into the cache layout in memory
+	 *
+	 * \param        file - path to the object's file
+	 * \param importFlags - ASSIMP post processing flags
+	 *
+	 * \return true if the object was imported else false
+	 */
+	bool Import(const std::string& file, const unsigned int& importFlags);
+
+	/**
+	 * Maps the cache file of an object or imports it when the cache is missing or out of date
+	 *
+	 * a fresh import is written to the cache file if the mesh cache is enabled
+	 *
+	 * \param        file - path to the object's file
+	 * \param importFlags - ASSIMP post processing flags
+	 *
+	 * \return true if the content is available else false
+	 */
+	bool LoadOrImport(const std::string& file, const unsigned int& importFlags);
+
+	/**
+	 * Writes imported content to the cache file
+	 *
+	 * \return true if the cache file was written else false
+	 */
+	bool Save() const;
+
+	/**
+	 * Getter whether the content comes from a mapped cache file
+	 *
+	 * \return true if mapped else false
+	 */
+	bool IsMapped() const;
+
+	/**
+	 * Getter of the content size
+	 *
+	 * \return size of the cache content in bytes
+	 */
+	size_t GetSize() const;
+
+	/**
+	 * Getter of the vertex cache statistics before optimization
+	 *
+	 * \return statistics of all meshes of the last import in ASSIMP's order
+	 */
+	const CMeshStatistics& GetStatisticsBefore() const;
+
+	/**
+	 * Getter of the vertex cache statistics after optimization
+	 *
+	 * \return statistics of all meshes of the last import in the cooked order
+	 */
+	const CMeshStatistics& GetStatisticsAfter() const;
+
+	/**
+	 * Moves reading to the first node
+	 */
+	void Rewind();
+
+	/**
+	 * Reads a node record
+	 *
+	 * \param  meshCount - number of meshes of the node
+	 * \param childCount - number of child nodes of the node
+	 *
+	 * \return true on success else false
+	 */
+	bool ReadNode(unsigned int& meshCount, unsigned int& childCount);
+
+	/**
+	 * Reads a mesh record
+	 *
+	 * \param mesh - read mesh
+	 *
+	 * \return true on success else false
+	 */
+	bool ReadMesh(CCachedMesh& mesh);
+private:
+	/**
+	 * Header at the start of every cache file
+	 */
+	struct CHeader
+	{
+		char MMagic[4];
+		uint32_t MVersion;
+		uint32_t MImportFlags;
+		uint32_t MVertexSize;
+		uint32_t MCookFlags;
+		uint32_t MReserved;
+		uint64_t MSourceHash;
+		uint64_t MSourceSize;
+		uint64_t MPayloadSize;
+	};
+
+	/**
+	 * Path of the cache file
+	 */
+	std::string MPath;
+
+	/**
+	 * Mapped cache file
+	 */
+	CMappedFile MFile;
+
+	/**
+	 * Cooked content after an import
+	 */
+	std::vector<char> MBuffer;
+
+	/**
+	 * Content of the cache, either mapped or cooked
+	 */
+	const char* MData = nullptr;
+
+	/**
+	 * Size of the content
+	 */
+	size_t MSize = 0;
+
+	/**
+	 * Reading position in the content
+	 */
+	size_t MOffset = 0;
+
+	/**
+	 * Vertex cache statistics of the imported meshes before optimization
+	 */
+	CMeshStatistics MStatisticsBefore;
+
+	/**
+	 * Vertex cache statistics of the imported meshes after optimization
+	 */
+	CMeshStatistics MStatisticsAfter;
+
+	/**
+	 * Help method describing how the content is cooked
+	 *
+	 * \return flags stored in the header, a cache cooked differently is stale
+	 */
+	static uint32_t GetCookFlags();
+
+	/**
+	 * Help method checking that every record can be read
+	 *
+	 * \return true if the content is complete else false
+	 */
+	bool ValidateNode();
+
+	/**
+	 * Help method cooking an ASSIMP node and its children
+	 *
+	 * \param  node - ASSIMP node to be cooked
+	 * \param scene - scene of the object
+	 */
+	void CookNode(const aiNode* node, const aiScene* scene);
+
+	/**
+	 * Help method cooking an ASSIMP mesh
+	 *
+	 * \param  mesh - ASSIMP mesh to be cooked
+	 * \param scene - scene of the object
+	 */
+	void CookMesh(const aiMesh* mesh, const aiScene* scene);
+
+	/**
+	 * Help method appending raw bytes to the cooked content
+	 *
+	 * \param data - bytes to be appended
+	 * \param size - number of bytes
+	 */
+	void Write(const void* data, const size_t& size);
+
+	/**
+	 * Help method appending a string padded to 4 bytes
+	 *
+	 * \param value - string to be appended
+	 */
+	void WriteString(const std::string& value);
+
+	/**
+	 * Help method reading raw bytes from the content
+	 *
+	 * \param data - destination of the bytes
+	 * \param size - number of bytes
+	 *
+	 * \return true if there was enough data else false
+	 */
+	bool Read(void* data, const size_t& size);
+
+	/**
+	 * Help method reading a string padded to 4 bytes
+	 *
+	 * \param value - read string
+	 *
+	 * \return true if there was enough data else false
+	 */
+	bool ReadString(std::string& value);
+};
@@ -11,20 +11,58 @@
 //----------------------------------------------------------------------------------------
 #pragma once
 
+#include <cfloat>
+#include <cstdint>
 #include <vector>
 
 #include "pgr.h"
 
 #include "HConstants.h"
 #include "CShaderProgram.h"
+#include "CRenderState.h"
+#include "CGeometryArena.h"
 #include "CVertex.h"
+#include "CVertexQuantizer.h"
 #include "CTexture.h"
 #include "CMaterial.h"
 
+/**
+ * Range of the EBO drawn by one draw call
+ */
+struct CIndexSegment
+{
+	/**
+	 * Position of the first index in the EBO
+	 */
+	size_t MFirstIndex;
+
+	/**
+	 * Number of indices
+	 */
+	GLsizei MIndexCount;
+
+	/**
+	 * Value added to every index of the segment
+	 */
+	GLint MBaseVertex;
+};
+
+/**
+ * CPU copies kept by a mesh after its upload
+ *
+ *	 MESH_RETENTION_DISCARD - nothing is kept, only OpenGL's buffers hold the mesh
+ *	MESH_RETENTION_POSITIONS - positions and indices, enough for picking and collision
+ *	     MESH_RETENTION_FULL - all vertex attributes and indices
+ */
+enum EMeshRetention { MESH_RETENTION_DISCARD, MESH_RETENTION_POSITIONS, MESH_RETENTION_FULL };
+
 /**
  * Class representing a mesh in OpenGL abstraction
  * 
- * holds VAO, VBO, EBO of the mesh for draw by the GPU
+ * holds VAO, VBO, EBO of the mesh for draw by the GPU, buffered meshes are placed
+ * into the pages of the geometry arena and share the page's buffers and VAO
+ * 
+ * \see CGeometryArena
  */
 class CMeshGeometry {
 public:
@@ -42,11 +80,46 @@ public:
 	 * \param  indices - indices of the faces, already ordered for EBO setup
 	 * \param textures - textures of the mesh
 	 * \param material - material of the mesh
+	 * \param    format - vertex format uploaded to the VBO
+	 * \param retention - CPU copies kept after the upload
 	 */
 	CMeshGeometry(const std::vector<CVertex>& vertices,
 				  const std::vector<unsigned int>& indices,
 				  const std::vector<CTexture>& textures,
-				  const CMaterial& material);
+				  const CMaterial& material,
+				  const EVertexFormat& format = VERTEX_FORMAT_FLOAT,
+				  const EMeshRetention& retention = MESH_RETENTION_DISCARD);
+
+	/**
+	 * Constructor for a mesh from raw arrays
+	 * 
+	 * uploads the arrays directly, copies are kept only as the retention asks,
+	 * used for meshes mapped from the mesh cache
+	 * 
+	 * meshes of one model are packed to the model's box, so they share
+	 * the dequantization matrix and can be batched
+	 * 
+	 * \param             vertices - vertices for drawing, already ordered for VBO setup
+	 * \param          vertexCount - number of vertices
+	 * \param              indices - indices of the faces, already ordered for EBO setup
+	 * \param           indexCount - number of indices
+	 * \param             textures - textures of the mesh
+	 * \param             material - material of the mesh
+	 * \param               format - vertex format uploaded to the VBO
+	 * \param            retention - CPU copies kept after the upload
+	 * \param quantizationMinimum - minimal corner of the box positions are packed to, the mesh's box is added
+	 * \param quantizationMaximum - maximal corner of the box positions are packed to, the mesh's box is added
+	 */
+	CMeshGeometry(const CVertex* vertices,
+				  const size_t& vertexCount,
+				  const unsigned int* indices,
+				  const size_t& indexCount,
+				  const std::vector<CTexture>& textures,
+				  const CMaterial& material,
+				  const EVertexFormat& format = VERTEX_FORMAT_FLOAT,
+				  const EMeshRetention& retention = MESH_RETENTION_DISCARD,
+				  const glm::vec3& quantizationMinimum = glm::vec3(FLT_MAX),
+				  const glm::vec3& quantizationMaximum = glm::vec3(-FLT_MAX));
 
 	/**
 	 * Deinitialzer for a mesh
@@ -62,8 +135,44 @@ public:
 	 * 
 	 * \param vertexCount - number of vertices on one side
 	 * \param		 size - gaps between each vertex
+	 * \param   retention - CPU copies kept after the upload
 	 */
-	void GeneratePlaneMesh(const int& vertexCount, const float& size);
+	void GeneratePlaneMesh(const int& vertexCount, const float& size, const EMeshRetention& retention = MESH_RETENTION_DISCARD);
+
+	/**
+	 * Help method for building a plane mesh on the CPU
+	 * 
+	 * builds the same vertices and indices as GeneratePlaneMesh uploads
+	 * 
+	 * \param vertexCount - number of vertices on one side
+	 * \param        size - gaps between each vertex
+	 * \param    vertices - vertices of the plane
+	 * \param     indices - indices of the plane's triangles
+	 */
+	static void BuildPlaneMesh(const int& vertexCount, const float& size,
+		std::vector<CVertex>& vertices, std::vector<unsigned int>& indices);
+
+	/**
+	 * Help method for generating a plane drawn without any buffers
+	 * 
+	 * the plane is drawn as one triangle strip per row, the vertex shader derives
+	 * the column from gl_VertexID and the row from gl_InstanceID, so nothing is
+	 * allocated or uploaded, the gap between vertices is applied by the shader
+	 * 
+	 * \param vertexCount - number of vertices on one side
+	 */
+	void GenerateProceduralPlane(const int& vertexCount);
+
+	/**
+	 * Help method for generating a mesh drawn without any buffers
+	 * 
+	 * the vertex shader derives every vertex from gl_VertexID and gl_InstanceID
+	 * 
+	 * \param          mode - primitive type
+	 * \param   vertexCount - number of vertices of one instance
+	 * \param instanceCount - number of instances
+	 */
+	void GenerateProceduralMesh(const GLenum& mode, const GLsizei& vertexCount, const GLsizei& instanceCount);
 
 	/**
 	 * Draw method
@@ -71,8 +180,101 @@ public:
 	 * draws mesh with shaderProgram
 	 * 
 	 * \param shaderProgram - shader program used for drawing the mesh
+	 * \param         state - state the binds go through
+	 */
+	void Draw(CShaderProgram& shaderProgram, CRenderState& state);
+
+	/**
+	 * Draw method for parts of a procedural mesh
+	 * 
+	 * draws ranges of the first instance with a single multi-draw call,
+	 * the vertex shader sees the same gl_VertexID as when the whole mesh is drawn
+	 * 
+	 * \param shaderProgram - shader program used for drawing the mesh
+	 * \param         state - state the binds go through
+	 * \param        firsts - first vertex of every range
+	 * \param        counts - number of vertices of every range
+	 */
+	void DrawRanges(CShaderProgram& shaderProgram, CRenderState& state, const std::vector<GLint>& firsts, const std::vector<GLsizei>& counts);
+
+	/**
+	 * Draw method for instances of the mesh
+	 * 
+	 * draws every segment once for all instances, the model matrices come
+	 * from the buffer set by SetInstanceBuffer
+	 * 
+	 * \param shaderProgram - shader program used for drawing the mesh
+	 * \param         state - state the binds go through
+	 * \param         count - number of instances
+	 */
+	void DrawInstanced(CShaderProgram& shaderProgram, CRenderState& state, const GLsizei& count);
+
+	/**
+	 * Attaches a buffer of model matrices to the VAO
+	 * 
+	 * the matrix takes INSTANCE_MATRIX_LOCATION and the three locations after it
+	 * and advances once per instance, draws without instancing ignore it
+	 * 
+	 * \param buffer - OpenGL id of the buffer with one glm::mat4 per instance
+	 */
+	void SetInstanceBuffer(const GLuint& buffer);
+
+	/**
+	 * Checks whether the mesh can be drawn in one batch with another mesh
+	 * 
+	 * the meshes need the same page of the geometry arena, index type, textures and material
+	 * 
+	 * \param mesh - mesh drawn next
+	 * 
+	 * \return true if both meshes can be drawn by one multi-draw call else false
+	 */
+	bool IsBatchableWith(const CMeshGeometry& mesh) const;
+
+	/**
+	 * Appends the draw records of the mesh
+	 * 
+	 * \param commands - draw records, one is appended for every index segment
+	 */
+	void AppendDrawCommands(std::vector<CDrawElementsIndirectCommand>& commands) const;
+
+	/**
+	 * Draw method for a batch of meshes
+	 * 
+	 * sets textures and material of this mesh and draws records of meshes batchable with it
+	 * 
+	 * \param shaderProgram - shader program used for drawing the meshes
+	 * \param         state - state the binds go through
+	 * \param      commands - draw records of the pass
+	 * \param         first - first drawn record
+	 * \param         count - number of drawn records
+	 * \param      indirect - true if the records were uploaded to the indirect buffer
+	 */
+	void DrawCommands(CShaderProgram& shaderProgram, CRenderState& state, const std::vector<CDrawElementsIndirectCommand>& commands,
+		const size_t& first, const size_t& count, const bool& indirect);
+
+	/**
+	 * Checks whether the mesh can be drawn as an instance of another mesh
+	 * 
+	 * the meshes need the same vertices, indices, textures and material,
+	 * vertices are compared through their hash, meshes over INSTANCING_MAX_VERTICES
+	 * are not hashed and are never instances
+	 * 
+	 * \param mesh - mesh drawn instead
+	 * 
+	 * \return true if drawing the other mesh gives the same result else false
 	 */
-	void Draw(CShaderProgram& shaderProgram);
+	bool IsInstanceOf(const CMeshGeometry& mesh) const;
+
+	/**
+	 * Creates a copy drawing the same buffers
+	 * 
+	 * nothing is uploaded for the copy and its Destroy leaves the buffers to this mesh,
+	 * which has to outlive the copy's drawing, textures are not copied, every user
+	 * acquires its own
+	 * 
+	 * \return mesh sharing this mesh's geometry
+	 */
+	CMeshGeometry Share() const;
 
 	/**
 	 * Appends a texture for the mesh
@@ -80,50 +282,298 @@ public:
 	 * \param texture - new texture for the mesh
 	 */
 	void PushTexture(const CTexture& texture);
+
+	/**
+	 * Getter of the index type of the EBO
+	 * 
+	 * \return GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	 */
+	GLenum GetIndexType() const;
+
+	/**
+	 * Getter of the number of draw calls of the mesh
+	 * 
+	 * \return number of index segments
+	 */
+	size_t GetSegmentCount() const;
+
+	/**
+	 * Getter of the vertex array
+	 * 
+	 * \return OpenGL id of the VAO
+	 */
+	GLuint GetVertexArray() const;
+
+	/**
+	 * Getter of the texture used for sorting draws
+	 * 
+	 * \return OpenGL id of the first texture, 0 if the mesh is drawn without textures
+	 */
+	GLuint GetFirstTexture() const;
+
+	/**
+	 * Splits indices into 16-bit segments
+	 * 
+	 * every segment references less than 65536 consecutive vertices and is drawn
+	 * with its own base vertex, meshes needing too many segments keep 32-bit indices
+	 * 
+	 * \param      indices - indices of the faces
+	 * \param   indexCount - number of indices
+	 * \param shortIndices - 16-bit indices relative to the base vertex of their segment
+	 * \param     segments - segments of the indices
+	 * 
+	 * \return GL_UNSIGNED_SHORT if the indices were split else GL_UNSIGNED_INT
+	 */
+	static GLenum SplitIndices(const unsigned int* indices, const size_t& indexCount,
+		std::vector<unsigned short>& shortIndices, std::vector<CIndexSegment>& segments);
+
+	/**
+	 * Getter of the kept vertices
+	 * 
+	 * \return vertices, empty unless kept with MESH_RETENTION_FULL
+	 */
+	const std::vector<CVertex>& GetVertices() const;
+
+	/**
+	 * Getter of the kept positions
+	 * 
+	 * \return positions, empty unless kept with MESH_RETENTION_POSITIONS
+	 */
+	const std::vector<glm::vec3>& GetPositions() const;
+
+	/**
+	 * Getter of the kept indices
+	 * 
+	 * \return indices, empty if kept with MESH_RETENTION_DISCARD
+	 */
+	const std::vector<unsigned int>& GetIndices() const;
+
+	/**
+	 * Getter of the minimal corner of the mesh's bounding box
+	 * 
+	 * \return minimal corner in the mesh space, greater than the maximal one for meshes without vertices
+	 */
+	const glm::vec3& GetBoundsMinimum() const;
+
+	/**
+	 * Getter of the maximal corner of the mesh's bounding box
+	 * 
+	 * \return maximal corner in the mesh space
+	 */
+	const glm::vec3& GetBoundsMaximum() const;
+
+	/**
+	 * Getter of the number of vertices uploaded to the VBO
+	 * 
+	 * \return number of vertices
+	 */
+	size_t GetVertexCount() const;
+
+	/**
+	 * Getter of the number of indices uploaded to the EBO
+	 * 
+	 * \return number of indices
+	 */
+	size_t GetIndexCount() const;
+
+	/**
+	 * Getter of the memory held by the CPU copies
+	 * 
+	 * \return resident bytes
+	 */
+	size_t GetResidentSize() const;
+
+	/**
+	 * Getter of the memory of OpenGL's buffers
+	 * 
+	 * \return bytes of the VBO and EBO
+	 */
+	size_t GetUploadedSize() const;
+
+	/**
+	 * Getter of the memory saved by packing the vertices
+	 * 
+	 * \return bytes the VBO would take more with float vertices
+	 */
+	size_t GetPackedSavedSize() const;
+
+	/**
+	 * Getter of the packing error
+	 * 
+	 * \return largest differences of the packed vertices, zeros for float vertices
+	 */
+	const CQuantizationError& GetQuantizationError() const;
 private:
 	/**
-	 * VBO represented as a vector of CVertex
+	 * CPU copy of the VBO, kept with MESH_RETENTION_FULL
 	 * 
 	 * \see CVertex
 	 */
 	std::vector<CVertex> MVertices;
 
 	/**
-	 * EBO represented as a vector unsigned ints
+	 * CPU copy of the vertex positions, kept with MESH_RETENTION_POSITIONS
+	 */
+	std::vector<glm::vec3> MPositions;
+
+	/**
+	 * CPU copy of the EBO, kept unless MESH_RETENTION_DISCARD
 	 */
 	std::vector<unsigned int> MIndices;
 
+	/**
+	 * CPU copies kept after the upload
+	 */
+	EMeshRetention MRetention = MESH_RETENTION_DISCARD;
+
+	/**
+	 * Corners of the bounding box of the uploaded positions, computed before packing,
+	 * an empty box has the minimum greater than the maximum
+	 */
+	glm::vec3 MBoundsMinimum = glm::vec3(FLT_MAX);
+	glm::vec3 MBoundsMaximum = glm::vec3(-FLT_MAX);
+
+	/**
+	 * Number of vertices uploaded to the VBO
+	 */
+	size_t MVertexCount = 0;
+
+	/**
+	 * Number of indices uploaded to the EBO, used for drawing
+	 */
+	GLsizei MIndexCount = 0;
+
+	/**
+	 * Bytes of the VBO and EBO
+	 */
+	size_t MUploadedSize = 0;
+
+	/**
+	 * Bytes saved by packing the vertices, 0 for float vertices
+	 */
+	size_t MPackedSavedSize = 0;
+
+	/**
+	 * Largest differences of the packed vertices, also kept when they exceed the tolerances
+	 */
+	CQuantizationError MQuantizationError;
+
+	/**
+	 * Primitive type of a procedural mesh
+	 */
+	GLenum MProceduralMode = GL_TRIANGLES;
+
+	/**
+	 * Number of vertices of one instance of a procedural mesh, zero for buffered meshes
+	 */
+	GLsizei MProceduralVertices = 0;
+
+	/**
+	 * Number of instances of a procedural mesh
+	 */
+	GLsizei MProceduralInstances = 0;
+
+	/**
+	 * Type of the indices in the EBO
+	 */
+	GLenum MIndexType = GL_UNSIGNED_INT;
+
+	/**
+	 * Segments of the EBO, each drawn by one draw call
+	 */
+	std::vector<CIndexSegment> MSegments;
+
 	/**
 	 * Textures of the mesh
 	 */
 	std::vector<CTexture> MTextures;
 
 	/**
-	 * VAO of the mesh
+	 * VAO of the mesh, the page's one for meshes in the geometry arena
 	 */
-	GLuint MVertexArrayObject;
+	GLuint MVertexArrayObject = 0;
+
+	/**
+	 * Boolean showing whether the VAO belongs to the mesh and is deleted with it
+	 */
+	bool MOwnsVertexArray = true;
+
+	/**
+	 * Boolean showing whether the VBO and EBO or the arena ranges belong to the mesh and are freed with it
+	 */
+	bool MOwnsBuffers = true;
+
+	/**
+	 * Place of the mesh in the geometry arena, EBO and VBO are the page's ones if it is placed
+	 */
+	CArenaAllocation MAllocation;
 
 	/**
 	 * EBO of the mesh
 	 */
-	GLuint MElementBufferObject;
+	GLuint MElementBufferObject = 0;
 
 	/**
 	 * VBO of the mesh
 	 */
-	GLuint MVertexBufferObject;
+	GLuint MVertexBufferObject = 0;
 
 	/**
 	 * Material of the mesh
 	 */
 	CMaterial MMaterial;
 
+	/**
+	 * Vertex format of the VBO
+	 */
+	EVertexFormat MVertexFormat = VERTEX_FORMAT_FLOAT;
+
+	/**
+	 * Corners of the box positions are packed to, the mesh's bounding box is added to it
+	 */
+	glm::vec3 MQuantizationMinimum = glm::vec3(FLT_MAX);
+	glm::vec3 MQuantizationMaximum = glm::vec3(-FLT_MAX);
+
+	/**
+	 * Matrix mapping packed positions back to the mesh space, identity for float vertices
+	 */
+	glm::mat4 MDequantization = glm::mat4(1.0f);
+
+	/**
+	 * Hash of the uploaded vertices and indices, 0 for meshes which are not hashed
+	 */
+	uint64_t MContentHash = 0;
+
+	/**
+	 * Help method binding textures and setting material uniforms before a draw
+	 * 
+	 * \param shaderProgram - shader program used for drawing the mesh
+	 * \param         state - state the binds go through
+	 */
+	void SetupDraw(CShaderProgram& shaderProgram, CRenderState& state);
+
+	/**
+	 * Help method checking whether the mesh has the textures and material of another mesh
+	 * 
+	 * \param mesh - compared mesh
+	 * 
+	 * \return true if both meshes set the same textures and material else false
+	 */
+	bool HasSameMaterial(const CMeshGeometry& mesh) const;
+
 	/**
 	 * Help method for conversion between C++ and OpenGL vertex abstractions
 	 * 
-	 * convertes MVertices, MIndices into OpenGL's VBO and EBO and encapsulates it into a VAO
+	 * convertes vertices, indices into OpenGL's VBO and EBO and encapsulates it into a VAO,
+	 * vertices are packed into MVertexFormat first, a mesh exceeding the packing tolerances
+	 * is uploaded as floats, the mesh is placed into the geometry arena if it fits a page,
+	 * CPU copies are kept afterwards as MRetention asks
 	 * 
+	 * \param    vertices - vertices to be uploaded
+	 * \param vertexCount - number of vertices
+	 * \param     indices - indices to be uploaded
+	 * \param  indexCount - number of indices
 	 */
-	void SetupMeshGeometry();
+	void SetupMeshGeometry(const CVertex* vertices, const size_t& vertexCount, const unsigned int* indices, const size_t& indexCount);
 };
 
@@ -0,0 +1,127 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CMeshOptimizer.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class reordering mesh geometry for faster drawing
+ *
+ * Reorders triangles for the post-transform vertex cache and for less overdraw
+ * and reorders vertices for linear vertex fetching
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+
+#include "pgr.h"
+
+#include "CVertex.h"
+
+/**
+ * Statistics of a simulated post-transform vertex cache
+ */
+struct CMeshStatistics
+{
+	/**
+	 * Number of triangles
+	 */
+	size_t MTriangles = 0;
+
+	/**
+	 * Number of vertices
+	 */
+	size_t MVertices = 0;
+
+	/**
+	 * Number of vertex shader invocations
+	 */
+	size_t MTransforms = 0;
+
+	/**
+	 * Average cache miss ratio
+	 *
+	 * \return transformed vertices per triangle, 0.5 is the best and 3.0 the worst
+	 */
+	float GetACMR() const;
+
+	/**
+	 * Average transform to vertex ratio
+	 *
+	 * \return transformed vertices per vertex, 1.0 is the best
+	 */
+	float GetATVR() const;
+
+	/**
+	 * Adds statistics of another mesh
+	 *
+	 * \param statistics - statistics to be added
+	 */
+	void Add(const CMeshStatistics& statistics);
+};
+
+/**
+ * Mesh optimizer
+ *
+ * all steps keep the rendered image the same, only order of triangles
+ * and vertices changes, the optimization runs once while cooking the mesh cache
+ *
+ * \see CMeshCache
+ */
+class CMeshOptimizer
+{
+public:
+	/**
+	 * Simulates a FIFO post-transform vertex cache of VERTEX_CACHE_SIZE entries
+	 *
+	 * \param     indices - indices of the triangles
+	 * \param vertexCount - number of vertices
+	 *
+	 * \return statistics of the mesh
+	 */
+	static CMeshStatistics Analyze(const std::vector<unsigned int>& indices, const size_t& vertexCount);
+
+	/**
+	 * Reorders triangles for the post-transform vertex cache
+	 *
+	 * greedy triangle selection scored by cache position and remaining
+	 * valence of the vertices (T. Forsyth, Linear-Speed Vertex Cache Optimisation)
+	 *
+	 * \param     indices - indices of the triangles
+	 * \param vertexCount - number of vertices
+	 */
+	static void OptimizeVertexCache(std::vector<unsigned int>& indices, const size_t& vertexCount);
+
+	/**
+	 * Reorders clusters of triangles for less overdraw
+	 *
+	 * splits the cache optimized order into clusters where the cache starts cold
+	 * or where a split costs little and draws outward facing clusters first
+	 *
+	 * \param   indices - indices of the triangles, already optimized for the vertex cache
+	 * \param  vertices - vertices of the mesh
+	 * \param threshold - allowed ACMR of a cluster relative to the whole mesh at a soft split
+	 */
+	static void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<CVertex>& vertices, const float& threshold);
+
+	/**
+	 * Reorders vertices in order of their first use and drops unused vertices
+	 *
+	 * \param vertices - vertices of the mesh
+	 * \param  indices - indices of the triangles, remapped to the new order
+	 */
+	static void OptimizeVertexFetch(std::vector<CVertex>& vertices, std::vector<unsigned int>& indices);
+
+	/**
+	 * Runs all optimization steps
+	 *
+	 * indices which are not a list of whole triangles are left unchanged
+	 *
+	 * \param vertices - vertices of the mesh
+	 * \param  indices - indices of the triangles
+	 * \param   before - statistics of the original order
+	 * \param    after - statistics of the optimized order
+	 */
+	static void Optimize(std::vector<CVertex>& vertices, std::vector<unsigned int>& indices,
+		CMeshStatistics& before, CMeshStatistics& after);
+};
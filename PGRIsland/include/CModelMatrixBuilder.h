@@ -0,0 +1,99 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CModelMatrixBuilder.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class building model matrices from position, size and orientation
+ *
+ * Builds model matrices directly from an orthonormal basis, one at a time or in batches
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+
+#include "pgr.h"
+
+/**
+ * Orientation of a node as an orthonormal basis
+ *
+ * same axes as the camera space of glm::lookAt, the node faces -MBackward
+ */
+struct CBasis
+{
+	/**
+	 * X axis of the node
+	 */
+	glm::vec3 MRight;
+
+	/**
+	 * Y axis of the node
+	 */
+	glm::vec3 MUp;
+
+	/**
+	 * Z axis of the node, opposite to the direction it faces
+	 */
+	glm::vec3 MBackward;
+};
+
+/**
+ * Model matrix builder
+ *
+ * the model matrix of a node used to be inverse(lookAt(position, position + direction, up)) * scale,
+ * lookAt is orthonormal, so its inverse is its basis in columns with the position as translation,
+ * the builder writes those columns directly instead of inverting a general 4x4 matrix
+ *
+ * batches process four nodes at once with SSE, the operations are the same as in the scalar
+ * builder and in the same order, so both give bit identical matrices
+ */
+class CModelMatrixBuilder
+{
+public:
+	/**
+	 * Computes the basis of an orientation
+	 *
+	 * \param direction - direction which the node faces, does not need to be normalized
+	 * \param  upVector - up vector of the node, does not need to be perpendicular to the direction
+	 *
+	 * \return orthonormal basis of the node
+	 */
+	static CBasis ComputeBasis(const glm::vec3& direction, const glm::vec3& upVector);
+
+	/**
+	 * Builds a model matrix from a basis
+	 *
+	 * \param position - position of the node
+	 * \param     size - size of the node
+	 * \param    basis - orientation of the node
+	 *
+	 * \return model matrix of the node
+	 */
+	static glm::mat4 Build(const glm::vec3& position, const glm::vec3& size, const CBasis& basis);
+
+	/**
+	 * Builds a model matrix from a direction and an up vector
+	 *
+	 * \param  position - position of the node
+	 * \param      size - size of the node
+	 * \param direction - direction which the node faces
+	 * \param  upVector - up vector of the node
+	 *
+	 * \return model matrix of the node
+	 */
+	static glm::mat4 Build(const glm::vec3& position, const glm::vec3& size, const glm::vec3& direction, const glm::vec3& upVector);
+
+	/**
+	 * Builds model matrices of selected nodes
+	 *
+	 * \param    indices - indices of the nodes to be built
+	 * \param  positions - positions of all nodes
+	 * \param      sizes - sizes of all nodes
+	 * \param directions - directions of all nodes
+	 * \param  upVectors - up vectors of all nodes
+	 * \param   matrices - model matrices of all nodes, the selected ones are written
+	 */
+	static void BuildBatch(const std::vector<int>& indices, const glm::vec3* positions, const glm::vec3* sizes,
+		const glm::vec3* directions, const glm::vec3* upVectors, glm::mat4* matrices);
+};
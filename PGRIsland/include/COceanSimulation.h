@@ -0,0 +1,178 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       COceanSimulation.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class simulating ocean waves on the CPU
+ *
+ * Evolves a Phillips spectrum in time and transforms it into heights and displacements
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+
+#include "pgr.h"
+
+#include "CFourierTransform.h"
+#include "CThreadPool.h"
+
+/**
+ * Spectral ocean after Tessendorf's Simulating Ocean Water
+ *
+ * the spectrum is evolved for a time and transformed by two inverse FFTs,
+ * one gives the height in its real part and the X displacement in its imaginary part,
+ * the other gives the Z displacement, the patch tiles seamlessly
+ *
+ * the simulation does not touch OpenGL, it can run on any thread
+ */
+class COceanSimulation
+{
+private:
+	/**
+	 * Number of samples on one side of the patch
+	 */
+	int MSize = 0;
+
+	/**
+	 * Inverse transform of the spectrum
+	 */
+	CFourierTransform MTransform;
+
+	/**
+	 * Initial amplitudes h0(k) of every wave vector, signs of the centred grid included
+	 */
+	std::vector<float> MSpectrumReal;
+	std::vector<float> MSpectrumImaginary;
+
+	/**
+	 * Conjugated initial amplitudes of the opposite wave vectors, conj(h0(-k))
+	 */
+	std::vector<float> MConjugateReal;
+	std::vector<float> MConjugateImaginary;
+
+	/**
+	 * Angular frequency of every wave vector
+	 */
+	std::vector<float> MFrequencies;
+
+	/**
+	 * Normalized wave vectors, zero for the constant term
+	 */
+	std::vector<float> MDirectionX;
+	std::vector<float> MDirectionZ;
+
+	/**
+	 * Grid of the height and the X displacement
+	 */
+	std::vector<float> MHeightReal;
+	std::vector<float> MHeightImaginary;
+
+	/**
+	 * Grid of the Z displacement
+	 */
+	std::vector<float> MDisplacementReal;
+	std::vector<float> MDisplacementImaginary;
+
+	/**
+	 * Scale of the horizontal displacement, zero keeps the vertices above their grid position
+	 */
+	float MChoppiness = 0.0f;
+
+	/**
+	 * X displacement, height and Z displacement of every sample, RGBA texels
+	 */
+	std::vector<float> MDisplacement;
+
+	/**
+	 * Largest height of the last step, absolute value
+	 */
+	float MMaxHeight = 0.0f;
+
+	/**
+	 * Largest horizontal displacement of the last step
+	 */
+	float MMaxDisplacement = 0.0f;
+
+	/**
+	 * Help method evolving the spectrum of rows and transforming them
+	 *
+	 * \param     time - simulated time
+	 * \param firstRow - first row
+	 * \param rowCount - number of rows
+	 */
+	void SimulateRows(const float& time, const int& firstRow, const int& rowCount);
+
+	/**
+	 * Help method writing rows of the transformed grids into the displacement texels
+	 *
+	 * \param        firstRow - first row
+	 * \param        rowCount - number of rows
+	 * \param       maxHeight - largest height of the rows
+	 * \param maxDisplacement - largest horizontal displacement of the rows
+	 */
+	void WriteRows(const int& firstRow, const int& rowCount, float& maxHeight, float& maxDisplacement);
+public:
+	/**
+	 * Initializer of the simulation
+	 *
+	 * generates the initial spectrum from Gaussian random numbers
+	 *
+	 * \param       size - number of samples on one side, a power of two
+	 * \param  patchSize - side of the simulated patch
+	 * \param       wind - wind velocity on the XZ plane
+	 * \param  amplitude - Phillips spectrum constant
+	 * \param choppiness - scale of the horizontal displacement
+	 * \param       seed - seed of the random numbers
+	 * \param     kernel - instruction set of the FFT
+	 */
+	void Initialize(const int& size, const float& patchSize, const glm::vec2& wind, const float& amplitude,
+		const float& choppiness, const unsigned int& seed, const EFourierKernel& kernel);
+
+	/**
+	 * Computes the displacement of a time
+	 *
+	 * rows and columns are split between the worker threads and the caller,
+	 * the caller works as well, so the step finishes even if all workers are busy
+	 *
+	 * \param time - simulated time
+	 * \param pool - pool of worker threads, nullptr computes everything on the caller
+	 */
+	void Simulate(const float& time, CThreadPool* pool);
+
+	/**
+	 * Getter of the number of samples on one side
+	 *
+	 * \return size of the patch
+	 */
+	int GetSize() const;
+
+	/**
+	 * Getter of the used FFT
+	 *
+	 * \return transform of the spectrum
+	 */
+	const CFourierTransform& GetTransform() const;
+
+	/**
+	 * Getter of the displacement texels
+	 *
+	 * \return X displacement, height, Z displacement and zero for every sample
+	 */
+	const std::vector<float>& GetDisplacement() const;
+
+	/**
+	 * Getter of the largest height of the last step
+	 *
+	 * \return absolute value of the largest height
+	 */
+	float GetMaxHeight() const;
+
+	/**
+	 * Getter of the largest horizontal displacement of the last step
+	 *
+	 * \return largest displacement
+	 */
+	float GetMaxDisplacement() const;
+};
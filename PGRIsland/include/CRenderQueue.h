@@ -0,0 +1,159 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CRenderQueue.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class collecting draws of a frame and submitting them sorted by state
+ *
+ * Sorts draws by 64-bit keys made of program, textures, vertex array and depth
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "pgr.h"
+
+#include "CRenderState.h"
+#include "CGeometryArena.h"
+
+class CSceneNode;
+
+/**
+ * Draw of one node's mesh
+ */
+struct CRenderItem
+{
+	/**
+	 * Sort key of the draw
+	 */
+	uint64_t MKey;
+
+	/**
+	 * Node whose mesh is drawn
+	 */
+	CSceneNode* MNode;
+
+	/**
+	 * Stencil reference, ID of the top level node the draw belongs to
+	 */
+	GLint MStencil;
+};
+
+/**
+ * Neighbouring draws submitted together
+ */
+struct CRenderBatch
+{
+	/**
+	 * First draw and number of draws of the batch
+	 */
+	size_t MFirstItem;
+	size_t MItemCount;
+
+	/**
+	 * First draw record and number of draw records, unused by a single draw
+	 */
+	size_t MFirstCommand;
+	size_t MCommandCount;
+};
+
+/**
+ * Render queue
+ *
+ * nodes push their draws while the scene is traversed, the draws are sorted by their keys
+ * and submitted through a CRenderState, which drops binds repeated by neighbouring draws
+ *
+ * opaque draws have keys holding from the highest bits the program, the first texture,
+ * the vertex array and the depth, so draws sharing state end up next to each other
+ * and are drawn front to back inside a group, every part is cut to its bits, a collision
+ * only makes the order less efficient
+ *
+ * ordered draws (blended objects, the skybox, the water) keep the order of submission,
+ * the ones pushed before the first opaque draw (the skybox) are drawn before all opaque
+ * draws, the others after them, so they are drawn over the opaque scene like before
+ *
+ * neighbouring opaque draws which can be batched, meshes of one model placed in the same
+ * page of the geometry arena with the same textures and material, are merged into one
+ * multi-draw call, the records of all batches are uploaded once per pass
+ */
+class CRenderQueue
+{
+private:
+	/**
+	 * Draws of the frame, the capacity is kept between frames
+	 */
+	std::vector<CRenderItem> MItems;
+
+	/**
+	 * Number of draws pushed since the last clear
+	 */
+	uint64_t MSequence = 0;
+
+	/**
+	 * Boolean showing whether an opaque draw was pushed since the last clear
+	 */
+	bool MOpaquePushed = false;
+
+	/**
+	 * Batches of the last submission and their draw records, the capacity is kept between frames
+	 */
+	std::vector<CRenderBatch> MBatches;
+	std::vector<CDrawElementsIndirectCommand> MCommands;
+
+	/**
+	 * Help method splitting the sorted draws into batches
+	 *
+	 * \param merge - true if neighbouring draws are merged else every draw is a batch of its own
+	 */
+	void BuildBatches(const bool& merge);
+public:
+	/**
+	 * Drops all draws
+	 */
+	void Clear();
+
+	/**
+	 * Pushes a draw which can be reordered
+	 *
+	 * \param        node - node whose mesh is drawn
+	 * \param     stencil - stencil reference of the draw
+	 * \param     program - OpenGL id of the program
+	 * \param     texture - OpenGL id of the first texture, 0 for none
+	 * \param vertexArray - OpenGL id of the vertex array
+	 * \param       depth - distance of the node from the camera
+	 */
+	void PushOpaque(CSceneNode* node, const GLint& stencil, const GLuint& program, const GLuint& texture,
+		const GLuint& vertexArray, const float& depth);
+
+	/**
+	 * Pushes a draw which keeps its order
+	 *
+	 * \param    node - node whose mesh is drawn
+	 * \param stencil - stencil reference of the draw
+	 */
+	void PushOrdered(CSceneNode* node, const GLint& stencil);
+
+	/**
+	 * Sorts the draws by their keys
+	 */
+	void Sort();
+
+	/**
+	 * Draws all draws in their order
+	 *
+	 * \param state - state the binds go through
+	 * \param arena - arena drawing the batches
+	 * \param merge - true if neighbouring draws are merged into batches else false
+	 */
+	void Submit(CRenderState& state, CGeometryArena& arena, const bool& merge);
+
+	/**
+	 * Getter of the number of draws
+	 *
+	 * \return number of draws since the last clear
+	 */
+	size_t GetSize() const;
+};
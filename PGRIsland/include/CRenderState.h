@@ -0,0 +1,156 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CRenderState.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class shadowing OpenGL's binding state
+ *
+ * Remembers the bound program, vertex array, textures and stencil reference to drop redundant calls
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include "pgr.h"
+
+#include "HConstants.h"
+#include "CShaderProgram.h"
+
+/**
+ * Counters of the binds of one frame
+ *
+ * requests are the binds the drawing code asked for, the rest are the binds actually issued
+ */
+struct CRenderStatistics
+{
+	/**
+	 * Programs asked for and programs switched to
+	 */
+	size_t MProgramRequests = 0;
+	size_t MProgramSwitches = 0;
+
+	/**
+	 * Textures asked for and textures bound
+	 */
+	size_t MTextureRequests = 0;
+	size_t MTextureBinds = 0;
+
+	/**
+	 * Vertex arrays asked for and vertex arrays bound
+	 */
+	size_t MVertexArrayRequests = 0;
+	size_t MVertexArrayBinds = 0;
+};
+
+/**
+ * Shadow copy of OpenGL's binding state
+ *
+ * all binds of the drawing code go through the state, a bind of what is already
+ * bound is dropped, the state is forgotten at the start of every frame because
+ * uploads between frames bind buffers and textures directly
+ *
+ * without filtering every requested bind is issued, which is how the scene
+ * was drawn before the render queue, so both ways can be counted
+ */
+class CRenderState
+{
+private:
+	/**
+	 * Whether redundant binds are dropped
+	 */
+	bool MFiltering = true;
+
+	/**
+	 * Bound program
+	 */
+	GLuint MProgram;
+
+	/**
+	 * Bound vertex array
+	 */
+	GLuint MVertexArray;
+
+	/**
+	 * Active texture unit
+	 */
+	int MActiveUnit;
+
+	/**
+	 * Targets and textures bound to the first units
+	 */
+	GLenum MTextureTypes[SHADER_TEXTURE_UNITS];
+	GLuint MTextures[SHADER_TEXTURE_UNITS];
+
+	/**
+	 * Reference value of the stencil test
+	 */
+	GLint MStencilReference;
+
+	/**
+	 * Counters of the current frame
+	 */
+	CRenderStatistics MStatistics;
+
+	/**
+	 * Help method forgetting the bound state
+	 */
+	void Invalidate();
+public:
+	/**
+	 * Constructor of a state knowing nothing about the bindings
+	 */
+	CRenderState();
+
+	/**
+	 * Starts a frame
+	 *
+	 * forgets the bound state and resets the counters
+	 *
+	 * \param filtering - whether redundant binds are dropped
+	 */
+	void Begin(const bool& filtering);
+
+	/**
+	 * Ends a frame
+	 *
+	 * unbinds the vertex array, so uploads between frames cannot change it
+	 */
+	void End();
+
+	/**
+	 * Activates a program for drawing
+	 *
+	 * \param program - activated program, an empty one is skipped
+	 */
+	void UseProgram(const CShaderProgram& program);
+
+	/**
+	 * Binds a vertex array
+	 *
+	 * \param vertexArray - OpenGL id of the vertex array
+	 */
+	void BindVertexArray(const GLuint& vertexArray);
+
+	/**
+	 * Binds a texture to a texture unit
+	 *
+	 * \param    unit - index of the texture unit
+	 * \param    type - target of the texture
+	 * \param texture - OpenGL id of the texture
+	 */
+	void BindTexture(const int& unit, const GLenum& type, const GLuint& texture);
+
+	/**
+	 * Sets the value written to the stencil buffer
+	 *
+	 * \param reference - stencil reference, ID of the drawn top level node
+	 */
+	void SetStencilReference(const GLint& reference);
+
+	/**
+	 * Getter of the counters
+	 *
+	 * \return counters of the current frame
+	 */
+	const CRenderStatistics& GetStatistics() const;
+};
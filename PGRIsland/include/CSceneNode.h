@@ -17,6 +17,50 @@
 #include "CVertex.h"
 #include "CTexture.h"
 #include "CMeshGeometry.h"
+#include "CMeshCache.h"
+#include "CTransformSystem.h"
+#include "CFrustum.h"
+#include "CRenderState.h"
+#include "CRenderQueue.h"
+
+class CSceneNode;
+
+/**
+ * Mesh read from the mesh cache waiting for its upload to a node
+ */
+struct CPendingMesh
+{
+	/**
+	 * Node the mesh belongs to
+	 */
+	std::shared_ptr<CSceneNode> MNode;
+
+	/**
+	 * Mesh geometry read from the mesh cache
+	 */
+	CCachedMesh MMesh;
+};
+
+/**
+ * Counters of one culling pass
+ */
+struct CCullStatistics
+{
+	/**
+	 * Number of bounding boxes tested against the frustum
+	 */
+	size_t MTested = 0;
+
+	/**
+	 * Number of tested boxes outside the frustum, subtrees below them are not tested
+	 */
+	size_t MCulled = 0;
+
+	/**
+	 * Number of nodes whose geometry is drawn
+	 */
+	size_t MDrawn = 0;
+};
 
 /**
  * General scene node/object to be drawn to the window
@@ -24,9 +68,25 @@
  * handles size, position, direction, interaction reaction of the object,
  * object's geometry is loaded through ASSIMP loader or through
  * PGR's Blender exporter files
+ * 
+ * the node is a handle of an entry in gameState.MTransforms, its transform
+ * is relative to the parent node, the entry is created on the first use
+ * on the main thread, so nodes can be built on worker threads
+ * 
+ * the entry also holds the bounding box of the node's mesh, Cull tests
+ * the boxes against the view frustum before drawing and Draw skips
+ * culled subtrees and meshes
+ * 
+ * the node's own mesh is drawn by DrawMesh, Draw goes through the subtree
+ * in the scene's order, Submit pushes the subtree's draws into a render queue instead,
+ * opaque nodes are sorted by their state, the others keep the scene's order
+ * 
+ * \see CTransformSystem
  */
 class CSceneNode
 {
+	friend class CStreamingLoader;
+	friend class CInstancedSceneNode;
 protected:
 	/**
 	 * Boolean for checking whether the node should be drawn
@@ -52,6 +112,17 @@ protected:
 	 */
 	bool MCollision = false;
 
+	/**
+	 * Boolean showing whether the object's geometry is still being streamed,
+	 * a placeholder is drawn in the meantime
+	 */
+	bool MStreaming = false;
+
+	/**
+	 * Vertex format of the object's meshes
+	 */
+	EVertexFormat MVertexFormat = VERTEX_FORMAT_FLOAT;
+
 	/**
 	 * Mesh geometry of the object
 	 */
@@ -66,21 +137,34 @@ protected:
 	std::vector<std::shared_ptr<CSceneNode>> MSceneNodes;
 
 	/**
-	 * Position of the object
+	 * Node holding this node in its MSceneNodes, nullptr for the root
+	 */
+	CSceneNode* MParent = nullptr;
+
+	/**
+	 * Handle of the node's transform, -1 until it is first used
+	 */
+	int MTransform = -1;
+
+	/**
+	 * Boolean showing whether the last culling pass rejected the node with all its children
 	 */
-	glm::vec3 MPosition = glm::vec3(0.0f);
+	bool MCulled = false;
+
 	/**
-	 * Size of the object
+	 * Boolean showing whether the last culling pass kept the node's own mesh
 	 */
-	glm::vec3 MSize = glm::vec3(1.0f);
+	bool MMeshVisible = true;
+
 	/**
-	 * Direction which the object faces
+	 * Boolean showing whether the node's draws can be reordered, inherited by its children
 	 */
-	glm::vec3 MDirection = glm::vec3(0.0f, 0.0f, -1.0f);
+	bool MOpaque = false;
+
 	/**
-	 * Up vector the object
+	 * Boolean showing whether the node's mesh is drawn by an instanced node instead
 	 */
-	glm::vec3 MUpVector = glm::vec3(0.0f, 1.0f, 0.0f);
+	bool MInstanced = false;
 
 	/**
 	 * Time of the object
@@ -99,49 +183,139 @@ protected:
 	/**
 	 * Help method for loading objects geometry
 	 * 
-	 * loads mesh geometry represented in ASSIMP's format and
-	 * converts it into CMeshGeometry
+	 * converts a mesh read from the mesh cache into CMeshGeometry
 	 * 
 	 * loads vertices's position, normals, texture coordinates, material and diffuse texture
 	 * 
 	 * \see CMeshGeometry
+	 * \see CMeshCache
 	 * 
-	 * \param mesh - mesh geometry given by ASSIMP to be converted to program's mesh representation
-	 * \param scene - scene of the object 
+	 * \param    mesh - mesh geometry read from the mesh cache
+	 * \param minimum - minimal corner of the model's box packed positions are quantized to
+	 * \param maximum - maximal corner of the model's box packed positions are quantized to
 	 */
-	void LoadSceneNode(aiMesh* mesh, const aiScene* scene);
+	void LoadSceneNode(const CCachedMesh& mesh, const glm::vec3& minimum, const glm::vec3& maximum);
+
+	/**
+	 * Help method computing the box of all meshes of a model
+	 * 
+	 * \param  meshes - meshes of the model waiting for their upload
+	 * \param minimum - minimal corner of the box
+	 * \param maximum - maximal corner of the box
+	 */
+	static void GetModelBounds(const std::vector<CPendingMesh>& meshes, glm::vec3& minimum, glm::vec3& maximum);
 
 	/**
 	 * Help method for loading meshes' textures
 	 * 
 	 * loads texture files and converts them to CTextures for drawing
 	 * 
-	 * \param mat - material of the mesh that holds the texture's path
-	 * \param type - type of the texture to be loaded
+	 * \param paths - paths of the textures relative to MDirectory
 	 * 
 	 * \return vector of textures for the object
 	 */
-	std::vector<CTexture> LoadMaterialTextures(aiMaterial* mat, aiTextureType type);
+	std::vector<CTexture> LoadMaterialTextures(const std::vector<std::string>& paths);
 
 	/**
 	 * Help method for loading meshes
 	 * 
-	 * navigates in ASSIMP's structure and loads each node's mesh
-	 * goes through all node's in scene recursively
+	 * navigates in the mesh cache's node records and loads each node's mesh
+	 * goes through all node's in the cache recursively
+	 * 
+	 * \param cache - mesh cache positioned at the node record to be loaded
 	 * 
-	 * \param node - ASSIMP node that would be loaded and its child nodes would be processed
-	 * \param scene - scene of the object
+	 * \return true if the whole node was read else false
 	 */
-	void ProcessSceneNode(aiNode* node, const aiScene* scene);
+	bool ProcessSceneNode(CMeshCache& cache);
+
+	/**
+	 * Help method for building child nodes from the mesh cache
+	 * 
+	 * creates the same nodes as ProcessSceneNode without touching OpenGL,
+	 * so it can run on a worker thread, meshes are collected for a later upload
+	 * 
+	 * \param  cache - mesh cache positioned at the node record to be built
+	 * \param meshes - meshes waiting for their upload
+	 * 
+	 * \return true if the whole node was read else false
+	 */
+	bool BuildSceneNode(CMeshCache& cache, std::vector<CPendingMesh>& meshes);
 
 	/**
 	 * Method for creating child nodes to the current node
 	 * 
-	 * child node inherits MDirectory, MPostion, MSize, MDirection of the parent node
+	 * child node inherits MDirectory, MVertexFormat of the parent node
+	 * and is placed at the parent node, its own transform is identity
 	 * 
 	 * \return child node of the caller
 	 */
 	std::shared_ptr<CSceneNode> CreateChildNode();
+
+	/**
+	 * Help method setting the node's bounding box from its mesh
+	 * 
+	 * called after every load of the node's mesh, nodes drawn differently
+	 * than their mesh's box suggests override it
+	 */
+	virtual void UpdateBounds();
+
+	/**
+	 * Setter for the node's bounding box
+	 * 
+	 * a node checking collisions gets a box covering its collision sphere as well,
+	 * so the scene's bounding volume hierarchy finds it for collision queries
+	 * 
+	 * \param minimum - minimal corner relative to the node
+	 * \param maximum - maximal corner relative to the node
+	 */
+	void SetBounds(const glm::vec3& minimum, const glm::vec3& maximum);
+
+	/**
+	 * Marks the node as unbounded, it is never culled
+	 */
+	void SetUnbounded();
+
+	/**
+	 * Help method checking whether the node's mesh can be drawn by a draw shared with other nodes
+	 * 
+	 * the node has to be drawn by CSceneNode::DrawMesh with nothing but its model matrix
+	 * differing from other nodes, nodes drawing themselves differently override it
+	 * 
+	 * \return true if the node can be batched or instanced else false
+	 */
+	virtual bool IsBatchable() const;
+
+	/**
+	 * Help method checking whether the node's mesh can be drawn as an instance
+	 * 
+	 * pickable nodes keep their own stencil reference
+	 * 
+	 * \return true if the node can be instanced else false
+	 */
+	bool IsInstanceable() const;
+
+	/**
+	 * Help method checking whether the node draws anything itself
+	 * 
+	 * \return true if the node has a mesh or draws the streaming placeholder else false
+	 */
+	bool HasGeometry() const;
+
+	/**
+	 * Help method marking the node and all its children visible without any test
+	 * 
+	 * \param statistics - counters of the culling pass
+	 */
+	void MarkVisible(CCullStatistics& statistics);
+
+	/**
+	 * Getter of the node's transform handle
+	 * 
+	 * creates the transform entry after the parent's one on the first call
+	 * 
+	 * \return handle in gameState.MTransforms
+	 */
+	int GetTransform();
 public:
 	/**
 	 * Default constructor
@@ -158,16 +332,21 @@ public:
 	CSceneNode(const CShaderProgram& program);
 
 	/**
-	 * Default destructor
+	 * Destructor
+	 * 
+	 * releases the node's transform, children left behind become roots
 	 */
-	virtual ~CSceneNode() = default;
+	virtual ~CSceneNode();
+
+	CSceneNode(const CSceneNode&) = delete;
+	CSceneNode& operator=(const CSceneNode&) = delete;
 
 	/**
 	 * Deinitializer of a node
 	 * 
 	 * destroys mesh of a node
 	 */
-	void Destroy();
+	virtual void Destroy();
 
 	/**
 	 * Getter of the child nodes
@@ -176,6 +355,19 @@ public:
 	 */
 	std::vector<std::shared_ptr<CSceneNode>>& GetSceneNodes();
 
+	/**
+	 * Prints CPU and GPU memory of the node's meshes
+	 *
+	 * prints one line per mesh with its index type and the bytes 16-bit indices saved,
+	 * packed meshes add the bytes packing saved and the packing error,
+	 * goes through all child nodes recursively
+	 *
+	 * \param     name - name of the node in the report, children append their index
+	 * \param resident - sum of resident CPU bytes, the node's meshes are added
+	 * \param uploaded - sum of bytes in OpenGL's buffers, the node's meshes are added
+	 */
+	void ReportMemory(const std::string& name, size_t& resident, size_t& uploaded);
+
 	/**
 	 * Update method
 	 * 
@@ -185,18 +377,89 @@ public:
 	 */
 	virtual void Update(const float& deltaTime);
 
+	/**
+	 * Culling method
+	 * 
+	 * tests the node's subtree box against the frustum, a rejected subtree is skipped
+	 * by the next Draw without testing its children, the node's own box is tested
+	 * only if it has children, picked objects are never culled,
+	 * no OpenGL call is made, so the pass can run without a window
+	 * 
+	 * \param    frustum - view frustum in the world space
+	 * \param statistics - counters of the pass, the node's tests are added
+	 */
+	void Cull(const CFrustum& frustum, CCullStatistics& statistics);
+
 	/**
 	 * Draw method
 	 * 
-	 * draws object to the screen 
+	 * draws the node's mesh and its children in the scene's order,
+	 * skips what the last Cull rejected
+	 * 
+	 * \param state - state the binds go through
 	 */
-	virtual void Draw();
+	void Draw(CRenderState& state);
+
+	/**
+	 * Draw method of the node's own mesh
+	 * 
+	 * uses the node's program, sets its uniforms and draws the mesh, children are not drawn
+	 * 
+	 * \param state - state the binds go through
+	 */
+	virtual void DrawMesh(CRenderState& state);
+
+	/**
+	 * Pushes draws of the node and its children into a render queue
+	 * 
+	 * skips what the last Cull rejected, opaque draws are keyed by the node's program,
+	 * first texture, vertex array and distance from the camera
+	 * 
+	 * \param   queue - queue collecting the draws of the frame
+	 * \param stencil - stencil reference of the draws
+	 * \param  opaque - true if an ancestor is opaque else false
+	 */
+	void Submit(CRenderQueue& queue, const GLint& stencil, const bool& opaque);
+
+	/**
+	 * Checks whether the node's mesh can be drawn in one batch with another node's mesh
+	 * 
+	 * both nodes need the same program and model matrix and batchable meshes,
+	 * like the meshes of one model loaded as siblings
+	 * 
+	 * \param node - node drawn next
+	 * 
+	 * \return true if both meshes can be drawn by one multi-draw call else false
+	 */
+	bool CanBatchWith(CSceneNode& node);
+
+	/**
+	 * Appends the draw records of the node's mesh
+	 * 
+	 * \param commands - draw records of the pass
+	 */
+	void AppendDrawCommands(std::vector<CDrawElementsIndirectCommand>& commands) const;
+
+	/**
+	 * Draw method of a batch starting with the node
+	 * 
+	 * sets the node's uniforms once and draws the records of all nodes of the batch
+	 * 
+	 * \param    state - state the binds go through
+	 * \param commands - draw records of the pass
+	 * \param    first - first record of the batch
+	 * \param    count - number of records of the batch
+	 * \param indirect - true if the records were uploaded to the indirect buffer
+	 */
+	void DrawBatch(CRenderState& state, const std::vector<CDrawElementsIndirectCommand>& commands,
+		const size_t& first, const size_t& count, const bool& indirect);
 
 	/**
 	 * Model matrix getter
 	 * 
-	 * creates a model matrix for the objects,
-	 * takes into account MPosition, MSize, MDirection of the object
+	 * world transform of the node, the parent's model matrix times
+	 * the node's position, size and direction, recomputed only after a change,
+	 * blended between the last two simulation steps for drawing
 	 * 
 	 * \return mat4 model matrix 
 	 */
@@ -216,7 +479,10 @@ public:
 	/**
 	 * Object loader
 	 * 
-	 * loads object through ASSIMP's interface
+	 * loads object through ASSIMP's interface, the result is stored in the mesh cache
+	 * and following loads of an unchanged file map the cache instead
+	 * 
+	 * \see CMeshCache
 	 * 
 	 * \param file - path to the object's file
 	 */
@@ -242,19 +508,38 @@ public:
 					const float* vertexAttributes,
 					const unsigned int* indicies);
 
+	/**
+	 * Object loader
+	 * 
+	 * draws the geometry already uploaded for another node instead of uploading
+	 * the same vertices again, textures are loaded separately
+	 * 
+	 * \see CMeshGeometry::Share
+	 * 
+	 * \param node - node whose mesh is shared, it has to outlive the current node's drawing
+	 */
+	void LoadSceneNode(const CSceneNode& node);
+
 	/**
 	 * Push method to the MSceneNodes
 	 * 
-	 * pushes a node into MSceneNodes
+	 * pushes a node into MSceneNodes, the node becomes the current node's child
 	 * 
 	 * \param node - node that would be added to MSceneNodes
 	 */
 	void PushSceneNode(const std::shared_ptr<CSceneNode>& node);
 
+	/**
+	 * Setter for the vertex format of meshes loaded afterwards
+	 * 
+	 * \param format - vertex format of the node and its children
+	 */
+	void SetVertexFormat(const EVertexFormat& format);
+
 	/**
 	 * Setter for node's position
 	 * 
-	 * \param position - position to be set
+	 * \param position - position relative to the parent node
 	 */
 	void SetPosition(const glm::vec3& position);
 
@@ -272,6 +557,13 @@ public:
 	 */
 	void SetSize(const glm::vec3& scale);
 
+	/**
+	 * Getter of the node's size
+	 * 
+	 * \return scale vector of the node
+	 */
+	glm::vec3 GetSize();
+
 	/**
 	 * Setter for node's direction
 	 * 
@@ -293,6 +585,13 @@ public:
 	 */
 	void SetUpVector(const glm::vec3& upVector);
 
+	/**
+	 * Getter of the node's up vector
+	 * 
+	 * \return up vector of the node
+	 */
+	glm::vec3 GetUpVector();
+
 	/**
 	 * Setter for MPickable
 	 * 
@@ -338,6 +637,13 @@ public:
 	 */
 	void SetOn(const bool& on);
 
+	/**
+	 * Setter for MOpaque
+	 * 
+	 * \param opaque - true if the node and its children can be drawn in any order else false
+	 */
+	void SetOpaque(const bool& opaque);
+
 	/**
 	 * Switch for IsOn	
 	 * 
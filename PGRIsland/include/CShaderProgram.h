@@ -12,13 +12,112 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 
 #include "pgr.h"
 
+#include "HConstants.h"
+
+/**
+ * Locations of the uniforms set for every draw, resolved once after linking
+ * 
+ * -1 marks a uniform the program does not use, setting it does nothing
+ */
+struct CShaderUniforms
+{
+	/**
+	 * Model matrix and time of the node
+	 */
+	GLint MModel = -1;
+	GLint MTime = -1;
+
+	/**
+	 * Whether the model matrices come from the instances
+	 */
+	GLint MInstanced = -1;
+
+	/**
+	 * Samplers texture_diffuse0, texture_diffuse1, ... and whether a texture is used
+	 */
+	GLint MTextures[SHADER_TEXTURE_UNITS] = { -1, -1, -1, -1 };
+	GLint MTextureUse = -1;
+
+	/**
+	 * Material of the mesh
+	 */
+	GLint MMaterialAmbient = -1;
+	GLint MMaterialDiffuse = -1;
+	GLint MMaterialSpecular = -1;
+	GLint MMaterialShininess = -1;
+
+	/**
+	 * Vertex format of the mesh
+	 */
+	GLint MDequantization = -1;
+	GLint MOctahedralNormal = -1;
+
+	/**
+	 * Normal matrix of the water and the skybox's own view and projection
+	 */
+	GLint MNormalMatrix = -1;
+	GLint MView = -1;
+	GLint MProjection = -1;
+
+	/**
+	 * Shading and ocean displacement of the water
+	 */
+	GLint MFlatShading = -1;
+	GLint MOceanEnabled = -1;
+	GLint MOceanDisplacement = -1;
+	GLint MOceanPatchSize = -1;
+
+	/**
+	 * Grid and clipmap of the water
+	 */
+	GLint MGridGap = -1;
+	GLint MClipmapLevels = -1;
+	GLint MCameraPosition = -1;
+	GLint MClipmapResolution = -1;
+	GLint MClipmapTiles = -1;
+	GLint MClipmapOrigins = -1;
+
+	/**
+	 * Blending between the skyboxes and whether it is day
+	 */
+	GLint MBlend = -1;
+	GLint MDay = -1;
+};
+
+/**
+ * Active uniform of a program in the hashed table
+ */
+struct CUniformSlot
+{
+	/**
+	 * Name of the uniform, array elements have their own slots
+	 */
+	std::string MName;
+
+	/**
+	 * Hash of the name
+	 */
+	unsigned int MHash = 0;
+
+	/**
+	 * Location of the uniform, -1 for an empty slot
+	 */
+	GLint MLocation = -1;
+};
+
 /**
  * Class representing a shader program
  * 
  * activates shader program for drawing, sets uniform attributes of the shader program
+ * 
+ * all active uniforms are read after linking into a hashed table with open addressing,
+ * so setting a uniform by name asks OpenGL for nothing but the upload itself, names
+ * are taken as C strings, so looking them up never allocates, uniforms set for every
+ * draw are resolved into CShaderUniforms and set through their locations directly
  */
 class CShaderProgram {
 public:
@@ -57,13 +156,36 @@ public:
 	 */
 	void UseProgram();
 
+	/**
+	 * Getter of the program
+	 * 
+	 * \return OpenGL id of the shader program, 0 if it is not initialized
+	 */
+	GLuint GetProgram() const;
+
+	/**
+	 * Getter of a uniform's location
+	 * 
+	 * \param name - name of the uniform, an element of an array as name[index]
+	 * 
+	 * \return location of the uniform, -1 if the program does not use it
+	 */
+	GLint GetLocation(const char* name) const;
+
+	/**
+	 * Getter of the uniforms set for every draw
+	 * 
+	 * \return locations resolved after linking
+	 */
+	const CShaderUniforms& GetUniforms() const;
+
 	/**
 	 * Uniform setter for a boolean
 	 * 
 	 * \param  name - name of the uniform attribute
 	 * \param value - value of the set boolean
 	 */
-	void SetBool(const std::string& name, bool value) const;
+	void SetBool(const char* name, bool value) const;
 
 	/**
 	 * Uniform setter for a integer
@@ -71,7 +193,7 @@ public:
 	 * \param  name - name of the uniform attribute
 	 * \param value - value of the set integer
 	 */
-	void SetInt(const std::string& name, int value) const;
+	void SetInt(const char* name, int value) const;
 
 	/**
 	 * Uniform setter for a float
@@ -79,32 +201,156 @@ public:
 	 * \param  name - name of the uniform attribute
 	 * \param value - value of the set float
 	 */
-	void SetFloat(const std::string& name, float value) const; 
+	void SetFloat(const char* name, float value) const;
+
+	/**
+	 * Uniform setter for a vec2
+	 * 
+	 * \param  name - name of the uniform attribute
+	 * \param value - value of the set vector
+	 */
+	void SetVec2(const char* name, glm::vec2 value) const;
+
+	/**
+	 * Uniform setter for an ivec2
+	 * 
+	 * \param  name - name of the uniform attribute
+	 * \param value - value of the set vector
+	 */
+	void SetIVec2(const char* name, glm::ivec2 value) const;
+
+	/**
+	 * Uniform setter for an array of ivec2
+	 * 
+	 * \param   name - name of the array without an index
+	 * \param values - values of the first elements
+	 * \param  count - number of the set elements
+	 */
+	void SetIVec2Array(const char* name, const glm::ivec2* values, const int& count) const;
 
 	/**
 	 * Uniform setter for a vec3
-	 *
+	 * 
 	 * \param  name - name of the uniform attribute
 	 * \param value - value of the set vector
 	 */
-	void SetVec3(const std::string& name, glm::vec3 value) const;
+	void SetVec3(const char* name, glm::vec3 value) const;
 
 	/**
 	 * Uniform setter for a vec4
-	 *
+	 * 
 	 * \param  name - name of the uniform attribute
 	 * \param value - value of the set vector
 	 */
-	void SetVec4(const std::string& name, glm::vec4 value) const;
+	void SetVec4(const char* name, glm::vec4 value) const;
+
+	/**
+	 * Uniform setter for a mat3
+	 * 
+	 * \param  name - name of the uniform attribute
+	 * \param value - value of the set mat3
+	 */
+	void SetMat3(const char* name, const glm::mat3& value) const;
 
 	/**
 	 * Uniform setter for a mat4
-	 *
+	 * 
 	 * \param  name - name of the uniform attribute
 	 * \param value - value of the set mat4
 	 */
-	void SetMat4(const std::string& name, const glm::mat4& value) const;
+	void SetMat4(const char* name, const glm::mat4& value) const;
+
+	/**
+	 * Uniform setter for a boolean at a resolved location
+	 * 
+	 * \param location - location of the uniform attribute
+	 * \param    value - value of the set boolean
+	 */
+	void SetBool(const GLint& location, bool value) const;
+
+	/**
+	 * Uniform setter for a integer at a resolved location
+	 * 
+	 * \param location - location of the uniform attribute
+	 * \param    value - value of the set integer
+	 */
+	void SetInt(const GLint& location, int value) const;
+
+	/**
+	 * Uniform setter for a float at a resolved location
+	 * 
+	 * \param location - location of the uniform attribute
+	 * \param    value - value of the set float
+	 */
+	void SetFloat(const GLint& location, float value) const;
+
+	/**
+	 * Uniform setter for a vec2 at a resolved location
+	 * 
+	 * \param location - location of the uniform attribute
+	 * \param    value - value of the set vector
+	 */
+	void SetVec2(const GLint& location, glm::vec2 value) const;
+
+	/**
+	 * Uniform setter for an ivec2 at a resolved location
+	 * 
+	 * \param location - location of the uniform attribute
+	 * \param    value - value of the set vector
+	 */
+	void SetIVec2(const GLint& location, glm::ivec2 value) const;
+
+	/**
+	 * Uniform setter for an array of ivec2 at a resolved location
+	 * 
+	 * \param location - location of the first element
+	 * \param   values - values of the first elements
+	 * \param    count - number of the set elements
+	 */
+	void SetIVec2Array(const GLint& location, const glm::ivec2* values, const int& count) const;
+
+	/**
+	 * Uniform setter for a vec3 at a resolved location
+	 * 
+	 * \param location - location of the uniform attribute
+	 * \param    value - value of the set vector
+	 */
+	void SetVec3(const GLint& location, glm::vec3 value) const;
+
+	/**
+	 * Uniform setter for a mat3 at a resolved location
+	 * 
+	 * \param location - location of the uniform attribute
+	 * \param    value - value of the set mat3
+	 */
+	void SetMat3(const GLint& location, const glm::mat3& value) const;
+
+	/**
+	 * Uniform setter for a mat4 at a resolved location
+	 * 
+	 * \param location - location of the uniform attribute
+	 * \param    value - value of the set mat4
+	 */
+	void SetMat4(const GLint& location, const glm::mat4& value) const;
+
+	/**
+	 * Binds a uniform block to a binding point
+	 * 
+	 * OpenGL 3.3 has no binding qualifier, so blocks are bound once after linking,
+	 * nothing happens if the program has no such block
+	 * 
+	 * \param    name - name of the uniform block
+	 * \param binding - index of the binding point
+	 */
+	void BindUniformBlock(const std::string& name, const GLuint& binding) const;
 protected:
+	/**
+	 * Help method reading all active uniforms of the linked program
+	 * 
+	 * fills the hashed table and resolves the uniforms set for every draw
+	 */
+	void Introspect();
+
 	/**
 	 * Boolean representing if the program is initialized
 	 */
@@ -114,4 +360,16 @@ protected:
 	 * OpenGL id of the shader program
 	 */
 	GLuint MProgram;
+
+	/**
+	 * Hashed table of the active uniforms, its size is a power of two
+	 * 
+	 * shared by all copies of the program, every scene node holds one
+	 */
+	std::shared_ptr<const std::vector<CUniformSlot>> MUniformSlots;
+
+	/**
+	 * Uniforms set for every draw
+	 */
+	CShaderUniforms MUniforms;
 };
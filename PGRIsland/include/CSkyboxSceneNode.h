@@ -27,6 +27,13 @@ private:
      * Member variable for slowing the time to slow the animation
      */
     float MSlow = 1.0f;
+protected:
+    /**
+     * Help method checking whether the node's mesh can be drawn by a draw shared with other nodes
+     * 
+     * \return false, the skybox has its own view matrix and blending
+     */
+    bool IsBatchable() const override;
 public:
     /**
      * Constructor for a skybox
@@ -35,6 +42,14 @@ public:
      * \param slow - slow coeficient for animation
      */
     CSkyboxSceneNode(const CShaderProgram& program, const float& slow);
-    void Draw() override;
+
+    /**
+     * Draw method
+     * 
+     * draws the cube around the camera blending the day and the night
+     * 
+     * \param state - state the binds go through
+     */
+    void DrawMesh(CRenderState& state) override;
 };
 
@@ -43,8 +43,9 @@ public:
      * \param program - program used for drawing the object
      * \param spline - spline along which the object moves
      * \param slow - slow coeficient for slowing the animatiom
+     * \param phase - spline time the object starts at
      */
-    CSplineSceneNode(const CShaderProgram& program, const CCatmulRomSpline& spline, const float& slow);
+    CSplineSceneNode(const CShaderProgram& program, const CCatmulRomSpline& spline, const float& slow, const float& phase = 0.0f);
 
     /**
      * Update function
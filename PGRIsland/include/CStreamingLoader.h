@@ -0,0 +1,206 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CStreamingLoader.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class streaming object geometry in the background
+ *
+ * Imports objects on worker threads and uploads them in small batches every frame
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <list>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pgr.h"
+
+#include "CSceneNode.h"
+#include "CMeshCache.h"
+#include "CThreadPool.h"
+#include "CMeshGeometry.h"
+#include "CShaderProgram.h"
+
+/**
+ * Streaming loader of objects
+ *
+ * nodes are drawn with a placeholder cube until their geometry is streamed,
+ * mesh cache loading or ASSIMP import runs on the pool and the OpenGL thread
+ * uploads finished meshes within a per-frame budget
+ */
+class CStreamingLoader
+{
+private:
+	/**
+	 * Object being streamed
+	 */
+	struct CRequest
+	{
+		/**
+		 * Node receiving the object's geometry
+		 */
+		std::shared_ptr<CSceneNode> MNode;
+
+		/**
+		 * Detached node the child nodes are built in
+		 */
+		std::shared_ptr<CSceneNode> MStaging;
+
+		/**
+		 * Path to the object's file
+		 */
+		std::string MFile;
+
+		/**
+		 * Cache holding the object's content until it is uploaded
+		 */
+		CMeshCache MCache;
+
+		/**
+		 * Meshes waiting for their upload
+		 */
+		std::vector<CPendingMesh> MMeshes;
+
+		/**
+		 * Corners of the box of all meshes, their positions are packed to it
+		 */
+		glm::vec3 MMinimum = glm::vec3(FLT_MAX);
+		glm::vec3 MMaximum = glm::vec3(-FLT_MAX);
+
+		/**
+		 * Number of already uploaded meshes
+		 */
+		size_t MUploaded = 0;
+
+		/**
+		 * Boolean showing whether the worker built the child nodes
+		 */
+		bool MBuilt = false;
+
+		/**
+		 * Future of the worker's job
+		 */
+		std::future<void> MJob;
+	};
+
+	/**
+	 * Pool running the imports, nullptr if objects are loaded right away
+	 */
+	CThreadPool* MPool = nullptr;
+
+	/**
+	 * Objects being streamed
+	 */
+	std::list<CRequest> MRequests;
+
+	/**
+	 * Geometry drawn in place of objects that are not streamed yet
+	 */
+	CMeshGeometry MPlaceholder;
+
+	/**
+	 * Point in time when streaming started
+	 */
+	std::chrono::steady_clock::time_point MStart;
+
+	/**
+	 * Boolean showing whether streaming of all objects was reported
+	 */
+	bool MReported = true;
+
+	/**
+	 * Help method uploading meshes of a streamed object
+	 *
+	 * \param request - object with a finished job
+	 * \param  budget - number of bytes that may be uploaded
+	 *
+	 * \return number of uploaded bytes
+	 */
+	size_t UploadMeshes(CRequest& request, const size_t& budget);
+
+	/**
+	 * Help method replacing the placeholder of a node by its streamed geometry
+	 *
+	 * \param request - object whose meshes are all uploaded
+	 */
+	void Attach(CRequest& request);
+public:
+	/**
+	 * Default constructor
+	 *
+	 * objects are loaded right away until Initialize is called
+	 */
+	CStreamingLoader() = default;
+
+	/**
+	 * Destructor
+	 *
+	 * waits for the running jobs, their content is owned by the loader
+	 */
+	~CStreamingLoader();
+
+	CStreamingLoader(const CStreamingLoader&) = delete;
+	CStreamingLoader& operator=(const CStreamingLoader&) = delete;
+
+	/**
+	 * Starts streaming
+	 *
+	 * creates the placeholder geometry
+	 *
+	 * \param pool - pool running the imports
+	 */
+	void Initialize(CThreadPool& pool);
+
+	/**
+	 * Object loader
+	 *
+	 * queues the object's import and lets the node draw a placeholder,
+	 * loads the object right away if streaming is not initialized
+	 *
+	 * \param node - node receiving the object's geometry
+	 * \param file - path to the object's file
+	 */
+	void LoadSceneNode(const std::shared_ptr<CSceneNode>& node, const std::string& file);
+
+	/**
+	 * Uploads streamed textures and meshes
+	 *
+	 * called once per frame on the OpenGL thread, uploads at most STREAMING_UPLOAD_BUDGET
+	 * bytes but always at least one finished item, so streaming cannot stall
+	 */
+	void Update();
+
+	/**
+	 * Getter whether anything is still being streamed
+	 *
+	 * \return true if all objects and textures are uploaded else false
+	 */
+	bool IsIdle() const;
+
+	/**
+	 * Draws the placeholder geometry
+	 *
+	 * \param shader - shader program with the node's uniforms already set
+	 * \param  state - state the binds go through
+	 */
+	void DrawPlaceholder(CShaderProgram& shader, CRenderState& state);
+
+	/**
+	 * Getter of the placeholder geometry
+	 *
+	 * \return placeholder mesh, its box bounds the nodes still being streamed
+	 */
+	const CMeshGeometry& GetPlaceholder() const;
+
+	/**
+	 * Deinitializer of the loader
+	 *
+	 * waits for the running jobs and destroys meshes that were not attached yet
+	 */
+	void Destroy();
+};
@@ -12,12 +12,54 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <memory>
 #include <iostream>
 
 #include "pgr.h"
 
 #include "../dependencies/stb_image.h"
 
+#include "CCookedTexture.h"
+
+
+/**
+ * Decoded image of a texture
+ *
+ * decoding does not touch OpenGL, so it can run on any thread
+ */
+struct CTextureImage
+{
+	/**
+	 * Path to the image
+	 */
+	std::string MPath;
+
+	/**
+	 * Width of the image
+	 */
+	int MWidth = 0;
+
+	/**
+	 * Height of the image
+	 */
+	int MHeight = 0;
+
+	/**
+	 * Number of bytes per pixel
+	 */
+	int MComponents = 0;
+
+	/**
+	 * Decoded pixels, nullptr if the image is not decoded
+	 */
+	unsigned char* MData = nullptr;
+
+	/**
+	 * Mapped cooked container, used instead of the pixels if present
+	 */
+	std::shared_ptr<CCookedTexture> MCooked;
+};
 
 /**
  * Struct representing a texture
@@ -39,6 +81,11 @@ struct CTexture
 	 */
 	GLenum MType;
 
+	/**
+	 * Size of the texture in graphics memory in bytes
+	 */
+	size_t MSize = 0;
+
 	/**
 	 * Default constructor
 	 * 
@@ -68,10 +115,80 @@ struct CTexture
 	 */
 	CTexture(const std::vector<std::string>& faces);
 
+	/**
+	 * Decodes an image
+	 *
+	 * maps the image's cooked container if it is up to date,
+	 * otherwise decodes the source image
+	 *
+	 * \param  image - image with path to be decoded
+	 * \param cooked - whether a cooked container may be used
+	 *
+	 * \return true if the image was decoded else false
+	 */
+	static bool Decode(CTextureImage& image, const bool& cooked = true);
+
+	/**
+	 * Frees pixels and the container of a decoded image
+	 *
+	 * \param image - image to be freed
+	 */
+	static void Free(CTextureImage& image);
+
+	/**
+	 * Computes size of a texture in graphics memory
+	 *
+	 * \param        width - width of the base level
+	 * \param       height - height of the base level
+	 * \param nrComponents - number of bytes per pixel
+	 * \param      mipmaps - whether the whole mipmap chain is included
+	 *
+	 * \return size in bytes
+	 */
+	static size_t ComputeSize(int width, int height, const int& nrComponents, const bool& mipmaps);
+
+	/**
+	 * Generates an OpenGL texture without any content
+	 *
+	 * \param type - OpenGL texture type
+	 */
+	void Generate(const GLenum& type);
+
+	/**
+	 * Uploads a decoded image as content of a generated 2D texture
+	 *
+	 * \param image - decoded image
+	 * \param clamp - whether the texture should be clamped for banners
+	 */
+	void Upload(const CTextureImage& image, const bool& clamp);
+
+	/**
+	 * Uploads decoded faces as content of a generated cubemap texture
+	 *
+	 * \param faces - decoded faces in order right, left, up, down, back, front
+	 */
+	void UploadCubemap(const std::vector<CTextureImage>& faces);
+
+	/**
+	 * Uploads pre-built levels of a cooked container as content of a generated 2D texture
+	 *
+	 * \param  image - image with a mapped container
+	 * \param clamp - whether the texture should be clamped for banners
+	 */
+	void UploadCooked(const CTextureImage& image, const bool& clamp);
+
+	/**
+	 * Sets wrapping and filtering of a bound 2D texture
+	 *
+	 * \param clamp - whether the texture should be clamped for banners
+	 */
+	void SetSampling(const bool& clamp);
+
 	/**
 	 * Destroy a texture
 	 * 
-	 * deletes OpenGL's abstraction from memory
+	 * releases the texture through the texture registry which
+	 * deletes OpenGL's abstraction from memory once it is not shared
 	 */
 	void Destroy();
 };
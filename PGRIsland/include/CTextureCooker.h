@@ -0,0 +1,63 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CTextureCooker.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class cooking textures from the command line
+ *
+ * Builds mipmap chains of images offline and stores them block compressed
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "pgr.h"
+
+#include "CCookedTexture.h"
+
+/**
+ * Texture cooker class
+ *
+ * runs with the arguments following COOK_TEXTURES_SWITCH:
+ *   [--format auto|rgba8|bc1|bc3] [image...]
+ *
+ * without images all textures of the scene are cooked, auto format chooses
+ * BC1 for opaque images and BC3 for images with alpha,
+ * BC7 containers are accepted by the loader but not produced by the cooker
+ *
+ * \see CCookedTexture
+ * \see HConstants.h
+ */
+class CTextureCooker
+{
+private:
+	/**
+	 * Help method collecting textures of all scene objects
+	 *
+	 * \return paths of the textures
+	 */
+	std::vector<std::string> CollectScenePaths();
+
+	/**
+	 * Cooks an image
+	 *
+	 * \param   path - path to the image
+	 * \param format - requested format, FORMAT_COUNT chooses automatically
+	 *
+	 * \return true if the container was written else false
+	 */
+	bool Cook(const std::string& path, const CCookedTexture::EFormat& format);
+public:
+	/**
+	 * Runs the cooker
+	 *
+	 * \param argc - number of arguments following COOK_TEXTURES_SWITCH
+	 * \param argv - arguments following COOK_TEXTURES_SWITCH
+	 *
+	 * \return zero on success and non-zero on failure
+	 */
+	int Run(int argc, char* argv[]);
+};
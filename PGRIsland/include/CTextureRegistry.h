@@ -0,0 +1,312 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CTextureRegistry.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class sharing loaded textures between scene nodes
+ *
+ * Decodes and uploads every image only once and hands out reference counted textures
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <string>
+#include <list>
+#include <vector>
+#include <chrono>
+#include <future>
+#include <unordered_map>
+
+#include "pgr.h"
+
+#include "CTexture.h"
+#include "CThreadPool.h"
+
+/**
+ * Registry of shared textures
+ *
+ * textures are keyed by canonical path of the image and sampler state,
+ * each acquired texture has to be released again through CTexture::Destroy,
+ * OpenGL texture is deleted when the last reference is released
+ */
+class CTextureRegistry
+{
+private:
+	/**
+	 * Registered texture
+	 */
+	struct CEntry
+	{
+		/**
+		 * Shared texture
+		 */
+		CTexture MTexture;
+
+		/**
+		 * Number of holders of the texture
+		 */
+		unsigned int MReferences = 0;
+	};
+
+	/**
+	 * Image waiting for its upload
+	 */
+	struct CPendingImage
+	{
+		/**
+		 * Image decoded on a worker
+		 */
+		CTextureImage MImage;
+
+		/**
+		 * Time the worker spent decoding in milliseconds
+		 */
+		double MDecodeTime = 0.0;
+
+		/**
+		 * Point in time when the decoding finished
+		 */
+		std::chrono::steady_clock::time_point MDecoded;
+
+		/**
+		 * Future of the decoding job
+		 */
+		std::future<void> MJob;
+	};
+
+	/**
+	 * Texture waiting for its upload
+	 */
+	struct CPendingTexture
+	{
+		/**
+		 * Generated texture without content
+		 */
+		CTexture MTexture;
+
+		/**
+		 * Whether the texture should be clamped for banners
+		 */
+		bool MClamp = false;
+
+		/**
+		 * Images of the texture, one for 2D textures and six for cubemaps
+		 */
+		std::vector<CPendingImage> MImages;
+	};
+
+	/**
+	 * Pool decoding images while uploads are deferred, nullptr if textures are loaded right away
+	 */
+	CThreadPool* MDecodePool = nullptr;
+
+	/**
+	 * Point in time when uploads started to be deferred
+	 */
+	std::chrono::steady_clock::time_point MDeferStart;
+
+	/**
+	 * Textures waiting for their upload
+	 */
+	std::list<CPendingTexture> MPending;
+
+	/**
+	 * Number of decoded images since uploads started to be deferred
+	 */
+	unsigned int MDecodedImages = 0;
+
+	/**
+	 * Time the workers spent decoding in milliseconds
+	 */
+	double MDecodeTime = 0.0;
+
+	/**
+	 * Point in time when the last image finished decoding
+	 */
+	std::chrono::steady_clock::time_point MDecodeEnd;
+
+	/**
+	 * Time spent uploading decoded images in milliseconds
+	 */
+	double MUploadTime = 0.0;
+
+	/**
+	 * Registered textures by key
+	 */
+	std::unordered_map<std::string, CEntry> MEntries;
+
+	/**
+	 * Keys of the registered textures by OpenGL identifier
+	 */
+	std::unordered_map<GLuint, std::string> MKeys;
+
+	/**
+	 * Number of requests served by an already loaded texture
+	 */
+	unsigned int MHits = 0;
+
+	/**
+	 * Number of requests that had to load a texture
+	 */
+	unsigned int MMisses = 0;
+
+	/**
+	 * Bytes that were not decoded and uploaded again thanks to sharing
+	 */
+	size_t MBytesSaved = 0;
+
+	/**
+	 * Help method finding a registered texture
+	 *
+	 * counts a hit and adds a reference if the texture is registered
+	 *
+	 * \param     key - key of the texture
+	 * \param texture - found texture
+	 *
+	 * \return true if the texture is registered else false
+	 */
+	bool Find(const std::string& key, CTexture& texture);
+
+	/**
+	 * Help method registering a newly loaded texture
+	 *
+	 * \param     key - key of the texture
+	 * \param texture - loaded texture
+	 */
+	void Register(const std::string& key, const CTexture& texture);
+
+	/**
+	 * Help method generating a texture and queueing decoding of its images
+	 *
+	 * \param  paths - paths to the images of the texture
+	 * \param   type - OpenGL texture type
+	 * \param  clamp - whether the texture should be clamped for banners
+	 *
+	 * \return texture whose content is uploaded by UploadPending
+	 */
+	CTexture Defer(const std::vector<std::string>& paths, const GLenum& type, const bool& clamp);
+
+	/**
+	 * Help method checking whether all images of a pending texture are decoded
+	 *
+	 * \param pending - pending texture
+	 *
+	 * \return true if the texture can be uploaded without waiting else false
+	 */
+	static bool IsDecoded(const CPendingTexture& pending);
+
+	/**
+	 * Help method uploading a pending texture
+	 *
+	 * waits for its images and frees them after the upload
+	 *
+	 * \param pending - pending texture
+	 *
+	 * \return number of uploaded bytes
+	 */
+	size_t UploadTexture(CPendingTexture& pending);
+public:
+	/**
+	 * Canonical form of a path
+	 *
+	 * unifies separators and resolves '.' and '..' components so that
+	 * different spellings of the same file share one key
+	 *
+	 * \param path - path to be converted
+	 *
+	 * \return canonical path
+	 */
+	static std::string CanonicalPath(const std::string& path);
+
+	/**
+	 * Acquires a 2D texture
+	 *
+	 * \param  path - path to an image
+	 * \param  type - OpenGL texture type
+	 * \param clamp - whether the texture should be clamped for banners
+	 *
+	 * \return shared texture
+	 */
+	CTexture Acquire(const std::string& path, const GLenum& type, const bool& clamp = false);
+
+	/**
+	 * Acquires a cubemap texture
+	 *
+	 * \param faces - paths for each faces of the cubemap in order right, left, up, down, back, front
+	 *
+	 * \return shared texture
+	 */
+	CTexture AcquireCubemap(const std::vector<std::string>& faces);
+
+	/**
+	 * Starts deferring texture uploads
+	 *
+	 * following acquired textures are only generated and their images
+	 * are decoded on the pool until UploadPending is called
+	 *
+	 * \param pool - pool decoding the images
+	 */
+	void DeferUploads(CThreadPool& pool);
+
+	/**
+	 * Waits for the decoded images and uploads them
+	 *
+	 * stops deferring and prints decode time versus upload time
+	 */
+	void UploadPending();
+
+	/**
+	 * Uploads textures whose images are already decoded
+	 *
+	 * never waits for a worker, at least one texture is uploaded if any is ready
+	 *
+	 * \param budget - number of bytes that may be uploaded
+	 *
+	 * \return number of uploaded bytes
+	 */
+	size_t UploadReady(const size_t& budget);
+
+	/**
+	 * Getter whether any texture waits for its upload
+	 *
+	 * \return true if a texture is pending else false
+	 */
+	bool HasPending() const;
+
+	/**
+	 * Releases a texture
+	 *
+	 * deletes the OpenGL texture when no holder is left,
+	 * textures that were not acquired through the registry are deleted right away
+	 *
+	 * \param texture - texture to be released
+	 */
+	void Release(const CTexture& texture);
+
+	/**
+	 * Getter of the hit counter
+	 *
+	 * \return number of requests served by an already loaded texture
+	 */
+	unsigned int GetHits() const;
+
+	/**
+	 * Getter of the miss counter
+	 *
+	 * \return number of requests that had to load a texture
+	 */
+	unsigned int GetMisses() const;
+
+	/**
+	 * Getter of the saved bytes counter
+	 *
+	 * \return bytes that were not decoded and uploaded again
+	 */
+	size_t GetBytesSaved() const;
+
+	/**
+	 * Prints the counters to the standard output
+	 */
+	void PrintStatistics() const;
+};
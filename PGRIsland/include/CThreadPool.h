@@ -0,0 +1,94 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CThreadPool.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class representing a pool of worker threads
+ *
+ * Runs CPU-only jobs like image decoding next to the OpenGL thread
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <future>
+#include <functional>
+#include <condition_variable>
+
+/**
+ * Pool of worker threads
+ *
+ * jobs must not call OpenGL, the context is current only on the main thread
+ */
+class CThreadPool
+{
+private:
+	/**
+	 * Worker threads
+	 */
+	std::vector<std::thread> MWorkers;
+
+	/**
+	 * Jobs waiting for a worker
+	 */
+	std::queue<std::function<void()>> MJobs;
+
+	/**
+	 * Mutex guarding the job queue
+	 */
+	std::mutex MMutex;
+
+	/**
+	 * Condition signaling a new job or stopping of the pool
+	 */
+	std::condition_variable MCondition;
+
+	/**
+	 * Boolean telling the workers to finish
+	 */
+	bool MStopping = false;
+
+	/**
+	 * Help method run by every worker thread
+	 */
+	void WorkerLoop();
+public:
+	/**
+	 * General constructor
+	 *
+	 * starts the worker threads
+	 *
+	 * \param threadCount - number of workers, 0 uses the number of hardware threads
+	 */
+	CThreadPool(const unsigned int& threadCount = 0);
+
+	/**
+	 * Destructor
+	 *
+	 * finishes queued jobs and joins the workers
+	 */
+	~CThreadPool();
+
+	CThreadPool(const CThreadPool&) = delete;
+	CThreadPool& operator=(const CThreadPool&) = delete;
+
+	/**
+	 * Queues a job
+	 *
+	 * \param job - job to be run on a worker
+	 *
+	 * \return future becoming ready once the job has finished
+	 */
+	std::future<void> Enqueue(const std::function<void()>& job);
+
+	/**
+	 * Getter of the worker count
+	 *
+	 * \return number of worker threads
+	 */
+	unsigned int GetThreadCount() const;
+};
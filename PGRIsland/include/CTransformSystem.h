@@ -0,0 +1,416 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CTransformSystem.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class storing transforms and bounds of all scene nodes
+ *
+ * Keeps local and world transforms and bounding boxes in contiguous arrays and updates only changed subtrees
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+
+#include "pgr.h"
+
+#include "HConstants.h"
+#include "CBoundingVolumeHierarchy.h"
+
+class CSceneNode;
+
+/**
+ * Transform hierarchy of the scene
+ *
+ * every node owns a handle to an entry, entries are stored as structure of arrays
+ * ordered parents before children, so one pass over the arrays updates the world
+ * transforms, a changed entry is marked dirty and the pass recomputes only
+ * the dirty entries and their descendants
+ *
+ * world transform of an entry is the world transform of its parent times its local transform
+ *
+ * every entry has a local bounding box of its own geometry, the update transforms it
+ * into an axis aligned world box and merges the world boxes of each subtree, an entry
+ * may be unbounded instead, e.g. the skybox, which makes its whole subtree unbounded
+ *
+ * world boxes of all bounded entries with geometry are leaves of a bounding volume
+ * hierarchy, whose objects are the entries' handles, so spatial queries do not
+ * have to visit every node
+ *
+ * the world transforms before the current simulation step are kept as well,
+ * frames drawn between two steps blend them with the current ones
+ *
+ * the system is used only from the main thread
+ */
+class CTransformSystem
+{
+private:
+	/**
+	 * Index of every handle's entry, -1 for released handles
+	 */
+	std::vector<int> MIndices;
+
+	/**
+	 * Handle of every entry, -1 for released entries
+	 */
+	std::vector<int> MHandles;
+
+	/**
+	 * Node owning every handle, nullptr for released handles and entries without a node
+	 */
+	std::vector<CSceneNode*> MOwners;
+
+	/**
+	 * Leaf of every handle in MHierarchy, -1 for handles without a world box
+	 */
+	std::vector<int> MLeaves;
+
+	/**
+	 * Hierarchy of the entries' world boxes
+	 */
+	CBoundingVolumeHierarchy MHierarchy = CBoundingVolumeHierarchy(SCENE_HIERARCHY_MARGIN);
+
+	/**
+	 * Released handles waiting to be reused
+	 */
+	std::vector<int> MFreeHandles;
+
+	/**
+	 * Entry index of every entry's parent, -1 for roots
+	 */
+	std::vector<int> MParents;
+
+	/**
+	 * Local position, size, direction and up vector of every entry
+	 */
+	std::vector<glm::vec3> MPositions;
+	std::vector<glm::vec3> MSizes;
+	std::vector<glm::vec3> MDirections;
+	std::vector<glm::vec3> MUpVectors;
+
+	/**
+	 * World transform of every entry
+	 */
+	std::vector<glm::mat4> MWorldMatrices;
+
+	/**
+	 * World transform of every entry before the current simulation step
+	 */
+	std::vector<glm::mat4> MPreviousMatrices;
+
+	/**
+	 * Boolean of every entry showing whether its previous world transform is known,
+	 * entries created since the last step are drawn where they are
+	 */
+	std::vector<unsigned char> MInterpolated;
+
+	/**
+	 * Boolean of every entry showing whether it was recomputed since the step began
+	 */
+	std::vector<unsigned char> MStepChanged;
+
+	/**
+	 * Entries recomputed since the step began, every entry at most once
+	 */
+	std::vector<int> MStepUpdated;
+
+	/**
+	 * Fraction of the step the drawn transforms are blended by
+	 */
+	float MInterpolation = 1.0f;
+
+	/**
+	 * Corners of every entry's bounding box relative to the entry, the minimum is greater
+	 * than the maximum for entries without geometry
+	 */
+	std::vector<glm::vec3> MLocalMinimums;
+	std::vector<glm::vec3> MLocalMaximums;
+
+	/**
+	 * Corners of every entry's axis aligned bounding box in the world
+	 */
+	std::vector<glm::vec3> MWorldMinimums;
+	std::vector<glm::vec3> MWorldMaximums;
+
+	/**
+	 * Corners of the world box of every entry and all its descendants
+	 */
+	std::vector<glm::vec3> MSubtreeMinimums;
+	std::vector<glm::vec3> MSubtreeMaximums;
+
+	/**
+	 * Boolean of every entry showing whether its geometry has no bounds
+	 */
+	std::vector<unsigned char> MUnbounded;
+
+	/**
+	 * Boolean of every entry showing whether it or any of its descendants has no bounds
+	 */
+	std::vector<unsigned char> MSubtreeUnbounded;
+
+	/**
+	 * Boolean of every entry showing whether its world transform has to be recomputed
+	 */
+	std::vector<unsigned char> MDirty;
+
+	/**
+	 * First dirty entry, all entries before it are up to date
+	 */
+	size_t MFirstDirty = 0;
+
+	/**
+	 * Boolean showing whether an entry precedes its parent or an entry was released
+	 */
+	bool MReorder = false;
+
+	/**
+	 * Entries recomputed by the last update
+	 */
+	std::vector<int> MUpdated;
+
+	/**
+	 * Help method marking an entry dirty
+	 *
+	 * \param index - index of the entry
+	 */
+	void MarkDirty(const int& index);
+
+	/**
+	 * Help method restoring the order of the entries
+	 *
+	 * drops released entries, entries of a released parent become roots,
+	 * sorts the rest by depth so parents precede children and marks all of them dirty
+	 */
+	void Reorder();
+
+	/**
+	 * Help method merging the world boxes of every subtree
+	 *
+	 * children follow their parents, so a reverse pass reaches every entry
+	 * after all its descendants were merged into it
+	 */
+	void UpdateSubtreeBounds();
+
+	/**
+	 * Help method moving an entry's world box in the hierarchy
+	 *
+	 * inserts or removes the leaf when the entry gains or loses its box
+	 *
+	 * \param index - index of the entry
+	 */
+	void UpdateLeaf(const int& index);
+public:
+	/**
+	 * Creates an entry with identity local transform and no parent
+	 *
+	 * \param owner - node owning the entry, returned for the handles found by the queries
+	 *
+	 * \return handle of the entry
+	 */
+	int Create(CSceneNode* owner = nullptr);
+
+	/**
+	 * Releases an entry, its handle can be reused afterwards
+	 *
+	 * \param handle - handle of the entry
+	 */
+	void Release(const int& handle);
+
+	/**
+	 * Setter for an entry's parent
+	 *
+	 * \param handle - handle of the entry
+	 * \param parent - handle of the new parent, -1 makes the entry a root
+	 */
+	void SetParent(const int& handle, const int& parent);
+
+	/**
+	 * Setter for an entry's local position
+	 *
+	 * \param   handle - handle of the entry
+	 * \param position - position relative to the parent
+	 */
+	void SetPosition(const int& handle, const glm::vec3& position);
+
+	/**
+	 * Setter for an entry's local size
+	 *
+	 * \param handle - handle of the entry
+	 * \param   size - scale relative to the parent
+	 */
+	void SetSize(const int& handle, const glm::vec3& size);
+
+	/**
+	 * Setter for an entry's local direction
+	 *
+	 * \param    handle - handle of the entry
+	 * \param direction - direction which the entry faces relative to the parent
+	 */
+	void SetDirection(const int& handle, const glm::vec3& direction);
+
+	/**
+	 * Setter for an entry's local up vector
+	 *
+	 * \param   handle - handle of the entry
+	 * \param upVector - up vector relative to the parent
+	 */
+	void SetUpVector(const int& handle, const glm::vec3& upVector);
+
+	/**
+	 * Setter for an entry's bounding box
+	 *
+	 * \param  handle - handle of the entry
+	 * \param minimum - minimal corner relative to the entry, greater than the maximum for no geometry
+	 * \param maximum - maximal corner relative to the entry
+	 */
+	void SetBounds(const int& handle, const glm::vec3& minimum, const glm::vec3& maximum);
+
+	/**
+	 * Marks an entry as unbounded
+	 *
+	 * the entry and all its ancestors pass every visibility test
+	 *
+	 * \param handle - handle of the entry
+	 */
+	void SetUnbounded(const int& handle);
+
+	/**
+	 * Getter of an entry's local position
+	 *
+	 * \param handle - handle of the entry
+	 *
+	 * \return position relative to the parent
+	 */
+	glm::vec3 GetPosition(const int& handle) const;
+
+	/**
+	 * Getter of an entry's local size
+	 *
+	 * \param handle - handle of the entry
+	 *
+	 * \return scale relative to the parent
+	 */
+	glm::vec3 GetSize(const int& handle) const;
+
+	/**
+	 * Getter of an entry's local direction
+	 *
+	 * \param handle - handle of the entry
+	 *
+	 * \return direction relative to the parent
+	 */
+	glm::vec3 GetDirection(const int& handle) const;
+
+	/**
+	 * Getter of an entry's local up vector
+	 *
+	 * \param handle - handle of the entry
+	 *
+	 * \return up vector relative to the parent
+	 */
+	glm::vec3 GetUpVector(const int& handle) const;
+
+	/**
+	 * Getter of an entry's world transform
+	 *
+	 * updates the hierarchy first if anything changed
+	 *
+	 * \param handle - handle of the entry
+	 *
+	 * \return model matrix of the entry
+	 */
+	const glm::mat4& GetWorldMatrix(const int& handle);
+
+	/**
+	 * Getter of an entry's drawn transform
+	 *
+	 * blends the world transforms before and after the last simulation step,
+	 * the blend is linear in the matrices' elements, the rotation of one step
+	 * is small enough for the shear to stay invisible
+	 *
+	 * \param handle - handle of the entry
+	 *
+	 * \return model matrix the entry is drawn with
+	 */
+	glm::mat4 GetRenderMatrix(const int& handle);
+
+	/**
+	 * Starts a simulation step
+	 *
+	 * remembers the world transforms of the entries changed by the previous step,
+	 * the unchanged ones are already remembered
+	 */
+	void BeginStep();
+
+	/**
+	 * Setter of the interpolation factor
+	 *
+	 * \param interpolation - fraction of the last step to draw, 1 draws the world transforms
+	 */
+	void SetInterpolation(const float& interpolation);
+
+	/**
+	 * Getter of an entry's world bounding box
+	 *
+	 * updates the hierarchy first if anything changed
+	 *
+	 * \param  handle - handle of the entry
+	 * \param minimum - minimal corner of the box in the world
+	 * \param maximum - maximal corner of the box in the world
+	 *
+	 * \return false if the entry is unbounded else true
+	 */
+	bool GetWorldBounds(const int& handle, glm::vec3& minimum, glm::vec3& maximum);
+
+	/**
+	 * Getter of the world bounding box of an entry and all its descendants
+	 *
+	 * updates the hierarchy first if anything changed
+	 *
+	 * \param  handle - handle of the entry
+	 * \param minimum - minimal corner of the box in the world
+	 * \param maximum - maximal corner of the box in the world
+	 *
+	 * \return false if the entry or any of its descendants is unbounded else true
+	 */
+	bool GetSubtreeBounds(const int& handle, glm::vec3& minimum, glm::vec3& maximum);
+
+	/**
+	 * Getter of the hierarchy of the entries' world boxes
+	 *
+	 * updates the hierarchy first if anything changed
+	 *
+	 * \return hierarchy returning handles of the entries
+	 */
+	const CBoundingVolumeHierarchy& GetHierarchy();
+
+	/**
+	 * Getter of an entry's owner
+	 *
+	 * \param handle - handle of the entry
+	 *
+	 * \return node owning the entry, nullptr if there is none
+	 */
+	CSceneNode* GetOwner(const int& handle) const;
+
+	/**
+	 * Recomputes world transforms and bounds of dirty entries and their descendants,
+	 * the subtree bounds are merged again whenever any entry changed
+	 */
+	void Update();
+
+	/**
+	 * Getter of the number of entries
+	 *
+	 * \return number of entries including released ones not dropped yet
+	 */
+	size_t GetCount() const;
+
+	/**
+	 * Getter of the number of world transforms recomputed by the last update
+	 *
+	 * \return number of recomputed entries
+	 */
+	size_t GetUpdatedCount() const;
+};
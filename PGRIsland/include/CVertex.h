@@ -9,6 +9,8 @@
 */
 //----------------------------------------------------------------------------------------
 #pragma once
+#include <cstdint>
+
 #include "pgr.h"
 
 /**
@@ -31,3 +33,64 @@ struct CVertex
 	 */
 	glm::vec2 MTextureCoordinates;
 };
+
+/**
+ * Vertex formats of the uploaded meshes
+ *
+ *		VERTEX_FORMAT_FLOAT - CVertex as it is, 32 bytes
+ *	 VERTEX_FORMAT_PACKED_8 - CPackedVertex8, 12 bytes
+ *	VERTEX_FORMAT_PACKED_16 - CPackedVertex16, 16 bytes
+ */
+enum EVertexFormat { VERTEX_FORMAT_FLOAT, VERTEX_FORMAT_PACKED_8, VERTEX_FORMAT_PACKED_16 };
+
+/**
+ * Struct for representing a quantized vertex with 8-bit normals
+ *
+ * position is normalized to the mesh's bounding box, normal is octahedral encoded,
+ * texture coordinates are half floats
+ */
+struct CPackedVertex8
+{
+	/**
+	 * Position of the vertex relative to the bounding box of the mesh
+	 */
+	uint16_t MPosition[3];
+
+	/**
+	 * Octahedral encoded normal of the vertex
+	 */
+	int8_t MNormal[2];
+
+	/**
+	 * Texture coordinates of the vertex as half floats
+	 */
+	uint16_t MTextureCoordinates[2];
+};
+
+/**
+ * Struct for representing a quantized vertex with 16-bit normals
+ *
+ * \see CPackedVertex8
+ */
+struct CPackedVertex16
+{
+	/**
+	 * Position of the vertex relative to the bounding box of the mesh
+	 */
+	uint16_t MPosition[3];
+
+	/**
+	 * Keeps the normal aligned to 4 bytes
+	 */
+	uint16_t MPadding;
+
+	/**
+	 * Octahedral encoded normal of the vertex
+	 */
+	int16_t MNormal[2];
+
+	/**
+	 * Texture coordinates of the vertex as half floats
+	 */
+	uint16_t MTextureCoordinates[2];
+};
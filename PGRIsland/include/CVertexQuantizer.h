@@ -0,0 +1,128 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CVertexQuantizer.h
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class packing vertices into compact formats
+ *
+ * Quantizes positions to the mesh's bounding box, encodes normals octahedrally
+ * and stores texture coordinates as half floats
+ *
+*/
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+
+#include "pgr.h"
+
+#include "CVertex.h"
+
+/**
+ * Largest differences between packed vertices and their float originals
+ */
+struct CQuantizationError
+{
+	/**
+	 * Position difference relative to the largest extent of the quantization box
+	 */
+	float MPosition = 0.0f;
+
+	/**
+	 * Angle between the normals in degrees
+	 */
+	float MNormal = 0.0f;
+
+	/**
+	 * Difference of the texture coordinates
+	 */
+	float MTextureCoordinates = 0.0f;
+};
+
+/**
+ * Vertex quantizer
+ *
+ * packed vertices are decoded by the vertex shader, positions are scaled back
+ * by the dequantization matrix applied together with the model matrix
+ *
+ * \see EVertexFormat
+ */
+class CVertexQuantizer
+{
+public:
+	/**
+	 * Getter of the size of a vertex
+	 *
+	 * \param format - vertex format
+	 *
+	 * \return size of a vertex in bytes
+	 */
+	static size_t GetVertexSize(const EVertexFormat& format);
+
+	/**
+	 * Packs vertices and checks them against the originals
+	 *
+	 * positions are quantized to the given box, meshes packed to the same box
+	 * get the same dequantization matrix
+	 *
+	 * \param          format - packed vertex format
+	 * \param        vertices - vertices to be packed
+	 * \param     vertexCount - number of vertices
+	 * \param         minimum - minimal corner of a box containing the positions
+	 * \param         maximum - maximal corner of a box containing the positions
+	 * \param            data - packed vertices
+	 * \param dequantization - matrix mapping packed positions back to the mesh space
+	 * \param           error - largest differences of the unpacked vertices
+	 *
+	 * \return true if the differences are within the tolerances else false
+	 */
+	static bool Pack(const EVertexFormat& format, const CVertex* vertices, const size_t& vertexCount,
+		const glm::vec3& minimum, const glm::vec3& maximum, std::vector<unsigned char>& data, glm::mat4& dequantization, CQuantizationError& error);
+
+	/**
+	 * Unpacks a vertex the same way as the vertex shader
+	 *
+	 * \param          format - packed vertex format
+	 * \param          vertex - packed vertex
+	 * \param dequantization - matrix mapping packed positions back to the mesh space
+	 *
+	 * \return unpacked vertex
+	 */
+	static CVertex Unpack(const EVertexFormat& format, const unsigned char* vertex, const glm::mat4& dequantization);
+
+	/**
+	 * Encodes a normal onto the octahedron
+	 *
+	 * \param normal - normal to be encoded
+	 *
+	 * \return octahedral coordinates in range <-1, 1>
+	 */
+	static glm::vec2 EncodeOctahedral(const glm::vec3& normal);
+
+	/**
+	 * Decodes a normal from the octahedron
+	 *
+	 * \param coordinates - octahedral coordinates in range <-1, 1>
+	 *
+	 * \return normalized normal
+	 */
+	static glm::vec3 DecodeOctahedral(const glm::vec2& coordinates);
+
+	/**
+	 * Converts a float to a half float, rounding to the nearest
+	 *
+	 * \param value - value to be converted
+	 *
+	 * \return bits of the half float
+	 */
+	static uint16_t FloatToHalf(const float& value);
+
+	/**
+	 * Converts a half float to a float
+	 *
+	 * \param value - bits of the half float
+	 *
+	 * \return converted value
+	 */
+	static float HalfToFloat(const uint16_t& value);
+};
@@ -11,30 +11,205 @@
 //----------------------------------------------------------------------------------------
 #pragma once
 
+#include <future>
+
 #include "CSceneNode.h"
+#include "CGpuTimer.h"
+#include "CFrustum.h"
+#include "COceanSimulation.h"
 
 /**
  * Scene node for drawing water
  * 
- * generates a plane mesh that is used for water animation
+ * draws a procedural plane that is used for water animation,
+ * the grid is derived from vertex and instance IDs in the vertex shader,
+ * by default as nested clipmap levels centred on the camera whose density
+ * halves with every level, so the triangle count barely depends on the ocean's size,
+ * waves are read from the FFT ocean simulated on worker threads,
+ * or the sine waves and their normals are evaluated analytically in the vertex shader
  */
 class CWaterPlaneSceneNode : public CSceneNode
 {
 private:
+    /**
+     * Number of clipmap levels, zero if the uniform grid is drawn
+     */
+    int MClipmapLevels = 0;
+
+    /**
+     * Origin of every clipmap level in multiples of the level's vertex gap
+     */
+    std::vector<glm::ivec2> MClipmapOrigins;
+
+    /**
+     * First vertex of every range of visible clipmap tiles
+     */
+    std::vector<GLint> MTileFirsts;
+
+    /**
+     * Number of vertices of every range of visible clipmap tiles
+     */
+    std::vector<GLsizei> MTileCounts;
+
+    /**
+     * Number of clipmap tiles culled in the last frame
+     */
+    int MCulledTiles = 0;
+
+    /**
+     * Number of vertices submitted in the last frame
+     */
+    size_t MSubmittedVertices = 0;
+
+    /**
+     * Largest wave height in the water's model space, vertical bounds of the tiles
+     */
+    float MWaveHeight = WATER_WAVE_HEIGHT;
+
+    /**
+     * Largest horizontal displacement of the waves, tiles' bounds are grown by it
+     */
+    float MWaveDisplacement = 0.0f;
+
+    /**
+     * FFT ocean simulation
+     */
+    COceanSimulation MOcean;
+
+    /**
+     * Step of the ocean simulation running on the thread pool
+     */
+    std::future<void> MOceanJob;
+
+    /**
+     * Texture of the ocean's X displacement, height and Z displacement
+     */
+    GLuint MOceanTexture = 0;
+
+    /**
+     * Pixel buffers alternately filled with a finished step and copied into the texture
+     */
+    GLuint MOceanBuffers[2] = { 0, 0 };
+
+    /**
+     * Pixel buffer copied into the texture next
+     */
+    int MOceanBuffer = 0;
+
+    /**
+     * Boolean showing whether MOceanBuffer holds a step not copied into the texture yet
+     */
+    bool MOceanUploadPending = false;
+
+    /**
+     * Boolean showing whether the water is faceted, lit with one normal per triangle
+     */
+    bool MFlatShading = WATER_FLAT_SHADING;
+
+    /**
+     * Timer measuring the GPU time of drawing the water
+     */
+    CGpuTimer MTimer;
+
+    /**
+     * Moves the clipmap levels with the camera
+     * 
+     * every level snaps to twice its vertex gap, so its vertices stay on the grid
+     * of the next coarser level and the level's hole matches the finer level
+     * 
+     * \param camera - XZ position of the camera in the water's model space
+     */
+    void UpdateClipmap(const glm::vec2& camera);
+
+    /**
+     * Creates the ocean simulation, its texture and pixel buffers and starts the first step
+     */
+    void InitializeOcean();
+
+    /**
+     * Streams finished ocean steps into the texture
+     * 
+     * never waits, the pixel buffer filled in the previous frame is copied into the texture,
+     * a finished step is copied into the other pixel buffer and the next step is started
+     * 
+     * \param state - state the texture is bound through
+     */
+    void UpdateOcean(CRenderState& state);
+
+    /**
+     * Selects the clipmap tiles to be drawn
+     * 
+     * tiles inside the hole of their level are skipped, the others are tested
+     * against the view frustum, visible tiles following each other in the vertex order
+     * are merged into one range of the multi-draw call
+     * 
+     * \param clip - projection * view * model matrix of the water
+     */
+    void CullClipmap(const glm::mat4& clip);
 public:
 
     /**
      * Constructor for water plane
      * 
-     * generates a plane mesh for water animation
+     * sets up a procedural plane for water animation
      * 
      * \param program - program that is used for drawing the object
      */
     CWaterPlaneSceneNode(const CShaderProgram& program);
 
+    /**
+     * Deinitializer of the water
+     * 
+     * waits for the ocean step and destroys the mesh, the ocean's buffers and the timer queries
+     */
+    void Destroy() override;
+
     /**
      * Draw method
+     * 
+     * \param state - state the binds go through
+     */
+    void DrawMesh(CRenderState& state) override;
+
+    /**
+     * Getter of the number of culled clipmap tiles
+     * 
+     * \return tiles culled in the last frame
+     */
+    int GetCulledTiles() const;
+
+    /**
+     * Getter of the number of submitted vertices
+     * 
+     * \return vertices submitted in the last frame
+     */
+    size_t GetSubmittedVertices() const;
+
+    /**
+     * Switch for MFlatShading
+     * 
+     * switches between smooth and faceted water, the GPU timer starts over
+     * 
+     * \return switched MFlatShading value
+     */
+    bool SwitchFlatShading();
+
+    /**
+     * Computes the number of clipmap levels covering the whole uniform grid
+     * 
+     * \param side - number of vertices on one side of the uniform grid
+     * 
+     * \return number of levels
+     */
+    static int ComputeClipmapLevels(const int& side);
+
+    /**
+     * Computes the number of triangles drawn by the clipmap
+     * 
+     * \param levels - number of clipmap levels
+     * 
+     * \return triangles outside the levels' holes
      */
-    void Draw() override;
+    static size_t ComputeClipmapTriangles(const int& levels);
 };
 
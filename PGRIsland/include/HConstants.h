@@ -14,6 +14,7 @@
 #include "pgr.h"
 
 #include "CLight.h"
+#include "CVertex.h"
 
 /**
  * Initial window height
@@ -246,11 +247,6 @@ const std::string SKYBOX_FRAGMENT_SHADER = "shaders/SSkyboxFragmentShader.frag";
  */
 const std::string WATER_VERTEX_SHADER = "shaders/SWaterVertexShader.vert";
 
-/**
- * Water geometry shader source path
- */
-const std::string WATER_GEOMETRY_SHADER = "shaders/SWaterGeometryShader.geom";
-
 /**
  * Water fragment shader source path
  */
@@ -337,28 +333,28 @@ const glm::vec3 STATIC_VIEW_THREE_DIR = glm::vec3(0.577926f, -0.0947738f, -0.810
 const glm::vec3 STATIC_VIEW_THREE_UP = glm::vec3(0.154813f, 0.987948f, -0.00513706f);
 
 /**
- * Camera panning angle
+ * Camera panning speed in degrees per second
  */
-const float PAN_ANGLE = 2.0f;
+const float PAN_SPEED = 60.0f;
 
 /**
- * Camera tilting angle
+ * Camera tilting speed in degrees per second
  */
-const float TILT_ANGLE = 2.0f;
+const float TILT_SPEED = 60.0f;
 
 /**
- * Camera forward and backward coefficient of the directional vector
+ * Camera forward and backward speed along the directional vector in units per second
  * 
  * used for moving back and forward
  */
-const float FRONT_BACK_MOVEMENT_COEF = 1.0f;
+const float FRONT_BACK_MOVEMENT_SPEED = 30.0f;
 
 /**
- * Camera right and left coefficient of the right vector
+ * Camera right and left speed along the right vector in units per second
  * 
  * used for moving right and left
  */
-const float RIGHT_LEFT_MOVEMENT_COEF = 1.0f;
+const float RIGHT_LEFT_MOVEMENT_SPEED = 30.0f;
 
 /**
  * Camera slow coefficient of flight view
@@ -565,6 +561,82 @@ const int WATER_PLANE_SIDE_SIZE = 2000;
  */
 const float WATER_PLANE_VERTEX_GAP = 1.0f;
 
+/**
+ * Whether the water is drawn as camera centred clipmap levels instead of the uniform grid
+ */
+const bool WATER_CLIPMAP_ENABLED = true;
+
+/**
+ * Number of quads on one side of a water clipmap level, a multiple of 4 * WATER_CLIPMAP_TILES
+ */
+const int WATER_CLIPMAP_RESOLUTION = 64;
+
+/**
+ * Number of tiles on one side of a water clipmap level
+ */
+const int WATER_CLIPMAP_TILES = 4;
+
+/**
+ * Largest number of water clipmap levels, has to match MAX_LEVELS in SWaterVertexShader.vert
+ */
+const int WATER_CLIPMAP_MAX_LEVELS = 16;
+
+/**
+ * Largest wave height in the water's model space, bounds of the culled water tiles,
+ * has to cover twice the amplitude in SWaterVertexShader.vert
+ */
+const float WATER_WAVE_HEIGHT = 0.1f;
+
+/**
+ * Whether the water waves come from the FFT ocean simulation instead of the sine waves
+ */
+const bool OCEAN_ENABLED = true;
+
+/**
+ * Number of ocean samples on one side, a power of two
+ */
+const int OCEAN_RESOLUTION = 128;
+
+/**
+ * Side of the ocean patch in the water's model space, the patch repeats over the water
+ */
+const float OCEAN_PATCH_SIZE = 128.0f;
+
+/**
+ * Wind velocity over the ocean, larger wind raises longer waves
+ */
+const glm::vec2 OCEAN_WIND = glm::vec2(4.0f, 2.0f);
+
+/**
+ * Phillips spectrum constant, scales the wave heights
+ */
+const float OCEAN_AMPLITUDE = 2.5e-7f;
+
+/**
+ * Scale of the horizontal displacement, sharpens the wave crests
+ */
+const float OCEAN_CHOPPINESS = 1.0f;
+
+/**
+ * Seed of the random ocean spectrum
+ */
+const unsigned int OCEAN_SEED = 1;
+
+/**
+ * Whether the water starts faceted, every triangle is lit with one normal
+ */
+const bool WATER_FLAT_SHADING = false;
+
+/**
+ * Number of frames averaged by the water's GPU timer before it is printed
+ */
+const int WATER_TIMER_FRAMES = 300;
+
+/**
+ * Number of timer queries in flight, results are read this many frames later
+ */
+const int GPU_TIMER_QUERIES = 4;
+
 /**
  * Viewing angle
  */
@@ -584,3 +656,328 @@ const float FAR_PLANE = 1250.0f;
  * Size of the player
  */
 const glm::vec3 CAMERA_SIZE = glm::vec3(1.0f);
+
+/**
+ * ASSIMP post processing steps for loading models
+ * 
+ * part of the mesh cache key, cached models are cooked again when the steps change
+ */
+const unsigned int MESH_IMPORT_FLAGS = aiProcess_Triangulate
+    | aiProcess_FlipUVs
+    | aiProcess_PreTransformVertices
+    | aiProcess_GenSmoothNormals
+    | aiProcess_JoinIdenticalVertices;
+
+/**
+ * Whether imported models are stored in and loaded from the mesh cache
+ */
+const bool MESH_CACHE_ENABLED = true;
+
+/**
+ * Extension appended to a model path for its mesh cache file
+ */
+const std::string MESH_CACHE_EXTENSION = ".meshcache";
+
+/**
+ * Whether imported meshes are reordered for the vertex cache, overdraw and vertex fetch while cooking
+ */
+const bool MESH_OPTIMIZE_ENABLED = true;
+
+/**
+ * Number of entries of the simulated post-transform vertex cache
+ */
+const size_t VERTEX_CACHE_SIZE = 16;
+
+/**
+ * Allowed ACMR of a cluster relative to the whole mesh when splitting for overdraw
+ */
+const float OVERDRAW_THRESHOLD = 1.05f;
+
+/**
+ * Vertex format of large models, normals keep 16 bits so wide smooth surfaces do not band
+ */
+const EVertexFormat MODEL_VERTEX_FORMAT = VERTEX_FORMAT_PACKED_16;
+
+/**
+ * Vertex format of small props
+ */
+const EVertexFormat PROP_VERTEX_FORMAT = VERTEX_FORMAT_PACKED_8;
+
+/**
+ * Allowed position error of a packed vertex relative to the largest extent of its mesh
+ */
+const float VERTEX_POSITION_TOLERANCE = 1.0e-4f;
+
+/**
+ * Allowed angle between a packed normal and its original in degrees
+ */
+const float VERTEX_NORMAL_TOLERANCE = 1.5f;
+
+/**
+ * Allowed texture coordinates error of a packed vertex
+ */
+const float VERTEX_TEXTURE_COORDINATES_TOLERANCE = 1.0f / 1024.0f;
+
+/**
+ * Least average number of triangles per draw call when a mesh is split for 16-bit indices
+ */
+const size_t INDEX_SEGMENT_MIN_TRIANGLES = 4096;
+
+/**
+ * Paths of all models loaded through ASSIMP
+ */
+const std::vector<std::string> MODEL_PATHS = {
+    ISLAND_PATH,
+    SHIP_PATH,
+    CAMPFIRE_PATH,
+    BUCKET_PATH,
+    CANNON_PATH,
+    TORCH_PATH
+};
+
+/**
+ * Command line switch for running a benchmark instead of the application
+ */
+const std::string BENCHMARK_SWITCH = "--benchmark";
+
+/**
+ * Number of repetitions of a measured benchmark step
+ */
+const int BENCHMARK_ITERATIONS = 5;
+
+/**
+ * Ocean resolutions measured by the FFT benchmark
+ */
+const std::vector<int> OCEAN_BENCHMARK_RESOLUTIONS = { 64, 128, 256, 512 };
+
+/**
+ * Node counts measured by the transform benchmark
+ */
+const std::vector<int> TRANSFORM_BENCHMARK_COUNTS = { 10000, 100000, 1000000 };
+
+/**
+ * Fraction of nodes moved every frame of the transform benchmark
+ */
+const float TRANSFORM_BENCHMARK_MOVED = 0.01f;
+
+/**
+ * Number of nodes measured by the model matrix benchmark
+ */
+const int MODEL_MATRIX_BENCHMARK_NODES = 100000;
+
+/**
+ * Largest error of a built model matrix accepted by the model matrix benchmark
+ *
+ * in units of the last place of 1.0 for the scaled basis, of the position for the translation
+ */
+const float MODEL_MATRIX_TOLERANCE_ULPS = 16.0f;
+
+/**
+ * Whether textures are loaded from cooked containers when they are up to date
+ */
+const bool COOKED_TEXTURES_ENABLED = true;
+
+/**
+ * Extension appended to an image path for its cooked container
+ */
+const std::string COOKED_TEXTURE_EXTENSION = ".ctex";
+
+/**
+ * Command line switch for cooking textures instead of running the application
+ */
+const std::string COOK_TEXTURES_SWITCH = "--cook-textures";
+
+/**
+ * Whether objects are streamed in the background while the scene is already drawn
+ */
+const bool STREAMING_ENABLED = true;
+
+/**
+ * Number of bytes of streamed geometry and textures uploaded per frame
+ */
+const size_t STREAMING_UPLOAD_BUDGET = 4 * 1024 * 1024;
+
+/**
+ * Whether scene nodes outside the view frustum are skipped before drawing
+ */
+const bool CULLING_ENABLED = true;
+
+/**
+ * Number of frames between two prints of the culling statistics
+ */
+const int CULLING_REPORT_FRAMES = 300;
+
+/**
+ * Enlargement of the world boxes in the scene's bounding volume hierarchy,
+ * objects moving less than this keep their place in the tree
+ */
+const float SCENE_HIERARCHY_MARGIN = 0.2f;
+
+/**
+ * Numbers of objects in the bounding volume hierarchy benchmark, when none are given
+ */
+const std::vector<int> HIERARCHY_BENCHMARK_COUNTS = { 1000, 10000, 100000 };
+
+/**
+ * Number of queries of every kind in the bounding volume hierarchy benchmark
+ */
+const int HIERARCHY_BENCHMARK_QUERIES = 1000;
+
+/**
+ * Fraction of objects moved between two refits in the bounding volume hierarchy benchmark
+ */
+const float HIERARCHY_BENCHMARK_MOVED = 0.1f;
+
+/**
+ * Name of the uniform block with per-frame data in the shaders
+ */
+const std::string FRAME_UNIFORM_BLOCK = "Frame";
+
+/**
+ * Binding point of the per-frame uniform buffer
+ */
+const GLuint FRAME_UNIFORM_BINDING = 0;
+
+/**
+ * Number of frames between two prints of the average numbers of OpenGL calls and heap allocations
+ */
+const int GL_CALL_REPORT_FRAMES = 300;
+
+/**
+ * Number of texture samplers of a mesh whose locations are resolved after linking
+ */
+const int SHADER_TEXTURE_UNITS = 4;
+
+/**
+ * Whether the scene is drawn through the render queue at start, switched by 'q'
+ */
+const bool RENDER_QUEUE_ENABLED = true;
+
+/**
+ * First attribute location of the per-instance model matrix, it takes four locations
+ */
+const GLuint INSTANCE_MATRIX_LOCATION = 3;
+
+/**
+ * Whether nodes sharing mesh, material and program are drawn instanced at start, switched by 'i'
+ */
+const bool INSTANCING_ENABLED = true;
+
+/**
+ * Smallest number of nodes drawn as instances of one mesh
+ */
+const size_t INSTANCING_MIN_NODES = 2;
+
+/**
+ * Largest mesh in vertices which can be instanced, bigger meshes are not hashed
+ */
+const size_t INSTANCING_MAX_VERTICES = 65536;
+
+/**
+ * Command line switch adding a school of fish to the scene, followed by the number of fish
+ */
+const std::string FISH_SCHOOL_SWITCH = "--fish-school";
+
+/**
+ * Number of fish of the school sharing one offset from their spline
+ */
+const int FISH_SCHOOL_GROUP_SIZE = 64;
+
+/**
+ * Largest offset of a group of the school from its spline, both ways horizontally
+ * and only downwards vertically, so the school stays under the water
+ */
+const glm::vec3 FISH_SCHOOL_SPREAD = glm::vec3(40.0f, 4.0f, 40.0f);
+
+/**
+ * Numbers of instances in the instancing benchmark
+ */
+const std::vector<int> INSTANCING_BENCHMARK_COUNTS = { 1000, 10000, 100000 };
+
+/**
+ * Whether meshes are placed into the pages of the geometry arena instead of their own buffers
+ */
+const bool GEOMETRY_ARENA_ENABLED = true;
+
+/**
+ * Vertices of one page of the geometry arena, bigger meshes keep their own buffers
+ */
+const size_t GEOMETRY_ARENA_PAGE_VERTICES = 1 << 20;
+
+/**
+ * Bytes of the indices of one page of the geometry arena
+ */
+const size_t GEOMETRY_ARENA_PAGE_INDEX_BYTES = 16 << 20;
+
+/**
+ * Whether the render queue merges neighbouring draws into multi-draw calls at start, switched by 'm'
+ */
+const bool MULTI_DRAW_ENABLED = true;
+
+/**
+ * Fraction of the meshes freed and placed again in every round of the geometry arena benchmark
+ */
+const float ARENA_BENCHMARK_CHURN = 0.5f;
+
+/**
+ * Number of rounds of freeing and placing meshes in the geometry arena benchmark
+ */
+const int ARENA_BENCHMARK_ROUNDS = 100;
+
+/**
+ * Length of a simulation step in seconds, the simulation runs at a fixed rate
+ * and the frames are drawn between its steps
+ */
+const double SIMULATION_STEP = 1.0 / 60.0;
+
+/**
+ * Longest frame time in seconds the simulation catches up with, e.g. after a stall
+ */
+const double SIMULATION_MAX_FRAME_TIME = 0.25;
+
+/**
+ * Most simulation steps run before a frame is drawn
+ */
+const int SIMULATION_MAX_STEPS = 8;
+
+/**
+ * Mean render times of a frame in milliseconds in the timestep benchmark
+ */
+const std::vector<double> TIMESTEP_BENCHMARK_RENDER_TIMES = { 4.0, 16.0, 40.0 };
+
+/**
+ * Largest deviation of a frame's render time from the mean as a fraction of the mean
+ * in the timestep benchmark
+ */
+const double TIMESTEP_BENCHMARK_JITTER = 0.5;
+
+/**
+ * Simulated seconds of every loop in the timestep benchmark
+ */
+const double TIMESTEP_BENCHMARK_SECONDS = 60.0;
+
+/**
+ * Timer interval in milliseconds of the loop driven by glutTimerFunc, compared in the timestep benchmark
+ */
+const int TIMESTEP_BENCHMARK_TIMER = 33;
+
+/**
+ * Command line switch rendering offscreen without a window, followed by the number
+ * of frames and the path of the written frame times
+ */
+const std::string HEADLESS_SWITCH = "--headless";
+
+/**
+ * Number of measured frames of the headless mode
+ */
+const int HEADLESS_FRAMES = 1000;
+
+/**
+ * Number of frames the headless mode draws before it measures, caches and drivers warm up
+ */
+const int HEADLESS_WARMUP_FRAMES = 30;
+
+/**
+ * Path of the frame times written by the headless mode
+ */
+const std::string HEADLESS_OUTPUT = "headless_frames.csv";
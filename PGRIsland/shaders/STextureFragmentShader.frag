@@ -41,32 +41,32 @@ uniform sampler2D texture_diffuse0;
 uniform Material material;
 
 /**
- * Point light
- */
-uniform Light light;
-
-/**
- * Direction of directional light
- */
-uniform Light dirLight;
-
-/**
- * Spotlight parameter
+ * Per-frame data shared by all programs, written once per frame by CFrameUniforms
  *
- *   cameraEye - position of camera, source of spotlight
- *   cameraDir - front vector of camera, direction of casted Light
- *	    cutOff - spotlight cutoff
- * outerCutOff - spotlight outerCutoff 
- */
-uniform vec3 cameraEye;
-uniform vec3 cameraDir;
-uniform float cutOff;
-uniform float outerCutOff;
-
-/**
- * View matrix
+ * the std140 layout has to match CFrameData and the block has to be
+ * the same in every shader of a program
+ *
+ *	         view - view matrix
+ *	   projection - projection matrix
+ *	        light - point light of the campfire
+ *	     dirLight - directional light
+ *	lightPosition - sun position for calculating directional light
+ *	    cameraEye - position of camera, source of spotlight
+ *	    cameraDir - front vector of camera, direction of casted light
+ *	       cutOff - spotlight cutoff
+ *	  outerCutOff - spotlight outer cutoff
  */
-uniform mat4 view;
+layout (std140) uniform Frame {
+	mat4 view;
+	mat4 projection;
+	Light light;
+	Light dirLight;
+	vec3 lightPosition;
+	vec3 cameraEye;
+	vec3 cameraDir;
+	float cutOff;
+	float outerCutOff;
+};
 
 /**
  * Vertex output - fragment inputs
@@ -17,16 +17,66 @@ layout (location = 1) in vec3 normal;
 layout (location = 2) in vec2 texCoord;           
 
 /**
- * Sun position for calcalculating directional light
+ * Model matrix of the instance, read only when drawn instanced
  */
-uniform vec3 lightPosition; 
+layout (location = 3) in mat4 instanceModel;
 
 /**
- * Projection, view, model matrices
+ * Light struct
  */
-uniform mat4 projection;
-uniform mat4 view;     
-uniform mat4 model;      
+struct Light {
+	vec4 vector;
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+	vec3 dim;
+};
+
+/**
+ * Per-frame data shared by all programs, written once per frame by CFrameUniforms
+ *
+ * the std140 layout has to match CFrameData and the block has to be
+ * the same in every shader of a program
+ *
+ *	         view - view matrix
+ *	   projection - projection matrix
+ *	        light - point light of the campfire
+ *	     dirLight - directional light
+ *	lightPosition - sun position for calculating directional light
+ *	    cameraEye - position of camera, source of spotlight
+ *	    cameraDir - front vector of camera, direction of casted light
+ *	       cutOff - spotlight cutoff
+ *	  outerCutOff - spotlight outer cutoff
+ */
+layout (std140) uniform Frame {
+	mat4 view;
+	mat4 projection;
+	Light light;
+	Light dirLight;
+	vec3 lightPosition;
+	vec3 cameraEye;
+	vec3 cameraDir;
+	float cutOff;
+	float outerCutOff;
+};
+
+/**
+ * Model matrix
+ *
+ *	    model - model matrix of a single draw
+ *	instanced - whether every instance has its own instanceModel instead
+ */
+uniform mat4 model;
+uniform bool instanced;
+
+/**
+ * Packed vertices of CVertexQuantizer
+ *
+ *	  dequantization - maps positions from the bounding box of the mesh, identity for float vertices
+ *	octahedralNormal - whether the normal is stored as octahedral coordinates
+ */
+uniform mat4 dequantization;
+uniform bool octahedralNormal;
 
 /**
  * Vertex output - fragment inputs
@@ -46,13 +96,29 @@ out float visibility;
 const float density = 0.0035f;
 const float gradient = 4.0f;
 
+/**
+ * Decodes a normal from the octahedron
+ */
+vec3 decodeOctahedral(vec2 coordinates) {
+  vec3 n = vec3(coordinates, 1.0f - abs(coordinates.x) - abs(coordinates.y));
+  float fold = max(-n.z, 0.0f);
+  n.x += n.x >= 0.0f ? -fold : fold;
+  n.y += n.y >= 0.0f ? -fold : fold;
+  return normalize(n);
+}
+
 void main() {
-  gl_Position = projection * view * model * vec4(position, 1.0f);
-  fPosition = vec3(view * model * vec4(position, 1.0));
-  fNormal = mat3(transpose(inverse(view * model))) * normal; 
+  // the dequantization only scales positions, normals are transformed by the model alone
+  mat4 modelMatrix = instanced ? instanceModel : model;
+  vec4 modelPosition = modelMatrix * dequantization * vec4(position, 1.0f);
+  vec3 vertexNormal = octahedralNormal ? decodeOctahedral(normal.xy) : normal;
+
+  gl_Position = projection * view * modelPosition;
+  fPosition = vec3(view * modelPosition);
+  fNormal = mat3(transpose(inverse(view * modelMatrix))) * vertexNormal; 
   fTexCoord = texCoord;
 
   // fog calculation
-  float cameraVertexDistance = length((view * model * vec4(position, 1.0f)).xyz);
+  float cameraVertexDistance = length((view * modelPosition).xyz);
   visibility = clamp(exp(-pow(cameraVertexDistance * density, gradient)), 0.0f, 1.0f);
 }
@@ -36,38 +36,48 @@ struct Material {
 Material material;
 
 /**
- * Spotlight parameter
+ * Per-frame data shared by all programs, written once per frame by CFrameUniforms
  *
- *   cameraEye - position of camera, source of spotlight
- *   cameraDir - front vector of camera, direction of casted Light
- *	    cutOff - spotlight cutoff
- * outerCutOff - spotlight outerCutoff 
- */
-uniform vec3 cameraEye;
-uniform vec3 cameraDir;
-uniform float cutOff;
-uniform float outerCutOff;
-
-/**
- * Direction of directional light
- */
-uniform Light dirLight;
-
-/**
- * View matrix
+ * the std140 layout has to match CFrameData and the block has to be
+ * the same in every shader of a program
+ *
+ *	         view - view matrix
+ *	   projection - projection matrix
+ *	        light - point light of the campfire
+ *	     dirLight - directional light
+ *	lightPosition - sun position for calculating directional light
+ *	    cameraEye - position of camera, source of spotlight
+ *	    cameraDir - front vector of camera, direction of casted light
+ *	       cutOff - spotlight cutoff
+ *	  outerCutOff - spotlight outer cutoff
  */
-uniform mat4 view;
+layout (std140) uniform Frame {
+	mat4 view;
+	mat4 projection;
+	Light light;
+	Light dirLight;
+	vec3 lightPosition;
+	vec3 cameraEye;
+	vec3 cameraDir;
+	float cutOff;
+	float outerCutOff;
+};
 
 /**
  * Vertex output - fragment inputs
  * 
  *	    fPosition - position of the vertex in camera space
  *		  fNormal - normal of the vertex in camera space
- *		fTexCoord - texturing coordinates of vertex
+ *	  fFlatNormal - normal of the triangle's provoking vertex in camera space
  */
 in vec3 fPosition;
-in vec2 fTexCoord;
 in vec3 fNormal;
+flat in vec3 fFlatNormal;
+
+/**
+ * Whether the triangle is lit with the normal of its provoking vertex
+ */
+uniform bool flatShading;
 
 /**
  * Fog factor
@@ -79,7 +89,7 @@ in float visibility;
  */
 out vec4 color;
 
-vec3 normal = normalize(fNormal);
+vec3 normal;
 
 /**
  * Setups a material for water
@@ -153,6 +163,7 @@ vec3 spotCalc() {
 
 
 void main(void){
+	normal = normalize(flatShading ? fFlatNormal : fNormal);
 	setupMaterial();
 	color = mix(vec4(0.7f, 0.7f, 0.7f, 1.0f), vec4(dirCalc() + spotCalc(), 0.7f), visibility);
 }
\ No newline at end of file
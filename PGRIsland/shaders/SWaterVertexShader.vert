@@ -8,7 +8,78 @@
 */
 //----------------------------------------------------------------------------------------
 #version 330
-layout (location = 0) in vec3 position; 
+
+/**
+ * Light struct
+ */
+struct Light {
+	vec4 vector;
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+	vec3 dim;
+};
+
+/**
+ * Per-frame data shared by all programs, written once per frame by CFrameUniforms
+ *
+ * the std140 layout has to match CFrameData and the block has to be
+ * the same in every shader of a program
+ *
+ *	         view - view matrix
+ *	   projection - projection matrix
+ *	        light - point light of the campfire
+ *	     dirLight - directional light
+ *	lightPosition - sun position for calculating directional light
+ *	    cameraEye - position of camera, source of spotlight
+ *	    cameraDir - front vector of camera, direction of casted light
+ *	       cutOff - spotlight cutoff
+ *	  outerCutOff - spotlight outer cutoff
+ */
+layout (std140) uniform Frame {
+	mat4 view;
+	mat4 projection;
+	Light light;
+	Light dirLight;
+	vec3 lightPosition;
+	vec3 cameraEye;
+	vec3 cameraDir;
+	float cutOff;
+	float outerCutOff;
+};
+
+/**
+ * Gap between vertices of the procedural grid, of the finest level for the clipmap
+ *
+ * the grid has no attributes, every instance draws one row as a triangle strip,
+ * gl_VertexID walks along the row and alternates between its two edges
+ */
+uniform float gridGap;
+
+/**
+ * Most clipmap levels, has to match WATER_CLIPMAP_MAX_LEVELS
+ */
+const int MAX_LEVELS = 16;
+
+/**
+ * Clipmap drawn as triangles, zero levels draw the uniform grid
+ *
+ *	    clipmapLevels - number of levels, the gap doubles with every level
+ *	clipmapResolution - number of quads on one side of a level
+ *	     clipmapTiles - number of tiles on one side of a level
+ *	   clipmapOrigins - first vertex of every level in multiples of the level's gap
+ *	   cameraPosition - XZ position of the camera in model space
+ */
+uniform int clipmapLevels;
+uniform int clipmapResolution;
+uniform int clipmapTiles;
+uniform ivec2 clipmapOrigins[MAX_LEVELS];
+uniform vec2 cameraPosition;
+
+/**
+ * Corners of the two triangles of a quad
+ */
+const ivec2 quadCorners[6] = ivec2[6](ivec2(0, 0), ivec2(0, 1), ivec2(1, 0), ivec2(1, 0), ivec2(0, 1), ivec2(1, 1));
 
 /**
  * Time for calculating height of a wave
@@ -16,11 +87,43 @@ layout (location = 0) in vec3 position;
 uniform float time;
 
 /**
- * Projection, view, model matrices
+ * FFT ocean simulated on the CPU, the sine waves are used without it
+ *
+ *	      oceanEnabled - whether the ocean is used
+ *	oceanDisplacement - X displacement, height and Z displacement of the repeated patch
+ *	    oceanPatchSize - side of the patch in model space
+ */
+uniform bool oceanEnabled;
+uniform sampler2D oceanDisplacement;
+uniform float oceanPatchSize;
+
+/**
+ * Model matrix
+ */
+uniform mat4 model;
+
+/**
+ * Inverse transpose of view * model, transforms normals into camera space
  */
-uniform mat4 projection;
-uniform mat4 view;     
-uniform mat4 model;   
+uniform mat3 normalMatrix;
+
+/**
+ * Vertex output - fragment inputs
+ * 
+ *	    fPosition - position of the vertex in camera space
+ *		  fNormal - normal of the vertex in camera space
+ *	  fFlatNormal - normal of the provoking vertex, used for the whole triangle
+ */
+out vec3 fPosition;
+out vec3 fNormal;
+flat out vec3 fFlatNormal;
+
+/**
+ * Fog constants
+ */
+out float visibility;
+const float density = 0.0025f;
+const float gradient = 4.0f;
 
 const float PI = 3.1415926535897932384626433832795;
 
@@ -32,13 +135,103 @@ const float amplitude = 0.05f;
 /**
  * Calculate wave height according to the time and X, Z coordinates
  */
-float generateHeight(){
+float generateHeight(vec3 position){
 	float component1 = sin(2.0 * PI * time + (position.x * 16.0)) * amplitude;
 	float component2 = sin(2.0 * PI * time + (position.z * position.x * 8.0)) * amplitude;
 	return component1 + component2;
 }
 
+/**
+ * Calculate wave normal as the derivative of generateHeight by X and Z
+ */
+vec3 generateNormal(vec3 position){
+	float slope1 = cos(2.0 * PI * time + (position.x * 16.0)) * amplitude * 16.0;
+	float slope2 = cos(2.0 * PI * time + (position.z * position.x * 8.0)) * amplitude * 8.0;
+	float dx = slope1 + slope2 * position.z;
+	float dz = slope2 * position.x;
+	return normalize(vec3(-dx, 1.0f, -dz));
+}
+
+/**
+ * Calculate displaced position of a grid point on the ocean
+ */
+vec3 oceanPosition(vec2 position){
+	vec3 displacement = textureLod(oceanDisplacement, position / oceanPatchSize, 0.0f).xyz;
+	return vec3(position.x + displacement.x, displacement.y, position.y + displacement.z);
+}
+
+/**
+ * Calculate ocean normal from the displaced neighbours one texel apart
+ */
+vec3 oceanNormal(vec2 position){
+	float texel = oceanPatchSize / float(textureSize(oceanDisplacement, 0).x);
+	vec3 tangent = oceanPosition(position + vec2(texel, 0.0f)) - oceanPosition(position - vec2(texel, 0.0f));
+	vec3 bitangent = oceanPosition(position + vec2(0.0f, texel)) - oceanPosition(position - vec2(0.0f, texel));
+	return normalize(cross(bitangent, tangent));
+}
+
+/**
+ * Calculate position of a clipmap vertex
+ *
+ * the vertex ID is split into level, tile, quad and corner, quads inside the hole
+ * of a level are collapsed, the finer level covers them
+ */
+vec3 generateClipmapPosition(){
+	int tileSize = clipmapResolution / clipmapTiles;
+	int quad = gl_VertexID / 6;
+	int tile = quad / (tileSize * tileSize);
+	int level = tile / (clipmapTiles * clipmapTiles);
+	int tileQuad = quad % (tileSize * tileSize);
+	tile = tile % (clipmapTiles * clipmapTiles);
+
+	ivec2 cell = ivec2(tile % clipmapTiles, tile / clipmapTiles) * tileSize + ivec2(tileQuad % tileSize, tileQuad / tileSize);
+	ivec2 corner = quadCorners[gl_VertexID % 6];
+	if (level > 0)
+	{
+		ivec2 hole = clipmapOrigins[level - 1] / 2 - clipmapOrigins[level];
+		if (all(greaterThanEqual(cell, hole)) && all(lessThan(cell, hole + clipmapResolution / 2)))
+			corner = ivec2(0, 0);
+	}
+
+	ivec2 index = clipmapOrigins[level] + cell + corner;
+	float gap = gridGap * float(1 << level);
+	vec2 position = vec2(index) * gap;
+
+	// towards the outer edge odd vertices slide onto the coarser level's vertices,
+	// the edge matches the next level exactly and the switch between levels is smooth
+	float distanceToCamera = max(abs(position.x - cameraPosition.x), abs(position.y - cameraPosition.y));
+	float morphEnd = float(clipmapResolution / 2 - 2) * gap;
+	float morphRange = float(clipmapResolution / 8) * gap;
+	float morph = clamp((distanceToCamera - (morphEnd - morphRange)) / morphRange, 0.0f, 1.0f);
+	position -= vec2(index & 1) * gap * morph;
+	return vec3(position.x, 0.0f, position.y);
+}
+
 void main(void) {
-	float height = generateHeight();
-	gl_Position = vec4(position.x,  height, position.z, 1.0f);
+	vec3 position;
+	if (clipmapLevels > 0)
+		position = generateClipmapPosition();
+	else
+		position = vec3(gl_VertexID / 2, 0.0f, gl_InstanceID + gl_VertexID % 2) * gridGap;
+	vec3 normal;
+	if (oceanEnabled)
+	{
+		normal = oceanNormal(position.xz);
+		position = oceanPosition(position.xz);
+	}
+	else
+	{
+		normal = generateNormal(position);
+		position.y = generateHeight(position);
+	}
+
+	vec4 viewPosition = view * model * vec4(position, 1.0f);
+	gl_Position = projection * viewPosition;
+	fPosition = vec3(viewPosition);
+	fNormal = normalMatrix * normal;
+	fFlatNormal = fNormal;
+
+	// fog calculation
+	float distanceToCamera = length(fPosition);
+	visibility = clamp(exp(-pow(distanceToCamera * density, gradient)), 0.0f, 1.0f);
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CAllocationCounter.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class counting heap allocations
+ *
+ * Counts calls of the global operator new on the calling thread
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CAllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+/**
+ * Number of allocations of the thread
+ */
+static thread_local size_t threadAllocations = 0;
+
+size_t CAllocationCounter::GetAllocations()
+{
+    return threadAllocations;
+}
+
+/**
+ * Help function allocating memory like the default operator new
+ *
+ * \param size - number of bytes
+ *
+ * \return allocated memory
+ */
+static void* Allocate(std::size_t size)
+{
+    ++threadAllocations;
+    if (size == 0)
+        size = 1;
+    while (true)
+    {
+        void* memory = std::malloc(size);
+        if (memory != nullptr)
+            return memory;
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    return Allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return Allocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
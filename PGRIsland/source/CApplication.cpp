@@ -11,55 +11,93 @@
 //----------------------------------------------------------------------------------------
 #include "../include/CApplication.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <vector>
+
 void Draw() {
+    DrawFrame(gameState.MTimestep.GetInterpolation());
+    glutSwapBuffers();
+}
+
+void DrawFrame(const float& interpolation) {
     glClearStencil(0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
     glEnable(GL_STENCIL_TEST);
     glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    CGLCallCounter::Add(4);
 
-    auto& nodes = gameState.MRoot->GetSceneNodes();
+    // the frame shows the state between the last two simulation steps,
+    // the simulated camera is put back after drawing
+    CCamera camera = gameState.MCamera;
+    gameState.MCamera = CCamera::Interpolate(gameState.MPreviousCamera, camera, interpolation);
+    gameState.MTransforms.SetInterpolation(interpolation);
 
-    for (unsigned int i = 0; i < nodes.size(); ++i) {
-        // Draw id to stencil buffer
-        glStencilFunc(GL_ALWAYS, i + 1, -1);
-        // Draw object
-        nodes[i]->Draw();
-    }
-    glutSwapBuffers();
+    // camera and lights are shared by all draws of the frame
+    gameState.BeginFrame();
+
+    // visibility is decided before the first draw call
+    if (CULLING_ENABLED)
+        gameState.CullScene(gameState.GetProjectionMatrix() * gameState.GetViewMatrix());
+
+    gameState.DrawScene();
+    gameState.MCamera = camera;
+    gameState.EndFrame();
 }
 
-void Timer(int value) {
-    // Calculate time delta
-    int currentFrameTime = glutGet(GLUT_ELAPSED_TIME);
-    gameState.MTimeDelta = (currentFrameTime - gameState.MLastFrameTime) / 1000.0f;
+void Idle() {
+    // Calculate time delta, the monotonic clock is not rounded to milliseconds
+    auto currentFrameTime = std::chrono::steady_clock::now();
+    double frameTime = std::chrono::duration<double>(currentFrameTime - gameState.MLastFrameTime).count();
     gameState.MLastFrameTime = currentFrameTime;
+    gameState.MFrameTimes.Add(frameTime * 1000.0);
+
+    // Upload streamed objects
+    gameState.MStreamingLoader.Update();
+
+    // Run the simulation steps the elapsed time covers
+    int steps = gameState.MTimestep.Advance(frameTime);
+    for (int i = 0; i < steps; ++i)
+        Step((float)gameState.MTimestep.GetStep());
+    gameState.MSimulationSteps += steps;
+
+    // Rendering is not capped, a driver with vertical sync paces it by the swap
+    glutPostRedisplay();
+}
+
+void Step(const float& delta) {
+    // The drawn frames blend the state before and after the step
+    gameState.MPreviousCamera = gameState.MCamera;
+    gameState.MTransforms.BeginStep();
 
     // Update object's time
-    gameState.MRoot->Update(gameState.MTimeDelta);
+    gameState.MRoot->Update(delta);
 
-    // Move camera
+    // Move camera, the speeds are per second
     if (gameState.MKeyMap[KEY_RIGHT_ARROW] == true)
-        gameState.MCamera.Pan(-PAN_ANGLE);
+        gameState.MCamera.Pan(-PAN_SPEED * delta);
     if (gameState.MKeyMap[KEY_LEFT_ARROW] == true)
-        gameState.MCamera.Pan(PAN_ANGLE);
+        gameState.MCamera.Pan(PAN_SPEED * delta);
     if (gameState.MKeyMap[KEY_UP_ARROW] == true)
-        gameState.MCamera.Tilt(TILT_ANGLE);
+        gameState.MCamera.Tilt(TILT_SPEED * delta);
     if (gameState.MKeyMap[KEY_DOWN_ARROW] == true)
-        gameState.MCamera.Tilt(-TILT_ANGLE);
+        gameState.MCamera.Tilt(-TILT_SPEED * delta);
     if (gameState.MKeyMap[KEY_LOWER_W] == true)
-        gameState.MCamera.MoveForwardBackward(FRONT_BACK_MOVEMENT_COEF);
+        gameState.MCamera.MoveForwardBackward(FRONT_BACK_MOVEMENT_SPEED * delta);
     if (gameState.MKeyMap[KEY_LOWER_S] == true)
-        gameState.MCamera.MoveForwardBackward(-FRONT_BACK_MOVEMENT_COEF);
+        gameState.MCamera.MoveForwardBackward(-FRONT_BACK_MOVEMENT_SPEED * delta);
     if (gameState.MKeyMap[KEY_LOWER_A] == true)
-        gameState.MCamera.MoveRightLeft(RIGHT_LEFT_MOVEMENT_COEF);
+        gameState.MCamera.MoveRightLeft(RIGHT_LEFT_MOVEMENT_SPEED * delta);
     if (gameState.MKeyMap[KEY_LOWER_D] == true)
-        gameState.MCamera.MoveRightLeft(-RIGHT_LEFT_MOVEMENT_COEF);
+        gameState.MCamera.MoveRightLeft(-RIGHT_LEFT_MOVEMENT_SPEED * delta);
 
     // Flight view
     if (gameState.MView == 3)
     {
-        gameState.MSplineTime += gameState.MTimeDelta / CAMERA_FLIGHT_SLOW;
+        gameState.MSplineTime += delta / CAMERA_FLIGHT_SLOW;
         if (gameState.MSplineTime >= gameState.MCameraSpline.GetControlPointSize())
             gameState.MSplineTime -= gameState.MCameraSpline.GetControlPointSize();
         glm::vec3 direction = glm::normalize(gameState.MCameraSpline.GetSplineLoopGradient(gameState.MSplineTime));
@@ -78,8 +116,6 @@ void Timer(int value) {
         gameState.MCamera.MEye = position + 0.75f * direction + upVector;
         gameState.MCamera.MUpVector = upVector;
     }
-    glutTimerFunc(33, Timer, 0);
-    glutPostRedisplay();
 }
 
 void Reshape(int newWidth, int newHeight) {
@@ -174,14 +210,19 @@ void MouseMotion(int mouseX, int mouseY) {
     if (mouseX != gameState.MWindowWidth / 2) {
         float deltaX = 0.2f * (mouseX - gameState.MWindowWidth / 2);
         if (fabs(deltaX) < 45.0f) {
+            // mouse look is not a part of the simulation, both cameras turn at once
             gameState.MCamera.Pan(-deltaX);
+            gameState.MPreviousCamera.Pan(-deltaX);
         }
     }
     // If movement registered in y axis
     if (mouseY != gameState.MWindowHeight / 2) {
         float deltaY = 0.2f * (mouseY - gameState.MWindowHeight / 2);
         if (fabs(deltaY) < 45.0f)
+        {
             gameState.MCamera.Tilt(-deltaY);
+            gameState.MPreviousCamera.Tilt(-deltaY);
+        }
     };
 
     // Recenter cursor
@@ -244,6 +285,8 @@ void KeyPressed(unsigned char keyPressed, int mouseX, int mouseY) {
                 default:
                     break;
                 }
+            // the new view is not blended with the old one
+            gameState.MPreviousCamera = gameState.MCamera;
             break;
         // Directional light on/off switch
         case 'r':
@@ -253,6 +296,22 @@ void KeyPressed(unsigned char keyPressed, int mouseX, int mouseY) {
                 gameState.dirLight = DAY_LIGHT;
             gameState.MDay = !gameState.MDay;
             break;
+        // Faceted water on/off switch
+        case 'g':
+            gameState.MWater->SwitchFlatShading();
+            break;
+        // Render queue on/off switch
+        case 'q':
+            gameState.SwitchRenderQueue();
+            break;
+        // Instancing on/off switch
+        case 'i':
+            gameState.SwitchInstancing();
+            break;
+        // Multi-draw on/off switch
+        case 'm':
+            gameState.SwitchMultiDraw();
+            break;
         default:
             ; // printf("Unrecognized key pressed\n");
     }
@@ -315,14 +374,17 @@ void SpecialKeyReleased(int specKeyReleased, int mouseX, int mouseY) {
     }
 }
 
-void CApplication::ApplicationInit() {
+void CApplication::ApplicationInit(const int& width, const int& height) {
     glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
     glEnable(GL_DEPTH_TEST);
-    glViewport(0, 0, glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT));
+    gameState.MWindowWidth = width;
+    gameState.MWindowHeight = height;
+    glViewport(0, 0, (GLsizei)width, (GLsizei)height);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    gameState.MLastFrameTime = glutGet(GLUT_ELAPSED_TIME);
     gameState.InitializeGame();
+    // loading is not a frame
+    gameState.MLastFrameTime = std::chrono::steady_clock::now();
 }
 
 int CApplication::WindowInit(int argc, char* argv[]) {
@@ -342,14 +404,105 @@ int CApplication::WindowInit(int argc, char* argv[]) {
     glutSpecialFunc(SpecialKeyPressed);    
     glutSpecialUpFunc(SpecialKeyReleased);
     glutMouseFunc(MousePressed);
-    glutTimerFunc(33, Timer, 0);
+    glutIdleFunc(Idle);
     if (!pgr::initialize(pgr::OGL_VER_MAJOR, pgr::OGL_VER_MINOR))
         pgr::dieWithError("pgr init failed, required OpenGL not supported?");
 
-    ApplicationInit();
+    ApplicationInit(glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT));
 
     glutMainLoop();
 
-    gameState.MRoot->Destroy();
+    ApplicationDestroy();
     return 0;
+}
+
+void CApplication::ApplicationDestroy() {
+    gameState.MRoot->Destroy();
+    for (const auto& node : gameState.MInstancedNodes)
+        node->Destroy();
+    gameState.MStreamingLoader.Destroy();
+    gameState.MGeometryArena.Destroy();
+    gameState.MFrameUniforms.Destroy();
+}
+
+int CApplication::HeadlessInit(int argc, char* argv[]) {
+    int frames = argc > 1 ? std::atoi(argv[1]) : HEADLESS_FRAMES;
+    std::string output = argc > 2 ? argv[2] : HEADLESS_OUTPUT;
+    if (frames < 1)
+    {
+        std::cerr << "Headless mode needs at least 1 frame, got " << frames << std::endl;
+        return 1;
+    }
+
+    CHeadlessContext context;
+    if (!context.CreateContext(argc, argv))
+        return 1;
+    if (!pgr::initialize(pgr::OGL_VER_MAJOR, pgr::OGL_VER_MINOR))
+    {
+        std::cerr << "pgr init failed, required OpenGL not supported?" << std::endl;
+        context.Destroy();
+        return 1;
+    }
+    if (!context.CreateFramebuffer(WINDOW_WIDTH, WINDOW_HEIGHT))
+    {
+        context.Destroy();
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ApplicationInit(WINDOW_WIDTH, WINDOW_HEIGHT);
+    // the measured frames do not wait for streamed models
+    while (!gameState.MStreamingLoader.IsIdle())
+    {
+        gameState.MStreamingLoader.Update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::cout << "Headless: " << context.GetRenderer() << ", " << WINDOW_WIDTH << "x" << WINDOW_HEIGHT << ", scene loaded in "
+        << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+
+    // Flight view
+    gameState.MView = 3;
+    gameState.MSplineTime = 0.0f;
+
+    std::vector<double> times;
+    times.reserve(frames);
+    CFrameTimeStatistics statistics;
+    for (int i = -HEADLESS_WARMUP_FRAMES; i < frames; ++i)
+    {
+        auto frameStart = std::chrono::steady_clock::now();
+        Step((float)SIMULATION_STEP);
+        DrawFrame(1.0f);
+        // the frame is measured until the GPU finished it, there is no swap to wait for
+        glFinish();
+        double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        if (i < 0)
+            continue;
+        times.push_back(time);
+        statistics.Add(time);
+        gameState.MFrameTimes.Add(time);
+        ++gameState.MSimulationSteps;
+    }
+
+    std::vector<double> sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+    std::cout << "Headless: " << frames << " frames, mean " << statistics.MMean << " ms, deviation " << statistics.GetDeviation()
+        << " ms, median " << sorted[sorted.size() / 2] << " ms, 99th percentile " << sorted[sorted.size() * 99 / 100]
+        << " ms, longest " << statistics.MMaximum << " ms" << std::endl;
+
+    std::ofstream file(output);
+    if (file)
+    {
+        file << "frame,milliseconds" << std::endl;
+        for (size_t i = 0; i < times.size(); ++i)
+            file << i << "," << times[i] << std::endl;
+    }
+    bool written = (bool)file;
+    if (written)
+        std::cout << "Headless: frame times written to " << output << std::endl;
+    else
+        std::cerr << "Headless: cannot write " << output << std::endl;
+
+    ApplicationDestroy();
+    context.Destroy();
+    return written ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,1285 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CBenchmark.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class running benchmarks from the command line
+ *
+ * Measures parts of the application that do not need a window
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CBenchmark.h"
+#include "../include/HConstants.h"
+#include "../include/CMeshCache.h"
+#include "../include/CMeshGeometry.h"
+#include "../include/CWaterPlaneSceneNode.h"
+#include "../include/CFourierTransform.h"
+#include "../include/COceanSimulation.h"
+#include "../include/CThreadPool.h"
+#include "../include/CTransformSystem.h"
+#include "../include/CModelMatrixBuilder.h"
+#include "../include/CBoundingVolumeHierarchy.h"
+#include "../include/CCatmulRomSpline.h"
+#include "../include/CGeometryArena.h"
+#include "../include/CVertexQuantizer.h"
+#include "../include/CFixedTimestep.h"
+#include "../include/planeOrtho.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <iomanip>
+#include <iostream>
+
+/**
+ * Help function reading every record of a mesh cache
+ *
+ * touches all vertices like an upload would, so mapped pages are really read
+ *
+ * \param    cache - cache positioned at a node record
+ * \param checksum - sum of the vertex positions
+ *
+ * \return true if the whole node was read else false
+ */
+static bool ReadCachedNode(CMeshCache& cache, double& checksum)
+{
+    unsigned int meshCount, childCount;
+    if (!cache.ReadNode(meshCount, childCount))
+        return false;
+    for (unsigned int i = 0; i < meshCount; ++i)
+    {
+        CCachedMesh mesh;
+        if (!cache.ReadMesh(mesh))
+            return false;
+        for (unsigned int j = 0; j < mesh.MVertexCount; ++j)
+            checksum += mesh.MVertices[j].MPosition.x;
+    }
+    for (unsigned int i = 0; i < childCount; ++i)
+    {
+        if (!ReadCachedNode(cache, checksum))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Mesh of the geometry arena benchmark
+ */
+struct CArenaMesh
+{
+    /**
+     * Place of the mesh, the same fields CGeometryArena fills
+     */
+    CArenaAllocation MAllocation;
+
+    /**
+     * Number of index segments, each is a draw call without batches
+     */
+    size_t MSegmentCount = 0;
+};
+
+/**
+ * Pages of the geometry arena benchmark, only their suballocators
+ */
+struct CArenaPages
+{
+    std::vector<CRangeAllocator> MVertices;
+    std::vector<CRangeAllocator> MIndices;
+};
+
+/**
+ * Help function computing the box of the meshes of a cached node and its children
+ *
+ * \param   cache - cache positioned at a node record
+ * \param minimum - minimal corner of the box, extended by the node's meshes
+ * \param maximum - maximal corner of the box, extended by the node's meshes
+ *
+ * \return true if the whole node was read else false
+ */
+static bool GetCachedBounds(CMeshCache& cache, glm::vec3& minimum, glm::vec3& maximum)
+{
+    unsigned int meshCount, childCount;
+    if (!cache.ReadNode(meshCount, childCount))
+        return false;
+    for (unsigned int i = 0; i < meshCount; ++i)
+    {
+        CCachedMesh mesh;
+        if (!cache.ReadMesh(mesh))
+            return false;
+        for (unsigned int j = 0; j < mesh.MVertexCount; ++j)
+        {
+            minimum = glm::min(minimum, mesh.MVertices[j].MPosition);
+            maximum = glm::max(maximum, mesh.MVertices[j].MPosition);
+        }
+    }
+    for (unsigned int i = 0; i < childCount; ++i)
+    {
+        if (!GetCachedBounds(cache, minimum, maximum))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Help function collecting the meshes of a cached node and its children
+ *
+ * meshes of one node share the model matrix, so meshes with the same textures,
+ * material, index type and dequantization are drawn by one batch, the meshes are
+ * packed to the model's box as MODEL_VERTEX_FORMAT like the scene does, a mesh
+ * exceeding the tolerances falls back to floats and gets its own batch
+ *
+ * \param   cache - cache positioned at a node record
+ * \param minimum - minimal corner of the model's box
+ * \param maximum - maximal corner of the model's box
+ * \param  meshes - meshes, new ones are appended
+ * \param batches - number of batches drawing the meshes, increased by the node's batches
+ *
+ * \return true if the whole node was read else false
+ */
+static bool CollectArenaMeshes(CMeshCache& cache, const glm::vec3& minimum, const glm::vec3& maximum,
+    std::vector<CArenaMesh>& meshes, size_t& batches)
+{
+    unsigned int meshCount, childCount;
+    if (!cache.ReadNode(meshCount, childCount))
+        return false;
+    std::vector<CCachedMesh> batchFirsts;
+    std::vector<GLenum> batchTypes;
+    std::vector<glm::mat4> batchDequantizations;
+    for (unsigned int i = 0; i < meshCount; ++i)
+    {
+        CCachedMesh cached;
+        if (!cache.ReadMesh(cached))
+            return false;
+        std::vector<unsigned short> shortIndices;
+        std::vector<CIndexSegment> segments;
+        GLenum type = CMeshGeometry::SplitIndices(cached.MIndices, cached.MIndexCount, shortIndices, segments);
+        size_t indexSize = type == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+
+        CArenaMesh mesh;
+        mesh.MAllocation.MVertexCount = cached.MVertexCount;
+        mesh.MAllocation.MIndexSize = (cached.MIndexCount * indexSize + 3) & ~(size_t)3;
+        mesh.MSegmentCount = segments.size();
+        meshes.push_back(mesh);
+
+        // the same packing as CMeshGeometry::SetupMeshGeometry, the mesh's box is within the model's one
+        std::vector<unsigned char> packed;
+        glm::mat4 dequantization;
+        CQuantizationError error;
+        if (!CVertexQuantizer::Pack(MODEL_VERTEX_FORMAT, cached.MVertices, cached.MVertexCount, minimum, maximum, packed, dequantization, error))
+            dequantization = glm::mat4(1.0f);
+
+        size_t batch = 0;
+        for (; batch < batchFirsts.size(); ++batch)
+        {
+            const CCachedMesh& first = batchFirsts[batch];
+            if (batchTypes[batch] == type && batchDequantizations[batch] == dequantization && first.MTexturePaths == cached.MTexturePaths && first.MMaterial.MKa == cached.MMaterial.MKa
+                && first.MMaterial.MKd == cached.MMaterial.MKd && first.MMaterial.MKs == cached.MMaterial.MKs && first.MMaterial.MNs == cached.MMaterial.MNs)
+                break;
+        }
+        if (batch == batchFirsts.size())
+        {
+            batchFirsts.push_back(cached);
+            batchTypes.push_back(type);
+            batchDequantizations.push_back(dequantization);
+        }
+    }
+    batches += batchFirsts.size();
+    for (unsigned int i = 0; i < childCount; ++i)
+    {
+        if (!CollectArenaMeshes(cache, minimum, maximum, meshes, batches))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Help function placing a mesh into the pages the way CGeometryArena does
+ *
+ * \param pages - pages of the arena, a new one is added if no page has enough space
+ * \param  mesh - placed mesh
+ *
+ * \return true if the mesh was placed, false if it is bigger than a page
+ */
+static bool PlaceArenaMesh(CArenaPages& pages, CArenaMesh& mesh)
+{
+    CArenaAllocation& allocation = mesh.MAllocation;
+    allocation.MPage = -1;
+    if (allocation.MVertexCount > GEOMETRY_ARENA_PAGE_VERTICES || allocation.MIndexSize > GEOMETRY_ARENA_PAGE_INDEX_BYTES)
+        return false;
+    for (size_t page = 0; page <= pages.MVertices.size(); ++page)
+    {
+        if (page == pages.MVertices.size())
+        {
+            pages.MVertices.push_back(CRangeAllocator(GEOMETRY_ARENA_PAGE_VERTICES));
+            pages.MIndices.push_back(CRangeAllocator(GEOMETRY_ARENA_PAGE_INDEX_BYTES));
+        }
+        if (!pages.MVertices[page].Allocate(allocation.MVertexCount, allocation.MFirstVertex))
+            continue;
+        if (!pages.MIndices[page].Allocate(allocation.MIndexSize, allocation.MIndexOffset))
+        {
+            pages.MVertices[page].Free(allocation.MFirstVertex, allocation.MVertexCount);
+            continue;
+        }
+        allocation.MPage = (int)page;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Help function printing usage and fragmentation of the pages
+ *
+ * \param state - name of the state of the pages
+ * \param pages - pages of the arena
+ */
+static void PrintArenaPages(const std::string& state, const CArenaPages& pages)
+{
+    size_t freeRanges = 0, vertices = 0, indices = 0;
+    float vertexFragmentation = 0.0f, indexFragmentation = 0.0f;
+    for (size_t i = 0; i < pages.MVertices.size(); ++i)
+    {
+        freeRanges += pages.MVertices[i].GetFreeRangeCount() + pages.MIndices[i].GetFreeRangeCount();
+        vertices += pages.MVertices[i].GetUsed();
+        indices += pages.MIndices[i].GetUsed();
+        vertexFragmentation = std::max(vertexFragmentation, pages.MVertices[i].GetFragmentation());
+        indexFragmentation = std::max(indexFragmentation, pages.MIndices[i].GetFragmentation());
+    }
+    std::cout << std::left << std::setw(16) << state << std::right << std::fixed << std::setprecision(2)
+        << std::setw(8) << pages.MVertices.size()
+        << std::setw(16) << vertices * sizeof(CVertex) / 1024
+        << std::setw(16) << indices / 1024
+        << std::setw(14) << freeRanges
+        << std::setw(18) << 100.0f * vertexFragmentation
+        << std::setw(18) << 100.0f * indexFragmentation << std::endl;
+}
+
+/**
+ * Result of a simulated loop of the timestep benchmark
+ */
+struct CLoopStatistics
+{
+    /**
+     * Times between the shown frames in milliseconds
+     */
+    CFrameTimeStatistics MFrames;
+
+    /**
+     * Lags of the shown camera behind the time its frame started at in milliseconds,
+     * a steady lag is not seen, a changing one is seen as stutter
+     */
+    CFrameTimeStatistics MLags;
+
+    /**
+     * Distance the camera moved and time the last frame started at in seconds
+     */
+    double MDistance = 0.0;
+    double MTime = 0.0;
+};
+
+/**
+ * Help function adding a shown frame to the statistics of a loop
+ *
+ * \param statistics - statistics of the loop
+ * \param   position - shown position of the camera
+ * \param  startTime - time the frame started at in seconds
+ * \param  shownTime - time the frame is shown at in seconds, set to it for the next frame
+ * \param  lastShown - time the previous frame was shown at, negative for the first frame
+ */
+static void AddShownFrame(CLoopStatistics& statistics, const double& position, const double& startTime,
+    const double& shownTime, double& lastShown)
+{
+    if (lastShown >= 0.0)
+        statistics.MFrames.Add((shownTime - lastShown) * 1000.0);
+    statistics.MLags.Add((startTime - position / FRONT_BACK_MOVEMENT_SPEED) * 1000.0);
+    lastShown = shownTime;
+    statistics.MDistance = position;
+    statistics.MTime = startTime;
+}
+
+/**
+ * Help function simulating the loop driven by glutTimerFunc
+ *
+ * the timer was registered again before the frame was drawn and fired once its interval
+ * elapsed and the frame was finished, the camera moved the same distance every tick,
+ * the distance of a tick at the timer's nominal rate is taken
+ *
+ * \param renderTime - mean render time of a frame in seconds
+ *
+ * \return statistics of the loop
+ */
+static CLoopStatistics SimulateTimerLoop(const double& renderTime)
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> jitter(1.0 - TIMESTEP_BENCHMARK_JITTER, 1.0 + TIMESTEP_BENCHMARK_JITTER);
+    double interval = TIMESTEP_BENCHMARK_TIMER / 1000.0;
+    double tick = FRONT_BACK_MOVEMENT_SPEED * interval;
+
+    CLoopStatistics statistics;
+    double time = 0.0, position = 0.0, lastShown = -1.0;
+    while (time < TIMESTEP_BENCHMARK_SECONDS)
+    {
+        position += tick;
+        double render = renderTime * jitter(random);
+        AddShownFrame(statistics, position, time, time + render, lastShown);
+        time += std::max(interval, render);
+    }
+    return statistics;
+}
+
+/**
+ * Help function simulating the loop with the fixed timestep
+ *
+ * the next frame starts as soon as the previous one is finished, the camera moves
+ * at its speed in every step and is shown blended between the last two steps
+ *
+ * \param renderTime - mean render time of a frame in seconds
+ *
+ * \return statistics of the loop
+ */
+static CLoopStatistics SimulateFixedLoop(const double& renderTime)
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> jitter(1.0 - TIMESTEP_BENCHMARK_JITTER, 1.0 + TIMESTEP_BENCHMARK_JITTER);
+    CFixedTimestep timestep(SIMULATION_STEP, SIMULATION_MAX_FRAME_TIME, SIMULATION_MAX_STEPS);
+
+    CLoopStatistics statistics;
+    double time = 0.0, lastTime = 0.0, position = 0.0, previous = 0.0, lastShown = -1.0;
+    while (time < TIMESTEP_BENCHMARK_SECONDS)
+    {
+        int steps = timestep.Advance(time - lastTime);
+        lastTime = time;
+        for (int i = 0; i < steps; ++i)
+        {
+            previous = position;
+            position += FRONT_BACK_MOVEMENT_SPEED * timestep.GetStep();
+        }
+        double shown = previous + (position - previous) * timestep.GetInterpolation();
+        double render = renderTime * jitter(random);
+        AddShownFrame(statistics, shown, time, time + render, lastShown);
+        time += render;
+    }
+    return statistics;
+}
+
+/**
+ * Help function printing the statistics of a simulated loop
+ *
+ * \param       loop - name of the loop
+ * \param renderTime - mean render time of a frame in milliseconds
+ * \param statistics - statistics of the loop
+ */
+static void PrintLoopStatistics(const std::string& loop, const double& renderTime, const CLoopStatistics& statistics)
+{
+    // drift is the error of the distance the camera moved
+    double drift = 100.0 * (statistics.MDistance / (FRONT_BACK_MOVEMENT_SPEED * statistics.MTime) - 1.0);
+    std::cout << std::left << std::setw(16) << loop << std::right << std::fixed << std::setprecision(2)
+        << std::setw(14) << renderTime
+        << std::setw(10) << 1000.0 / statistics.MFrames.MMean
+        << std::setw(14) << statistics.MFrames.MMean
+        << std::setw(16) << statistics.MFrames.GetDeviation()
+        << std::setw(14) << statistics.MFrames.MMaximum
+        << std::setw(14) << statistics.MLags.GetDeviation()
+        << std::setw(12) << drift << std::endl;
+}
+
+/**
+ * Scene node transform as it was stored before CTransformSystem
+ */
+struct CRecursiveTransform
+{
+    glm::vec3 MPosition = glm::vec3(0.0f);
+    glm::vec3 MSize = glm::vec3(1.0f);
+    glm::vec3 MDirection = glm::vec3(0.0f, 0.0f, -1.0f);
+    glm::vec3 MUpVector = glm::vec3(0.0f, 1.0f, 0.0f);
+    std::vector<int> MChildren;
+};
+
+/**
+ * Help function setting a position the way scene nodes did, overwriting the whole subtree
+ *
+ * \param    nodes - all nodes
+ * \param     node - index of the moved node
+ * \param position - new position
+ */
+static void SetRecursivePosition(std::vector<CRecursiveTransform>& nodes, const int& node, const glm::vec3& position)
+{
+    nodes[node].MPosition = position;
+    for (int child : nodes[node].MChildren)
+        SetRecursivePosition(nodes, child, position);
+}
+
+/**
+ * Help function measuring the error of a model matrix
+ *
+ * the reference is the closed form computed in double precision,
+ * the basis columns are compared relative to their scale, the translation
+ * relative to the position, errors are in units of the last place of 1.0
+ *
+ * \param    matrix - measured model matrix
+ * \param  position - position of the node
+ * \param      size - size of the node
+ * \param direction - direction which the node faces
+ * \param  upVector - up vector of the node
+ *
+ * \return largest error of the matrix's elements
+ */
+static double ComputeModelMatrixError(const glm::mat4& matrix, const glm::vec3& position, const glm::vec3& size,
+    const glm::vec3& direction, const glm::vec3& upVector)
+{
+    double forward[3] = { direction.x, direction.y, direction.z };
+    double length = std::sqrt(forward[0] * forward[0] + forward[1] * forward[1] + forward[2] * forward[2]);
+    for (double& component : forward)
+        component /= length;
+    double right[3] = { forward[1] * upVector.z - upVector.y * forward[2],
+        forward[2] * upVector.x - upVector.z * forward[0],
+        forward[0] * upVector.y - upVector.x * forward[1] };
+    length = std::sqrt(right[0] * right[0] + right[1] * right[1] + right[2] * right[2]);
+    for (double& component : right)
+        component /= length;
+    double up[3] = { right[1] * forward[2] - forward[1] * right[2],
+        right[2] * forward[0] - forward[2] * right[0],
+        right[0] * forward[1] - forward[0] * right[1] };
+
+    const double ulp = std::ldexp(1.0, -23);
+    double error = 0.0;
+    for (int row = 0; row < 3; ++row)
+    {
+        error = std::max(error, std::fabs(matrix[0][row] / size.x - right[row]) / ulp);
+        error = std::max(error, std::fabs(matrix[1][row] / size.y - up[row]) / ulp);
+        error = std::max(error, std::fabs(matrix[2][row] / size.z + forward[row]) / ulp);
+        error = std::max(error, std::fabs(matrix[3][row] - position[row]) / (std::max(1.0, (double)std::fabs(position[row])) * ulp));
+    }
+    return error;
+}
+
+/**
+ * Queries of the bounding volume hierarchy benchmark
+ */
+struct CHierarchyQueries
+{
+    /**
+     * Frustums looking from random points in random directions
+     */
+    std::vector<CFrustum> MFrustums;
+
+    /**
+     * Centers and radii of the spheres
+     */
+    std::vector<glm::vec3> MCenters;
+    std::vector<float> MRadii;
+
+    /**
+     * Origins, directions and lengths of the rays
+     */
+    std::vector<glm::vec3> MOrigins;
+    std::vector<glm::vec3> MDirections;
+    std::vector<float> MLengths;
+};
+
+/**
+ * Help function running the queries of the bounding volume hierarchy benchmark
+ *
+ * \param hierarchy - hierarchy to be queried, nullptr scans the boxes instead
+ * \param  minimums - minimal corners of the objects' boxes
+ * \param  maximums - maximal corners of the objects' boxes
+ * \param   queries - queries to be run
+ * \param      kind - 0 for frustums, 1 for spheres, 2 for rays
+ * \param   results - sorted objects found by every query
+ *
+ * \return time of all queries in microseconds
+ */
+static double RunHierarchyQueries(const CBoundingVolumeHierarchy* hierarchy, const std::vector<glm::vec3>& minimums,
+    const std::vector<glm::vec3>& maximums, const CHierarchyQueries& queries, const int& kind, std::vector<std::vector<int>>& results)
+{
+    size_t count = kind == 0 ? queries.MFrustums.size() : kind == 1 ? queries.MCenters.size() : queries.MOrigins.size();
+    results.assign(count, std::vector<int>());
+    float hit;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::vector<int>& objects = results[i];
+        if (hierarchy != nullptr)
+        {
+            if (kind == 0)
+                hierarchy->QueryFrustum(queries.MFrustums[i], objects);
+            else if (kind == 1)
+                hierarchy->QuerySphere(queries.MCenters[i], queries.MRadii[i], objects);
+            else
+                hierarchy->QueryRay(queries.MOrigins[i], queries.MDirections[i], queries.MLengths[i], objects);
+            continue;
+        }
+        glm::vec3 inverse(0.0f);
+        if (kind == 2)
+            inverse = 1.0f / queries.MDirections[i];
+        for (size_t j = 0; j < minimums.size(); ++j)
+        {
+            bool found;
+            if (kind == 0)
+                found = queries.MFrustums[i].IsBoxVisible(minimums[j], maximums[j]);
+            else if (kind == 1)
+                found = CBoundingVolumeHierarchy::IsBoxInSphere(minimums[j], maximums[j], queries.MCenters[i], queries.MRadii[i]);
+            else
+                found = CBoundingVolumeHierarchy::IsBoxOnRay(minimums[j], maximums[j], queries.MOrigins[i], inverse, queries.MLengths[i], hit);
+            if (found)
+                objects.push_back((int)j);
+        }
+    }
+    double time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    // the order of the hits is not compared
+    for (auto& objects : results)
+        std::sort(objects.begin(), objects.end());
+    return time;
+}
+
+int CBenchmark::MeshCacheBenchmark(const std::vector<std::string>& arguments)
+{
+    const std::vector<std::string>& paths = arguments.empty() ? MODEL_PATHS : arguments;
+
+    std::cout << std::left << std::setw(32) << "model"
+        << std::right << std::setw(14) << "assimp [ms]"
+        << std::setw(14) << "cache [ms]"
+        << std::setw(10) << "speedup"
+        << std::setw(14) << "cache [KiB]" << std::endl;
+
+    for (const auto& path : paths)
+    {
+        double importTime = 0.0;
+        double cacheTime = 0.0;
+        size_t cacheSize = 0;
+        double checksum = 0.0;
+
+        for (int i = 0; i < BENCHMARK_ITERATIONS; ++i)
+        {
+            CMeshCache cache;
+            auto start = std::chrono::steady_clock::now();
+            if (!cache.Import(path, MESH_IMPORT_FLAGS) || !ReadCachedNode(cache, checksum))
+            {
+                std::cerr << "Benchmark failed to import " << path << std::endl;
+                return 1;
+            }
+            importTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (i == 0 && !cache.Save())
+            {
+                std::cerr << "Benchmark failed to write mesh cache of " << path << std::endl;
+                return 1;
+            }
+        }
+
+        for (int i = 0; i < BENCHMARK_ITERATIONS; ++i)
+        {
+            CMeshCache cache;
+            auto start = std::chrono::steady_clock::now();
+            if (!cache.Load(path, MESH_IMPORT_FLAGS) || !ReadCachedNode(cache, checksum))
+            {
+                std::cerr << "Benchmark failed to load mesh cache of " << path << std::endl;
+                return 1;
+            }
+            cacheTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            cacheSize = cache.GetSize();
+        }
+
+        importTime /= BENCHMARK_ITERATIONS;
+        cacheTime /= BENCHMARK_ITERATIONS;
+        std::cout << std::left << std::setw(32) << path << std::right << std::fixed << std::setprecision(2)
+            << std::setw(14) << importTime
+            << std::setw(14) << cacheTime
+            << std::setw(9) << importTime / cacheTime << "x"
+            << std::setw(14) << cacheSize / 1024 << std::endl;
+    }
+    return 0;
+}
+
+int CBenchmark::WaterBenchmark(const std::vector<std::string>& arguments)
+{
+    int side = arguments.empty() ? WATER_PLANE_SIDE_SIZE : std::atoi(arguments[0].c_str());
+    if (side < 2)
+    {
+        std::cerr << "Benchmark needs at least 2 vertices on a side" << std::endl;
+        return 1;
+    }
+
+    double buildTime = 0.0;
+    size_t memory = 0;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; ++i)
+    {
+        std::vector<CVertex> vertices;
+        std::vector<unsigned int> indices;
+        auto start = std::chrono::steady_clock::now();
+        CMeshGeometry::BuildPlaneMesh(side, WATER_PLANE_VERTEX_GAP, vertices, indices);
+        buildTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        memory = vertices.capacity() * sizeof(CVertex) + indices.capacity() * sizeof(unsigned int);
+    }
+    buildTime /= BENCHMARK_ITERATIONS;
+
+    // the procedural grid only needs an empty VAO, its vertices come from gl_VertexID and gl_InstanceID
+    std::cout << "Water grid " << side << "x" << side << std::endl
+        << std::left << std::setw(14) << "grid"
+        << std::right << std::setw(14) << "build [ms]"
+        << std::setw(14) << "memory [KiB]"
+        << std::setw(14) << "GPU [KiB]" << std::endl
+        << std::left << std::setw(14) << "buffered" << std::right << std::fixed << std::setprecision(2)
+        << std::setw(14) << buildTime
+        << std::setw(14) << memory / 1024
+        << std::setw(14) << memory / 1024 << std::endl
+        << std::left << std::setw(14) << "procedural" << std::right
+        << std::setw(14) << 0.0
+        << std::setw(14) << 0
+        << std::setw(14) << 0 << std::endl;
+
+    // work of one frame, the grid reuses vertices along its strips, the clipmap draws separate triangles
+    int levels = CWaterPlaneSceneNode::ComputeClipmapLevels(side);
+    size_t gridTriangles = (size_t)2 * (side - 1) * (side - 1);
+    size_t gridVertices = (size_t)2 * side * (side - 1);
+    size_t clipmapTriangles = CWaterPlaneSceneNode::ComputeClipmapTriangles(levels);
+    size_t clipmapVertices = (size_t)levels * WATER_CLIPMAP_RESOLUTION * WATER_CLIPMAP_RESOLUTION * 6;
+    std::cout << std::endl << "Water per frame" << std::endl
+        << std::left << std::setw(14) << "grid"
+        << std::right << std::setw(14) << "triangles"
+        << std::setw(14) << "vertices" << std::endl
+        << std::left << std::setw(14) << "uniform" << std::right
+        << std::setw(14) << gridTriangles
+        << std::setw(14) << gridVertices << std::endl
+        << std::left << std::setw(14) << "clipmap" << std::right
+        << std::setw(14) << clipmapTriangles
+        << std::setw(14) << clipmapVertices << std::endl
+        << levels << " clipmap levels draw " << (double)gridTriangles / clipmapTriangles << "x fewer triangles" << std::endl;
+    return 0;
+}
+
+int CBenchmark::FourierBenchmark(const std::vector<std::string>& arguments)
+{
+    std::vector<int> sizes;
+    for (const auto& argument : arguments)
+        sizes.push_back(std::atoi(argument.c_str()));
+    if (sizes.empty())
+        sizes = OCEAN_BENCHMARK_RESOLUTIONS;
+    for (int size : sizes)
+    {
+        if (size < 2 || (size & (size - 1)) != 0)
+        {
+            std::cerr << "Benchmark needs a power of two of at least 2 samples, got " << size << std::endl;
+            return 1;
+        }
+    }
+
+    CThreadPool pool;
+    std::cout << "Ocean step on 1 thread and on " << pool.GetThreadCount() << " workers with the caller" << std::endl;
+    std::cout << std::left << std::setw(10) << "size"
+        << std::setw(10) << "kernel"
+        << std::right << std::setw(14) << "2D FFT [ms]"
+        << std::setw(10) << "GFLOP/s"
+        << std::setw(14) << "1 thread [ms]"
+        << std::setw(12) << "pool [ms]"
+        << std::setw(10) << "speedup" << std::endl;
+
+    const EFourierKernel kernels[] = { FOURIER_KERNEL_SCALAR, FOURIER_KERNEL_SSE, FOURIER_KERNEL_AVX };
+    for (int size : sizes)
+    {
+        size_t count = (size_t)size * size;
+        // small grids are repeated more to get measurable times
+        int iterations = std::max(1, (1 << 22) / (int)count);
+        std::vector<float> real(count);
+        std::vector<float> imaginary(count);
+
+        for (EFourierKernel kernel : kernels)
+        {
+            if (!CFourierTransform::IsKernelSupported(kernel))
+                continue;
+
+            CFourierTransform transform;
+            transform.Initialize(size, true, kernel);
+            double transformTime = 0.0;
+            for (int i = 0; i < iterations; ++i)
+            {
+                // the transform works in place, the grid is refilled outside of the measured time
+                for (size_t j = 0; j < count; ++j)
+                {
+                    real[j] = (float)(j % 7) - 3.0f;
+                    imaginary[j] = (float)(j % 5) - 2.0f;
+                }
+                auto start = std::chrono::steady_clock::now();
+                transform.TransformRows(real.data(), imaginary.data(), 0, size);
+                transform.TransformColumns(real.data(), imaginary.data(), 0, size);
+                transformTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            transformTime /= iterations;
+            // usual estimate of a complex FFT of n points, 5 n log2(n) operations
+            double flops = 5.0 * count * std::log2((double)count);
+
+            COceanSimulation ocean;
+            ocean.Initialize(size, OCEAN_PATCH_SIZE, OCEAN_WIND, OCEAN_AMPLITUDE, OCEAN_CHOPPINESS, OCEAN_SEED, kernel);
+            double singleTime = 0.0;
+            double pooledTime = 0.0;
+            for (int i = 0; i < iterations; ++i)
+            {
+                auto start = std::chrono::steady_clock::now();
+                ocean.Simulate(i * 0.1f, nullptr);
+                singleTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                start = std::chrono::steady_clock::now();
+                ocean.Simulate(i * 0.1f, &pool);
+                pooledTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            singleTime /= iterations;
+            pooledTime /= iterations;
+
+            std::cout << std::left << std::setw(10) << size
+                << std::setw(10) << CFourierTransform::GetKernelName(kernel)
+                << std::right << std::fixed << std::setprecision(3)
+                << std::setw(14) << transformTime
+                << std::setw(10) << flops / (transformTime * 1e6)
+                << std::setw(14) << singleTime
+                << std::setw(12) << pooledTime
+                << std::setw(9) << singleTime / pooledTime << "x" << std::endl;
+        }
+    }
+    return 0;
+}
+
+int CBenchmark::TransformBenchmark(const std::vector<std::string>& arguments)
+{
+    std::vector<int> counts;
+    for (const auto& argument : arguments)
+        counts.push_back(std::atoi(argument.c_str()));
+    if (counts.empty())
+        counts = TRANSFORM_BENCHMARK_COUNTS;
+    for (int count : counts)
+    {
+        if (count < 2)
+        {
+            std::cerr << "Benchmark needs at least 2 nodes, got " << count << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << std::left << std::setw(10) << "nodes"
+        << std::setw(12) << "moved"
+        << std::right << std::setw(16) << "recursive [ms]"
+        << std::setw(14) << "system [ms]"
+        << std::setw(14) << "recomputed"
+        << std::setw(10) << "speedup" << std::endl;
+
+    for (int count : counts)
+    {
+        // objects of eight meshes each, the index of a parent is always lower
+        std::vector<CRecursiveTransform> recursive(count);
+        CTransformSystem system;
+        std::vector<int> handles(count);
+        for (int i = 0; i < count; ++i)
+        {
+            handles[i] = system.Create();
+            if (i > 0)
+            {
+                recursive[(i - 1) / 8].MChildren.push_back(i);
+                system.SetParent(handles[i], handles[(i - 1) / 8]);
+            }
+        }
+
+        // a fraction of nodes from the end, mostly leaves, then the root moving the whole tree
+        int moved = std::max(1, (int)(count * TRANSFORM_BENCHMARK_MOVED));
+        int stride = count / moved;
+        for (int frame = 0; frame < 2; ++frame)
+        {
+            bool root = frame == 1;
+            double recursiveTime = 0.0;
+            double systemTime = 0.0;
+            // matrices are copied out like a draw would upload them
+            std::vector<glm::mat4> modelMatrices(count);
+            for (int i = 0; i < BENCHMARK_ITERATIONS; ++i)
+            {
+                glm::vec3 position((float)i, 0.0f, 0.0f);
+
+                auto start = std::chrono::steady_clock::now();
+                for (int j = 0; j < (root ? 1 : moved); ++j)
+                    SetRecursivePosition(recursive, root ? 0 : count - 1 - j * stride, position);
+                for (int j = 0; j < count; ++j)
+                {
+                    const CRecursiveTransform& node = recursive[j];
+                    glm::mat4 modelMatrix = glm::scale(glm::mat4(1.0f), node.MSize);
+                    modelMatrices[j] = glm::inverse(glm::lookAt(node.MPosition, node.MPosition + node.MDirection, node.MUpVector)) * modelMatrix;
+                }
+                recursiveTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                start = std::chrono::steady_clock::now();
+                for (int j = 0; j < (root ? 1 : moved); ++j)
+                    system.SetPosition(handles[root ? 0 : count - 1 - j * stride], position);
+                for (int j = 0; j < count; ++j)
+                    modelMatrices[j] = system.GetWorldMatrix(handles[j]);
+                systemTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            recursiveTime /= BENCHMARK_ITERATIONS;
+            systemTime /= BENCHMARK_ITERATIONS;
+
+            std::cout << std::left << std::setw(10) << count
+                << std::setw(12) << (root ? std::string("root") : std::to_string(moved))
+                << std::right << std::fixed << std::setprecision(3)
+                << std::setw(16) << recursiveTime
+                << std::setw(14) << systemTime
+                << std::setw(14) << system.GetUpdatedCount()
+                << std::setw(9) << recursiveTime / systemTime << "x" << std::endl;
+        }
+    }
+    return 0;
+}
+
+int CBenchmark::ModelMatrixBenchmark(const std::vector<std::string>& arguments)
+{
+    int count = arguments.empty() ? MODEL_MATRIX_BENCHMARK_NODES : std::atoi(arguments[0].c_str());
+    if (count < 1)
+    {
+        std::cerr << "Benchmark needs at least 1 node" << std::endl;
+        return 1;
+    }
+
+    // nodes spread over the scene, facing anywhere, half of them upright
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    std::vector<glm::vec3> positions(count), sizes(count), directions(count), upVectors(count);
+    std::vector<int> indices(count);
+    for (int i = 0; i < count; ++i)
+    {
+        indices[i] = i;
+        positions[i] = glm::vec3(uniform(random) * 1000.0f, uniform(random) * 100.0f, uniform(random) * 1000.0f);
+        sizes[i] = glm::vec3(5.05f + uniform(random) * 4.95f);
+        do
+        {
+            directions[i] = glm::vec3(uniform(random), uniform(random), uniform(random));
+            upVectors[i] = i % 2 == 0 ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(uniform(random), uniform(random), uniform(random));
+        } while (glm::length(directions[i]) < 0.3f || glm::length(glm::cross(glm::normalize(directions[i]), upVectors[i])) < 0.1f);
+    }
+
+    std::vector<glm::mat4> inverted(count), closed(count), batched(count);
+    double invertTime = 0.0, closedTime = 0.0, batchTime = 0.0;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int j = 0; j < count; ++j)
+        {
+            glm::mat4 modelMatrix = glm::scale(glm::mat4(1.0f), sizes[j]);
+            inverted[j] = glm::inverse(glm::lookAt(positions[j], positions[j] + directions[j], upVectors[j])) * modelMatrix;
+        }
+        invertTime += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (int j = 0; j < count; ++j)
+            closed[j] = CModelMatrixBuilder::Build(positions[j], sizes[j], directions[j], upVectors[j]);
+        closedTime += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        CModelMatrixBuilder::BuildBatch(indices, positions.data(), sizes.data(), directions.data(), upVectors.data(), batched.data());
+        batchTime += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double invertError = 0.0, closedError = 0.0, batchError = 0.0;
+    int mismatches = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        invertError = std::max(invertError, ComputeModelMatrixError(inverted[i], positions[i], sizes[i], directions[i], upVectors[i]));
+        closedError = std::max(closedError, ComputeModelMatrixError(closed[i], positions[i], sizes[i], directions[i], upVectors[i]));
+        batchError = std::max(batchError, ComputeModelMatrixError(batched[i], positions[i], sizes[i], directions[i], upVectors[i]));
+        if (std::memcmp(&closed[i], &batched[i], sizeof(glm::mat4)) != 0)
+            ++mismatches;
+    }
+
+    double nodes = (double)count * BENCHMARK_ITERATIONS;
+    std::cout << "Model matrices of " << count << " nodes" << std::endl
+        << std::left << std::setw(20) << "builder"
+        << std::right << std::setw(14) << "per node [ns]"
+        << std::setw(10) << "speedup"
+        << std::setw(16) << "max error [ulp]" << std::endl
+        << std::fixed << std::setprecision(2)
+        << std::left << std::setw(20) << "inverse(lookAt)" << std::right
+        << std::setw(14) << invertTime / nodes
+        << std::setw(9) << 1.0 << "x"
+        << std::setw(16) << invertError << std::endl
+        << std::left << std::setw(20) << "closed form" << std::right
+        << std::setw(14) << closedTime / nodes
+        << std::setw(9) << invertTime / closedTime << "x"
+        << std::setw(16) << closedError << std::endl
+        << std::left << std::setw(20) << "closed form SSE" << std::right
+        << std::setw(14) << batchTime / nodes
+        << std::setw(9) << invertTime / batchTime << "x"
+        << std::setw(16) << batchError << std::endl
+        << mismatches << " batched matrices differ from the closed form in any bit" << std::endl;
+
+    if (mismatches > 0)
+    {
+        std::cerr << "Batched model matrices differ from the closed form" << std::endl;
+        return 1;
+    }
+    if (closedError > MODEL_MATRIX_TOLERANCE_ULPS)
+    {
+        std::cerr << "Closed form model matrices exceed the tolerance of " << MODEL_MATRIX_TOLERANCE_ULPS << " ulp" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int CBenchmark::HierarchyBenchmark(const std::vector<std::string>& arguments)
+{
+    std::vector<int> counts;
+    for (const auto& argument : arguments)
+        counts.push_back(std::atoi(argument.c_str()));
+    if (counts.empty())
+        counts = HIERARCHY_BENCHMARK_COUNTS;
+    for (int count : counts)
+    {
+        if (count < 1)
+        {
+            std::cerr << "Benchmark needs at least 1 object, got " << count << std::endl;
+            return 1;
+        }
+    }
+
+    const char* kinds[3] = { "frustum", "sphere", "ray" };
+    int failures = 0;
+    for (int count : counts)
+    {
+        // the ground grows with the count, so every query finds about the same number of objects
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+        float side = 10.0f * std::sqrt((float)count);
+        std::vector<glm::vec3> minimums(count), maximums(count);
+        for (int i = 0; i < count; ++i)
+        {
+            minimums[i] = glm::vec3(uniform(random) * side, uniform(random) * 50.0f, uniform(random) * side);
+            maximums[i] = minimums[i] + glm::vec3(1.0f + uniform(random) * 4.0f);
+        }
+
+        CHierarchyQueries queries;
+        for (int i = 0; i < HIERARCHY_BENCHMARK_QUERIES; ++i)
+        {
+            glm::vec3 point(uniform(random) * side, uniform(random) * 50.0f, uniform(random) * side);
+            float angle = uniform(random) * 6.2831853f;
+            glm::vec3 direction(std::cos(angle), uniform(random) - 0.5f, std::sin(angle));
+            glm::mat4 projection = glm::perspective(glm::radians(VIEW_ANGLE), 16.0f / 9.0f, NEAR_PLANE, 100.0f);
+            queries.MFrustums.push_back(CFrustum(projection * glm::lookAt(point, point + direction, glm::vec3(0.0f, 1.0f, 0.0f))));
+            queries.MCenters.push_back(point);
+            queries.MRadii.push_back(5.0f + uniform(random) * 15.0f);
+            queries.MOrigins.push_back(point);
+            queries.MDirections.push_back(glm::normalize(direction));
+            queries.MLengths.push_back(200.0f);
+        }
+
+        CBoundingVolumeHierarchy hierarchy(SCENE_HIERARCHY_MARGIN);
+        std::vector<int> leaves(count);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i)
+            leaves[i] = hierarchy.Insert(minimums[i], maximums[i], i);
+        double buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // the same objects moved by up to twice the margin, refitted in one tree and reinserted in a copy
+        int moved = std::max(1, (int)(count * HIERARCHY_BENCHMARK_MOVED));
+        std::vector<int> movedObjects(moved);
+        for (int i = 0; i < moved; ++i)
+        {
+            int object = (int)(uniform(random) * count) % count;
+            glm::vec3 offset = (glm::vec3(uniform(random), uniform(random), uniform(random)) * 2.0f - 1.0f) * 2.0f * SCENE_HIERARCHY_MARGIN;
+            minimums[object] += offset;
+            maximums[object] += offset;
+            movedObjects[i] = object;
+        }
+        CBoundingVolumeHierarchy reinserted = hierarchy;
+        start = std::chrono::steady_clock::now();
+        for (int object : movedObjects)
+            hierarchy.SetBox(leaves[object], minimums[object], maximums[object]);
+        hierarchy.Refit();
+        double refitTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        start = std::chrono::steady_clock::now();
+        for (int object : movedObjects)
+            reinserted.Move(leaves[object], minimums[object], maximums[object]);
+        double reinsertTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << count << " objects, height " << hierarchy.GetHeight() << ", built in "
+            << std::fixed << std::setprecision(3) << buildTime << " ms, " << moved << " moved: refit "
+            << refitTime << " ms, reinsertion " << reinsertTime << " ms (height " << reinserted.GetHeight() << ")" << std::endl
+            << std::left << std::setw(10) << "query"
+            << std::right << std::setw(14) << "linear [us]"
+            << std::setw(14) << "refit [us]"
+            << std::setw(16) << "reinsert [us]"
+            << std::setw(10) << "speedup"
+            << std::setw(10) << "found" << std::endl;
+        for (int kind = 0; kind < 3; ++kind)
+        {
+            std::vector<std::vector<int>> expected, refitted, moves;
+            double linearTime = RunHierarchyQueries(nullptr, minimums, maximums, queries, kind, expected);
+            double refitQueryTime = RunHierarchyQueries(&hierarchy, minimums, maximums, queries, kind, refitted);
+            double reinsertQueryTime = RunHierarchyQueries(&reinserted, minimums, maximums, queries, kind, moves);
+            size_t found = 0;
+            for (const auto& objects : expected)
+                found += objects.size();
+            if (refitted != expected || moves != expected)
+            {
+                std::cerr << "Hierarchy " << kinds[kind] << " queries differ from the linear scan" << std::endl;
+                ++failures;
+            }
+
+            std::cout << std::left << std::setw(10) << kinds[kind]
+                << std::right << std::fixed << std::setprecision(2)
+                << std::setw(14) << linearTime / HIERARCHY_BENCHMARK_QUERIES
+                << std::setw(14) << refitQueryTime / HIERARCHY_BENCHMARK_QUERIES
+                << std::setw(16) << reinsertQueryTime / HIERARCHY_BENCHMARK_QUERIES
+                << std::setw(9) << linearTime / reinsertQueryTime << "x"
+                << std::setw(10) << std::setprecision(1) << (double)found / HIERARCHY_BENCHMARK_QUERIES << std::endl;
+        }
+    }
+    return failures > 0 ? 1 : 0;
+}
+
+int CBenchmark::InstancingBenchmark(const std::vector<std::string>& arguments)
+{
+    std::vector<int> counts;
+    for (const auto& argument : arguments)
+        counts.push_back(std::atoi(argument.c_str()));
+    if (counts.empty())
+        counts = INSTANCING_BENCHMARK_COUNTS;
+    for (int count : counts)
+    {
+        if (count < 1)
+        {
+            std::cerr << "Benchmark needs at least 1 fish, got " << count << std::endl;
+            return 1;
+        }
+    }
+
+    // every draw of the mesh, instanced or not, issues one call per index segment
+    std::vector<unsigned short> shortIndices;
+    std::vector<CIndexSegment> segments;
+    CMeshGeometry::SplitIndices(planeOrthoTriangles, (size_t)planeOrthoNTriangles * 3, shortIndices, segments);
+    size_t segmentCount = segments.size();
+
+    const CCatmulRomSpline splines[] = { CCatmulRomSpline(FISH_ONE_CONTROL_POINTS),
+        CCatmulRomSpline(FISH_TWO_CONTROL_POINTS), CCatmulRomSpline(FISH_THREE_CONTROL_POINTS) };
+
+    std::cout << std::left << std::setw(10) << "fish"
+        << std::right << std::setw(14) << "draws single"
+        << std::setw(16) << "draws instanced"
+        << std::setw(16) << "stream [KiB]"
+        << std::setw(14) << "update [ms]"
+        << std::setw(14) << "gather [ms]"
+        << std::setw(16) << "per fish [ns]" << std::endl;
+
+    for (int count : counts)
+    {
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<float> times(count);
+        std::vector<int> paths(count);
+        for (int i = 0; i < count; ++i)
+        {
+            paths[i] = (i / FISH_SCHOOL_GROUP_SIZE) % 3;
+            times[i] = unit(random) * splines[paths[i]].GetControlPointSize();
+        }
+
+        std::vector<glm::mat4> matrices(count), stream;
+        stream.reserve(count);
+        double updateTime = 0.0, gatherTime = 0.0;
+        for (int i = 0; i < BENCHMARK_ITERATIONS; ++i)
+        {
+            // one frame of CSplineSceneNode::Update and the model matrix
+            auto start = std::chrono::steady_clock::now();
+            for (int j = 0; j < count; ++j)
+            {
+                const CCatmulRomSpline& spline = splines[paths[j]];
+                times[j] += 1.0f / 30.0f / FISH_CHANGE_SLOW;
+                if (times[j] >= (float)spline.GetControlPointSize())
+                    times[j] -= spline.GetControlPointSize();
+                glm::vec3 gradient = spline.GetSplineLoopGradient(times[j]);
+                matrices[j] = CModelMatrixBuilder::Build(spline.GetSplineLoopPoint(times[j]), FISH_SIZE,
+                    glm::normalize(glm::vec3(gradient.x, 0.0f, gradient.z)), glm::vec3(0.0f, 1.0f, 0.0f));
+            }
+            updateTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            // what CInstancedSceneNode does on the CPU before its upload
+            start = std::chrono::steady_clock::now();
+            stream.clear();
+            for (int j = 0; j < count; ++j)
+                stream.push_back(matrices[j]);
+            gatherTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        updateTime /= BENCHMARK_ITERATIONS;
+        gatherTime /= BENCHMARK_ITERATIONS;
+
+        std::cout << std::left << std::setw(10) << count
+            << std::right << std::setw(14) << count * segmentCount
+            << std::setw(16) << segmentCount
+            << std::fixed << std::setprecision(3)
+            << std::setw(16) << stream.size() * sizeof(glm::mat4) / 1024.0
+            << std::setw(14) << updateTime
+            << std::setw(14) << gatherTime
+            << std::setw(16) << std::setprecision(2) << (updateTime + gatherTime) * 1e6 / count << std::endl;
+    }
+    return 0;
+}
+
+int CBenchmark::ArenaBenchmark(const std::vector<std::string>& arguments)
+{
+    const std::vector<std::string>& paths = arguments.empty() ? MODEL_PATHS : arguments;
+
+    // all models share one arena like in the scene
+    std::vector<CArenaMesh> meshes;
+    std::cout << std::left << std::setw(32) << "model"
+        << std::right << std::setw(10) << "meshes"
+        << std::setw(16) << "draws separate"
+        << std::setw(16) << "draws batched" << std::endl;
+    size_t totalSeparate = 0, totalBatched = 0;
+    for (const auto& path : paths)
+    {
+        CMeshCache cache;
+        size_t first = meshes.size();
+        size_t batches = 0;
+        glm::vec3 minimum(FLT_MAX), maximum(-FLT_MAX);
+        bool loaded = cache.LoadOrImport(path, MESH_IMPORT_FLAGS) && GetCachedBounds(cache, minimum, maximum);
+        if (loaded)
+            cache.Rewind();
+        if (!loaded || !CollectArenaMeshes(cache, minimum, maximum, meshes, batches))
+        {
+            std::cerr << "Benchmark failed to load " << path << std::endl;
+            return 1;
+        }
+        size_t separate = 0;
+        for (size_t i = first; i < meshes.size(); ++i)
+            separate += meshes[i].MSegmentCount;
+        totalSeparate += separate;
+        totalBatched += batches;
+        std::cout << std::left << std::setw(32) << path << std::right
+            << std::setw(10) << meshes.size() - first
+            << std::setw(16) << separate
+            << std::setw(16) << batches << std::endl;
+    }
+    std::cout << std::left << std::setw(32) << "all" << std::right
+        << std::setw(10) << meshes.size()
+        << std::setw(16) << totalSeparate
+        << std::setw(16) << totalBatched << std::endl << std::endl;
+
+    std::cout << std::left << std::setw(16) << "arena"
+        << std::right << std::setw(8) << "pages"
+        << std::setw(16) << "vertices [KiB]"
+        << std::setw(16) << "indices [KiB]"
+        << std::setw(14) << "free ranges"
+        << std::setw(18) << "frag vertices [%]"
+        << std::setw(18) << "frag indices [%]" << std::endl;
+
+    CArenaPages pages;
+    size_t separateMeshes = 0;
+    for (auto& mesh : meshes)
+    {
+        if (!PlaceArenaMesh(pages, mesh))
+            ++separateMeshes;
+    }
+    PrintArenaPages("loaded", pages);
+
+    // streaming frees and places meshes while the scene runs, the holes are what fragments the pages
+    std::mt19937 random(1);
+    std::vector<size_t> placed;
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        if (meshes[i].MAllocation.MPage >= 0)
+            placed.push_back(i);
+    }
+    size_t churn = (size_t)(placed.size() * ARENA_BENCHMARK_CHURN);
+    size_t placements = 0;
+    double placeTime = 0.0;
+    for (int round = 0; round < ARENA_BENCHMARK_ROUNDS && churn > 0; ++round)
+    {
+        std::shuffle(placed.begin(), placed.end(), random);
+        for (size_t i = 0; i < churn; ++i)
+        {
+            CArenaAllocation& allocation = meshes[placed[i]].MAllocation;
+            pages.MVertices[allocation.MPage].Free(allocation.MFirstVertex, allocation.MVertexCount);
+            pages.MIndices[allocation.MPage].Free(allocation.MIndexOffset, allocation.MIndexSize);
+        }
+        std::shuffle(placed.begin(), placed.begin() + churn, random);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < churn; ++i)
+            PlaceArenaMesh(pages, meshes[placed[i]]);
+        placeTime += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        placements += churn;
+    }
+    PrintArenaPages("after churn", pages);
+
+    std::cout << std::endl << "Meshes with their own buffers: " << separateMeshes
+        << ", vertex arrays: " << meshes.size() << " -> " << pages.MVertices.size() + separateMeshes;
+    if (placements > 0)
+        std::cout << ", placement: " << std::fixed << std::setprecision(3) << placeTime / placements << " us";
+    std::cout << std::endl;
+    return 0;
+}
+
+int CBenchmark::TimestepBenchmark(const std::vector<std::string>& arguments)
+{
+    std::vector<double> renderTimes;
+    for (const auto& argument : arguments)
+        renderTimes.push_back(std::atof(argument.c_str()));
+    if (renderTimes.empty())
+        renderTimes = TIMESTEP_BENCHMARK_RENDER_TIMES;
+    for (double renderTime : renderTimes)
+    {
+        if (renderTime <= 0.0)
+        {
+            std::cerr << "Benchmark needs a positive render time, got " << renderTime << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << std::left << std::setw(16) << "loop"
+        << std::right << std::setw(14) << "render [ms]"
+        << std::setw(10) << "fps"
+        << std::setw(14) << "frame [ms]"
+        << std::setw(16) << "deviation [ms]"
+        << std::setw(14) << "longest [ms]"
+        << std::setw(14) << "lag dev [ms]"
+        << std::setw(12) << "drift [%]" << std::endl;
+    // both loops draw the same sequence of render times
+    for (double renderTime : renderTimes)
+    {
+        PrintLoopStatistics("timer", renderTime, SimulateTimerLoop(renderTime / 1000.0));
+        PrintLoopStatistics("fixed step", renderTime, SimulateFixedLoop(renderTime / 1000.0));
+    }
+    return 0;
+}
+
+int CBenchmark::Run(int argc, char* argv[])
+{
+    if (argc < 1)
+    {
+        std::cout << "Usage: " << BENCHMARK_SWITCH << " <benchmark> [arguments]" << std::endl
+            << "  mesh-cache [model...]" << std::endl
+            << "  water [side]" << std::endl
+            << "  fft [resolution...]" << std::endl
+            << "  transforms [count...]" << std::endl
+            << "  model-matrix [count]" << std::endl
+            << "  hierarchy [count...]" << std::endl
+            << "  instancing [count...]" << std::endl
+            << "  arena [model...]" << std::endl
+            << "  timestep [render ms...]" << std::endl;
+        return 1;
+    }
+
+    std::string name = argv[0];
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+    if (name == "mesh-cache")
+        return MeshCacheBenchmark(arguments);
+    if (name == "water")
+        return WaterBenchmark(arguments);
+    if (name == "fft")
+        return FourierBenchmark(arguments);
+    if (name == "transforms")
+        return TransformBenchmark(arguments);
+    if (name == "model-matrix")
+        return ModelMatrixBenchmark(arguments);
+    if (name == "hierarchy")
+        return HierarchyBenchmark(arguments);
+    if (name == "instancing")
+        return InstancingBenchmark(arguments);
+    if (name == "arena")
+        return ArenaBenchmark(arguments);
+    if (name == "timestep")
+        return TimestepBenchmark(arguments);
+
+    std::cerr << "Unknown benchmark: " << name << std::endl;
+    return 1;
+}
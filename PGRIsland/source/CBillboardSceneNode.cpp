@@ -17,13 +17,31 @@ CBillboardSceneNode::CBillboardSceneNode(const CShaderProgram& program)
 {
 }
 
-void CBillboardSceneNode::Draw()
+void CBillboardSceneNode::UpdateBounds()
 {
-    if (!IsOn)
+    glm::vec3 minimum = MMesh.GetBoundsMinimum();
+    glm::vec3 maximum = MMesh.GetBoundsMaximum();
+    if (minimum.x > maximum.x)
+    {
+        CSceneNode::UpdateBounds();
         return;
-    MShaderProgram.UseProgram();
+    }
+    // the furthest corner from the origin reaches the same distance in any rotation
+    float radius = glm::length(glm::max(glm::abs(minimum), glm::abs(maximum)));
+    SetBounds(glm::vec3(-radius), glm::vec3(radius));
+}
 
-    MShaderProgram.SetFloat("time", MTime);
+bool CBillboardSceneNode::IsBatchable() const
+{
+    return false;
+}
+
+void CBillboardSceneNode::DrawMesh(CRenderState& state)
+{
+    state.UseProgram(MShaderProgram);
+
+    const CShaderUniforms& uniforms = MShaderProgram.GetUniforms();
+    MShaderProgram.SetFloat(uniforms.MTime, MTime);
 
     // calculation of model matrix so that the object faces the camera
     glm::mat4 viewMatrix = gameState.MCamera.GetViewMatrix();
@@ -35,26 +53,8 @@ void CBillboardSceneNode::Draw()
     );
     rotationMatrix = glm::inverse(rotationMatrix);
 
-    MShaderProgram.SetMat4("model", GetModelMatrix() * rotationMatrix);
-    MShaderProgram.SetMat4("view", viewMatrix);
-    MShaderProgram.SetMat4("projection", gameState.GetProjectionMatrix());
-
-    MShaderProgram.SetVec3("lightPosition", SUN_POSITION);
-    MShaderProgram.SetVec4("light.vector", gameState.light.MVector);
-    MShaderProgram.SetVec3("light.ambient", gameState.light.MAmbient);
-    MShaderProgram.SetVec3("light.diffuse", gameState.light.MDiffuse);
-    MShaderProgram.SetVec3("light.specular", gameState.light.MSpecular);
-    MShaderProgram.SetVec3("light.dim", gameState.light.MDim);
-    MShaderProgram.SetVec3("cameraDir", gameState.MCamera.MDirection);
-    MShaderProgram.SetFloat("cutOff", CAMERA_LIGHT_CUTOFF);
-    MShaderProgram.SetFloat("outerCutOff", CAMERA_LIGHT_OUTERCUTOFF);
-
-    MShaderProgram.SetVec4("dirLight.vector", gameState.dirLight.MVector);
-    MShaderProgram.SetVec3("dirLight.ambient", gameState.dirLight.MAmbient);
-    MShaderProgram.SetVec3("dirLight.diffuse", gameState.dirLight.MDiffuse);
-    MShaderProgram.SetVec3("dirLight.specular", gameState.dirLight.MSpecular);
-
-    MMesh.Draw(MShaderProgram);
-    for (const auto& node : MSceneNodes)
-        node->Draw();
+    // view, projection and lights come from the per-frame uniform buffer
+    MShaderProgram.SetMat4(uniforms.MModel, GetModelMatrix() * rotationMatrix);
+
+    MMesh.Draw(MShaderProgram, state);
 }
@@ -0,0 +1,442 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CBoundingVolumeHierarchy.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class representing a dynamic bounding volume hierarchy
+ *
+ * Keeps axis aligned boxes of objects in a balanced binary tree for fast spatial queries
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CBoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <utility>
+
+/**
+ * Help function computing the surface area of a box
+ *
+ * \param minimum - minimal corner of the box
+ * \param maximum - maximal corner of the box
+ *
+ * \return surface area of the box
+ */
+static float Area(const glm::vec3& minimum, const glm::vec3& maximum)
+{
+    glm::vec3 size = maximum - minimum;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+/**
+ * Help function checking whether a box contains another one
+ *
+ * \param      minimum - minimal corner of the outer box
+ * \param      maximum - maximal corner of the outer box
+ * \param innerMinimum - minimal corner of the inner box
+ * \param innerMaximum - maximal corner of the inner box
+ *
+ * \return true if the inner box is contained else false
+ */
+static bool Contains(const glm::vec3& minimum, const glm::vec3& maximum, const glm::vec3& innerMinimum, const glm::vec3& innerMaximum)
+{
+    return minimum.x <= innerMinimum.x && minimum.y <= innerMinimum.y && minimum.z <= innerMinimum.z
+        && innerMaximum.x <= maximum.x && innerMaximum.y <= maximum.y && innerMaximum.z <= maximum.z;
+}
+
+CBoundingVolumeHierarchy::CBoundingVolumeHierarchy(const float& margin)
+    : MMargin(margin)
+{}
+
+int CBoundingVolumeHierarchy::AllocateNode()
+{
+    int node;
+    if (MFreeNode >= 0)
+    {
+        node = MFreeNode;
+        MFreeNode = MNodes[node].MParent;
+    }
+    else
+    {
+        node = (int)MNodes.size();
+        MNodes.emplace_back();
+    }
+    CHierarchyNode& created = MNodes[node];
+    created.MParent = -1;
+    created.MChildren[0] = -1;
+    created.MChildren[1] = -1;
+    created.MHeight = 0;
+    created.MObject = -1;
+    return node;
+}
+
+void CBoundingVolumeHierarchy::FreeNode(const int& node)
+{
+    MNodes[node].MParent = MFreeNode;
+    MNodes[node].MHeight = -1;
+    MFreeNode = node;
+}
+
+int CBoundingVolumeHierarchy::Insert(const glm::vec3& minimum, const glm::vec3& maximum, const int& object)
+{
+    int leaf = AllocateNode();
+    CHierarchyNode& node = MNodes[leaf];
+    node.MObject = object;
+    node.MObjectMinimum = minimum;
+    node.MObjectMaximum = maximum;
+    node.MMinimum = minimum - glm::vec3(MMargin);
+    node.MMaximum = maximum + glm::vec3(MMargin);
+    InsertLeaf(leaf);
+    ++MLeafCount;
+    return leaf;
+}
+
+void CBoundingVolumeHierarchy::Remove(const int& leaf)
+{
+    RemoveLeaf(leaf);
+    FreeNode(leaf);
+    --MLeafCount;
+}
+
+bool CBoundingVolumeHierarchy::Move(const int& leaf, const glm::vec3& minimum, const glm::vec3& maximum)
+{
+    CHierarchyNode& node = MNodes[leaf];
+    node.MObjectMinimum = minimum;
+    node.MObjectMaximum = maximum;
+    if (Contains(node.MMinimum, node.MMaximum, minimum, maximum))
+        return false;
+
+    RemoveLeaf(leaf);
+    node.MMinimum = minimum - glm::vec3(MMargin);
+    node.MMaximum = maximum + glm::vec3(MMargin);
+    InsertLeaf(leaf);
+    return true;
+}
+
+void CBoundingVolumeHierarchy::SetBox(const int& leaf, const glm::vec3& minimum, const glm::vec3& maximum)
+{
+    CHierarchyNode& node = MNodes[leaf];
+    node.MObjectMinimum = minimum;
+    node.MObjectMaximum = maximum;
+    if (Contains(node.MMinimum, node.MMaximum, minimum, maximum))
+        return;
+    node.MMinimum = minimum - glm::vec3(MMargin);
+    node.MMaximum = maximum + glm::vec3(MMargin);
+    MRefit.push_back(leaf);
+}
+
+void CBoundingVolumeHierarchy::Refit()
+{
+    for (int leaf : MRefit)
+    {
+        // a removed leaf is free and has no ancestors to fix
+        if (MNodes[leaf].MHeight != 0)
+            continue;
+        int index = MNodes[leaf].MParent;
+        while (index >= 0)
+        {
+            CHierarchyNode& node = MNodes[index];
+            const CHierarchyNode& first = MNodes[node.MChildren[0]];
+            const CHierarchyNode& second = MNodes[node.MChildren[1]];
+            glm::vec3 minimum = glm::min(first.MMinimum, second.MMinimum);
+            glm::vec3 maximum = glm::max(first.MMaximum, second.MMaximum);
+            // the ancestors above depend only on this box
+            if (minimum == node.MMinimum && maximum == node.MMaximum)
+                break;
+            node.MMinimum = minimum;
+            node.MMaximum = maximum;
+            index = node.MParent;
+        }
+    }
+    MRefit.clear();
+}
+
+void CBoundingVolumeHierarchy::Clear()
+{
+    MNodes.clear();
+    MRefit.clear();
+    MRoot = -1;
+    MFreeNode = -1;
+    MLeafCount = 0;
+}
+
+void CBoundingVolumeHierarchy::InsertLeaf(const int& leaf)
+{
+    if (MRoot < 0)
+    {
+        MRoot = leaf;
+        MNodes[leaf].MParent = -1;
+        return;
+    }
+
+    // descends while the cost of placing the leaf further down can still be lower,
+    // every node passed on the way grows by the leaf's box
+    glm::vec3 leafMinimum = MNodes[leaf].MMinimum;
+    glm::vec3 leafMaximum = MNodes[leaf].MMaximum;
+    int index = MRoot;
+    while (MNodes[index].MChildren[0] >= 0)
+    {
+        const CHierarchyNode& node = MNodes[index];
+        float area = Area(node.MMinimum, node.MMaximum);
+        float combinedArea = Area(glm::min(node.MMinimum, leafMinimum), glm::max(node.MMaximum, leafMaximum));
+        // a new parent of this node and the leaf
+        float cost = 2.0f * combinedArea;
+        // growth of the ancestors when the leaf goes further down
+        float inheritance = 2.0f * (combinedArea - area);
+
+        float childCosts[2];
+        for (int i = 0; i < 2; ++i)
+        {
+            const CHierarchyNode& child = MNodes[node.MChildren[i]];
+            float childArea = Area(glm::min(child.MMinimum, leafMinimum), glm::max(child.MMaximum, leafMaximum));
+            if (child.MChildren[0] >= 0)
+                childArea -= Area(child.MMinimum, child.MMaximum);
+            childCosts[i] = childArea + inheritance;
+        }
+        if (cost < childCosts[0] && cost < childCosts[1])
+            break;
+        index = childCosts[0] < childCosts[1] ? node.MChildren[0] : node.MChildren[1];
+    }
+
+    int sibling = index;
+    int oldParent = MNodes[sibling].MParent;
+    int newParent = AllocateNode();
+    CHierarchyNode& parent = MNodes[newParent];
+    parent.MParent = oldParent;
+    parent.MChildren[0] = sibling;
+    parent.MChildren[1] = leaf;
+    parent.MHeight = MNodes[sibling].MHeight + 1;
+    parent.MMinimum = glm::min(MNodes[sibling].MMinimum, leafMinimum);
+    parent.MMaximum = glm::max(MNodes[sibling].MMaximum, leafMaximum);
+    if (oldParent >= 0)
+    {
+        CHierarchyNode& grandparent = MNodes[oldParent];
+        grandparent.MChildren[grandparent.MChildren[0] == sibling ? 0 : 1] = newParent;
+    }
+    else
+        MRoot = newParent;
+    MNodes[sibling].MParent = newParent;
+    MNodes[leaf].MParent = newParent;
+
+    FixUpwards(oldParent);
+}
+
+void CBoundingVolumeHierarchy::RemoveLeaf(const int& leaf)
+{
+    if (leaf == MRoot)
+    {
+        MRoot = -1;
+        return;
+    }
+
+    int parent = MNodes[leaf].MParent;
+    int grandparent = MNodes[parent].MParent;
+    int sibling = MNodes[parent].MChildren[0] == leaf ? MNodes[parent].MChildren[1] : MNodes[parent].MChildren[0];
+    // the sibling takes the parent's place
+    if (grandparent >= 0)
+    {
+        CHierarchyNode& node = MNodes[grandparent];
+        node.MChildren[node.MChildren[0] == parent ? 0 : 1] = sibling;
+        MNodes[sibling].MParent = grandparent;
+        FreeNode(parent);
+        FixUpwards(grandparent);
+    }
+    else
+    {
+        MRoot = sibling;
+        MNodes[sibling].MParent = -1;
+        FreeNode(parent);
+    }
+    MNodes[leaf].MParent = -1;
+}
+
+void CBoundingVolumeHierarchy::FixUpwards(int node)
+{
+    while (node >= 0)
+    {
+        node = Balance(node);
+        CHierarchyNode& current = MNodes[node];
+        const CHierarchyNode& first = MNodes[current.MChildren[0]];
+        const CHierarchyNode& second = MNodes[current.MChildren[1]];
+        current.MHeight = 1 + std::max(first.MHeight, second.MHeight);
+        current.MMinimum = glm::min(first.MMinimum, second.MMinimum);
+        current.MMaximum = glm::max(first.MMaximum, second.MMaximum);
+        node = current.MParent;
+    }
+}
+
+int CBoundingVolumeHierarchy::Balance(const int& a)
+{
+    CHierarchyNode& nodeA = MNodes[a];
+    if (nodeA.MChildren[0] < 0 || nodeA.MHeight < 2)
+        return a;
+
+    // the higher child is rotated up and its higher child stays under it,
+    // its lower child replaces it under a
+    int higherSide = MNodes[nodeA.MChildren[1]].MHeight > MNodes[nodeA.MChildren[0]].MHeight ? 1 : 0;
+    int b = nodeA.MChildren[higherSide];
+    int c = nodeA.MChildren[1 - higherSide];
+    int balance = MNodes[b].MHeight - MNodes[c].MHeight;
+    if (balance <= 1)
+        return a;
+
+    CHierarchyNode& nodeB = MNodes[b];
+    int d = nodeB.MChildren[0];
+    int e = nodeB.MChildren[1];
+    if (MNodes[d].MHeight > MNodes[e].MHeight)
+        std::swap(d, e);
+    // e is the higher grandchild, it stays under b, d moves under a
+
+    nodeB.MParent = nodeA.MParent;
+    if (nodeB.MParent >= 0)
+    {
+        CHierarchyNode& parent = MNodes[nodeB.MParent];
+        parent.MChildren[parent.MChildren[0] == a ? 0 : 1] = b;
+    }
+    else
+        MRoot = b;
+    nodeB.MChildren[0] = a;
+    nodeB.MChildren[1] = e;
+    nodeA.MParent = b;
+    nodeA.MChildren[higherSide] = d;
+    MNodes[d].MParent = a;
+
+    const CHierarchyNode& nodeC = MNodes[c];
+    const CHierarchyNode& nodeD = MNodes[d];
+    const CHierarchyNode& nodeE = MNodes[e];
+    nodeA.MHeight = 1 + std::max(nodeC.MHeight, nodeD.MHeight);
+    nodeA.MMinimum = glm::min(nodeC.MMinimum, nodeD.MMinimum);
+    nodeA.MMaximum = glm::max(nodeC.MMaximum, nodeD.MMaximum);
+    nodeB.MHeight = 1 + std::max(nodeA.MHeight, nodeE.MHeight);
+    nodeB.MMinimum = glm::min(nodeA.MMinimum, nodeE.MMinimum);
+    nodeB.MMaximum = glm::max(nodeA.MMaximum, nodeE.MMaximum);
+    return b;
+}
+
+void CBoundingVolumeHierarchy::CollectObjects(const int& node, std::vector<int>& objects) const
+{
+    std::vector<int> stack(1, node);
+    while (!stack.empty())
+    {
+        const CHierarchyNode& current = MNodes[stack.back()];
+        stack.pop_back();
+        if (current.MChildren[0] < 0)
+            objects.push_back(current.MObject);
+        else
+        {
+            stack.push_back(current.MChildren[0]);
+            stack.push_back(current.MChildren[1]);
+        }
+    }
+}
+
+void CBoundingVolumeHierarchy::QueryFrustum(const CFrustum& frustum, std::vector<int>& objects) const
+{
+    if (MRoot < 0)
+        return;
+    std::vector<int> stack(1, MRoot);
+    while (!stack.empty())
+    {
+        int index = stack.back();
+        stack.pop_back();
+        const CHierarchyNode& node = MNodes[index];
+        if (node.MChildren[0] < 0)
+        {
+            if (frustum.IsBoxVisible(node.MObjectMinimum, node.MObjectMaximum))
+                objects.push_back(node.MObject);
+            continue;
+        }
+        if (!frustum.IsBoxVisible(node.MMinimum, node.MMaximum))
+            continue;
+        // the objects' boxes lie in the enlarged ones, all of them pass as well
+        if (frustum.IsBoxInside(node.MMinimum, node.MMaximum))
+        {
+            CollectObjects(index, objects);
+            continue;
+        }
+        stack.push_back(node.MChildren[0]);
+        stack.push_back(node.MChildren[1]);
+    }
+}
+
+void CBoundingVolumeHierarchy::QuerySphere(const glm::vec3& center, const float& radius, std::vector<int>& objects) const
+{
+    if (MRoot < 0)
+        return;
+    std::vector<int> stack(1, MRoot);
+    while (!stack.empty())
+    {
+        const CHierarchyNode& node = MNodes[stack.back()];
+        stack.pop_back();
+        if (node.MChildren[0] < 0)
+        {
+            if (IsBoxInSphere(node.MObjectMinimum, node.MObjectMaximum, center, radius))
+                objects.push_back(node.MObject);
+        }
+        else if (IsBoxInSphere(node.MMinimum, node.MMaximum, center, radius))
+        {
+            stack.push_back(node.MChildren[0]);
+            stack.push_back(node.MChildren[1]);
+        }
+    }
+}
+
+void CBoundingVolumeHierarchy::QueryRay(const glm::vec3& origin, const glm::vec3& direction, const float& distance, std::vector<int>& objects) const
+{
+    if (MRoot < 0)
+        return;
+    // divisions by zero give infinities, which the slab test handles
+    glm::vec3 inverse = 1.0f / direction;
+    std::vector<std::pair<float, int>> hits;
+    std::vector<int> stack(1, MRoot);
+    float hit;
+    while (!stack.empty())
+    {
+        const CHierarchyNode& node = MNodes[stack.back()];
+        stack.pop_back();
+        if (node.MChildren[0] < 0)
+        {
+            if (IsBoxOnRay(node.MObjectMinimum, node.MObjectMaximum, origin, inverse, distance, hit))
+                hits.emplace_back(hit, node.MObject);
+        }
+        else if (IsBoxOnRay(node.MMinimum, node.MMaximum, origin, inverse, distance, hit))
+        {
+            stack.push_back(node.MChildren[0]);
+            stack.push_back(node.MChildren[1]);
+        }
+    }
+    std::sort(hits.begin(), hits.end());
+    for (const auto& entry : hits)
+        objects.push_back(entry.second);
+}
+
+int CBoundingVolumeHierarchy::GetLeafCount() const
+{
+    return MLeafCount;
+}
+
+int CBoundingVolumeHierarchy::GetHeight() const
+{
+    return MRoot < 0 ? -1 : MNodes[MRoot].MHeight;
+}
+
+bool CBoundingVolumeHierarchy::IsBoxInSphere(const glm::vec3& minimum, const glm::vec3& maximum, const glm::vec3& center, const float& radius)
+{
+    // the closest point of the box to the center
+    glm::vec3 offset = glm::clamp(center, minimum, maximum) - center;
+    return glm::dot(offset, offset) <= radius * radius;
+}
+
+bool CBoundingVolumeHierarchy::IsBoxOnRay(const glm::vec3& minimum, const glm::vec3& maximum, const glm::vec3& origin,
+    const glm::vec3& inverse, const float& distance, float& hit)
+{
+    // the ray is inside the box between the last entry into a slab and the first exit from one
+    glm::vec3 first = (minimum - origin) * inverse;
+    glm::vec3 second = (maximum - origin) * inverse;
+    glm::vec3 entries = glm::min(first, second);
+    glm::vec3 exits = glm::max(first, second);
+    float entry = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.0f));
+    float exit = std::min(std::min(exits.x, exits.y), std::min(exits.z, distance));
+    hit = entry;
+    return entry <= exit;
+}
@@ -36,11 +36,8 @@ void CCamera::MoveForwardBackward(const float & coeficient)
 		return;
 	}
 
-	for (const auto& object : gameState.MRoot->GetSceneNodes())
-	{
-		if (object->CheckCollision(eye, CAMERA_SIZE))
-			return;
-	}
+	if (gameState.CheckCollision(eye, CAMERA_SIZE))
+		return;
 
 	MEye = eye;
 	//std::cout << "MEye: [" << MEye.x << ", " << MEye.y << ", " << MEye.z << "]\n"
@@ -60,11 +57,8 @@ void CCamera::MoveRightLeft(const float& coeficient)
 		return;
 	}
 
-	for (const auto& object : gameState.MRoot->GetSceneNodes())
-	{
-		if (object->CheckCollision(eye, CAMERA_SIZE))
-			return;
-	}
+	if (gameState.CheckCollision(eye, CAMERA_SIZE))
+		return;
 
 	MEye = eye;
 	//std::cout << "MEye: [" << MEye.x << ", " << MEye.y << ", " << MEye.z << "]\n"
@@ -91,3 +85,15 @@ void CCamera::Tilt(float angle)
 	//	<< "MDirection: (" << MDirection.x << ", " << MDirection.y << ", " << MDirection.z << ")\n"
 	//	<< "MUpVector: (" << MUpVector.x << ", " << MUpVector.y << ", " << MUpVector.z << ")\n";
 }
+
+CCamera CCamera::Interpolate(const CCamera& from, const CCamera& to, const float& interpolation)
+{
+	CCamera camera;
+	camera.MEye = glm::mix(from.MEye, to.MEye, interpolation);
+	// opposite directions have no blend, the step's result is taken then
+	glm::vec3 direction = glm::mix(from.MDirection, to.MDirection, interpolation);
+	glm::vec3 upVector = glm::mix(from.MUpVector, to.MUpVector, interpolation);
+	camera.MDirection = glm::length(direction) > 1e-4f ? glm::normalize(direction) : to.MDirection;
+	camera.MUpVector = glm::length(upVector) > 1e-4f ? glm::normalize(upVector) : to.MUpVector;
+	return camera;
+}
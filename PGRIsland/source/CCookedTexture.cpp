@@ -0,0 +1,248 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CCookedTexture.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class representing a cooked texture container
+ *
+ * Holds pre-built mipmap levels of an image, optionally block compressed,
+ * the container is memory mapped so levels are uploaded without decoding
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CCookedTexture.h"
+#include "../include/CMeshCache.h"
+#include "../include/HConstants.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+/**
+ * Magic identifier of a container
+ */
+static const char COOKED_TEXTURE_MAGIC[4] = { 'P', 'G', 'R', 'T' };
+
+/**
+ * Alignment of the level data in the container
+ */
+static const uint64_t COOKED_TEXTURE_ALIGNMENT = 16;
+
+/**
+ * Help function checking whether the OpenGL context exposes an extension
+ *
+ * \param name - name of the extension
+ *
+ * \return true if exposed else false
+ */
+static bool HasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && std::strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+std::string CCookedTexture::GetCookedPath(const std::string& file)
+{
+    return file + COOKED_TEXTURE_EXTENSION;
+}
+
+uint64_t CCookedTexture::ComputeLevelSize(const EFormat& format, const uint32_t& width, const uint32_t& height)
+{
+    uint64_t blocks = (uint64_t)((width + 3) / 4) * ((height + 3) / 4);
+    switch (format)
+    {
+        case FORMAT_BC1:
+            return blocks * 8;
+        case FORMAT_BC3:
+        case FORMAT_BC7:
+            return blocks * 16;
+        default:
+            return (uint64_t)width * height * 4;
+    }
+}
+
+const char* CCookedTexture::GetFormatName(const EFormat& format)
+{
+    switch (format)
+    {
+        case FORMAT_BC1:
+            return "BC1";
+        case FORMAT_BC3:
+            return "BC3";
+        case FORMAT_BC7:
+            return "BC7";
+        default:
+            return "RGBA8";
+    }
+}
+
+bool CCookedTexture::Load(const std::string& file)
+{
+    MLevels.clear();
+
+    uint64_t hash, size;
+    if (!CMeshCache::HashFile(file, hash, size) || !MFile.Open(GetCookedPath(file)))
+        return false;
+
+    CHeader header;
+    if (MFile.GetSize() < sizeof(CHeader))
+    {
+        MFile.Close();
+        return false;
+    }
+    std::memcpy(&header, MFile.GetData(), sizeof(CHeader));
+    if (std::memcmp(header.MMagic, COOKED_TEXTURE_MAGIC, sizeof(header.MMagic)) != 0 ||
+        header.MVersion != VERSION ||
+        header.MFormat >= FORMAT_COUNT ||
+        header.MLevelCount == 0 || header.MLevelCount > 32 ||
+        header.MSourceHash != hash ||
+        header.MSourceSize != size ||
+        MFile.GetSize() < sizeof(CHeader) + header.MLevelCount * sizeof(CLevel))
+    {
+        MFile.Close();
+        return false;
+    }
+
+    MFormat = (EFormat)header.MFormat;
+    MSourceComponents = header.MSourceComponents;
+    MLevels.resize(header.MLevelCount);
+    std::memcpy(MLevels.data(), MFile.GetData() + sizeof(CHeader), header.MLevelCount * sizeof(CLevel));
+
+    // every level has to lie inside the file and match its dimensions
+    for (const auto& level : MLevels)
+    {
+        if (level.MWidth == 0 || level.MHeight == 0 ||
+            level.MSize != ComputeLevelSize(MFormat, level.MWidth, level.MHeight) ||
+            level.MOffset > MFile.GetSize() || level.MSize > MFile.GetSize() - level.MOffset)
+        {
+            std::cerr << "ERROR::COOKED_TEXTURE::invalid level in " << GetCookedPath(file) << std::endl;
+            MLevels.clear();
+            MFile.Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CCookedTexture::Save(const std::string& file, const EFormat& format, const uint32_t& sourceComponents,
+    std::vector<CLevel> levels, const std::vector<std::vector<unsigned char>>& data)
+{
+    CHeader header;
+    std::memcpy(header.MMagic, COOKED_TEXTURE_MAGIC, sizeof(header.MMagic));
+    header.MVersion = VERSION;
+    header.MFormat = format;
+    header.MLevelCount = (uint32_t)levels.size();
+    header.MSourceComponents = sourceComponents;
+    header.MReserved = 0;
+    if (!CMeshCache::HashFile(file, header.MSourceHash, header.MSourceSize))
+        return false;
+
+    uint64_t offset = sizeof(CHeader) + levels.size() * sizeof(CLevel);
+    for (auto& level : levels)
+    {
+        offset = (offset + COOKED_TEXTURE_ALIGNMENT - 1) / COOKED_TEXTURE_ALIGNMENT * COOKED_TEXTURE_ALIGNMENT;
+        level.MOffset = offset;
+        offset += level.MSize;
+    }
+
+    // write to a temporary file first, so a running application never maps a half written container
+    std::string path = GetCookedPath(file);
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+        if (!stream)
+            return false;
+        stream.write((const char*)&header, sizeof(header));
+        stream.write((const char*)levels.data(), levels.size() * sizeof(CLevel));
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            static const char padding[COOKED_TEXTURE_ALIGNMENT] = {};
+            stream.write(padding, levels[i].MOffset - (uint64_t)stream.tellp());
+            stream.write((const char*)data[i].data(), levels[i].MSize);
+        }
+        if (!stream)
+            return false;
+    }
+    std::remove(path.c_str());
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool CCookedTexture::IsSupported() const
+{
+    // the context does not change, so its capabilities are queried once
+    static const bool s3tc = HasExtension("GL_EXT_texture_compression_s3tc");
+    static const bool bptc = HasExtension("GL_ARB_texture_compression_bptc");
+
+    switch (MFormat)
+    {
+        case FORMAT_BC1:
+        case FORMAT_BC3:
+            return s3tc;
+        case FORMAT_BC7:
+            return bptc;
+        default:
+            return true;
+    }
+}
+
+size_t CCookedTexture::Upload(const GLenum& target, const uint32_t& levels) const
+{
+    GLenum internalFormat = GL_RGBA;
+    if (MFormat == FORMAT_BC1)
+        internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    else if (MFormat == FORMAT_BC3)
+        internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    else if (MFormat == FORMAT_BC7)
+        internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+
+    size_t size = 0;
+    for (uint32_t i = 0; i < levels && i < MLevels.size(); ++i)
+    {
+        const CLevel& level = MLevels[i];
+        const char* data = MFile.GetData() + level.MOffset;
+        if (MFormat == FORMAT_RGBA8)
+            glTexImage2D(target, i, GL_RGBA, level.MWidth, level.MHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        else
+            glCompressedTexImage2D(target, i, internalFormat, level.MWidth, level.MHeight, 0, (GLsizei)level.MSize, data);
+        size += (size_t)level.MSize;
+    }
+    return size;
+}
+
+CCookedTexture::EFormat CCookedTexture::GetFormat() const
+{
+    return MFormat;
+}
+
+uint32_t CCookedTexture::GetLevelCount() const
+{
+    return (uint32_t)MLevels.size();
+}
+
+const CCookedTexture::CLevel& CCookedTexture::GetLevel(const uint32_t& level) const
+{
+    return MLevels[level];
+}
+
+uint32_t CCookedTexture::GetSourceComponents() const
+{
+    return MSourceComponents;
+}
@@ -0,0 +1,83 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CFixedTimestep.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class dividing the elapsed time into simulation steps of a fixed length
+ *
+ * Decouples the simulation rate from the frame rate and measures the frame times
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CFixedTimestep.h"
+
+#include <algorithm>
+#include <cmath>
+
+void CFrameTimeStatistics::Add(const double& frameTime)
+{
+    ++MFrames;
+    double difference = frameTime - MMean;
+    MMean += difference / MFrames;
+    MSquares += difference * (frameTime - MMean);
+    MMaximum = std::max(MMaximum, frameTime);
+}
+
+double CFrameTimeStatistics::GetDeviation() const
+{
+    if (MFrames < 2)
+        return 0.0;
+    return std::sqrt(MSquares / (MFrames - 1));
+}
+
+void CFrameTimeStatistics::Reset()
+{
+    *this = CFrameTimeStatistics();
+}
+
+CFixedTimestep::CFixedTimestep(const double& step, const double& maxFrameTime, const int& maxSteps)
+    : MStep(step), MMaxFrameTime(maxFrameTime), MMaxSteps(maxSteps)
+{
+}
+
+int CFixedTimestep::Advance(const double& frameTime)
+{
+    double time = std::max(frameTime, 0.0);
+    if (time > MMaxFrameTime)
+    {
+        MDropped += time - MMaxFrameTime;
+        time = MMaxFrameTime;
+    }
+    MAccumulator += time;
+
+    int steps = (int)std::min(std::floor(MAccumulator / MStep), (double)MMaxSteps);
+    MAccumulator -= steps * MStep;
+    if (MAccumulator >= MStep)
+    {
+        // the simulation cannot keep up, the rest is dropped instead of piling up
+        double rest = std::fmod(MAccumulator, MStep);
+        MDropped += MAccumulator - rest;
+        MAccumulator = rest;
+    }
+    return steps;
+}
+
+double CFixedTimestep::GetStep() const
+{
+    return MStep;
+}
+
+float CFixedTimestep::GetInterpolation() const
+{
+    return (float)(MAccumulator / MStep);
+}
+
+double CFixedTimestep::GetDropped() const
+{
+    return MDropped;
+}
+
+void CFixedTimestep::ResetDropped()
+{
+    MDropped = 0.0;
+}
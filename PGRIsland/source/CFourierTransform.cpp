@@ -0,0 +1,413 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CFourierTransform.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class computing fast Fourier transforms of square grids
+ *
+ * Radix-2 transforms of rows and columns with SSE, AVX or scalar butterflies
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CFourierTransform.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FOURIER_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FOURIER_SSE_TARGET
+#define FOURIER_AVX_TARGET
+#else
+#include <cpuid.h>
+#define FOURIER_SSE_TARGET __attribute__((target("sse2")))
+#define FOURIER_AVX_TARGET __attribute__((target("avx")))
+#endif
+#endif
+
+/**
+ * Help function computing butterflies with a twiddle factor per butterfly
+ *
+ * every butterfly combines a with t = w * b into a + t and a - t
+ *
+ * \param            aReal - real parts of the first halves
+ * \param       aImaginary - imaginary parts of the first halves
+ * \param            bReal - real parts of the second halves
+ * \param       bImaginary - imaginary parts of the second halves
+ * \param      twiddleReal - real parts of the twiddle factors
+ * \param twiddleImaginary - imaginary parts of the twiddle factors
+ * \param            first - first butterfly
+ * \param            count - number of butterflies
+ */
+static void ButterfliesScalar(float* aReal, float* aImaginary, float* bReal, float* bImaginary,
+    const float* twiddleReal, const float* twiddleImaginary, const int& first, const int& count)
+{
+    for (int i = first; i < count; ++i)
+    {
+        float tReal = twiddleReal[i] * bReal[i] - twiddleImaginary[i] * bImaginary[i];
+        float tImaginary = twiddleReal[i] * bImaginary[i] + twiddleImaginary[i] * bReal[i];
+        bReal[i] = aReal[i] - tReal;
+        bImaginary[i] = aImaginary[i] - tImaginary;
+        aReal[i] += tReal;
+        aImaginary[i] += tImaginary;
+    }
+}
+
+/**
+ * Help function computing butterflies sharing one twiddle factor
+ *
+ * \param            aReal - real parts of the first halves
+ * \param       aImaginary - imaginary parts of the first halves
+ * \param            bReal - real parts of the second halves
+ * \param       bImaginary - imaginary parts of the second halves
+ * \param      twiddleReal - real part of the twiddle factor
+ * \param twiddleImaginary - imaginary part of the twiddle factor
+ * \param            first - first butterfly
+ * \param            count - number of butterflies
+ */
+static void BroadcastButterfliesScalar(float* aReal, float* aImaginary, float* bReal, float* bImaginary,
+    const float& twiddleReal, const float& twiddleImaginary, const int& first, const int& count)
+{
+    for (int i = first; i < count; ++i)
+    {
+        float tReal = twiddleReal * bReal[i] - twiddleImaginary * bImaginary[i];
+        float tImaginary = twiddleReal * bImaginary[i] + twiddleImaginary * bReal[i];
+        bReal[i] = aReal[i] - tReal;
+        bImaginary[i] = aImaginary[i] - tImaginary;
+        aReal[i] += tReal;
+        aImaginary[i] += tImaginary;
+    }
+}
+
+#ifdef FOURIER_X86
+/**
+ * Help function computing butterflies with a twiddle factor per butterfly, 4 at once
+ *
+ * \see ButterfliesScalar
+ */
+FOURIER_SSE_TARGET
+static void ButterfliesSSE(float* aReal, float* aImaginary, float* bReal, float* bImaginary,
+    const float* twiddleReal, const float* twiddleImaginary, const int& count)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 wr = _mm_loadu_ps(twiddleReal + i);
+        __m128 wi = _mm_loadu_ps(twiddleImaginary + i);
+        __m128 br = _mm_loadu_ps(bReal + i);
+        __m128 bi = _mm_loadu_ps(bImaginary + i);
+        __m128 ar = _mm_loadu_ps(aReal + i);
+        __m128 ai = _mm_loadu_ps(aImaginary + i);
+        __m128 tr = _mm_sub_ps(_mm_mul_ps(wr, br), _mm_mul_ps(wi, bi));
+        __m128 ti = _mm_add_ps(_mm_mul_ps(wr, bi), _mm_mul_ps(wi, br));
+        _mm_storeu_ps(bReal + i, _mm_sub_ps(ar, tr));
+        _mm_storeu_ps(bImaginary + i, _mm_sub_ps(ai, ti));
+        _mm_storeu_ps(aReal + i, _mm_add_ps(ar, tr));
+        _mm_storeu_ps(aImaginary + i, _mm_add_ps(ai, ti));
+    }
+    ButterfliesScalar(aReal, aImaginary, bReal, bImaginary, twiddleReal, twiddleImaginary, i, count);
+}
+
+/**
+ * Help function computing butterflies sharing one twiddle factor, 4 at once
+ *
+ * \see BroadcastButterfliesScalar
+ */
+FOURIER_SSE_TARGET
+static void BroadcastButterfliesSSE(float* aReal, float* aImaginary, float* bReal, float* bImaginary,
+    const float& twiddleReal, const float& twiddleImaginary, const int& count)
+{
+    __m128 wr = _mm_set1_ps(twiddleReal);
+    __m128 wi = _mm_set1_ps(twiddleImaginary);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 br = _mm_loadu_ps(bReal + i);
+        __m128 bi = _mm_loadu_ps(bImaginary + i);
+        __m128 ar = _mm_loadu_ps(aReal + i);
+        __m128 ai = _mm_loadu_ps(aImaginary + i);
+        __m128 tr = _mm_sub_ps(_mm_mul_ps(wr, br), _mm_mul_ps(wi, bi));
+        __m128 ti = _mm_add_ps(_mm_mul_ps(wr, bi), _mm_mul_ps(wi, br));
+        _mm_storeu_ps(bReal + i, _mm_sub_ps(ar, tr));
+        _mm_storeu_ps(bImaginary + i, _mm_sub_ps(ai, ti));
+        _mm_storeu_ps(aReal + i, _mm_add_ps(ar, tr));
+        _mm_storeu_ps(aImaginary + i, _mm_add_ps(ai, ti));
+    }
+    BroadcastButterfliesScalar(aReal, aImaginary, bReal, bImaginary, twiddleReal, twiddleImaginary, i, count);
+}
+
+/**
+ * Help function computing butterflies with a twiddle factor per butterfly, 8 at once
+ *
+ * \see ButterfliesScalar
+ */
+FOURIER_AVX_TARGET
+static void ButterfliesAVX(float* aReal, float* aImaginary, float* bReal, float* bImaginary,
+    const float* twiddleReal, const float* twiddleImaginary, const int& count)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 wr = _mm256_loadu_ps(twiddleReal + i);
+        __m256 wi = _mm256_loadu_ps(twiddleImaginary + i);
+        __m256 br = _mm256_loadu_ps(bReal + i);
+        __m256 bi = _mm256_loadu_ps(bImaginary + i);
+        __m256 ar = _mm256_loadu_ps(aReal + i);
+        __m256 ai = _mm256_loadu_ps(aImaginary + i);
+        __m256 tr = _mm256_sub_ps(_mm256_mul_ps(wr, br), _mm256_mul_ps(wi, bi));
+        __m256 ti = _mm256_add_ps(_mm256_mul_ps(wr, bi), _mm256_mul_ps(wi, br));
+        _mm256_storeu_ps(bReal + i, _mm256_sub_ps(ar, tr));
+        _mm256_storeu_ps(bImaginary + i, _mm256_sub_ps(ai, ti));
+        _mm256_storeu_ps(aReal + i, _mm256_add_ps(ar, tr));
+        _mm256_storeu_ps(aImaginary + i, _mm256_add_ps(ai, ti));
+    }
+    // legacy SSE code after dirty upper halves of YMM registers stalls on every instruction
+    _mm256_zeroupper();
+    ButterfliesScalar(aReal, aImaginary, bReal, bImaginary, twiddleReal, twiddleImaginary, i, count);
+}
+
+/**
+ * Help function computing butterflies sharing one twiddle factor, 8 at once
+ *
+ * \see BroadcastButterfliesScalar
+ */
+FOURIER_AVX_TARGET
+static void BroadcastButterfliesAVX(float* aReal, float* aImaginary, float* bReal, float* bImaginary,
+    const float& twiddleReal, const float& twiddleImaginary, const int& count)
+{
+    __m256 wr = _mm256_set1_ps(twiddleReal);
+    __m256 wi = _mm256_set1_ps(twiddleImaginary);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 br = _mm256_loadu_ps(bReal + i);
+        __m256 bi = _mm256_loadu_ps(bImaginary + i);
+        __m256 ar = _mm256_loadu_ps(aReal + i);
+        __m256 ai = _mm256_loadu_ps(aImaginary + i);
+        __m256 tr = _mm256_sub_ps(_mm256_mul_ps(wr, br), _mm256_mul_ps(wi, bi));
+        __m256 ti = _mm256_add_ps(_mm256_mul_ps(wr, bi), _mm256_mul_ps(wi, br));
+        _mm256_storeu_ps(bReal + i, _mm256_sub_ps(ar, tr));
+        _mm256_storeu_ps(bImaginary + i, _mm256_sub_ps(ai, ti));
+        _mm256_storeu_ps(aReal + i, _mm256_add_ps(ar, tr));
+        _mm256_storeu_ps(aImaginary + i, _mm256_add_ps(ai, ti));
+    }
+    _mm256_zeroupper();
+    BroadcastButterfliesScalar(aReal, aImaginary, bReal, bImaginary, twiddleReal, twiddleImaginary, i, count);
+}
+
+/**
+ * Help function reading processor features
+ *
+ * \param      leaf - CPUID leaf
+ * \param registers - EAX, EBX, ECX, EDX of the leaf
+ */
+static void ReadCpuId(const unsigned int& leaf, unsigned int registers[4])
+{
+#if defined(_MSC_VER)
+    int values[4];
+    __cpuid(values, (int)leaf);
+    for (int i = 0; i < 4; ++i)
+        registers[i] = (unsigned int)values[i];
+#else
+    if (!__get_cpuid(leaf, &registers[0], &registers[1], &registers[2], &registers[3]))
+        registers[0] = registers[1] = registers[2] = registers[3] = 0;
+#endif
+}
+#endif
+
+/**
+ * Help function computing butterflies with the selected instruction set
+ *
+ * \see ButterfliesScalar
+ */
+static void Butterflies(const EFourierKernel& kernel, float* aReal, float* aImaginary, float* bReal, float* bImaginary,
+    const float* twiddleReal, const float* twiddleImaginary, const int& count)
+{
+#ifdef FOURIER_X86
+    if (kernel == FOURIER_KERNEL_AVX)
+    {
+        ButterfliesAVX(aReal, aImaginary, bReal, bImaginary, twiddleReal, twiddleImaginary, count);
+        return;
+    }
+    if (kernel == FOURIER_KERNEL_SSE)
+    {
+        ButterfliesSSE(aReal, aImaginary, bReal, bImaginary, twiddleReal, twiddleImaginary, count);
+        return;
+    }
+#endif
+    ButterfliesScalar(aReal, aImaginary, bReal, bImaginary, twiddleReal, twiddleImaginary, 0, count);
+}
+
+/**
+ * Help function computing butterflies sharing one twiddle factor with the selected instruction set
+ *
+ * \see BroadcastButterfliesScalar
+ */
+static void BroadcastButterflies(const EFourierKernel& kernel, float* aReal, float* aImaginary, float* bReal, float* bImaginary,
+    const float& twiddleReal, const float& twiddleImaginary, const int& count)
+{
+#ifdef FOURIER_X86
+    if (kernel == FOURIER_KERNEL_AVX)
+    {
+        BroadcastButterfliesAVX(aReal, aImaginary, bReal, bImaginary, twiddleReal, twiddleImaginary, count);
+        return;
+    }
+    if (kernel == FOURIER_KERNEL_SSE)
+    {
+        BroadcastButterfliesSSE(aReal, aImaginary, bReal, bImaginary, twiddleReal, twiddleImaginary, count);
+        return;
+    }
+#endif
+    BroadcastButterfliesScalar(aReal, aImaginary, bReal, bImaginary, twiddleReal, twiddleImaginary, 0, count);
+}
+
+void CFourierTransform::Initialize(const int& size, const bool& inverse, const EFourierKernel& kernel)
+{
+    MSize = size;
+    MKernel = IsKernelSupported(kernel) ? kernel : GetBestKernel();
+
+    int bits = 0;
+    while ((1 << bits) < size)
+        ++bits;
+    MReversed.resize(size);
+    for (int i = 0; i < size; ++i)
+    {
+        int reversed = 0;
+        for (int bit = 0; bit < bits; ++bit)
+            reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+        MReversed[i] = reversed;
+    }
+
+    const double pi = 3.14159265358979323846;
+    double sign = inverse ? 1.0 : -1.0;
+    MTwiddleReal.assign(std::max(size - 1, 0), 0.0f);
+    MTwiddleImaginary.assign(std::max(size - 1, 0), 0.0f);
+    for (int half = 1; half < size; half *= 2)
+    {
+        for (int j = 0; j < half; ++j)
+        {
+            double angle = sign * pi * j / half;
+            MTwiddleReal[half - 1 + j] = (float)std::cos(angle);
+            MTwiddleImaginary[half - 1 + j] = (float)std::sin(angle);
+        }
+    }
+}
+
+int CFourierTransform::GetSize() const
+{
+    return MSize;
+}
+
+EFourierKernel CFourierTransform::GetKernel() const
+{
+    return MKernel;
+}
+
+void CFourierTransform::TransformRows(float* real, float* imaginary, const int& firstRow, const int& rowCount) const
+{
+    for (int row = firstRow; row < firstRow + rowCount; ++row)
+    {
+        float* rowReal = real + (size_t)row * MSize;
+        float* rowImaginary = imaginary + (size_t)row * MSize;
+        for (int i = 0; i < MSize; ++i)
+        {
+            int j = MReversed[i];
+            if (j > i)
+            {
+                std::swap(rowReal[i], rowReal[j]);
+                std::swap(rowImaginary[i], rowImaginary[j]);
+            }
+        }
+        // first stages are too short for SIMD registers, the butterflies fall back to scalar code
+        for (int half = 1; half < MSize; half *= 2)
+        {
+            for (int start = 0; start < MSize; start += 2 * half)
+            {
+                Butterflies(MKernel, rowReal + start, rowImaginary + start, rowReal + start + half, rowImaginary + start + half,
+                    &MTwiddleReal[half - 1], &MTwiddleImaginary[half - 1], half);
+            }
+        }
+    }
+}
+
+void CFourierTransform::TransformColumns(float* real, float* imaginary, const int& firstColumn, const int& columnCount) const
+{
+    // whole row segments are swapped and combined, so every butterfly runs along the rows
+    for (int i = 0; i < MSize; ++i)
+    {
+        int j = MReversed[i];
+        if (j > i)
+        {
+            std::swap_ranges(real + (size_t)i * MSize + firstColumn, real + (size_t)i * MSize + firstColumn + columnCount,
+                real + (size_t)j * MSize + firstColumn);
+            std::swap_ranges(imaginary + (size_t)i * MSize + firstColumn, imaginary + (size_t)i * MSize + firstColumn + columnCount,
+                imaginary + (size_t)j * MSize + firstColumn);
+        }
+    }
+    for (int half = 1; half < MSize; half *= 2)
+    {
+        for (int start = 0; start < MSize; start += 2 * half)
+        {
+            for (int j = 0; j < half; ++j)
+            {
+                size_t a = (size_t)(start + j) * MSize + firstColumn;
+                size_t b = (size_t)(start + j + half) * MSize + firstColumn;
+                BroadcastButterflies(MKernel, real + a, imaginary + a, real + b, imaginary + b,
+                    MTwiddleReal[half - 1 + j], MTwiddleImaginary[half - 1 + j], columnCount);
+            }
+        }
+    }
+}
+
+bool CFourierTransform::IsKernelSupported(const EFourierKernel& kernel)
+{
+    if (kernel == FOURIER_KERNEL_SCALAR)
+        return true;
+#ifdef FOURIER_X86
+    unsigned int registers[4];
+    ReadCpuId(1, registers);
+    // SSE2 is in EDX bit 26
+    if (kernel == FOURIER_KERNEL_SSE)
+        return (registers[3] & (1u << 26)) != 0;
+    // AVX needs the processor's support in ECX bit 28 and the operating system saving YMM registers
+    if (kernel == FOURIER_KERNEL_AVX)
+    {
+        if ((registers[2] & (1u << 28)) == 0 || (registers[2] & (1u << 27)) == 0)
+            return false;
+#if defined(_MSC_VER)
+        unsigned long long enabled = _xgetbv(0);
+#else
+        unsigned int low, high;
+        __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+        unsigned long long enabled = ((unsigned long long)high << 32) | low;
+#endif
+        return (enabled & 6) == 6;
+    }
+#endif
+    return false;
+}
+
+EFourierKernel CFourierTransform::GetBestKernel()
+{
+    if (IsKernelSupported(FOURIER_KERNEL_AVX))
+        return FOURIER_KERNEL_AVX;
+    if (IsKernelSupported(FOURIER_KERNEL_SSE))
+        return FOURIER_KERNEL_SSE;
+    return FOURIER_KERNEL_SCALAR;
+}
+
+const char* CFourierTransform::GetKernelName(const EFourierKernel& kernel)
+{
+    switch (kernel)
+    {
+        case FOURIER_KERNEL_AVX:
+            return "avx";
+        case FOURIER_KERNEL_SSE:
+            return "sse";
+        default:
+            return "scalar";
+    }
+}
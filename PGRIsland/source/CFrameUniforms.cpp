@@ -0,0 +1,71 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CFrameUniforms.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class representing a uniform buffer with per-frame data
+ *
+ * Uploads camera and light state once per frame for all shader programs
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CFrameUniforms.h"
+
+#include <cstddef>
+
+#include "../include/HConstants.h"
+#include "../include/CGLCallCounter.h"
+
+static_assert(offsetof(CFrameData, MLight) == 128, "CFrameData does not match the std140 layout");
+static_assert(offsetof(CFrameData, MCameraDirection) == 320, "CFrameData does not match the std140 layout");
+static_assert(offsetof(CFrameData, MOuterCutOff) == 336, "CFrameData does not match the std140 layout");
+static_assert(sizeof(CFrameData) == 352, "CFrameData does not match the std140 layout");
+
+CFrameLight CFrameUniforms::ConvertLight(const CLight& light)
+{
+    CFrameLight converted;
+    converted.MVector = light.MVector;
+    converted.MAmbient = glm::vec4(light.MAmbient, 0.0f);
+    converted.MDiffuse = glm::vec4(light.MDiffuse, 0.0f);
+    converted.MSpecular = glm::vec4(light.MSpecular, 0.0f);
+    converted.MDim = glm::vec4(light.MDim, 0.0f);
+    return converted;
+}
+
+void CFrameUniforms::Initialize()
+{
+    glGenBuffers(1, &MBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, MBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CFrameData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, MBuffer);
+}
+
+void CFrameUniforms::Destroy()
+{
+    if (MBuffer != 0)
+        glDeleteBuffers(1, &MBuffer);
+    MBuffer = 0;
+}
+
+void CFrameUniforms::Update(const glm::mat4& view, const glm::mat4& projection, const CLight& light, const CLight& dirLight,
+    const glm::vec3& cameraEye, const glm::vec3& cameraDir)
+{
+    if (MBuffer == 0)
+        return;
+    MData.MView = view;
+    MData.MProjection = projection;
+    MData.MLight = ConvertLight(light);
+    MData.MDirLight = ConvertLight(dirLight);
+    MData.MLightPosition = glm::vec4(SUN_POSITION, 1.0f);
+    MData.MCameraEye = glm::vec4(cameraEye, 1.0f);
+    MData.MCameraDirection = cameraDir;
+    MData.MCutOff = CAMERA_LIGHT_CUTOFF;
+    MData.MOuterCutOff = CAMERA_LIGHT_OUTERCUTOFF;
+
+    // the whole block is replaced, so the old contents are orphaned instead of waited for
+    glBindBuffer(GL_UNIFORM_BUFFER, MBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CFrameData), &MData, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    CGLCallCounter::Add(3);
+}
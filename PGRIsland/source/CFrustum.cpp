@@ -0,0 +1,66 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CFrustum.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class representing a view frustum
+ *
+ * Tests bounding boxes against the planes of the view frustum
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CFrustum.h"
+
+CFrustum::CFrustum()
+{
+    for (int i = 0; i < 6; ++i)
+        MPlanes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+CFrustum::CFrustum(const glm::mat4& clip)
+{
+    // a point is inside if -w <= x, y, z <= w in the clip space,
+    // every inequality is a plane made of the matrix's rows
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        for (int side = 0; side < 2; ++side)
+        {
+            float sign = side == 0 ? 1.0f : -1.0f;
+            glm::vec4& plane = MPlanes[axis * 2 + side];
+            for (int column = 0; column < 4; ++column)
+                plane[column] = clip[column][3] + sign * clip[column][axis];
+        }
+    }
+}
+
+bool CFrustum::IsBoxVisible(const glm::vec3& minimum, const glm::vec3& maximum) const
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        const glm::vec4& plane = MPlanes[i];
+        // the corner furthest along the plane's normal decides
+        float distance = plane.w
+            + plane.x * (plane.x >= 0.0f ? maximum.x : minimum.x)
+            + plane.y * (plane.y >= 0.0f ? maximum.y : minimum.y)
+            + plane.z * (plane.z >= 0.0f ? maximum.z : minimum.z);
+        if (distance < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool CFrustum::IsBoxInside(const glm::vec3& minimum, const glm::vec3& maximum) const
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        const glm::vec4& plane = MPlanes[i];
+        // the corner furthest against the plane's normal decides
+        float distance = plane.w
+            + plane.x * (plane.x >= 0.0f ? minimum.x : maximum.x)
+            + plane.y * (plane.y >= 0.0f ? minimum.y : maximum.y)
+            + plane.z * (plane.z >= 0.0f ? minimum.z : maximum.z);
+        if (distance < 0.0f)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,42 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CGLCallCounter.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class counting OpenGL calls
+ *
+ * Counts OpenGL calls issued while drawing a frame
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CGLCallCounter.h"
+
+size_t CGLCallCounter::MCalls = 0;
+size_t CGLCallCounter::MDrawCalls = 0;
+
+void CGLCallCounter::Add(const size_t& calls)
+{
+    MCalls += calls;
+}
+
+void CGLCallCounter::AddDraw(const size_t& calls)
+{
+    MCalls += calls;
+    MDrawCalls += calls;
+}
+
+size_t CGLCallCounter::GetCalls()
+{
+    return MCalls;
+}
+
+size_t CGLCallCounter::GetDrawCalls()
+{
+    return MDrawCalls;
+}
+
+void CGLCallCounter::Reset()
+{
+    MCalls = 0;
+    MDrawCalls = 0;
+}
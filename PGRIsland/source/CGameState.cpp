@@ -11,24 +11,42 @@
 //----------------------------------------------------------------------------------------
 #include "../include/CGameState.h"
 
+#include <algorithm>
+#include <chrono>
+#include <random>
+
 CGameState::CGameState()
 {
 	for (auto & key : MKeyMap)
 		key = false;
 
     gameState.MCamera.SetCamera(CAMERA_SPAWN_EYE, CAMERA_SPAWN_DIR, CAMERA_SPAWN_UP);
+    gameState.MPreviousCamera = gameState.MCamera;
 }
 
 void CGameState::InitializeGame()
 {
+    auto start = std::chrono::steady_clock::now();
+
     MShader = CShaderProgram(GENERAL_VERTEX_SHADER, GENERAL_FRAGMENT_SHADER);
     MSkyboxShader = CShaderProgram(SKYBOX_VERTEX_SHADER, SKYBOX_FRAGMENT_SHADER);
     MTextureShader = CShaderProgram(GENERAL_VERTEX_SHADER, TEXTURE_FRAGMENT_SHADER);
-    MWaterShader = CShaderProgram(WATER_VERTEX_SHADER, WATER_GEOMETRY_SHADER, WATER_FRAGMENT_SHADER);
+    MWaterShader = CShaderProgram(WATER_VERTEX_SHADER, WATER_FRAGMENT_SHADER);
     MFireShader = CShaderProgram(GENERAL_VERTEX_SHADER, FIRE_FRAGMENT_SHADER);
     MLightShader = CShaderProgram(GENERAL_VERTEX_SHADER, LIGHT_FRAGMENT_SHADER);
     MBannerShader = CShaderProgram(GENERAL_VERTEX_SHADER, BANNER_FRAGMENT_SHADER);
 
+    // camera and light state is uploaded once per frame and read by every program through its block
+    MFrameUniforms.Initialize();
+    for (const CShaderProgram* program : { &MShader, &MSkyboxShader, &MTextureShader, &MWaterShader, &MFireShader, &MLightShader, &MBannerShader })
+        program->BindUniformBlock(FRAME_UNIFORM_BLOCK, FRAME_UNIFORM_BINDING);
+
+    // images are decoded on the pool while the models are loaded
+    MTextureRegistry.DeferUploads(MThreadPool);
+    // objects are streamed while the first frames are already drawn
+    if (STREAMING_ENABLED)
+        MStreamingLoader.Initialize(MThreadPool);
+
     // SKYBOX 1
     InitializeSkybox();
 
@@ -64,6 +82,38 @@ void CGameState::InitializeGame()
 
     //EXPLOSION 15
     InitializeExplosion();
+
+    // FISH SCHOOL 16
+    if (MFishSchoolSize > 0)
+        InitializeFishSchool();
+
+    // nodes sharing mesh, material and program are drawn at once
+    MInstancedNodes = CInstancedSceneNode::CreateInstancedNodes(*MRoot);
+    size_t instances = 0;
+    for (const auto& node : MInstancedNodes)
+    {
+        node->SetInstancing(MInstancingEnabled);
+        instances += node->GetInstanceCount();
+    }
+    std::cout << "Instancing: " << instances << " nodes drawn by " << MInstancedNodes.size() << " instanced nodes" << std::endl;
+
+    if (!STREAMING_ENABLED)
+    {
+        MTextureRegistry.UploadPending();
+        MTextureRegistry.PrintStatistics();
+        PrintMemoryReport();
+    }
+
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+    std::cout << "Scene initialized in " << duration.count() << " ms" << std::endl;
+}
+
+void CGameState::PrintMemoryReport()
+{
+    size_t resident = 0, uploaded = 0;
+    std::cout << "Mesh memory:" << std::endl;
+    MRoot->ReportMemory("scene", resident, uploaded);
+    std::cout << "Mesh memory total: " << resident / 1024 << " KiB CPU, " << uploaded / 1024 << " KiB GPU" << std::endl;
 }
 
 void CGameState::InitializeSkybox()
@@ -76,9 +126,11 @@ void CGameState::InitializeSkybox()
 void CGameState::InitializeIsland()
 {
     std::shared_ptr<CSceneNode> island = std::make_shared<CSceneNode>(MShader);
-    island->LoadSceneNode(ISLAND_PATH);
+    island->SetVertexFormat(MODEL_VERTEX_FORMAT);
+    MStreamingLoader.LoadSceneNode(island, ISLAND_PATH);
     island->SetPosition(ISLAND_POSITION);
     island->SetSize(ISLAND_SIZE);
+    island->SetOpaque(true);
     MRoot->PushSceneNode(island);
 }
 
@@ -119,8 +171,10 @@ void CGameState::InitializeFishes()
 void CGameState::InitializeShip()
 {
     std::shared_ptr<CSplineSceneNode> ship = std::make_shared<CSplineSceneNode>(MShader, CCatmulRomSpline(SHIP_CONTROL_POINTS), SHIP_CHANGE_SLOW);
-    ship->LoadSceneNode(SHIP_PATH);
+    ship->SetVertexFormat(MODEL_VERTEX_FORMAT);
+    MStreamingLoader.LoadSceneNode(ship, SHIP_PATH);
     ship->SetSize(SHIP_SIZE);
+    ship->SetOpaque(true);
     gameState.MShip = ship;
     MRoot->PushSceneNode(ship);
 }
@@ -128,9 +182,11 @@ void CGameState::InitializeShip()
 void CGameState::InitializeCampfire()
 {
     std::shared_ptr<CSceneNode> campfire = std::make_shared<CSceneNode>(MShader);
-    campfire->LoadSceneNode(CAMPFIRE_PATH);
+    campfire->SetVertexFormat(PROP_VERTEX_FORMAT);
+    MStreamingLoader.LoadSceneNode(campfire, CAMPFIRE_PATH);
     campfire->SetPosition(CAMPFIRE_POSITION);
     campfire->SetSize(CAMPFIRE_SIZE);
+    campfire->SetOpaque(true);
     MRoot->PushSceneNode(campfire);
 }
 
@@ -142,37 +198,44 @@ void CGameState::InitializeSun()
         sphereVertices, sphereTriangles);
     sun->SetSize(SUN_SIZE);
     sun->SetPosition(SUN_POSITION);
+    sun->SetOpaque(true);
     MRoot->PushSceneNode(sun);
 }
 
 void CGameState::InitializeBucket()
 {
     std::shared_ptr<CSceneNode> bucket = std::make_shared<CSceneNode>(MShader);
-    bucket->LoadSceneNode(BUCKET_PATH);
+    bucket->SetVertexFormat(PROP_VERTEX_FORMAT);
+    MStreamingLoader.LoadSceneNode(bucket, BUCKET_PATH);
     bucket->SetPickable(true);
     bucket->SetSize(BUCKET_SIZE);
     bucket->SetPosition(BUCKET_POSITION);
+    bucket->SetOpaque(true);
     MRoot->PushSceneNode(bucket);
 }
 
 void CGameState::InitializeCannon()
 {
     std::shared_ptr<CSceneNode> cannon = std::make_shared<CSceneNode>(MShader);
-    cannon->LoadSceneNode(CANNON_PATH);
+    cannon->SetVertexFormat(PROP_VERTEX_FORMAT);
+    MStreamingLoader.LoadSceneNode(cannon, CANNON_PATH);
     cannon->SetSize(CANNON_SIZE);
     cannon->SetPosition(CANNON_POSITION);
     cannon->SetDirection(CANNON_DIRECTION);
     cannon->SetCollision(true);
+    cannon->SetOpaque(true);
     MRoot->PushSceneNode(cannon);
 }
 
 void CGameState::InitializeTorch()
 {
     std::shared_ptr<CSceneNode> torch = std::make_shared<CSceneNode>(MShader);
-    torch->LoadSceneNode(TORCH_PATH);
+    torch->SetVertexFormat(PROP_VERTEX_FORMAT);
+    MStreamingLoader.LoadSceneNode(torch, TORCH_PATH);
     torch->SetSize(TORCH_SIZE);
     torch->SetPosition(TORCH_POSITION);
     torch->SetPickable(true);
+    torch->SetOpaque(true);
     MRoot->PushSceneNode(torch);
 }
 
@@ -198,12 +261,192 @@ void CGameState::InitializeExplosion()
     MRoot->PushSceneNode(explosion);
 }
 
+void CGameState::InitializeFishSchool()
+{
+    const std::vector<glm::vec3>* splines[] = { &FISH_ONE_CONTROL_POINTS, &FISH_TWO_CONTROL_POINTS, &FISH_THREE_CONTROL_POINTS };
+    // a fixed seed gives every run the same school
+    std::mt19937 random;
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::shared_ptr<CSceneNode> school = std::make_shared<CSceneNode>();
+    MRoot->PushSceneNode(school);
+    // only the first fish is uploaded, the others draw its geometry
+    std::shared_ptr<CSplineSceneNode> first;
+    for (int i = 0; i < MFishSchoolSize; i += FISH_SCHOOL_GROUP_SIZE)
+    {
+        int spline = (i / FISH_SCHOOL_GROUP_SIZE) % 3;
+        std::shared_ptr<CSceneNode> group = std::make_shared<CSceneNode>();
+        school->PushSceneNode(group);
+        group->SetPosition(glm::vec3((2.0f * unit(random) - 1.0f) * FISH_SCHOOL_SPREAD.x, -unit(random) * FISH_SCHOOL_SPREAD.y,
+            (2.0f * unit(random) - 1.0f) * FISH_SCHOOL_SPREAD.z));
+        for (int j = i; j < std::min(i + FISH_SCHOOL_GROUP_SIZE, MFishSchoolSize); ++j)
+        {
+            float phase = unit(random) * splines[spline]->size();
+            std::shared_ptr<CSplineSceneNode> fish = std::make_shared<CSplineSceneNode>(MTextureShader, *splines[spline], FISH_CHANGE_SLOW, phase);
+            if (first == nullptr)
+            {
+                fish->LoadSceneNode(planeOrthoNAttribsPerVertex, planeOrthoNVertices, planeOrthoNTriangles, planeOrthoVertices, planeOrthoTriangles);
+                first = fish;
+            }
+            else
+                fish->LoadSceneNode(*first);
+            fish->LoadTextureSceneNode(FISH_PATH, GL_TEXTURE_2D);
+            fish->SetSize(FISH_SIZE);
+            group->PushSceneNode(fish);
+        }
+    }
+    std::cout << "Fish school: " << MFishSchoolSize << " fish" << std::endl;
+}
+
 void CGameState::InitializeWater()
 {
     std::shared_ptr<CWaterPlaneSceneNode> plane = std::make_shared<CWaterPlaneSceneNode>(MWaterShader);
     plane->SetPosition(WATER_POSITION);
     plane->SetSize(WATER_SIZE);
     MRoot->PushSceneNode(plane);
+    gameState.MWater = plane;
+}
+
+void CGameState::CullScene(const glm::mat4& clip)
+{
+    CFrustum frustum(clip);
+    MCullStatistics = CCullStatistics();
+    // top level nodes are culled one by one like they are drawn, the root itself is never tested
+    for (const auto& node : MRoot->GetSceneNodes())
+        node->Cull(frustum, MCullStatistics);
+
+    if (++MCullFrames >= CULLING_REPORT_FRAMES)
+    {
+        std::cout << "Culling: " << MCullStatistics.MTested << " boxes tested, " << MCullStatistics.MCulled
+            << " culled, " << MCullStatistics.MDrawn << " nodes drawn" << std::endl;
+        MCullFrames = 0;
+    }
+}
+
+void CGameState::DrawScene()
+{
+    auto& nodes = MRoot->GetSceneNodes();
+    // instanced nodes are drawn before the top level node holding their first instance
+    size_t instanced = 0;
+    MRenderState.Begin(MRenderQueueEnabled);
+    if (MRenderQueueEnabled)
+    {
+        MRenderQueue.Clear();
+        for (unsigned int i = 0; i < nodes.size(); ++i)
+        {
+            for (; instanced < MInstancedNodes.size() && MInstancedNodes[instanced]->GetSlot() == (int)i; ++instanced)
+                MInstancedNodes[instanced]->Submit(MRenderQueue, i + 1, false);
+            nodes[i]->Submit(MRenderQueue, i + 1, false);
+        }
+        MRenderQueue.Sort();
+        MRenderQueue.Submit(MRenderState, MGeometryArena, MMultiDrawEnabled);
+    }
+    else
+    {
+        for (unsigned int i = 0; i < nodes.size(); ++i)
+        {
+            // Draw id to stencil buffer
+            MRenderState.SetStencilReference(i + 1);
+            for (; instanced < MInstancedNodes.size() && MInstancedNodes[instanced]->GetSlot() == (int)i; ++instanced)
+                MInstancedNodes[instanced]->Draw(MRenderState);
+            nodes[i]->Draw(MRenderState);
+        }
+    }
+    MRenderState.End();
+
+    const CRenderStatistics& statistics = MRenderState.GetStatistics();
+    MRenderStatistics.MProgramRequests += statistics.MProgramRequests;
+    MRenderStatistics.MProgramSwitches += statistics.MProgramSwitches;
+    MRenderStatistics.MTextureRequests += statistics.MTextureRequests;
+    MRenderStatistics.MTextureBinds += statistics.MTextureBinds;
+    MRenderStatistics.MVertexArrayRequests += statistics.MVertexArrayRequests;
+    MRenderStatistics.MVertexArrayBinds += statistics.MVertexArrayBinds;
+}
+
+bool CGameState::SwitchRenderQueue()
+{
+    MRenderQueueEnabled = !MRenderQueueEnabled;
+    // the averages are not mixed between the two ways of drawing
+    ResetFrameReport();
+    return MRenderQueueEnabled;
+}
+
+bool CGameState::SwitchMultiDraw()
+{
+    MMultiDrawEnabled = !MMultiDrawEnabled;
+    ResetFrameReport();
+    return MMultiDrawEnabled;
+}
+
+bool CGameState::SwitchInstancing()
+{
+    MInstancingEnabled = !MInstancingEnabled;
+    for (const auto& node : MInstancedNodes)
+        node->SetInstancing(MInstancingEnabled);
+    ResetFrameReport();
+    return MInstancingEnabled;
+}
+
+void CGameState::ResetFrameReport()
+{
+    MGLCalls = 0;
+    MDrawCalls = 0;
+    MAllocations = 0;
+    MGLCallFrames = 0;
+    MRenderStatistics = CRenderStatistics();
+    MGeometryArena.ResetStatistics();
+    MFrameTimes.Reset();
+    MSimulationSteps = 0;
+    MTimestep.ResetDropped();
+}
+
+void CGameState::BeginFrame()
+{
+    MFrameAllocations = CAllocationCounter::GetAllocations();
+    MFrameUniforms.Update(GetViewMatrix(), GetProjectionMatrix(), light, dirLight, MCamera.MEye, MCamera.MDirection);
+}
+
+void CGameState::EndFrame()
+{
+    MGLCalls += CGLCallCounter::GetCalls();
+    MDrawCalls += CGLCallCounter::GetDrawCalls();
+    CGLCallCounter::Reset();
+    MAllocations += CAllocationCounter::GetAllocations() - MFrameAllocations;
+    if (++MGLCallFrames >= GL_CALL_REPORT_FRAMES)
+    {
+        std::cout << "OpenGL calls: " << MGLCalls / MGLCallFrames << " per frame (" << MDrawCalls / MGLCallFrames
+            << " draw calls" << (MInstancingEnabled ? ", instanced" : "") << "), heap allocations: "
+            << (double)MAllocations / MGLCallFrames << " per frame over " << MGLCallFrames << " frames" << std::endl;
+        // requested binds are what drawing in the scene's order without filtering issues
+        std::cout << "Binds (" << (MRenderQueueEnabled ? "render queue" : "scene order") << "): programs "
+            << MRenderStatistics.MProgramRequests / MGLCallFrames << " -> " << MRenderStatistics.MProgramSwitches / MGLCallFrames
+            << ", textures " << MRenderStatistics.MTextureRequests / MGLCallFrames << " -> " << MRenderStatistics.MTextureBinds / MGLCallFrames
+            << ", vertex arrays " << MRenderStatistics.MVertexArrayRequests / MGLCallFrames << " -> " << MRenderStatistics.MVertexArrayBinds / MGLCallFrames
+            << " per frame" << std::endl;
+        const CBatchStatistics& batches = MGeometryArena.GetStatistics();
+        std::cout << "Multi-draw" << (MRenderQueueEnabled && MMultiDrawEnabled ? "" : " (off)") << ": "
+            << batches.MNodes / MGLCallFrames << " nodes with " << batches.MCommands / MGLCallFrames << " draw records in "
+            << batches.MBatches / MGLCallFrames << " calls per frame" << std::endl;
+        MGeometryArena.Report();
+        // the deviation is what shows as stutter, the mean alone hides it
+        std::cout << "Frame time: " << MFrameTimes.MMean << " ms, deviation " << MFrameTimes.GetDeviation()
+            << " ms, longest " << MFrameTimes.MMaximum << " ms, " << (double)MSimulationSteps / MGLCallFrames
+            << " simulation steps per frame, " << MTimestep.GetDropped() * 1000.0 << " ms dropped" << std::endl;
+        ResetFrameReport();
+    }
+}
+
+bool CGameState::CheckCollision(const glm::vec3& position, const glm::vec3& size)
+{
+    std::vector<int> handles;
+    MTransforms.GetHierarchy().QuerySphere(position, size.x, handles);
+    for (int handle : handles)
+    {
+        CSceneNode* node = MTransforms.GetOwner(handle);
+        if (node != nullptr && node->CheckCollision(position, size))
+            return true;
+    }
+    return false;
 }
 
 glm::mat4 CGameState::GetProjectionMatrix()
@@ -0,0 +1,345 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CGeometryArena.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class sharing large vertex and index buffers between meshes
+ *
+ * Suballocates meshes from pages of shared buffers and submits their draws in batches
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CGeometryArena.h"
+#include "../include/CVertexQuantizer.h"
+#include "../include/CGLCallCounter.h"
+#include "../include/HConstants.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+/**
+ * Help function checking whether the OpenGL context exposes an extension
+ *
+ * \param name - name of the extension
+ *
+ * \return true if exposed else false
+ */
+static bool HasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && std::strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+CRangeAllocator::CRangeAllocator(const size_t& capacity)
+    : MCapacity(capacity)
+{
+    if (capacity > 0)
+        MFree.push_back({ 0, capacity });
+}
+
+bool CRangeAllocator::Allocate(const size_t& size, size_t& offset)
+{
+    if (size == 0)
+        return false;
+    // the smallest range keeps the big ones for big meshes
+    size_t best = MFree.size();
+    for (size_t i = 0; i < MFree.size(); ++i)
+    {
+        if (MFree[i].MSize >= size && (best == MFree.size() || MFree[i].MSize < MFree[best].MSize))
+            best = i;
+    }
+    if (best == MFree.size())
+        return false;
+
+    offset = MFree[best].MOffset;
+    MFree[best].MOffset += size;
+    MFree[best].MSize -= size;
+    if (MFree[best].MSize == 0)
+        MFree.erase(MFree.begin() + best);
+    MUsed += size;
+    return true;
+}
+
+void CRangeAllocator::Free(const size_t& offset, const size_t& size)
+{
+    if (size == 0)
+        return;
+    auto next = std::lower_bound(MFree.begin(), MFree.end(), offset,
+        [](const CFreeRange& range, const size_t& value) { return range.MOffset < value; });
+    next = MFree.insert(next, { offset, size });
+    MUsed -= size;
+
+    // merge with the following range first, so the iterator stays valid
+    auto following = next + 1;
+    if (following != MFree.end() && next->MOffset + next->MSize == following->MOffset)
+    {
+        next->MSize += following->MSize;
+        MFree.erase(following);
+    }
+    if (next != MFree.begin())
+    {
+        auto previous = next - 1;
+        if (previous->MOffset + previous->MSize == next->MOffset)
+        {
+            previous->MSize += next->MSize;
+            MFree.erase(next);
+        }
+    }
+}
+
+size_t CRangeAllocator::GetCapacity() const
+{
+    return MCapacity;
+}
+
+size_t CRangeAllocator::GetUsed() const
+{
+    return MUsed;
+}
+
+size_t CRangeAllocator::GetFreeRangeCount() const
+{
+    return MFree.size();
+}
+
+size_t CRangeAllocator::GetLargestFree() const
+{
+    size_t largest = 0;
+    for (const auto& range : MFree)
+        largest = std::max(largest, range.MSize);
+    return largest;
+}
+
+float CRangeAllocator::GetFragmentation() const
+{
+    size_t free = MCapacity - MUsed;
+    if (free == 0)
+        return 0.0f;
+    return 1.0f - (float)GetLargestFree() / free;
+}
+
+int CGeometryArena::CreatePage(const EVertexFormat& format)
+{
+    CArenaPage page;
+    page.MFormat = format;
+    page.MVertices = CRangeAllocator(GEOMETRY_ARENA_PAGE_VERTICES);
+    page.MIndices = CRangeAllocator(GEOMETRY_ARENA_PAGE_INDEX_BYTES);
+    page.MMeshCount = 0;
+
+    glGenVertexArrays(1, &page.MVertexArray);
+    glGenBuffers(1, &page.MVertexBuffer);
+    glGenBuffers(1, &page.MElementBuffer);
+
+    // the storage is reserved once, meshes are written into it by glBufferSubData
+    glBindVertexArray(page.MVertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, page.MVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, GEOMETRY_ARENA_PAGE_VERTICES * CVertexQuantizer::GetVertexSize(format), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page.MElementBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, GEOMETRY_ARENA_PAGE_INDEX_BYTES, nullptr, GL_STATIC_DRAW);
+    SetupVertexAttributes(format);
+    glBindVertexArray(0);
+
+    MPages.push_back(page);
+    std::cout << "Geometry arena: page " << MPages.size() - 1 << " of format " << format << ", "
+        << GEOMETRY_ARENA_PAGE_VERTICES * CVertexQuantizer::GetVertexSize(format) / (1024 * 1024) << " MiB vertices, "
+        << GEOMETRY_ARENA_PAGE_INDEX_BYTES / (1024 * 1024) << " MiB indices" << std::endl;
+    return (int)MPages.size() - 1;
+}
+
+bool CGeometryArena::Allocate(const EVertexFormat& format, const size_t& vertexCount, const size_t& indexSize, CArenaAllocation& allocation,
+    GLuint& vertexArray, GLuint& vertexBuffer, GLuint& elementBuffer)
+{
+    allocation = CArenaAllocation();
+    if (vertexCount > GEOMETRY_ARENA_PAGE_VERTICES || indexSize > GEOMETRY_ARENA_PAGE_INDEX_BYTES)
+        return false;
+
+    for (int page = 0; page <= (int)MPages.size(); ++page)
+    {
+        if (page == (int)MPages.size())
+            CreatePage(format);
+        CArenaPage& current = MPages[page];
+        if (current.MFormat != format)
+            continue;
+        size_t firstVertex, indexOffset;
+        if (!current.MVertices.Allocate(vertexCount, firstVertex))
+            continue;
+        if (!current.MIndices.Allocate(indexSize, indexOffset))
+        {
+            current.MVertices.Free(firstVertex, vertexCount);
+            continue;
+        }
+
+        allocation.MPage = page;
+        allocation.MFirstVertex = firstVertex;
+        allocation.MVertexCount = vertexCount;
+        allocation.MIndexOffset = indexOffset;
+        allocation.MIndexSize = indexSize;
+        ++current.MMeshCount;
+        vertexArray = current.MVertexArray;
+        vertexBuffer = current.MVertexBuffer;
+        elementBuffer = current.MElementBuffer;
+        return true;
+    }
+    return false;
+}
+
+void CGeometryArena::Free(CArenaAllocation& allocation)
+{
+    // pages are gone after Destroy, meshes destroyed later have nothing to give back
+    if (allocation.MPage >= 0 && allocation.MPage < (int)MPages.size())
+    {
+        CArenaPage& page = MPages[allocation.MPage];
+        page.MVertices.Free(allocation.MFirstVertex, allocation.MVertexCount);
+        page.MIndices.Free(allocation.MIndexOffset, allocation.MIndexSize);
+        --page.MMeshCount;
+    }
+    allocation = CArenaAllocation();
+}
+
+bool CGeometryArena::IsIndirectSupported() const
+{
+    static const bool supported = [] {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        bool indirect = major > 4 || (major == 4 && minor >= 3) || HasExtension("GL_ARB_multi_draw_indirect");
+        std::cout << "Multi-draw: " << (indirect ? "glMultiDrawElementsIndirect" : "glMultiDrawElementsBaseVertex") << std::endl;
+        return indirect;
+    }();
+    return supported;
+}
+
+bool CGeometryArena::UploadCommands(const std::vector<CDrawElementsIndirectCommand>& commands)
+{
+    if (commands.empty() || !IsIndirectSupported())
+        return false;
+    if (MIndirectBuffer == 0)
+        glGenBuffers(1, &MIndirectBuffer);
+
+    // the indirect binding is not a part of the VAO, it stays bound for the whole pass
+    size_t size = commands.size() * sizeof(CDrawElementsIndirectCommand);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, MIndirectBuffer);
+    if (size > MIndirectSize)
+        MIndirectSize = std::max(size, 2 * MIndirectSize);
+    // orphaning keeps the previous frame's records for the GPU
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, MIndirectSize, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, commands.data());
+    CGLCallCounter::Add(3);
+    return true;
+}
+
+void CGeometryArena::MultiDraw(const GLenum& indexType, const std::vector<CDrawElementsIndirectCommand>& commands,
+    const size_t& first, const size_t& count, const bool& indirect)
+{
+    if (count == 0)
+        return;
+    if (indirect)
+        glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, (const void*)(first * sizeof(CDrawElementsIndirectCommand)), (GLsizei)count, 0);
+    else
+    {
+        size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+        MCounts.resize(count);
+        MOffsets.resize(count);
+        MBaseVertices.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const CDrawElementsIndirectCommand& command = commands[first + i];
+            MCounts[i] = (GLsizei)command.MCount;
+            MOffsets[i] = (const void*)(command.MFirstIndex * indexSize);
+            MBaseVertices[i] = command.MBaseVertex;
+        }
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, MCounts.data(), indexType, MOffsets.data(), (GLsizei)count, MBaseVertices.data());
+    }
+    CGLCallCounter::AddDraw();
+    MStatistics.MCommands += count;
+    ++MStatistics.MBatches;
+}
+
+void CGeometryArena::AddBatchedNodes(const size_t& nodes)
+{
+    MStatistics.MNodes += nodes;
+}
+
+void CGeometryArena::AddSeparateMesh()
+{
+    ++MSeparateMeshes;
+}
+
+const CBatchStatistics& CGeometryArena::GetStatistics() const
+{
+    return MStatistics;
+}
+
+void CGeometryArena::ResetStatistics()
+{
+    MStatistics = CBatchStatistics();
+}
+
+void CGeometryArena::Report() const
+{
+    for (size_t i = 0; i < MPages.size(); ++i)
+    {
+        const CArenaPage& page = MPages[i];
+        size_t vertexSize = CVertexQuantizer::GetVertexSize(page.MFormat);
+        std::cout << "Geometry arena page " << i << ": " << page.MMeshCount << " meshes, vertices "
+            << page.MVertices.GetUsed() * vertexSize / 1024 << " / " << page.MVertices.GetCapacity() * vertexSize / 1024
+            << " KiB in " << page.MVertices.GetFreeRangeCount() << " free ranges, fragmentation "
+            << 100.0f * page.MVertices.GetFragmentation() << " %, indices "
+            << page.MIndices.GetUsed() / 1024 << " / " << page.MIndices.GetCapacity() / 1024
+            << " KiB in " << page.MIndices.GetFreeRangeCount() << " free ranges, fragmentation "
+            << 100.0f * page.MIndices.GetFragmentation() << " %" << std::endl;
+    }
+    std::cout << "Geometry arena: " << MPages.size() << " pages, " << MSeparateMeshes << " meshes with their own buffers" << std::endl;
+}
+
+void CGeometryArena::Destroy()
+{
+    for (auto& page : MPages)
+    {
+        glDeleteVertexArrays(1, &page.MVertexArray);
+        glDeleteBuffers(1, &page.MVertexBuffer);
+        glDeleteBuffers(1, &page.MElementBuffer);
+    }
+    MPages.clear();
+    if (MIndirectBuffer != 0)
+        glDeleteBuffers(1, &MIndirectBuffer);
+    MIndirectBuffer = 0;
+    MIndirectSize = 0;
+}
+
+void CGeometryArena::SetupVertexAttributes(const EVertexFormat& format)
+{
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    if (format == VERTEX_FORMAT_FLOAT)
+    {
+        // vertex positions
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CVertex), (void*)0);
+        // vertex normals
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(CVertex), (void*)offsetof(CVertex, MNormal));
+        // vertex texture coords
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(CVertex), (void*)offsetof(CVertex, MTextureCoordinates));
+    }
+    else if (format == VERTEX_FORMAT_PACKED_8)
+    {
+        // positions in the bounding box, octahedral normals, half float texture coords
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CPackedVertex8), (void*)0);
+        glVertexAttribPointer(1, 2, GL_BYTE, GL_TRUE, sizeof(CPackedVertex8), (void*)offsetof(CPackedVertex8, MNormal));
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CPackedVertex8), (void*)offsetof(CPackedVertex8, MTextureCoordinates));
+    }
+    else
+    {
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CPackedVertex16), (void*)0);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(CPackedVertex16), (void*)offsetof(CPackedVertex16, MNormal));
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CPackedVertex16), (void*)offsetof(CPackedVertex16, MTextureCoordinates));
+    }
+}
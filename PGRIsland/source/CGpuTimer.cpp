@@ -0,0 +1,100 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CGpuTimer.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class measuring GPU time of draw calls
+ *
+ * Averages GL_TIME_ELAPSED queries over a number of frames
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CGpuTimer.h"
+#include "../include/CGLCallCounter.h"
+
+void CGpuTimer::Initialize(const int& queries)
+{
+    MQueries.assign(queries, 0);
+    MPending.assign(queries, false);
+    glGenQueries(queries, MQueries.data());
+    MNext = 0;
+    MRunning = false;
+    MElapsed = 0;
+    MSamples = 0;
+}
+
+void CGpuTimer::Destroy()
+{
+    if (MRunning)
+        End();
+    if (!MQueries.empty())
+        glDeleteQueries((GLsizei)MQueries.size(), MQueries.data());
+    MQueries.clear();
+    MPending.clear();
+}
+
+void CGpuTimer::Collect(const bool& wait)
+{
+    for (size_t i = 0; i < MQueries.size(); ++i)
+    {
+        if (!MPending[i])
+            continue;
+        GLuint available = GL_TRUE;
+        if (!wait)
+        {
+            glGetQueryObjectuiv(MQueries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            CGLCallCounter::Add();
+        }
+        if (available == GL_FALSE)
+            continue;
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(MQueries[i], GL_QUERY_RESULT, &elapsed);
+        CGLCallCounter::Add();
+        MElapsed += elapsed;
+        ++MSamples;
+        MPending[i] = false;
+    }
+}
+
+void CGpuTimer::Begin()
+{
+    if (MQueries.empty() || MRunning)
+        return;
+    Collect(false);
+    if (MPending[MNext])
+        return;
+    glBeginQuery(GL_TIME_ELAPSED, MQueries[MNext]);
+    CGLCallCounter::Add();
+    MRunning = true;
+}
+
+void CGpuTimer::End()
+{
+    if (!MRunning)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    CGLCallCounter::Add();
+    MPending[MNext] = true;
+    MNext = (MNext + 1) % MQueries.size();
+    MRunning = false;
+}
+
+int CGpuTimer::GetSamples() const
+{
+    return MSamples;
+}
+
+double CGpuTimer::GetAverage() const
+{
+    return MSamples > 0 ? MElapsed / 1.0e6 / MSamples : 0.0;
+}
+
+void CGpuTimer::Reset()
+{
+    // results of queries in flight belong to the previous measurement
+    if (MRunning)
+        End();
+    Collect(true);
+    MElapsed = 0;
+    MSamples = 0;
+}
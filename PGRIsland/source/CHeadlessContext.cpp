@@ -0,0 +1,148 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CHeadlessContext.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class creating an OpenGL context without a window
+ *
+ * Creates an offscreen context and a framebuffer the headless mode renders into
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CHeadlessContext.h"
+#include "../include/HConstants.h"
+
+#include <iostream>
+
+#ifdef HEADLESS_EGL
+bool CHeadlessContext::CreateContext(int, char*[])
+{
+    // the surfaceless platform needs no X server, the default display is the fallback
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay != nullptr)
+        MDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (MDisplay == EGL_NO_DISPLAY)
+        MDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major, minor;
+    if (MDisplay == EGL_NO_DISPLAY || !eglInitialize(MDisplay, &major, &minor))
+    {
+        std::cerr << "Headless: no EGL display" << std::endl;
+        MDisplay = EGL_NO_DISPLAY;
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cerr << "Headless: EGL " << major << "." << minor << " does not support desktop OpenGL" << std::endl;
+        Destroy();
+        return false;
+    }
+
+    // nothing is drawn to a surface, any config rendering OpenGL does
+    const EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config = EGL_NO_CONFIG_KHR;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(MDisplay, configAttributes, &config, 1, &configCount) || configCount == 0)
+        config = EGL_NO_CONFIG_KHR;
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, pgr::OGL_VER_MAJOR,
+        EGL_CONTEXT_MINOR_VERSION, pgr::OGL_VER_MINOR,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    MContext = eglCreateContext(MDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+    if (MContext == EGL_NO_CONTEXT || !eglMakeCurrent(MDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, MContext))
+    {
+        std::cerr << "Headless: no surfaceless OpenGL " << pgr::OGL_VER_MAJOR << "." << pgr::OGL_VER_MINOR
+            << " core context, EGL error 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        Destroy();
+        return false;
+    }
+    return true;
+}
+#else
+bool CHeadlessContext::CreateContext(int argc, char* argv[])
+{
+    glutInit(&argc, argv);
+    glutInitContextVersion(pgr::OGL_VER_MAJOR, pgr::OGL_VER_MINOR);
+    glutInitContextFlags(GLUT_FORWARD_COMPATIBLE);
+    glutInitDisplayMode(GLUT_RGB | GLUT_DOUBLE | GLUT_DEPTH | GLUT_STENCIL);
+    glutInitWindowSize(1, 1);
+    MWindow = glutCreateWindow(WINDOW_TITLE.c_str());
+    if (MWindow == 0)
+    {
+        std::cerr << "Headless: no GLUT window for the context" << std::endl;
+        return false;
+    }
+    glutHideWindow();
+    return true;
+}
+#endif
+
+bool CHeadlessContext::CreateFramebuffer(const int& width, const int& height)
+{
+    glGenRenderbuffers(1, &MColorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, MColorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &MDepthStencilBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, MDepthStencilBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &MFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, MFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, MColorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, MDepthStencilBuffer);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Headless: framebuffer " << width << "x" << height << " is incomplete, status 0x"
+            << std::hex << status << std::dec << std::endl;
+        return false;
+    }
+    // the framebuffer stays bound, nothing else binds one
+    return true;
+}
+
+std::string CHeadlessContext::GetRenderer() const
+{
+    const GLubyte* renderer = glGetString(GL_RENDERER);
+    return renderer != nullptr ? std::string((const char*)renderer) : std::string("unknown");
+}
+
+void CHeadlessContext::Destroy()
+{
+    if (MFramebuffer != 0)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &MFramebuffer);
+        MFramebuffer = 0;
+    }
+    if (MColorBuffer != 0)
+    {
+        glDeleteRenderbuffers(1, &MColorBuffer);
+        MColorBuffer = 0;
+    }
+    if (MDepthStencilBuffer != 0)
+    {
+        glDeleteRenderbuffers(1, &MDepthStencilBuffer);
+        MDepthStencilBuffer = 0;
+    }
+#ifdef HEADLESS_EGL
+    if (MDisplay != EGL_NO_DISPLAY)
+    {
+        eglMakeCurrent(MDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (MContext != EGL_NO_CONTEXT)
+            eglDestroyContext(MDisplay, MContext);
+        eglTerminate(MDisplay);
+    }
+    MContext = EGL_NO_CONTEXT;
+    MDisplay = EGL_NO_DISPLAY;
+#else
+    if (MWindow != 0)
+    {
+        glutDestroyWindow(MWindow);
+        MWindow = 0;
+    }
+#endif
+}
@@ -0,0 +1,137 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CInstancedSceneNode.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Scene node drawing meshes of other nodes as instances
+ *
+ * Draws nodes sharing mesh, material and program with a single instanced draw call
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CInstancedSceneNode.h"
+#include "../include/CGLCallCounter.h"
+
+CInstancedSceneNode::CInstancedSceneNode(const std::vector<CSceneNode*>& instances, const int& slot)
+    : CSceneNode(instances[0]->MShaderProgram), MInstances(instances), MSlot(slot)
+{
+    MMatrices.reserve(MInstances.size());
+
+    // the buffer is never empty, so the attributes can be read even by draws without instancing
+    glm::mat4 identity(1.0f);
+    glGenBuffers(1, &MInstanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, MInstanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4), &identity, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    MInstances[0]->MMesh.SetInstanceBuffer(MInstanceBuffer);
+    SetInstancing(true);
+}
+
+void CInstancedSceneNode::Destroy()
+{
+    if (MInstanceBuffer != 0)
+    {
+        glDeleteBuffers(1, &MInstanceBuffer);
+        MInstanceBuffer = 0;
+    }
+    CSceneNode::Destroy();
+}
+
+bool CInstancedSceneNode::IsDrawn(const CSceneNode* node)
+{
+    if (!node->MMeshVisible)
+        return false;
+    // culling stops at a rejected ancestor, so the instance's own flag may be old
+    for (; node != nullptr; node = node->MParent)
+    {
+        if (!node->IsOn || node->MCulled)
+            return false;
+    }
+    return true;
+}
+
+void CInstancedSceneNode::DrawMesh(CRenderState& state)
+{
+    MMatrices.clear();
+    for (CSceneNode* node : MInstances)
+    {
+        if (IsDrawn(node))
+            MMatrices.push_back(node->GetModelMatrix());
+    }
+    if (MMatrices.empty())
+        return;
+
+    // orphaning lets the GPU read the previous frame's matrices while the new ones are written
+    glBindBuffer(GL_ARRAY_BUFFER, MInstanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, MMatrices.size() * sizeof(glm::mat4), MMatrices.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    CGLCallCounter::Add(3);
+
+    state.UseProgram(MShaderProgram);
+    const CShaderUniforms& uniforms = MShaderProgram.GetUniforms();
+    MShaderProgram.SetBool(uniforms.MInstanced, true);
+    MInstances[0]->MMesh.DrawInstanced(MShaderProgram, state, (GLsizei)MMatrices.size());
+    // the program draws single meshes of other nodes as well
+    MShaderProgram.SetBool(uniforms.MInstanced, false);
+}
+
+void CInstancedSceneNode::SetInstancing(const bool& instancing)
+{
+    IsOn = instancing;
+    for (CSceneNode* node : MInstances)
+        node->MInstanced = instancing;
+}
+
+int CInstancedSceneNode::GetSlot() const
+{
+    return MSlot;
+}
+
+size_t CInstancedSceneNode::GetInstanceCount() const
+{
+    return MInstances.size();
+}
+
+void CInstancedSceneNode::CollectInstanceable(CSceneNode* node, const int& slot, std::vector<std::pair<CSceneNode*, int>>& nodes)
+{
+    if (node->IsInstanceable())
+        nodes.push_back({ node, slot });
+    for (const auto& child : node->MSceneNodes)
+        CollectInstanceable(child.get(), slot, nodes);
+}
+
+std::vector<std::shared_ptr<CInstancedSceneNode>> CInstancedSceneNode::CreateInstancedNodes(CSceneNode& root)
+{
+    std::vector<std::pair<CSceneNode*, int>> nodes;
+    for (int i = 0; i < (int)root.MSceneNodes.size(); ++i)
+        CollectInstanceable(root.MSceneNodes[i].get(), i, nodes);
+
+    // nodes are visited in the drawing order, so a group's first node has the lowest slot
+    std::vector<std::vector<CSceneNode*>> groups;
+    std::vector<int> slots;
+    for (const auto& node : nodes)
+    {
+        size_t group = 0;
+        for (; group < groups.size(); ++group)
+        {
+            const CSceneNode* first = groups[group][0];
+            if (first->MShaderProgram.GetProgram() == node.first->MShaderProgram.GetProgram()
+                && node.first->MMesh.IsInstanceOf(first->MMesh))
+                break;
+        }
+        if (group == groups.size())
+        {
+            groups.emplace_back();
+            slots.push_back(node.second);
+        }
+        groups[group].push_back(node.first);
+    }
+
+    std::vector<std::shared_ptr<CInstancedSceneNode>> instanced;
+    for (size_t i = 0; i < groups.size(); ++i)
+    {
+        if (groups[i].size() >= INSTANCING_MIN_NODES)
+            instanced.push_back(std::make_shared<CInstancedSceneNode>(groups[i], slots[i]));
+    }
+    return instanced;
+}
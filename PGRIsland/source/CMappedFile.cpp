@@ -0,0 +1,134 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CMappedFile.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class representing a read-only memory mapped file
+ *
+ * Maps a whole file into the address space so its content can be read without copying
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CMappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CMappedFile::~CMappedFile()
+{
+    Close();
+}
+
+#ifdef _WIN32
+bool CMappedFile::Open(const std::string& path)
+{
+    Close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    MFileHandle = file;
+    MMappingHandle = mapping;
+    MData = static_cast<const char*>(data);
+    MSize = (size_t)size.QuadPart;
+    return true;
+}
+
+void CMappedFile::Close()
+{
+    if (MData)
+        UnmapViewOfFile(MData);
+    if (MMappingHandle)
+        CloseHandle(MMappingHandle);
+    if (MFileHandle)
+        CloseHandle(MFileHandle);
+    MData = nullptr;
+    MSize = 0;
+    MMappingHandle = nullptr;
+    MFileHandle = nullptr;
+}
+#else
+bool CMappedFile::Open(const std::string& path)
+{
+    Close();
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+
+    void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (data == MAP_FAILED)
+    {
+        close(file);
+        return false;
+    }
+
+    MFileDescriptor = file;
+    MData = static_cast<const char*>(data);
+    MSize = (size_t)info.st_size;
+    return true;
+}
+
+void CMappedFile::Close()
+{
+    if (MData)
+        munmap(const_cast<char*>(MData), MSize);
+    if (MFileDescriptor >= 0)
+        close(MFileDescriptor);
+    MData = nullptr;
+    MSize = 0;
+    MFileDescriptor = -1;
+}
+#endif
+
+const char* CMappedFile::GetData() const
+{
+    return MData;
+}
+
+size_t CMappedFile::GetSize() const
+{
+    return MSize;
+}
+
+bool CMappedFile::IsOpen() const
+{
+    return MData != nullptr;
+}
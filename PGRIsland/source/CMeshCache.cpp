@@ -0,0 +1,462 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CMeshCache.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class representing a binary cache of imported object geometry
+ *
+ * Stores post-processed vertices, indices and materials of an object so that
+ * following runs can skip ASSIMP and upload the memory mapped data directly
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CMeshCache.h"
+#include "../include/HConstants.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static_assert(sizeof(CVertex) == 8 * sizeof(float), "CVertex has to be tightly packed for the mesh cache");
+
+/**
+ * Magic identifier of a cache file
+ */
+static const char MESH_CACHE_MAGIC[4] = { 'P', 'G', 'R', 'M' };
+
+std::string CMeshCache::GetCachePath(const std::string& file)
+{
+    return file + MESH_CACHE_EXTENSION;
+}
+
+/**
+ * Help function adding a stream's content to a 64-bit FNV-1a hash
+ *
+ * \param stream - stream read to its end
+ * \param   hash - hash continued by the content
+ * \param   size - size increased by the content's size
+ */
+static void HashStream(std::istream& stream, uint64_t& hash, uint64_t& size)
+{
+    char chunk[64 * 1024];
+    while (stream)
+    {
+        stream.read(chunk, sizeof(chunk));
+        std::streamsize count = stream.gcount();
+        for (std::streamsize i = 0; i < count; ++i)
+        {
+            hash ^= (unsigned char)chunk[i];
+            hash *= 1099511628211ULL;
+        }
+        size += (uint64_t)count;
+    }
+}
+
+bool CMeshCache::HashFile(const std::string& file, uint64_t& hash, uint64_t& size)
+{
+    std::ifstream stream(file, std::ios::binary);
+    if (!stream)
+        return false;
+
+    hash = 14695981039346656037ULL;
+    size = 0;
+    HashStream(stream, hash, size);
+    return true;
+}
+
+bool CMeshCache::HashSource(const std::string& file, uint64_t& hash, uint64_t& size)
+{
+    if (!HashFile(file, hash, size))
+        return false;
+
+    // colours and texture paths are cooked from the material libraries, so they are hashed too
+    std::ifstream object(file);
+    std::string directory = file.substr(0, file.find_last_of('/') + 1);
+    std::string line;
+    while (std::getline(object, line))
+    {
+        std::istringstream words(line);
+        std::string keyword, library;
+        if (!(words >> keyword) || keyword != "mtllib")
+            continue;
+        while (words >> library)
+        {
+            // a missing library gives ASSIMP's default material, its later addition changes the size
+            std::ifstream stream(directory + library, std::ios::binary);
+            if (stream)
+                HashStream(stream, hash, size);
+        }
+    }
+    return true;
+}
+
+bool CMeshCache::Load(const std::string& file, const unsigned int& importFlags)
+{
+    MPath = GetCachePath(file);
+    MBuffer.clear();
+    MData = nullptr;
+    MSize = 0;
+
+    uint64_t hash, size;
+    if (!HashSource(file, hash, size) || !MFile.Open(MPath))
+        return false;
+
+    CHeader header;
+    if (MFile.GetSize() < sizeof(CHeader))
+    {
+        MFile.Close();
+        return false;
+    }
+    std::memcpy(&header, MFile.GetData(), sizeof(CHeader));
+    if (std::memcmp(header.MMagic, MESH_CACHE_MAGIC, sizeof(header.MMagic)) != 0 ||
+        header.MVersion != VERSION ||
+        header.MImportFlags != importFlags ||
+        header.MVertexSize != sizeof(CVertex) ||
+        header.MCookFlags != GetCookFlags() ||
+        header.MSourceHash != hash ||
+        header.MSourceSize != size ||
+        header.MPayloadSize != MFile.GetSize() - sizeof(CHeader))
+    {
+        std::cout << "Mesh cache is stale: " << MPath << std::endl;
+        MFile.Close();
+        return false;
+    }
+
+    MData = MFile.GetData();
+    MSize = MFile.GetSize();
+    Rewind();
+    if (!ValidateNode() || MOffset != MSize)
+    {
+        std::cout << "Mesh cache is corrupted: " << MPath << std::endl;
+        MFile.Close();
+        MData = nullptr;
+        MSize = 0;
+        return false;
+    }
+    Rewind();
+    return true;
+}
+
+bool CMeshCache::Import(const std::string& file, const unsigned int& importFlags)
+{
+    MPath = GetCachePath(file);
+    MFile.Close();
+
+    Assimp::Importer importer;
+    importer.SetPropertyInteger(AI_CONFIG_PP_PTV_NORMALIZE, 1);
+    const aiScene* scene = importer.ReadFile(file, importFlags);
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    {
+        std::cerr << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+        return false;
+    }
+
+    CHeader header;
+    std::memcpy(header.MMagic, MESH_CACHE_MAGIC, sizeof(header.MMagic));
+    header.MVersion = VERSION;
+    header.MImportFlags = importFlags;
+    header.MVertexSize = sizeof(CVertex);
+    header.MCookFlags = GetCookFlags();
+    header.MReserved = 0;
+    header.MPayloadSize = 0;
+    if (!HashSource(file, header.MSourceHash, header.MSourceSize))
+        return false;
+
+    MBuffer.clear();
+    MStatisticsBefore = CMeshStatistics();
+    MStatisticsAfter = CMeshStatistics();
+    Write(&header, sizeof(CHeader));
+    CookNode(scene->mRootNode, scene);
+    if (MESH_OPTIMIZE_ENABLED)
+    {
+        std::cout << "Optimized " << file << ": ACMR " << MStatisticsBefore.GetACMR() << " -> " << MStatisticsAfter.GetACMR()
+            << ", ATVR " << MStatisticsBefore.GetATVR() << " -> " << MStatisticsAfter.GetATVR() << std::endl;
+    }
+
+    // patch the payload size now that the content is complete
+    header.MPayloadSize = MBuffer.size() - sizeof(CHeader);
+    std::memcpy(MBuffer.data(), &header, sizeof(CHeader));
+
+    MData = MBuffer.data();
+    MSize = MBuffer.size();
+    Rewind();
+    return true;
+}
+
+uint32_t CMeshCache::GetCookFlags()
+{
+    return MESH_OPTIMIZE_ENABLED ? 1u : 0u;
+}
+
+const CMeshStatistics& CMeshCache::GetStatisticsBefore() const
+{
+    return MStatisticsBefore;
+}
+
+const CMeshStatistics& CMeshCache::GetStatisticsAfter() const
+{
+    return MStatisticsAfter;
+}
+
+bool CMeshCache::LoadOrImport(const std::string& file, const unsigned int& importFlags)
+{
+    // map the cooked geometry if it is up to date, otherwise import and cook it again
+    if (MESH_CACHE_ENABLED && Load(file, importFlags))
+        return true;
+    if (!Import(file, importFlags))
+        return false;
+    if (MESH_CACHE_ENABLED)
+        Save();
+    return true;
+}
+
+bool CMeshCache::Save() const
+{
+    if (MBuffer.empty())
+        return false;
+
+    // write to a temporary file first so a crash never leaves a truncated cache behind
+    std::string temporaryPath = MPath + ".tmp";
+    {
+        std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!stream)
+        {
+            std::cout << "Mesh cache could not be written: " << MPath << std::endl;
+            return false;
+        }
+        stream.write(MBuffer.data(), (std::streamsize)MBuffer.size());
+        if (!stream)
+        {
+            std::cout << "Mesh cache could not be written: " << MPath << std::endl;
+            return false;
+        }
+    }
+    std::remove(MPath.c_str());
+    if (std::rename(temporaryPath.c_str(), MPath.c_str()) != 0)
+    {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CMeshCache::IsMapped() const
+{
+    return MFile.IsOpen();
+}
+
+size_t CMeshCache::GetSize() const
+{
+    return MSize;
+}
+
+void CMeshCache::Rewind()
+{
+    MOffset = sizeof(CHeader);
+}
+
+bool CMeshCache::ReadNode(unsigned int& meshCount, unsigned int& childCount)
+{
+    uint32_t counts[2];
+    if (!Read(counts, sizeof(counts)))
+        return false;
+    meshCount = counts[0];
+    childCount = counts[1];
+    return true;
+}
+
+bool CMeshCache::ReadMesh(CCachedMesh& mesh)
+{
+    uint32_t counts[2];
+    float material[10];
+    uint32_t textureCount;
+    if (!Read(counts, sizeof(counts)) || !Read(material, sizeof(material)) || !Read(&textureCount, sizeof(textureCount)))
+        return false;
+
+    mesh.MMaterial.MKa = glm::vec3(material[0], material[1], material[2]);
+    mesh.MMaterial.MKd = glm::vec3(material[3], material[4], material[5]);
+    mesh.MMaterial.MKs = glm::vec3(material[6], material[7], material[8]);
+    mesh.MMaterial.MNs = material[9];
+
+    mesh.MTexturePaths.clear();
+    for (uint32_t i = 0; i < textureCount; ++i)
+    {
+        std::string path;
+        if (!ReadString(path))
+            return false;
+        mesh.MTexturePaths.push_back(path);
+    }
+
+    // vertices and indices are not copied, they point into the content
+    size_t verticesSize = (size_t)counts[0] * sizeof(CVertex);
+    size_t indicesSize = (size_t)counts[1] * sizeof(unsigned int);
+    if (MSize - MOffset < verticesSize + indicesSize)
+        return false;
+    mesh.MVertexCount = counts[0];
+    mesh.MVertices = reinterpret_cast<const CVertex*>(MData + MOffset);
+    MOffset += verticesSize;
+    mesh.MIndexCount = counts[1];
+    mesh.MIndices = reinterpret_cast<const unsigned int*>(MData + MOffset);
+    MOffset += indicesSize;
+    return true;
+}
+
+bool CMeshCache::ValidateNode()
+{
+    unsigned int meshCount, childCount;
+    if (!ReadNode(meshCount, childCount))
+        return false;
+    CCachedMesh mesh;
+    for (unsigned int i = 0; i < meshCount; ++i)
+    {
+        if (!ReadMesh(mesh))
+            return false;
+        for (unsigned int j = 0; j < mesh.MIndexCount; ++j)
+        {
+            if (mesh.MIndices[j] >= mesh.MVertexCount)
+                return false;
+        }
+    }
+    for (unsigned int i = 0; i < childCount; ++i)
+    {
+        if (!ValidateNode())
+            return false;
+    }
+    return true;
+}
+
+void CMeshCache::CookNode(const aiNode* node, const aiScene* scene)
+{
+    uint32_t counts[2] = { node->mNumMeshes, node->mNumChildren };
+    Write(counts, sizeof(counts));
+    for (unsigned int i = 0; i < node->mNumMeshes; i++)
+        CookMesh(scene->mMeshes[node->mMeshes[i]], scene);
+    for (unsigned int i = 0; i < node->mNumChildren; i++)
+        CookNode(node->mChildren[i], scene);
+}
+
+void CMeshCache::CookMesh(const aiMesh* mesh, const aiScene* scene)
+{
+    std::vector<CVertex> vertices;
+    std::vector<unsigned int> indices;
+
+    for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+    {
+        CVertex vertex;
+        // positions
+        vertex.MPosition = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+        // normals
+        if (mesh->HasNormals())
+            vertex.MNormal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+        else
+            vertex.MNormal = glm::vec3(0.0f);
+        // texture coordinates
+        if (mesh->mTextureCoords[0])
+            vertex.MTextureCoordinates = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+        else
+            vertex.MTextureCoordinates = glm::vec2(0.0f, 0.0f);
+        vertices.push_back(vertex);
+    }
+    // go through all faces of the mesh
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+    {
+        const aiFace& face = mesh->mFaces[i];
+        // lines and points of a model are not drawn as triangles, they would break the triangle list
+        if (face.mNumIndices != 3)
+            continue;
+        // retrieve indicies of the face
+        for (unsigned int j = 0; j < face.mNumIndices; j++)
+            indices.push_back(face.mIndices[j]);
+    }
+
+    // reorder for the vertex cache, overdraw and vertex fetch once, so every load profits
+    if (MESH_OPTIMIZE_ENABLED)
+    {
+        CMeshStatistics before, after;
+        CMeshOptimizer::Optimize(vertices, indices, before, after);
+        MStatisticsBefore.Add(before);
+        MStatisticsAfter.Add(after);
+    }
+
+    // get material
+    aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+
+    CMaterial mat;
+    aiColor4D ambient(mat.MKa.x, mat.MKa.y, mat.MKa.z, 1.0f);
+    aiColor4D diffuse(mat.MKd.x, mat.MKd.y, mat.MKd.z, 1.0f);
+    aiColor4D specular(mat.MKs.x, mat.MKs.y, mat.MKs.z, 1.0f);
+    float shininess = mat.MNs;
+
+    aiGetMaterialColor(material, AI_MATKEY_COLOR_AMBIENT, &ambient);
+    aiGetMaterialColor(material, AI_MATKEY_COLOR_DIFFUSE, &diffuse);
+    aiGetMaterialColor(material, AI_MATKEY_COLOR_SPECULAR, &specular);
+    aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &shininess);
+
+    float materialValues[10] = {
+        ambient.r, ambient.g, ambient.b,
+        diffuse.r, diffuse.g, diffuse.b,
+        specular.r, specular.g, specular.b,
+        shininess
+    };
+
+    // get diffuse textures
+    std::vector<std::string> texturePaths;
+    for (unsigned int i = 0; i < material->GetTextureCount(aiTextureType_DIFFUSE); i++)
+    {
+        aiString str;
+        material->GetTexture(aiTextureType_DIFFUSE, i, &str);
+        texturePaths.push_back(str.C_Str());
+    }
+
+    uint32_t counts[2] = { (uint32_t)vertices.size(), (uint32_t)indices.size() };
+    uint32_t textureCount = (uint32_t)texturePaths.size();
+    Write(counts, sizeof(counts));
+    Write(materialValues, sizeof(materialValues));
+    Write(&textureCount, sizeof(textureCount));
+    for (const auto& path : texturePaths)
+        WriteString(path);
+    Write(vertices.data(), vertices.size() * sizeof(CVertex));
+    Write(indices.data(), indices.size() * sizeof(unsigned int));
+}
+
+void CMeshCache::Write(const void* data, const size_t& size)
+{
+    if (!size)
+        return;
+    const char* bytes = static_cast<const char*>(data);
+    MBuffer.insert(MBuffer.end(), bytes, bytes + size);
+}
+
+void CMeshCache::WriteString(const std::string& value)
+{
+    uint32_t length = (uint32_t)value.size();
+    Write(&length, sizeof(length));
+    Write(value.data(), value.size());
+    // keep the following vertex data aligned
+    static const char padding[4] = { 0, 0, 0, 0 };
+    Write(padding, (4 - value.size() % 4) % 4);
+}
+
+bool CMeshCache::Read(void* data, const size_t& size)
+{
+    if (!MData || MSize - MOffset < size)
+        return false;
+    std::memcpy(data, MData + MOffset, size);
+    MOffset += size;
+    return true;
+}
+
+bool CMeshCache::ReadString(std::string& value)
+{
+    uint32_t length;
+    if (!Read(&length, sizeof(length)))
+        return false;
+    size_t paddedLength = length + (4 - length % 4) % 4;
+    if (MSize - MOffset < paddedLength)
+        return false;
+    value.assign(MData + MOffset, length);
+    MOffset += paddedLength;
+    return true;
+}
@@ -10,36 +10,131 @@
 */
 //----------------------------------------------------------------------------------------
 #include "../include/CMeshGeometry.h"
+#include "../include/CVertexQuantizer.h"
+#include "../include/CGLCallCounter.h"
+#include "../include/CGameState.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
+/**
+ * Help function hashing bytes with 64-bit FNV-1a
+ *
+ * eight bytes are mixed at once, the hash only has to tell meshes apart
+ *
+ * \param data - hashed bytes
+ * \param size - number of bytes
+ * \param hash - hash of the previous bytes
+ *
+ * \return hash including the bytes
+ */
+static uint64_t HashBytes(const void* data, const size_t& size, uint64_t hash)
+{
+    const uint64_t prime = 1099511628211ull;
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(uint64_t));
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < size; ++i)
+        hash = (hash ^ bytes[i]) * prime;
+    return hash;
+}
+
 CMeshGeometry::CMeshGeometry(const std::vector<CVertex>& vertices,
                 const std::vector<unsigned int>& indices, 
                 const std::vector<CTexture>& textures,
-                const CMaterial& material)
+                const CMaterial& material,
+                const EVertexFormat& format,
+                const EMeshRetention& retention)
 {
-	MVertices = vertices;
-	MIndices = indices;
 	MTextures = textures;
     MMaterial = material;
+    MVertexFormat = format;
+    MRetention = retention;
+
+	SetupMeshGeometry(vertices.data(), vertices.size(), indices.data(), indices.size());
+}
+
+CMeshGeometry::CMeshGeometry(const CVertex* vertices,
+                const size_t& vertexCount,
+                const unsigned int* indices,
+                const size_t& indexCount,
+                const std::vector<CTexture>& textures,
+                const CMaterial& material,
+                const EVertexFormat& format,
+                const EMeshRetention& retention,
+                const glm::vec3& quantizationMinimum,
+                const glm::vec3& quantizationMaximum)
+{
+    MTextures = textures;
+    MMaterial = material;
+    MVertexFormat = format;
+    MRetention = retention;
+    MQuantizationMinimum = quantizationMinimum;
+    MQuantizationMaximum = quantizationMaximum;
 
-	SetupMeshGeometry();
+    SetupMeshGeometry(vertices, vertexCount, indices, indexCount);
 }
 
 void CMeshGeometry::Destroy()
 {
-    glDeleteVertexArrays(1, &MVertexArrayObject);
-    glDeleteBuffers(1, &MVertexBufferObject);
-    glDeleteBuffers(1, &MElementBufferObject);
-    MVertices.clear();
-    MIndices.clear();
+    if (MOwnsVertexArray)
+        glDeleteVertexArrays(1, &MVertexArrayObject);
+    // a shared copy leaves the buffers to the mesh it was made from,
+    // the page's buffers stay for other meshes, only the mesh's ranges are given back
+    if (MOwnsBuffers && MAllocation.MPage >= 0)
+        gameState.MGeometryArena.Free(MAllocation);
+    else if (MOwnsBuffers)
+    {
+        glDeleteBuffers(1, &MVertexBufferObject);
+        glDeleteBuffers(1, &MElementBufferObject);
+    }
+    MVertexArrayObject = 0;
+    MVertexBufferObject = 0;
+    MElementBufferObject = 0;
+    MOwnsVertexArray = true;
+    MOwnsBuffers = true;
+    // clear does not give the memory back
+    std::vector<CVertex>().swap(MVertices);
+    std::vector<glm::vec3>().swap(MPositions);
+    std::vector<unsigned int>().swap(MIndices);
+    MVertexCount = 0;
+    MIndexCount = 0;
+    MUploadedSize = 0;
+    MPackedSavedSize = 0;
+    MQuantizationError = CQuantizationError();
+    MBoundsMinimum = glm::vec3(FLT_MAX);
+    MBoundsMaximum = glm::vec3(-FLT_MAX);
+    MQuantizationMinimum = glm::vec3(FLT_MAX);
+    MQuantizationMaximum = glm::vec3(-FLT_MAX);
+    MProceduralVertices = 0;
+    MProceduralInstances = 0;
+    MContentHash = 0;
+    MSegments.clear();
     for ( auto& texture: MTextures ) 
         texture.Destroy();
     MTextures.clear();
 }
 
-void CMeshGeometry::GeneratePlaneMesh(const int& vertexCount, const float& size)
+void CMeshGeometry::GeneratePlaneMesh(const int& vertexCount, const float& size, const EMeshRetention& retention)
 {
+    MRetention = retention;
+
     std::vector<CVertex> verticies;
+    std::vector<unsigned int> indicies;
+    BuildPlaneMesh(vertexCount, size, verticies, indicies);
+    SetupMeshGeometry(verticies.data(), verticies.size(), indicies.data(), indicies.size());
+}
+
+void CMeshGeometry::BuildPlaneMesh(const int& vertexCount, const float& size,
+    std::vector<CVertex>& verticies, std::vector<unsigned int>& indicies)
+{
+    verticies.clear();
+    verticies.reserve((size_t)vertexCount * vertexCount);
     for (int i = 0; i < vertexCount; ++i)
     {
         for (int j = 0; j < vertexCount; ++j)
@@ -50,7 +145,8 @@ void CMeshGeometry::GeneratePlaneMesh(const int& vertexCount, const float& size)
         }
     }
 
-    std::vector<unsigned int> indicies;
+    indicies.clear();
+    indicies.reserve((size_t)(vertexCount - 1) * (vertexCount - 1) * 6);
     for (int i = 0; i < vertexCount - 1; ++i)
     {
         for (int j = 0; j < vertexCount - 1; ++j)
@@ -67,41 +163,138 @@ void CMeshGeometry::GeneratePlaneMesh(const int& vertexCount, const float& size)
             indicies.push_back(bottomRight);
         }
     }
-    MVertices = verticies;
-    MIndices = indicies;
-    SetupMeshGeometry();
 }
 
-void CMeshGeometry::SetupMeshGeometry()
+void CMeshGeometry::GenerateProceduralPlane(const int& vertexCount)
+{
+    GenerateProceduralMesh(GL_TRIANGLE_STRIP, 2 * vertexCount, vertexCount - 1);
+    MVertexCount = (size_t)vertexCount * vertexCount;
+}
+
+void CMeshGeometry::GenerateProceduralMesh(const GLenum& mode, const GLsizei& vertexCount, const GLsizei& instanceCount)
 {
+    MProceduralMode = mode;
+    MProceduralVertices = vertexCount;
+    MProceduralInstances = instanceCount;
+    MVertexCount = (size_t)vertexCount * instanceCount;
+    MIndexCount = 0;
+    MUploadedSize = 0;
+    MContentHash = 0;
+    MSegments.clear();
+
+    // the core profile draws only with a bound VAO, even without attributes
     glGenVertexArrays(1, &MVertexArrayObject);
-    glGenBuffers(1, &MVertexBufferObject);
-    glGenBuffers(1, &MElementBufferObject);
+}
+
+void CMeshGeometry::SetupMeshGeometry(const CVertex* vertices, const size_t& vertexCount, const unsigned int* indices, const size_t& indexCount)
+{
+    MVertexCount = vertexCount;
+    MIndexCount = (GLsizei)indexCount;
 
-    glBindVertexArray(MVertexArrayObject);
-    glBindBuffer(GL_ARRAY_BUFFER, MVertexBufferObject);
+    // the positions are gone after the upload unless retained, culling needs only their box
+    MBoundsMinimum = glm::vec3(FLT_MAX);
+    MBoundsMaximum = glm::vec3(-FLT_MAX);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        MBoundsMinimum = glm::min(MBoundsMinimum, vertices[i].MPosition);
+        MBoundsMaximum = glm::max(MBoundsMaximum, vertices[i].MPosition);
+    }
+
+    // only small meshes are drawn often enough to be instanced, big ones are not worth hashing
+    MContentHash = 0;
+    if (vertexCount > 0 && vertexCount <= INSTANCING_MAX_VERTICES)
+    {
+        MContentHash = HashBytes(vertices, vertexCount * sizeof(CVertex), 14695981039346656037ull);
+        MContentHash = HashBytes(indices, indexCount * sizeof(unsigned int), MContentHash);
+    }
 
-    glBufferData(GL_ARRAY_BUFFER, MVertices.size() * sizeof(CVertex), &MVertices[0], GL_STATIC_DRAW);
+    std::vector<unsigned char> packed;
+    MQuantizationError = CQuantizationError();
+    if (MVertexFormat != VERTEX_FORMAT_FLOAT)
+    {
+        CQuantizationError& error = MQuantizationError;
+        // a shared box makes the dequantization equal to the other meshes' of the model
+        glm::vec3 minimum = glm::min(MQuantizationMinimum, MBoundsMinimum);
+        glm::vec3 maximum = glm::max(MQuantizationMaximum, MBoundsMaximum);
+        if (!CVertexQuantizer::Pack(MVertexFormat, vertices, vertexCount, minimum, maximum, packed, MDequantization, error))
+        {
+            std::cout << "WARNING::MESH_GEOMETRY::packed vertices exceed the tolerances, uploading floats: max error position "
+                << error.MPosition << ", normal " << error.MNormal << " deg, texture coordinates " << error.MTextureCoordinates << std::endl;
+            packed.clear();
+            MVertexFormat = VERTEX_FORMAT_FLOAT;
+            MDequantization = glm::mat4(1.0f);
+        }
+    }
+    size_t vertexSize = CVertexQuantizer::GetVertexSize(MVertexFormat);
+    MPackedSavedSize = vertexCount * (sizeof(CVertex) - vertexSize);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, MElementBufferObject);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, MIndices.size() * sizeof(unsigned int),
-        &MIndices[0], GL_STATIC_DRAW);
+    const void* vertexData = packed.empty() ? (const void*)vertices : (const void*)packed.data();
 
-    // vertex positions
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CVertex), (void*)0);
-    // vertex normals
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(CVertex), (void*)offsetof(CVertex, MNormal));
-    // vertex texture coords
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(CVertex), (void*)offsetof(CVertex, MTextureCoordinates));
+    // 16-bit indices halve the EBO whenever the mesh can be drawn with them
+    std::vector<unsigned short> shortIndices;
+    MIndexType = SplitIndices(indices, indexCount, shortIndices, MSegments);
+    size_t indexSize = MIndexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    const void* indexData = MIndexType == GL_UNSIGNED_SHORT ? (const void*)shortIndices.data() : (const void*)indices;
 
-    glBindVertexArray(0);
+    // ranges of whole words keep the next mesh's indices aligned for both index types
+    size_t reservedIndexSize = (indexCount * indexSize + 3) & ~(size_t)3;
+    MOwnsVertexArray = true;
+    if (GEOMETRY_ARENA_ENABLED && vertexCount > 0 && indexCount > 0
+        && gameState.MGeometryArena.Allocate(MVertexFormat, vertexCount, reservedIndexSize, MAllocation,
+            MVertexArrayObject, MVertexBufferObject, MElementBufferObject))
+    {
+        // the copy target writes into a buffer without touching any VAO
+        MOwnsVertexArray = false;
+        glBindBuffer(GL_COPY_WRITE_BUFFER, MVertexBufferObject);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, MAllocation.MFirstVertex * vertexSize, vertexCount * vertexSize, vertexData);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, MElementBufferObject);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, MAllocation.MIndexOffset, indexCount * indexSize, indexData);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        for (auto& segment : MSegments)
+        {
+            segment.MFirstIndex += MAllocation.MIndexOffset / indexSize;
+            segment.MBaseVertex += (GLint)MAllocation.MFirstVertex;
+        }
+    }
+    else
+    {
+        if (GEOMETRY_ARENA_ENABLED)
+            gameState.MGeometryArena.AddSeparateMesh();
+        glGenVertexArrays(1, &MVertexArrayObject);
+        glGenBuffers(1, &MVertexBufferObject);
+        glGenBuffers(1, &MElementBufferObject);
+
+        glBindVertexArray(MVertexArrayObject);
+        glBindBuffer(GL_ARRAY_BUFFER, MVertexBufferObject);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * vertexSize, vertexData, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, MElementBufferObject);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * indexSize, indexData, GL_STATIC_DRAW);
+        CGeometryArena::SetupVertexAttributes(MVertexFormat);
+        glBindVertexArray(0);
+    }
+
+    MUploadedSize = vertexCount * vertexSize + indexCount * indexSize;
+
+    // OpenGL's buffers hold the mesh now, only what picking or collision needs stays on the CPU
+    std::vector<CVertex>().swap(MVertices);
+    std::vector<glm::vec3>().swap(MPositions);
+    std::vector<unsigned int>().swap(MIndices);
+    if (MRetention == MESH_RETENTION_FULL)
+        MVertices.assign(vertices, vertices + vertexCount);
+    else if (MRetention == MESH_RETENTION_POSITIONS)
+    {
+        MPositions.resize(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i)
+            MPositions[i] = vertices[i].MPosition;
+    }
+    if (MRetention != MESH_RETENTION_DISCARD)
+        MIndices.assign(indices, indices + indexCount);
 }
 
-void CMeshGeometry::Draw(CShaderProgram& shader)
+void CMeshGeometry::SetupDraw(CShaderProgram& shader, CRenderState& state)
 {
+    // locations were resolved when the program was linked
+    const CShaderUniforms& uniforms = shader.GetUniforms();
     bool noTexture = false;
     for (unsigned int i = 0; i < MTextures.size(); i++)
     { 
@@ -109,27 +302,294 @@ void CMeshGeometry::Draw(CShaderProgram& shader)
             noTexture = true;
             break;
         }
-        glActiveTexture(GL_TEXTURE0 + i);
-        std::string type = "texture_diffuse"+std::to_string(i);
-        shader.SetInt(type, i);
-        glBindTexture(MTextures[i].MType, MTextures[i].MID);
+        if ((int)i < SHADER_TEXTURE_UNITS)
+            shader.SetInt(uniforms.MTextures[i], i);
+        state.BindTexture(i, MTextures[i].MType, MTextures[i].MID);
     }
     if (noTexture || !MTextures.size()) {
-        shader.SetBool("textureUse", false);
+        shader.SetBool(uniforms.MTextureUse, false);
     }
     else
-        shader.SetBool("textureUse", true);
-    shader.SetVec3("material.ambient", MMaterial.MKa);
-    shader.SetVec3("material.diffuse", MMaterial.MKd);
-    shader.SetVec3("material.specular", MMaterial.MKs);
-    shader.SetFloat("material.shininess", MMaterial.MNs);
-    // draw mesh
-    glBindVertexArray(MVertexArrayObject);
-    glDrawElements(GL_TRIANGLES, MIndices.size(), GL_UNSIGNED_INT, 0);
+        shader.SetBool(uniforms.MTextureUse, true);
+    shader.SetVec3(uniforms.MMaterialAmbient, MMaterial.MKa);
+    shader.SetVec3(uniforms.MMaterialDiffuse, MMaterial.MKd);
+    shader.SetVec3(uniforms.MMaterialSpecular, MMaterial.MKs);
+    shader.SetFloat(uniforms.MMaterialShininess, MMaterial.MNs);
+    shader.SetMat4(uniforms.MDequantization, MDequantization);
+    shader.SetBool(uniforms.MOctahedralNormal, MVertexFormat != VERTEX_FORMAT_FLOAT);
+}
+
+void CMeshGeometry::Draw(CShaderProgram& shader, CRenderState& state)
+{
+    SetupDraw(shader, state);
+    // draw mesh, the VAO stays bound for the next mesh using it
+    state.BindVertexArray(MVertexArrayObject);
+    if (MProceduralVertices > 0 && MProceduralInstances > 0)
+    {
+        glDrawArraysInstanced(MProceduralMode, 0, MProceduralVertices, MProceduralInstances);
+        CGLCallCounter::AddDraw();
+    }
+    size_t indexSize = MIndexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    for (const auto& segment : MSegments)
+    {
+        void* offset = (void*)(segment.MFirstIndex * indexSize);
+        if (segment.MBaseVertex == 0)
+            glDrawElements(GL_TRIANGLES, segment.MIndexCount, MIndexType, offset);
+        else
+            glDrawElementsBaseVertex(GL_TRIANGLES, segment.MIndexCount, MIndexType, offset, segment.MBaseVertex);
+    }
+    CGLCallCounter::AddDraw(MSegments.size());
+}
+
+void CMeshGeometry::DrawRanges(CShaderProgram& shader, CRenderState& state, const std::vector<GLint>& firsts, const std::vector<GLsizei>& counts)
+{
+    if (MProceduralVertices == 0 || firsts.empty())
+        return;
+    SetupDraw(shader, state);
+    state.BindVertexArray(MVertexArrayObject);
+    glMultiDrawArrays(MProceduralMode, firsts.data(), counts.data(), (GLsizei)firsts.size());
+    CGLCallCounter::AddDraw();
+}
+
+void CMeshGeometry::DrawInstanced(CShaderProgram& shader, CRenderState& state, const GLsizei& count)
+{
+    if (count <= 0)
+        return;
+    SetupDraw(shader, state);
+    state.BindVertexArray(MVertexArrayObject);
+    size_t indexSize = MIndexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    for (const auto& segment : MSegments)
+    {
+        void* offset = (void*)(segment.MFirstIndex * indexSize);
+        if (segment.MBaseVertex == 0)
+            glDrawElementsInstanced(GL_TRIANGLES, segment.MIndexCount, MIndexType, offset, count);
+        else
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, segment.MIndexCount, MIndexType, offset, count, segment.MBaseVertex);
+    }
+    CGLCallCounter::AddDraw(MSegments.size());
+}
+
+void CMeshGeometry::SetInstanceBuffer(const GLuint& buffer)
+{
+    if (!MOwnsVertexArray)
+    {
+        // the page's VAO is shared by other meshes, the instances need a VAO of their own
+        glGenVertexArrays(1, &MVertexArrayObject);
+        MOwnsVertexArray = true;
+        glBindVertexArray(MVertexArrayObject);
+        glBindBuffer(GL_ARRAY_BUFFER, MVertexBufferObject);
+        CGeometryArena::SetupVertexAttributes(MVertexFormat);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, MElementBufferObject);
+    }
+    else
+        glBindVertexArray(MVertexArrayObject);
+    // a mat4 attribute takes four locations, one column each
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (GLuint i = 0; i < 4; ++i)
+    {
+        glEnableVertexAttribArray(INSTANCE_MATRIX_LOCATION + i);
+        glVertexAttribPointer(INSTANCE_MATRIX_LOCATION + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i * sizeof(glm::vec4)));
+        glVertexAttribDivisor(INSTANCE_MATRIX_LOCATION + i, 1);
+    }
     glBindVertexArray(0);
 }
 
+bool CMeshGeometry::IsBatchableWith(const CMeshGeometry& mesh) const
+{
+    // meshes with their own VAO never share it
+    return !MOwnsVertexArray && MVertexArrayObject == mesh.MVertexArrayObject && MIndexType == mesh.MIndexType
+        && MDequantization == mesh.MDequantization && HasSameMaterial(mesh);
+}
+
+void CMeshGeometry::AppendDrawCommands(std::vector<CDrawElementsIndirectCommand>& commands) const
+{
+    for (const auto& segment : MSegments)
+        commands.push_back({ (GLuint)segment.MIndexCount, 1, (GLuint)segment.MFirstIndex, segment.MBaseVertex, 0 });
+}
+
+void CMeshGeometry::DrawCommands(CShaderProgram& shader, CRenderState& state, const std::vector<CDrawElementsIndirectCommand>& commands,
+    const size_t& first, const size_t& count, const bool& indirect)
+{
+    SetupDraw(shader, state);
+    state.BindVertexArray(MVertexArrayObject);
+    gameState.MGeometryArena.MultiDraw(MIndexType, commands, first, count, indirect);
+}
+
+bool CMeshGeometry::IsInstanceOf(const CMeshGeometry& mesh) const
+{
+    return MContentHash != 0 && MContentHash == mesh.MContentHash && MVertexCount == mesh.MVertexCount
+        && MIndexCount == mesh.MIndexCount && MVertexFormat == mesh.MVertexFormat && HasSameMaterial(mesh);
+}
+
+CMeshGeometry CMeshGeometry::Share() const
+{
+    CMeshGeometry mesh = *this;
+    // a VAO of the mesh's own is bound by the copy like a page's one, an instance buffer gets the copy a new one
+    mesh.MOwnsVertexArray = false;
+    mesh.MOwnsBuffers = false;
+    mesh.MUploadedSize = 0;
+    mesh.MPackedSavedSize = 0;
+    mesh.MTextures.clear();
+    return mesh;
+}
+
+bool CMeshGeometry::HasSameMaterial(const CMeshGeometry& mesh) const
+{
+    if (MTextures.size() != mesh.MTextures.size())
+        return false;
+    for (size_t i = 0; i < MTextures.size(); ++i)
+    {
+        if (MTextures[i].MInitialized != mesh.MTextures[i].MInitialized)
+            return false;
+        if (MTextures[i].MInitialized && (MTextures[i].MID != mesh.MTextures[i].MID || MTextures[i].MType != mesh.MTextures[i].MType))
+            return false;
+    }
+    return MMaterial.MKa == mesh.MMaterial.MKa && MMaterial.MKd == mesh.MMaterial.MKd
+        && MMaterial.MKs == mesh.MMaterial.MKs && MMaterial.MNs == mesh.MMaterial.MNs;
+}
+
 void CMeshGeometry::PushTexture(const CTexture& texture)
 {
     MTextures.push_back(texture);
 }
+
+const glm::vec3& CMeshGeometry::GetBoundsMinimum() const
+{
+    return MBoundsMinimum;
+}
+
+const glm::vec3& CMeshGeometry::GetBoundsMaximum() const
+{
+    return MBoundsMaximum;
+}
+
+GLenum CMeshGeometry::GetIndexType() const
+{
+    return MIndexType;
+}
+
+size_t CMeshGeometry::GetSegmentCount() const
+{
+    return MSegments.size();
+}
+
+GLuint CMeshGeometry::GetVertexArray() const
+{
+    return MVertexArrayObject;
+}
+
+GLuint CMeshGeometry::GetFirstTexture() const
+{
+    // SetupDraw binds nothing if a texture is missing
+    if (MTextures.empty() || !MTextures[0].MInitialized)
+        return 0;
+    return MTextures[0].MID;
+}
+
+GLenum CMeshGeometry::SplitIndices(const unsigned int* indices, const size_t& indexCount,
+    std::vector<unsigned short>& shortIndices, std::vector<CIndexSegment>& segments)
+{
+    const unsigned int range = 65536;
+    shortIndices.clear();
+    segments.clear();
+
+    // triangles are taken in order while the vertices they reference fit into one 16-bit range,
+    // vertices ordered for vertex fetch keep these ranges compact
+    size_t start = 0;
+    unsigned int low = 0, high = 0;
+    bool fits = true;
+    for (size_t i = 0; fits && i + 2 < indexCount; i += 3)
+    {
+        unsigned int triangleLow = std::min(indices[i], std::min(indices[i + 1], indices[i + 2]));
+        unsigned int triangleHigh = std::max(indices[i], std::max(indices[i + 1], indices[i + 2]));
+        if (triangleHigh - triangleLow >= range)
+            fits = false;
+        else if (i == start)
+        {
+            low = triangleLow;
+            high = triangleHigh;
+        }
+        else if (std::max(high, triangleHigh) - std::min(low, triangleLow) >= range)
+        {
+            segments.push_back({ start, (GLsizei)(i - start), (GLint)low });
+            start = i;
+            low = triangleLow;
+            high = triangleHigh;
+        }
+        else
+        {
+            low = std::min(low, triangleLow);
+            high = std::max(high, triangleHigh);
+        }
+    }
+    if (fits && start < indexCount)
+        segments.push_back({ start, (GLsizei)(indexCount - start), (GLint)low });
+
+    // every additional draw call has to pay off
+    size_t triangleCount = indexCount / 3;
+    if (!fits || segments.empty() || (segments.size() > 1 && triangleCount / segments.size() < INDEX_SEGMENT_MIN_TRIANGLES))
+    {
+        segments.assign(1, { 0, (GLsizei)indexCount, 0 });
+        return GL_UNSIGNED_INT;
+    }
+
+    shortIndices.resize(indexCount);
+    for (auto& segment : segments)
+    {
+        // segments within the first range do not need a base vertex
+        unsigned int segmentHigh = 0;
+        for (size_t i = segment.MFirstIndex; i < segment.MFirstIndex + segment.MIndexCount; ++i)
+            segmentHigh = std::max(segmentHigh, indices[i]);
+        if (segmentHigh < range)
+            segment.MBaseVertex = 0;
+        for (size_t i = segment.MFirstIndex; i < segment.MFirstIndex + segment.MIndexCount; ++i)
+            shortIndices[i] = (unsigned short)(indices[i] - segment.MBaseVertex);
+    }
+    return GL_UNSIGNED_SHORT;
+}
+
+const std::vector<CVertex>& CMeshGeometry::GetVertices() const
+{
+    return MVertices;
+}
+
+const std::vector<glm::vec3>& CMeshGeometry::GetPositions() const
+{
+    return MPositions;
+}
+
+const std::vector<unsigned int>& CMeshGeometry::GetIndices() const
+{
+    return MIndices;
+}
+
+size_t CMeshGeometry::GetVertexCount() const
+{
+    return MVertexCount;
+}
+
+size_t CMeshGeometry::GetIndexCount() const
+{
+    return (size_t)MIndexCount;
+}
+
+size_t CMeshGeometry::GetResidentSize() const
+{
+    return MVertices.capacity() * sizeof(CVertex) + MPositions.capacity() * sizeof(glm::vec3) +
+        MIndices.capacity() * sizeof(unsigned int);
+}
+
+size_t CMeshGeometry::GetUploadedSize() const
+{
+    return MUploadedSize;
+}
+
+size_t CMeshGeometry::GetPackedSavedSize() const
+{
+    return MPackedSavedSize;
+}
+
+const CQuantizationError& CMeshGeometry::GetQuantizationError() const
+{
+    return MQuantizationError;
+}
@@ -0,0 +1,314 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CMeshOptimizer.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class reordering mesh geometry for faster drawing
+ *
+ * Reorders triangles for the post-transform vertex cache and for less overdraw
+ * and reorders vertices for linear vertex fetching
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CMeshOptimizer.h"
+#include "../include/HConstants.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+/**
+ * Size of the LRU cache modeled by the triangle scoring
+ */
+static const int SCORING_CACHE_SIZE = 32;
+
+/**
+ * Help function scoring a vertex for the triangle selection
+ *
+ * \param cachePosition - position in the modeled cache, -1 if not cached
+ * \param     remaining - number of triangles of the vertex that are not emitted yet
+ *
+ * \return score of the vertex
+ */
+static float VertexScore(const int& cachePosition, const unsigned int& remaining)
+{
+    if (remaining == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // vertices of the last triangle are scored lower, so strips do not turn back
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - (cachePosition - 3) / (float)(SCORING_CACHE_SIZE - 3), 1.5f);
+    }
+    // vertices with few remaining triangles are finished first
+    score += 2.0f / std::sqrt((float)remaining);
+    return score;
+}
+
+float CMeshStatistics::GetACMR() const
+{
+    return MTriangles ? (float)MTransforms / MTriangles : 0.0f;
+}
+
+float CMeshStatistics::GetATVR() const
+{
+    return MVertices ? (float)MTransforms / MVertices : 0.0f;
+}
+
+void CMeshStatistics::Add(const CMeshStatistics& statistics)
+{
+    MTriangles += statistics.MTriangles;
+    MVertices += statistics.MVertices;
+    MTransforms += statistics.MTransforms;
+}
+
+CMeshStatistics CMeshOptimizer::Analyze(const std::vector<unsigned int>& indices, const size_t& vertexCount)
+{
+    CMeshStatistics statistics;
+    statistics.MTriangles = indices.size() / 3;
+    statistics.MVertices = vertexCount;
+
+    // a vertex is cached if it entered the FIFO less than VERTEX_CACHE_SIZE misses ago
+    std::vector<size_t> entered(vertexCount, 0);
+    size_t misses = VERTEX_CACHE_SIZE + 1;
+    for (auto index : indices)
+    {
+        if (misses - entered[index] > VERTEX_CACHE_SIZE)
+        {
+            entered[index] = misses++;
+            ++statistics.MTransforms;
+        }
+    }
+    return statistics;
+}
+
+void CMeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, const size_t& vertexCount)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || indices.size() % 3 != 0)
+        return;
+
+    // triangles of every vertex, live triangles are kept at the front of each list
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (auto index : indices)
+        ++remaining[index];
+    std::vector<size_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < vertexCount; ++i)
+        offsets[i + 1] = offsets[i] + remaining[i];
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+        adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+        vertexScore[i] = VertexScore(-1, remaining[i]);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    size_t best = 0;
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        triangleScore[i] = vertexScore[indices[3 * i]] + vertexScore[indices[3 * i + 1]] + vertexScore[indices[3 * i + 2]];
+        if (triangleScore[i] > triangleScore[best])
+            best = i;
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    std::vector<unsigned int> cache, nextCache;
+    size_t scan = 0;
+    while (best < triangleCount)
+    {
+        emitted[best] = true;
+        const unsigned int* triangle = &indices[3 * best];
+        for (int i = 0; i < 3; ++i)
+        {
+            unsigned int vertex = triangle[i];
+            result.push_back(vertex);
+
+            unsigned int* live = &adjacency[offsets[vertex]];
+            for (unsigned int j = 0; j < remaining[vertex]; ++j)
+            {
+                if (live[j] == best)
+                {
+                    live[j] = live[remaining[vertex] - 1];
+                    --remaining[vertex];
+                    break;
+                }
+            }
+        }
+
+        // emitted vertices move to the front of the modeled cache
+        nextCache.clear();
+        for (int i = 0; i < 3; ++i)
+        {
+            if (std::find(nextCache.begin(), nextCache.end(), triangle[i]) == nextCache.end())
+                nextCache.push_back(triangle[i]);
+        }
+        for (auto vertex : cache)
+        {
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                nextCache.push_back(vertex);
+        }
+        for (size_t i = 0; i < nextCache.size(); ++i)
+        {
+            unsigned int vertex = nextCache[i];
+            cachePosition[vertex] = i < SCORING_CACHE_SIZE ? (int)i : -1;
+            vertexScore[vertex] = VertexScore(cachePosition[vertex], remaining[vertex]);
+        }
+
+        // the next triangle is the best one touching the cache
+        best = triangleCount;
+        float bestScore = -std::numeric_limits<float>::max();
+        for (auto vertex : nextCache)
+        {
+            const unsigned int* live = &adjacency[offsets[vertex]];
+            for (unsigned int j = 0; j < remaining[vertex]; ++j)
+            {
+                unsigned int candidate = live[j];
+                const unsigned int* corners = &indices[3 * candidate];
+                triangleScore[candidate] = vertexScore[corners[0]] + vertexScore[corners[1]] + vertexScore[corners[2]];
+                if (triangleScore[candidate] > bestScore)
+                {
+                    bestScore = triangleScore[candidate];
+                    best = candidate;
+                }
+            }
+        }
+        if (nextCache.size() > SCORING_CACHE_SIZE)
+            nextCache.resize(SCORING_CACHE_SIZE);
+        cache.swap(nextCache);
+
+        // the cache has no live triangle left, continue with the next disconnected part
+        if (best == triangleCount)
+        {
+            while (scan < triangleCount && emitted[scan])
+                ++scan;
+            best = scan;
+        }
+    }
+    indices.swap(result);
+}
+
+void CMeshOptimizer::OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<CVertex>& vertices, const float& threshold)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+        return;
+
+    // split where the FIFO cache starts cold, or where a split keeps the cluster's ACMR low
+    float meshACMR = Analyze(indices, vertices.size()).GetACMR();
+    std::vector<size_t> clusters;
+    std::vector<size_t> entered(vertices.size(), 0);
+    size_t misses = VERTEX_CACHE_SIZE + 1;
+    size_t clusterStart = 0, clusterMisses = 0;
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        int triangleMisses = 0;
+        for (int j = 0; j < 3; ++j)
+        {
+            unsigned int index = indices[3 * i + j];
+            if (misses - entered[index] > VERTEX_CACHE_SIZE)
+            {
+                entered[index] = misses++;
+                ++triangleMisses;
+            }
+        }
+
+        bool hard = triangleMisses == 3;
+        bool soft = triangleMisses == 2 && i > clusterStart &&
+            (float)clusterMisses / (i - clusterStart) <= meshACMR * threshold;
+        if (i == 0 || hard || soft)
+        {
+            clusters.push_back(i);
+            clusterStart = i;
+            clusterMisses = 0;
+        }
+        clusterMisses += triangleMisses;
+    }
+    clusters.push_back(triangleCount);
+
+    // area weighted centroid and normal of every cluster
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> centroids(clusters.size() - 1), normals(clusters.size() - 1);
+    for (size_t c = 0; c + 1 < clusters.size(); ++c)
+    {
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t i = clusters[c]; i < clusters[c + 1]; ++i)
+        {
+            const glm::vec3& a = vertices[indices[3 * i]].MPosition;
+            const glm::vec3& b = vertices[indices[3 * i + 1]].MPosition;
+            const glm::vec3& d = vertices[indices[3 * i + 2]].MPosition;
+            glm::vec3 cross = glm::cross(b - a, d - a);
+            float triangleArea = glm::length(cross);
+            centroid += (a + b + d) * (triangleArea / 3.0f);
+            normal += cross;
+            area += triangleArea;
+        }
+        meshCentroid += centroid;
+        meshArea += area;
+        centroids[c] = area > 0.0f ? centroid / area : vertices[indices[3 * clusters[c]]].MPosition;
+        normals[c] = normal;
+    }
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    // clusters facing away from the center occlude the others, so they are drawn first
+    std::vector<float> sortKeys(clusters.size() - 1);
+    std::vector<size_t> order(clusters.size() - 1);
+    for (size_t c = 0; c < order.size(); ++c)
+    {
+        float normalLength = glm::length(normals[c]);
+        sortKeys[c] = normalLength > 0.0f ? glm::dot(centroids[c] - meshCentroid, normals[c] / normalLength) : 0.0f;
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (auto c : order)
+        result.insert(result.end(), indices.begin() + 3 * clusters[c], indices.begin() + 3 * clusters[c + 1]);
+    indices.swap(result);
+}
+
+void CMeshOptimizer::OptimizeVertexFetch(std::vector<CVertex>& vertices, std::vector<unsigned int>& indices)
+{
+    const unsigned int unused = std::numeric_limits<unsigned int>::max();
+    std::vector<unsigned int> remap(vertices.size(), unused);
+    std::vector<CVertex> result;
+    result.reserve(vertices.size());
+    for (auto& index : indices)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = (unsigned int)result.size();
+            result.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(result);
+}
+
+void CMeshOptimizer::Optimize(std::vector<CVertex>& vertices, std::vector<unsigned int>& indices,
+    CMeshStatistics& before, CMeshStatistics& after)
+{
+    before = Analyze(indices, vertices.size());
+    // the steps work on whole triangles, anything else is left as it is
+    if (indices.size() % 3 != 0)
+    {
+        after = before;
+        return;
+    }
+    OptimizeVertexCache(indices, vertices.size());
+    OptimizeOverdraw(indices, vertices, OVERDRAW_THRESHOLD);
+    OptimizeVertexFetch(vertices, indices);
+    after = Analyze(indices, vertices.size());
+}
@@ -0,0 +1,177 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CModelMatrixBuilder.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class building model matrices from position, size and orientation
+ *
+ * Builds model matrices directly from an orthonormal basis, one at a time or in batches
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CModelMatrixBuilder.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define MODEL_MATRIX_SSE
+#include <emmintrin.h>
+#endif
+
+/**
+ * Help function normalizing a vector
+ *
+ * written out, so the SSE batch can repeat the exact operations
+ *
+ * \param vector - vector to be normalized
+ *
+ * \return vector of unit length
+ */
+static glm::vec3 Normalize(const glm::vec3& vector)
+{
+    float length = std::sqrt(vector.x * vector.x + vector.y * vector.y + vector.z * vector.z);
+    return glm::vec3(vector.x / length, vector.y / length, vector.z / length);
+}
+
+/**
+ * Help function computing a cross product
+ *
+ * \param a - first vector
+ * \param b - second vector
+ *
+ * \return a x b
+ */
+static glm::vec3 Cross(const glm::vec3& a, const glm::vec3& b)
+{
+    return glm::vec3(a.y * b.z - b.y * a.z, a.z * b.x - b.z * a.x, a.x * b.y - b.x * a.y);
+}
+
+CBasis CModelMatrixBuilder::ComputeBasis(const glm::vec3& direction, const glm::vec3& upVector)
+{
+    // the same axes as glm::lookAt, which puts them into rows
+    glm::vec3 forward = Normalize(direction);
+    CBasis basis;
+    basis.MRight = Normalize(Cross(forward, upVector));
+    basis.MUp = Cross(basis.MRight, forward);
+    basis.MBackward = glm::vec3(-forward.x, -forward.y, -forward.z);
+    return basis;
+}
+
+glm::mat4 CModelMatrixBuilder::Build(const glm::vec3& position, const glm::vec3& size, const CBasis& basis)
+{
+    // the rows of lookAt become columns, the eye becomes the translation
+    return glm::mat4(glm::vec4(basis.MRight * size.x, 0.0f),
+        glm::vec4(basis.MUp * size.y, 0.0f),
+        glm::vec4(basis.MBackward * size.z, 0.0f),
+        glm::vec4(position, 1.0f));
+}
+
+glm::mat4 CModelMatrixBuilder::Build(const glm::vec3& position, const glm::vec3& size, const glm::vec3& direction, const glm::vec3& upVector)
+{
+    return Build(position, size, ComputeBasis(direction, upVector));
+}
+
+#ifdef MODEL_MATRIX_SSE
+/**
+ * Help function normalizing four vectors stored as components
+ *
+ * \see Normalize
+ *
+ * \param x - X components
+ * \param y - Y components
+ * \param z - Z components
+ */
+static void NormalizeSSE(__m128& x, __m128& y, __m128& z)
+{
+    __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+    x = _mm_div_ps(x, length);
+    y = _mm_div_ps(y, length);
+    z = _mm_div_ps(z, length);
+}
+
+/**
+ * Help function computing four cross products stored as components
+ *
+ * \see Cross
+ *
+ * \param ax, ay, az - components of the first vectors
+ * \param bx, by, bz - components of the second vectors
+ * \param cx, cy, cz - components of the results
+ */
+static void CrossSSE(const __m128& ax, const __m128& ay, const __m128& az, const __m128& bx, const __m128& by, const __m128& bz,
+    __m128& cx, __m128& cy, __m128& cz)
+{
+    cx = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(by, az));
+    cy = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(bz, ax));
+    cz = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(bx, ay));
+}
+
+/**
+ * Help function loading one component of four vectors
+ *
+ * \param   vectors - all vectors
+ * \param   indices - indices of the four vectors
+ * \param component - loaded component
+ *
+ * \return component of every vector
+ */
+static __m128 GatherSSE(const glm::vec3* vectors, const int* indices, const int& component)
+{
+    return _mm_setr_ps(vectors[indices[0]][component], vectors[indices[1]][component],
+        vectors[indices[2]][component], vectors[indices[3]][component]);
+}
+#endif
+
+void CModelMatrixBuilder::BuildBatch(const std::vector<int>& indices, const glm::vec3* positions, const glm::vec3* sizes,
+    const glm::vec3* directions, const glm::vec3* upVectors, glm::mat4* matrices)
+{
+    size_t i = 0;
+#ifdef MODEL_MATRIX_SSE
+    // every register holds one component of four nodes
+    for (; i + 4 <= indices.size(); i += 4)
+    {
+        const int* batch = indices.data() + i;
+        __m128 fx = GatherSSE(directions, batch, 0);
+        __m128 fy = GatherSSE(directions, batch, 1);
+        __m128 fz = GatherSSE(directions, batch, 2);
+        NormalizeSSE(fx, fy, fz);
+
+        __m128 rx, ry, rz;
+        CrossSSE(fx, fy, fz, GatherSSE(upVectors, batch, 0), GatherSSE(upVectors, batch, 1), GatherSSE(upVectors, batch, 2), rx, ry, rz);
+        NormalizeSSE(rx, ry, rz);
+        __m128 ux, uy, uz;
+        CrossSSE(rx, ry, rz, fx, fy, fz, ux, uy, uz);
+
+        __m128 sx = GatherSSE(sizes, batch, 0);
+        __m128 sy = GatherSSE(sizes, batch, 1);
+        __m128 sz = GatherSSE(sizes, batch, 2);
+        // the backward axis is negated forward, flipping the sign bit is exact
+        __m128 sign = _mm_set1_ps(-0.0f);
+        float columns[9][4];
+        _mm_storeu_ps(columns[0], _mm_mul_ps(rx, sx));
+        _mm_storeu_ps(columns[1], _mm_mul_ps(ry, sx));
+        _mm_storeu_ps(columns[2], _mm_mul_ps(rz, sx));
+        _mm_storeu_ps(columns[3], _mm_mul_ps(ux, sy));
+        _mm_storeu_ps(columns[4], _mm_mul_ps(uy, sy));
+        _mm_storeu_ps(columns[5], _mm_mul_ps(uz, sy));
+        _mm_storeu_ps(columns[6], _mm_mul_ps(_mm_xor_ps(fx, sign), sz));
+        _mm_storeu_ps(columns[7], _mm_mul_ps(_mm_xor_ps(fy, sign), sz));
+        _mm_storeu_ps(columns[8], _mm_mul_ps(_mm_xor_ps(fz, sign), sz));
+
+        for (int j = 0; j < 4; ++j)
+        {
+            glm::mat4& matrix = matrices[batch[j]];
+            const glm::vec3& position = positions[batch[j]];
+            _mm_storeu_ps(&matrix[0][0], _mm_setr_ps(columns[0][j], columns[1][j], columns[2][j], 0.0f));
+            _mm_storeu_ps(&matrix[1][0], _mm_setr_ps(columns[3][j], columns[4][j], columns[5][j], 0.0f));
+            _mm_storeu_ps(&matrix[2][0], _mm_setr_ps(columns[6][j], columns[7][j], columns[8][j], 0.0f));
+            _mm_storeu_ps(&matrix[3][0], _mm_setr_ps(position.x, position.y, position.z, 1.0f));
+        }
+    }
+#endif
+    for (; i < indices.size(); ++i)
+    {
+        int index = indices[i];
+        matrices[index] = Build(positions[index], sizes[index], directions[index], upVectors[index]);
+    }
+}
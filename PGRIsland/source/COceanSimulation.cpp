@@ -0,0 +1,273 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       COceanSimulation.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class simulating ocean waves on the CPU
+ *
+ * Evolves a Phillips spectrum in time and transforms it into heights and displacements
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/COceanSimulation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+
+/**
+ * Gravitational acceleration of the dispersion relation
+ */
+static const float GRAVITY = 9.81f;
+
+/**
+ * Number of rows or columns processed by one job, keeps whole AVX registers busy
+ */
+static const int CHUNK_SIZE = 16;
+
+/**
+ * Help function running jobs on the pool and the caller
+ *
+ * jobs are taken from a shared counter, the caller takes them as well
+ * and waits only for jobs already being run, so it never waits on a job
+ * queued behind others or on a worker it occupies itself
+ *
+ * \param  pool - pool of worker threads, nullptr runs all jobs on the caller
+ * \param count - number of jobs
+ * \param   job - job taking its index
+ */
+static void ParallelFor(CThreadPool* pool, const int& count, const std::function<void(int)>& job)
+{
+    if (pool == nullptr || count <= 1)
+    {
+        for (int i = 0; i < count; ++i)
+            job(i);
+        return;
+    }
+
+    // workers may start after the caller returned, the counters have to outlive it
+    struct CSharedJobs
+    {
+        std::atomic<int> MNext;
+        std::atomic<int> MDone;
+        int MCount;
+        std::function<void(int)> MJob;
+        std::mutex MMutex;
+        std::condition_variable MCondition;
+    };
+    auto shared = std::make_shared<CSharedJobs>();
+    shared->MNext = 0;
+    shared->MDone = 0;
+    shared->MCount = count;
+    shared->MJob = job;
+
+    auto work = [shared]()
+    {
+        int index;
+        while ((index = shared->MNext++) < shared->MCount)
+        {
+            shared->MJob(index);
+            if (++shared->MDone == shared->MCount)
+            {
+                std::lock_guard<std::mutex> lock(shared->MMutex);
+                shared->MCondition.notify_all();
+            }
+        }
+    };
+
+    int helpers = std::min((int)pool->GetThreadCount(), count - 1);
+    for (int i = 0; i < helpers; ++i)
+        pool->Enqueue(work);
+    work();
+
+    std::unique_lock<std::mutex> lock(shared->MMutex);
+    shared->MCondition.wait(lock, [&shared] { return shared->MDone == shared->MCount; });
+}
+
+void COceanSimulation::Initialize(const int& size, const float& patchSize, const glm::vec2& wind, const float& amplitude,
+    const float& choppiness, const unsigned int& seed, const EFourierKernel& kernel)
+{
+    MSize = size;
+    MChoppiness = choppiness;
+    MTransform.Initialize(size, true, kernel);
+
+    size_t count = (size_t)size * size;
+    MSpectrumReal.assign(count, 0.0f);
+    MSpectrumImaginary.assign(count, 0.0f);
+    MConjugateReal.assign(count, 0.0f);
+    MConjugateImaginary.assign(count, 0.0f);
+    MFrequencies.assign(count, 0.0f);
+    MDirectionX.assign(count, 0.0f);
+    MDirectionZ.assign(count, 0.0f);
+    MHeightReal.assign(count, 0.0f);
+    MHeightImaginary.assign(count, 0.0f);
+    MDisplacementReal.assign(count, 0.0f);
+    MDisplacementImaginary.assign(count, 0.0f);
+    MDisplacement.assign(count * 4, 0.0f);
+    MMaxHeight = 0.0f;
+    MMaxDisplacement = 0.0f;
+
+    const float pi = 3.14159265358979323846f;
+    float windSpeed = glm::length(wind);
+    glm::vec2 windDirection = windSpeed > 0.0f ? wind / windSpeed : glm::vec2(1.0f, 0.0f);
+    // largest wave rising from the wind and a cut off of waves much smaller than it
+    float largestWave = windSpeed * windSpeed / GRAVITY;
+    float smallestWave = largestWave / 1000.0f;
+
+    std::mt19937 random(seed);
+    std::normal_distribution<float> gaussian(0.0f, 1.0f);
+    for (int z = 0; z < size; ++z)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            size_t i = (size_t)z * size + x;
+            glm::vec2 k(2.0f * pi * (x - size / 2) / patchSize, 2.0f * pi * (z - size / 2) / patchSize);
+            float length = glm::length(k);
+            float real = gaussian(random);
+            float imaginary = gaussian(random);
+            MFrequencies[i] = std::sqrt(GRAVITY * length);
+            if (length < 1e-6f)
+                continue;
+            MDirectionX[i] = k.x / length;
+            MDirectionZ[i] = k.y / length;
+
+            // the Nyquist row and column pair with themselves and would leave imaginary heights
+            if (x == 0 || z == 0)
+                continue;
+            float alignment = glm::dot(k / length, windDirection);
+            float kL = length * largestWave;
+            float phillips = amplitude * std::exp(-1.0f / (kL * kL)) / (length * length * length * length)
+                * alignment * alignment * std::exp(-length * length * smallestWave * smallestWave);
+            float scale = std::sqrt(phillips * 0.5f);
+            MSpectrumReal[i] = real * scale;
+            MSpectrumImaginary[i] = imaginary * scale;
+        }
+    }
+
+    // k and -k are both on the grid, the sum of their waves is real
+    for (int z = 0; z < size; ++z)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            size_t i = (size_t)z * size + x;
+            size_t opposite = (size_t)((size - z) % size) * size + (size - x) % size;
+            MConjugateReal[i] = MSpectrumReal[opposite];
+            MConjugateImaginary[i] = -MSpectrumImaginary[opposite];
+        }
+    }
+
+    // wave vectors centred around zero shift the FFT's input and output by (-1)^(x + z),
+    // the input half is applied to the spectrum once, the output half in WriteRows
+    for (int z = 0; z < size; ++z)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            if (((x + z) & 1) == 0)
+                continue;
+            size_t i = (size_t)z * size + x;
+            MSpectrumReal[i] = -MSpectrumReal[i];
+            MSpectrumImaginary[i] = -MSpectrumImaginary[i];
+            MConjugateReal[i] = -MConjugateReal[i];
+            MConjugateImaginary[i] = -MConjugateImaginary[i];
+        }
+    }
+}
+
+void COceanSimulation::SimulateRows(const float& time, const int& firstRow, const int& rowCount)
+{
+    size_t first = (size_t)firstRow * MSize;
+    size_t last = first + (size_t)rowCount * MSize;
+    for (size_t i = first; i < last; ++i)
+    {
+        float phase = MFrequencies[i] * time;
+        float c = std::cos(phase);
+        float s = std::sin(phase);
+        // h(k, t) = h0(k) e^(iwt) + conj(h0(-k)) e^(-iwt)
+        float real = MSpectrumReal[i] * c - MSpectrumImaginary[i] * s + MConjugateReal[i] * c + MConjugateImaginary[i] * s;
+        float imaginary = MSpectrumReal[i] * s + MSpectrumImaginary[i] * c + MConjugateImaginary[i] * c - MConjugateReal[i] * s;
+
+        // displacement D(k) = -i k / |k| h(k), the height grid carries h + i Dx, both results being real
+        float x = 1.0f + MDirectionX[i];
+        MHeightReal[i] = real * x;
+        MHeightImaginary[i] = imaginary * x;
+        MDisplacementReal[i] = MDirectionZ[i] * imaginary;
+        MDisplacementImaginary[i] = -MDirectionZ[i] * real;
+    }
+    MTransform.TransformRows(MHeightReal.data(), MHeightImaginary.data(), firstRow, rowCount);
+    MTransform.TransformRows(MDisplacementReal.data(), MDisplacementImaginary.data(), firstRow, rowCount);
+}
+
+void COceanSimulation::WriteRows(const int& firstRow, const int& rowCount, float& maxHeight, float& maxDisplacement)
+{
+    maxHeight = 0.0f;
+    maxDisplacement = 0.0f;
+    for (int z = firstRow; z < firstRow + rowCount; ++z)
+    {
+        for (int x = 0; x < MSize; ++x)
+        {
+            size_t i = (size_t)z * MSize + x;
+            float sign = ((x + z) & 1) ? -1.0f : 1.0f;
+            // crests get sharper when vertices move against the displacement
+            float displacementX = -MChoppiness * sign * MHeightImaginary[i];
+            float height = sign * MHeightReal[i];
+            float displacementZ = -MChoppiness * sign * MDisplacementReal[i];
+            MDisplacement[i * 4 + 0] = displacementX;
+            MDisplacement[i * 4 + 1] = height;
+            MDisplacement[i * 4 + 2] = displacementZ;
+            MDisplacement[i * 4 + 3] = 0.0f;
+            maxHeight = std::max(maxHeight, std::fabs(height));
+            maxDisplacement = std::max(maxDisplacement, std::max(std::fabs(displacementX), std::fabs(displacementZ)));
+        }
+    }
+}
+
+void COceanSimulation::Simulate(const float& time, CThreadPool* pool)
+{
+    int chunk = std::min(MSize, CHUNK_SIZE);
+    int chunks = MSize / chunk;
+
+    ParallelFor(pool, chunks, [&](int i)
+    {
+        SimulateRows(time, i * chunk, chunk);
+    });
+    ParallelFor(pool, chunks, [&](int i)
+    {
+        MTransform.TransformColumns(MHeightReal.data(), MHeightImaginary.data(), i * chunk, chunk);
+        MTransform.TransformColumns(MDisplacementReal.data(), MDisplacementImaginary.data(), i * chunk, chunk);
+    });
+
+    std::vector<float> maxHeights(chunks);
+    std::vector<float> maxDisplacements(chunks);
+    ParallelFor(pool, chunks, [&](int i)
+    {
+        WriteRows(i * chunk, chunk, maxHeights[i], maxDisplacements[i]);
+    });
+    MMaxHeight = *std::max_element(maxHeights.begin(), maxHeights.end());
+    MMaxDisplacement = *std::max_element(maxDisplacements.begin(), maxDisplacements.end());
+}
+
+int COceanSimulation::GetSize() const
+{
+    return MSize;
+}
+
+const CFourierTransform& COceanSimulation::GetTransform() const
+{
+    return MTransform;
+}
+
+const std::vector<float>& COceanSimulation::GetDisplacement() const
+{
+    return MDisplacement;
+}
+
+float COceanSimulation::GetMaxHeight() const
+{
+    return MMaxHeight;
+}
+
+float COceanSimulation::GetMaxDisplacement() const
+{
+    return MMaxDisplacement;
+}
@@ -0,0 +1,117 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CRenderQueue.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class collecting draws of a frame and submitting them sorted by state
+ *
+ * Sorts draws by 64-bit keys made of program, textures, vertex array and depth
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CRenderQueue.h"
+#include "../include/CSceneNode.h"
+
+#include <algorithm>
+
+/**
+ * Layout of the keys from the highest bit
+ *
+ *  2 bits - layer, 0 for ordered draws before the opaque ones, 1 for opaque draws,
+ *           2 for ordered draws after them
+ * 16 bits - program
+ * 16 bits - first texture
+ * 16 bits - vertex array
+ * 14 bits - depth
+ *
+ * ordered draws keep the order of submission in the 62 lower bits instead
+ */
+static const int KEY_PROGRAM_SHIFT = 46;
+static const int KEY_TEXTURE_SHIFT = 30;
+static const int KEY_VERTEX_ARRAY_SHIFT = 14;
+static const uint64_t KEY_PART_MASK = 0xFFFF;
+static const uint64_t KEY_DEPTH_MASK = 0x3FFF;
+static const uint64_t KEY_OPAQUE = (uint64_t)1 << 62;
+static const uint64_t KEY_ORDERED = (uint64_t)2 << 62;
+static const uint64_t KEY_LAYER_MASK = (uint64_t)3 << 62;
+
+void CRenderQueue::Clear()
+{
+    MItems.clear();
+    MSequence = 0;
+    MOpaquePushed = false;
+}
+
+void CRenderQueue::PushOpaque(CSceneNode* node, const GLint& stencil, const GLuint& program, const GLuint& texture,
+    const GLuint& vertexArray, const float& depth)
+{
+    float scaled = std::min(std::max(depth / FAR_PLANE, 0.0f), 1.0f) * KEY_DEPTH_MASK;
+    uint64_t key = KEY_OPAQUE | ((program & KEY_PART_MASK) << KEY_PROGRAM_SHIFT)
+        | ((texture & KEY_PART_MASK) << KEY_TEXTURE_SHIFT)
+        | ((vertexArray & KEY_PART_MASK) << KEY_VERTEX_ARRAY_SHIFT)
+        | ((uint64_t)scaled & KEY_DEPTH_MASK);
+    MItems.push_back({ key, node, stencil });
+    ++MSequence;
+    MOpaquePushed = true;
+}
+
+void CRenderQueue::PushOrdered(CSceneNode* node, const GLint& stencil)
+{
+    MItems.push_back({ (MOpaquePushed ? KEY_ORDERED : 0) | MSequence, node, stencil });
+    ++MSequence;
+}
+
+void CRenderQueue::Sort()
+{
+    std::sort(MItems.begin(), MItems.end(), [](const CRenderItem& a, const CRenderItem& b) { return a.MKey < b.MKey; });
+}
+
+void CRenderQueue::BuildBatches(const bool& merge)
+{
+    MBatches.clear();
+    MCommands.clear();
+    for (size_t i = 0; i < MItems.size();)
+    {
+        // ordered draws are never merged, their nodes may draw themselves differently
+        size_t end = i + 1;
+        if (merge && (MItems[i].MKey & KEY_LAYER_MASK) == KEY_OPAQUE)
+        {
+            while (end < MItems.size() && (MItems[end].MKey & KEY_LAYER_MASK) == KEY_OPAQUE
+                && MItems[end].MStencil == MItems[i].MStencil && MItems[i].MNode->CanBatchWith(*MItems[end].MNode))
+                ++end;
+        }
+
+        CRenderBatch batch = { i, end - i, MCommands.size(), 0 };
+        if (batch.MItemCount > 1)
+        {
+            for (size_t j = i; j < end; ++j)
+                MItems[j].MNode->AppendDrawCommands(MCommands);
+            batch.MCommandCount = MCommands.size() - batch.MFirstCommand;
+        }
+        MBatches.push_back(batch);
+        i = end;
+    }
+}
+
+void CRenderQueue::Submit(CRenderState& state, CGeometryArena& arena, const bool& merge)
+{
+    BuildBatches(merge);
+    bool indirect = arena.UploadCommands(MCommands);
+    for (const CRenderBatch& batch : MBatches)
+    {
+        const CRenderItem& item = MItems[batch.MFirstItem];
+        state.SetStencilReference(item.MStencil);
+        if (batch.MItemCount == 1)
+            item.MNode->DrawMesh(state);
+        else
+        {
+            item.MNode->DrawBatch(state, MCommands, batch.MFirstCommand, batch.MCommandCount, indirect);
+            arena.AddBatchedNodes(batch.MItemCount);
+        }
+    }
+}
+
+size_t CRenderQueue::GetSize() const
+{
+    return MItems.size();
+}
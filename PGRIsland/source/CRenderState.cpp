@@ -0,0 +1,112 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CRenderState.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class shadowing OpenGL's binding state
+ *
+ * Remembers the bound program, vertex array, textures and stencil reference to drop redundant calls
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CRenderState.h"
+#include "../include/CGLCallCounter.h"
+
+/**
+ * Name no OpenGL object has, marks an unknown binding
+ */
+static const GLuint UNKNOWN_NAME = 0xFFFFFFFFu;
+
+CRenderState::CRenderState()
+{
+    Invalidate();
+}
+
+void CRenderState::Invalidate()
+{
+    MProgram = UNKNOWN_NAME;
+    MVertexArray = UNKNOWN_NAME;
+    MActiveUnit = -1;
+    for (int i = 0; i < SHADER_TEXTURE_UNITS; ++i)
+    {
+        MTextureTypes[i] = GL_NONE;
+        MTextures[i] = UNKNOWN_NAME;
+    }
+    MStencilReference = -1;
+}
+
+void CRenderState::Begin(const bool& filtering)
+{
+    MFiltering = filtering;
+    MStatistics = CRenderStatistics();
+    Invalidate();
+}
+
+void CRenderState::End()
+{
+    glBindVertexArray(0);
+    CGLCallCounter::Add();
+    Invalidate();
+}
+
+void CRenderState::UseProgram(const CShaderProgram& program)
+{
+    GLuint id = program.GetProgram();
+    if (id == 0)
+        return;
+    ++MStatistics.MProgramRequests;
+    if (MFiltering && id == MProgram)
+        return;
+    glUseProgram(id);
+    CGLCallCounter::Add();
+    ++MStatistics.MProgramSwitches;
+    MProgram = id;
+}
+
+void CRenderState::BindVertexArray(const GLuint& vertexArray)
+{
+    ++MStatistics.MVertexArrayRequests;
+    if (MFiltering && vertexArray == MVertexArray)
+        return;
+    glBindVertexArray(vertexArray);
+    CGLCallCounter::Add();
+    ++MStatistics.MVertexArrayBinds;
+    MVertexArray = vertexArray;
+}
+
+void CRenderState::BindTexture(const int& unit, const GLenum& type, const GLuint& texture)
+{
+    ++MStatistics.MTextureRequests;
+    // only the first units are remembered, the rest is always bound
+    bool known = unit < SHADER_TEXTURE_UNITS;
+    if (MFiltering && known && MTextureTypes[unit] == type && MTextures[unit] == texture)
+        return;
+    if (!MFiltering || unit != MActiveUnit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        CGLCallCounter::Add();
+        MActiveUnit = unit;
+    }
+    glBindTexture(type, texture);
+    CGLCallCounter::Add();
+    ++MStatistics.MTextureBinds;
+    if (known)
+    {
+        MTextureTypes[unit] = type;
+        MTextures[unit] = texture;
+    }
+}
+
+void CRenderState::SetStencilReference(const GLint& reference)
+{
+    if (MFiltering && reference == MStencilReference)
+        return;
+    glStencilFunc(GL_ALWAYS, reference, -1);
+    CGLCallCounter::Add();
+    MStencilReference = reference;
+}
+
+const CRenderStatistics& CRenderState::GetStatistics() const
+{
+    return MStatistics;
+}
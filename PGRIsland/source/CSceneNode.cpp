@@ -12,10 +12,23 @@
 #include "../include/CSceneNode.h"
 #include "../include/CGameState.h"
 
+#include <chrono>
+
 CSceneNode::CSceneNode(const CShaderProgram& program)
     : MShaderProgram(program)
 {}
 
+CSceneNode::~CSceneNode()
+{
+    for (auto& child : MSceneNodes)
+    {
+        if (child->MParent == this)
+            child->MParent = nullptr;
+    }
+    if (MTransform >= 0)
+        gameState.MTransforms.Release(MTransform);
+}
+
 void CSceneNode::Destroy()
 {
     MMesh.Destroy();
@@ -28,16 +41,57 @@ std::vector<std::shared_ptr<CSceneNode>>& CSceneNode::GetSceneNodes()
     return MSceneNodes;
 }
 
+void CSceneNode::ReportMemory(const std::string& name, size_t& resident, size_t& uploaded)
+{
+    if (MMesh.GetVertexCount() > 0)
+    {
+        std::cout << "  " << name << ": " << MMesh.GetVertexCount() << " vertices, "
+            << MMesh.GetResidentSize() / 1024 << " KiB CPU, " << MMesh.GetUploadedSize() / 1024 << " KiB GPU";
+        // a shared mesh uploaded nothing, so it saved nothing either
+        if (MMesh.GetIndexType() == GL_UNSIGNED_SHORT)
+        {
+            size_t saved = MMesh.GetUploadedSize() > 0 ? MMesh.GetIndexCount() * (sizeof(unsigned int) - sizeof(unsigned short)) : 0;
+            std::cout << ", 16-bit indices in " << MMesh.GetSegmentCount() << " draw calls, " << saved / 1024 << " KiB saved";
+        }
+        else
+            std::cout << ", 32-bit indices";
+        if (MMesh.GetPackedSavedSize() > 0)
+        {
+            const CQuantizationError& error = MMesh.GetQuantizationError();
+            std::cout << ", packed " << MMesh.GetPackedSavedSize() / 1024 << " KiB saved, max error position " << error.MPosition
+                << ", normal " << error.MNormal << " deg, texture coordinates " << error.MTextureCoordinates;
+        }
+        std::cout << std::endl;
+        resident += MMesh.GetResidentSize();
+        uploaded += MMesh.GetUploadedSize();
+    }
+    for (size_t i = 0; i < MSceneNodes.size(); ++i)
+        MSceneNodes[i]->ReportMemory(name + "/" + std::to_string(i), resident, uploaded);
+}
+
 std::shared_ptr<CSceneNode> CSceneNode::CreateChildNode()
 {
     std::shared_ptr<CSceneNode> childNode = std::make_shared<CSceneNode>(MShaderProgram);
     childNode->MDirectory = MDirectory;
-    childNode->MPosition = MPosition;
-    childNode->MSize = MSize;
-    childNode->MDirection = MDirection;
+    childNode->MVertexFormat = MVertexFormat;
+    // may run on a worker thread, the transform is created when the child is first used
+    childNode->MParent = this;
     return childNode;
 }
 
+int CSceneNode::GetTransform()
+{
+    if (MTransform < 0)
+    {
+        // the parent's entry is created first, so it precedes the child's one
+        int parent = MParent != nullptr ? MParent->GetTransform() : -1;
+        MTransform = gameState.MTransforms.Create(this);
+        if (parent >= 0)
+            gameState.MTransforms.SetParent(MTransform, parent);
+    }
+    return MTransform;
+}
+
 void CSceneNode::Update(const float& deltaTime)
 {
     if (MTimeSet && MTime > MTimeToLive)
@@ -51,41 +105,144 @@ void CSceneNode::Update(const float& deltaTime)
         node->Update(deltaTime);
 }
 
-void CSceneNode::Draw()
+void CSceneNode::Cull(const CFrustum& frustum, CCullStatistics& statistics)
 {
+    MCulled = true;
+    MMeshVisible = false;
     if (!IsOn)
         return;
+    // a picked object is moved in front of the camera only when it is drawn
+    if (IsPicked)
+    {
+        MarkVisible(statistics);
+        return;
+    }
+
+    int transform = GetTransform();
+    glm::vec3 minimum, maximum;
+    ++statistics.MTested;
+    if (gameState.MTransforms.GetSubtreeBounds(transform, minimum, maximum) && !frustum.IsBoxVisible(minimum, maximum))
+    {
+        ++statistics.MCulled;
+        return;
+    }
+    MCulled = false;
+
+    if (HasGeometry())
+    {
+        // a leaf's own box is the subtree's box, which has just passed
+        MMeshVisible = true;
+        if (!MSceneNodes.empty())
+        {
+            ++statistics.MTested;
+            if (gameState.MTransforms.GetWorldBounds(transform, minimum, maximum) && !frustum.IsBoxVisible(minimum, maximum))
+            {
+                ++statistics.MCulled;
+                MMeshVisible = false;
+            }
+        }
+        if (MMeshVisible)
+            ++statistics.MDrawn;
+    }
+    for (const auto& node : MSceneNodes)
+        node->Cull(frustum, statistics);
+}
+
+void CSceneNode::MarkVisible(CCullStatistics& statistics)
+{
+    MCulled = false;
+    MMeshVisible = true;
+    if (HasGeometry())
+        ++statistics.MDrawn;
+    for (const auto& node : MSceneNodes)
+        node->MarkVisible(statistics);
+}
+
+bool CSceneNode::IsBatchable() const
+{
+    // a program using the time would need it for every node
+    return !MStreaming && MMesh.GetIndexCount() > 0 && MShaderProgram.GetUniforms().MTime < 0;
+}
+
+bool CSceneNode::IsInstanceable() const
+{
+    return IsBatchable() && !IsPickable;
+}
+
+bool CSceneNode::HasGeometry() const
+{
+    return MStreaming || MMesh.GetVertexCount() > 0;
+}
+
+void CSceneNode::Draw(CRenderState& state)
+{
+    if (!IsOn || MCulled)
+        return;
+    if (MMeshVisible && !MInstanced)
+        DrawMesh(state);
+    // Draw child nodes
+    for (const auto& node : MSceneNodes)
+        node->Draw(state);
+}
+
+void CSceneNode::Submit(CRenderQueue& queue, const GLint& stencil, const bool& opaque)
+{
+    if (!IsOn || MCulled)
+        return;
+    bool reorder = opaque || MOpaque;
+    // an instanced mesh is pushed by its instanced node
+    if (MMeshVisible && !MInstanced)
+    {
+        if (!reorder)
+            queue.PushOrdered(this, stencil);
+        // opaque nodes without geometry draw nothing, so they are left out
+        else if (HasGeometry())
+        {
+            const CMeshGeometry& mesh = MStreaming ? gameState.MStreamingLoader.GetPlaceholder() : MMesh;
+            float depth = glm::distance(glm::vec3(GetModelMatrix()[3]), gameState.MCamera.MEye);
+            queue.PushOpaque(this, stencil, MShaderProgram.GetProgram(), mesh.GetFirstTexture(), mesh.GetVertexArray(), depth);
+        }
+    }
+    for (const auto& node : MSceneNodes)
+        node->Submit(queue, stencil, reorder);
+}
+
+bool CSceneNode::CanBatchWith(CSceneNode& node)
+{
+    return IsBatchable() && node.IsBatchable() && MShaderProgram.GetProgram() == node.MShaderProgram.GetProgram()
+        && MMesh.IsBatchableWith(node.MMesh) && GetModelMatrix() == node.GetModelMatrix();
+}
+
+void CSceneNode::AppendDrawCommands(std::vector<CDrawElementsIndirectCommand>& commands) const
+{
+    MMesh.AppendDrawCommands(commands);
+}
+
+void CSceneNode::DrawBatch(CRenderState& state, const std::vector<CDrawElementsIndirectCommand>& commands,
+    const size_t& first, const size_t& count, const bool& indirect)
+{
+    // batchable programs do not use the time
+    state.UseProgram(MShaderProgram);
+    MShaderProgram.SetMat4(MShaderProgram.GetUniforms().MModel, GetModelMatrix());
+    MMesh.DrawCommands(MShaderProgram, state, commands, first, count, indirect);
+}
 
+void CSceneNode::DrawMesh(CRenderState& state)
+{
     // Use MShaderProgram for rendering current scenenode
-    MShaderProgram.UseProgram();
+    state.UseProgram(MShaderProgram);
 
     // Set uniform attributes
-    MShaderProgram.SetFloat("time", MTime);
-
-    MShaderProgram.SetMat4("model", GetModelMatrix());
-    MShaderProgram.SetMat4("view", gameState.MCamera.GetViewMatrix());
-    MShaderProgram.SetMat4("projection", gameState.GetProjectionMatrix());
-
-    MShaderProgram.SetVec3("lightPosition", SUN_POSITION);
-    MShaderProgram.SetVec4("light.vector", gameState.light.MVector);
-    MShaderProgram.SetVec3("light.ambient", gameState.light.MAmbient);
-    MShaderProgram.SetVec3("light.diffuse", gameState.light.MDiffuse);
-    MShaderProgram.SetVec3("light.specular", gameState.light.MSpecular);
-    MShaderProgram.SetVec3("light.dim", gameState.light.MDim);
-   
-    MShaderProgram.SetVec3("cameraDir", gameState.MCamera.MDirection);
-    MShaderProgram.SetFloat("cutOff", CAMERA_LIGHT_CUTOFF);
-    MShaderProgram.SetFloat("outerCutOff", CAMERA_LIGHT_OUTERCUTOFF);
-
-    MShaderProgram.SetVec4("dirLight.vector", gameState.dirLight.MVector);
-    MShaderProgram.SetVec3("dirLight.ambient", gameState.dirLight.MAmbient);
-    MShaderProgram.SetVec3("dirLight.diffuse", gameState.dirLight.MDiffuse);
-    MShaderProgram.SetVec3("dirLight.specular", gameState.dirLight.MSpecular);
-
-    MMesh.Draw(MShaderProgram);
-    // Draw child nodes
-    for (const auto& node: MSceneNodes)
-        node->Draw();
+    const CShaderUniforms& uniforms = MShaderProgram.GetUniforms();
+    MShaderProgram.SetFloat(uniforms.MTime, MTime);
+
+    // view, projection, lights and spotlight come from the per-frame uniform buffer
+    MShaderProgram.SetMat4(uniforms.MModel, GetModelMatrix());
+
+    if (MStreaming)
+        gameState.MStreamingLoader.DrawPlaceholder(MShaderProgram, state);
+    else
+        MMesh.Draw(MShaderProgram, state);
 }
 
 glm::mat4 CSceneNode::GetModelMatrix()
@@ -93,66 +250,94 @@ glm::mat4 CSceneNode::GetModelMatrix()
    // If the object is picked show it by the camera
     if (IsPicked && IsOn)
     {
-        glm::vec3 position = MPosition;
-        glm::vec3 direction = MDirection;
-        glm::vec3 upVector = MUpVector;
         glm::vec3 rightOffset = glm::normalize(glm::cross(gameState.MCamera.MDirection, gameState.MCamera.MUpVector));
         glm::vec3 offset = 2.5f * gameState.MCamera.MDirection + rightOffset + -0.5f * gameState.MCamera.MUpVector;
-        position = gameState.MCamera.MEye + offset;
-        upVector = gameState.MCamera.MUpVector;
-        direction = gameState.MCamera.MDirection;
-        SetPosition(position);
-        SetDirection(direction);
-        SetUpVector(upVector);
+        SetPosition(gameState.MCamera.MEye + offset);
+        SetDirection(gameState.MCamera.MDirection);
+        SetUpVector(gameState.MCamera.MUpVector);
+        // the drawn camera is blended already
+        return gameState.MTransforms.GetWorldMatrix(GetTransform());
     }
-    glm::mat4 modelMatrix = glm::mat4(1.0f);
-    modelMatrix = glm::scale(modelMatrix, MSize);
-    modelMatrix = glm::inverse(glm::lookAt(MPosition, MPosition + MDirection, MUpVector)) * modelMatrix;
-    return modelMatrix;
+    return gameState.MTransforms.GetRenderMatrix(GetTransform());
 }
 
 void CSceneNode::LoadTextureSceneNode(const std::string& file, const GLenum& type, const bool& clamp)
 {
-    MMesh.PushTexture(CTexture(file, type, clamp));
+    MMesh.PushTexture(gameState.MTextureRegistry.Acquire(file, type, clamp));
 }
 
-void CSceneNode::ProcessSceneNode(aiNode* node, const aiScene* scene)
+bool CSceneNode::ProcessSceneNode(CMeshCache& cache)
 {
-    // load mesh from current node
-    for (unsigned int i = 0; i < node->mNumMeshes; i++)
+    std::vector<CPendingMesh> meshes;
+    bool complete = BuildSceneNode(cache, meshes);
+    glm::vec3 minimum, maximum;
+    GetModelBounds(meshes, minimum, maximum);
+    for (const auto& mesh : meshes)
+        mesh.MNode->LoadSceneNode(mesh.MMesh, minimum, maximum);
+    return complete;
+}
+
+void CSceneNode::GetModelBounds(const std::vector<CPendingMesh>& meshes, glm::vec3& minimum, glm::vec3& maximum)
+{
+    minimum = glm::vec3(FLT_MAX);
+    maximum = glm::vec3(-FLT_MAX);
+    for (const auto& mesh : meshes)
     {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        std::shared_ptr<CSceneNode> childNode = CreateChildNode();
-        childNode->LoadSceneNode(mesh, scene);
-        MSceneNodes.push_back(childNode);
+        for (unsigned int i = 0; i < mesh.MMesh.MVertexCount; ++i)
+        {
+            minimum = glm::min(minimum, mesh.MMesh.MVertices[i].MPosition);
+            maximum = glm::max(maximum, mesh.MMesh.MVertices[i].MPosition);
+        }
     }
-    // process children of the current node
-    for (unsigned int i = 0; i < node->mNumChildren; i++)
+}
+
+bool CSceneNode::BuildSceneNode(CMeshCache& cache, std::vector<CPendingMesh>& meshes)
+{
+    unsigned int meshCount, childCount;
+    if (!cache.ReadNode(meshCount, childCount))
+        return false;
+    // collect meshes of the current node
+    for (unsigned int i = 0; i < meshCount; i++)
+    {
+        CPendingMesh mesh;
+        if (!cache.ReadMesh(mesh.MMesh))
+            return false;
+        mesh.MNode = CreateChildNode();
+        MSceneNodes.push_back(mesh.MNode);
+        meshes.push_back(mesh);
+    }
+    // build children of the current node
+    for (unsigned int i = 0; i < childCount; i++)
     {
         std::shared_ptr<CSceneNode> childNode = CreateChildNode();
-        childNode->ProcessSceneNode(node->mChildren[i], scene);
         MSceneNodes.push_back(childNode);
+        if (!childNode->BuildSceneNode(cache, meshes))
+            return false;
     }
+    return true;
 }
 
 void CSceneNode::LoadSceneNode(const std::string& file)
 {
-    Assimp::Importer importer;
-    importer.SetPropertyInteger(AI_CONFIG_PP_PTV_NORMALIZE, 1);
-    const aiScene* scene = importer.ReadFile(file,
-        aiProcess_Triangulate
-        | aiProcess_FlipUVs
-        | aiProcess_PreTransformVertices
-        | aiProcess_GenSmoothNormals
-        | aiProcess_JoinIdenticalVertices);
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
-    {
-        std::cerr << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+    auto start = std::chrono::steady_clock::now();
+
+    CMeshCache cache;
+    if (!cache.LoadOrImport(file, MESH_IMPORT_FLAGS))
         return;
-    }
     MDirectory = file.substr(0, file.find_last_of('/'));
     std::cout << MDirectory << std::endl;
-    ProcessSceneNode(scene->mRootNode, scene);
+    if (!ProcessSceneNode(cache))
+    {
+        std::cerr << "ERROR::MESH_CACHE::incomplete content of " << file << std::endl;
+        for (auto& child : MSceneNodes)
+            child->Destroy();
+        MSceneNodes.clear();
+        return;
+    }
+
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+    std::cout << "Loaded " << file << (cache.IsMapped() ? " from mesh cache" : " through ASSIMP")
+        << " in " << duration.count() << " ms" << std::endl;
 }
 
 void CSceneNode::LoadSceneNode(const int& attributesCount, const int& verticesCount, const int& trianglesCount, const float* vertexAttributes, const unsigned int* indicies)
@@ -168,122 +353,115 @@ void CSceneNode::LoadSceneNode(const int& attributesCount, const int& verticesCo
         vertices.push_back(vertex);
     }
     std::vector<unsigned int> meshIndicies(indicies, indicies + trianglesCount * 3);
-    MMesh = CMeshGeometry(vertices, meshIndicies, {}, {});
+    MMesh = CMeshGeometry(vertices, meshIndicies, {}, {}, MVertexFormat);
+    UpdateBounds();
+}
 
+void CSceneNode::LoadSceneNode(const CSceneNode& node)
+{
+    MMesh = node.MMesh.Share();
+    UpdateBounds();
 }
 
 void CSceneNode::PushSceneNode(const std::shared_ptr<CSceneNode>& node)
 {
     MSceneNodes.push_back(node);
+    node->MParent = this;
+    if (node->MTransform >= 0)
+        gameState.MTransforms.SetParent(node->MTransform, GetTransform());
 }
 
-void CSceneNode::LoadSceneNode(aiMesh* mesh, const aiScene* scene)
+void CSceneNode::LoadSceneNode(const CCachedMesh& mesh, const glm::vec3& minimum, const glm::vec3& maximum)
 {
-    std::vector<CVertex> vertices;
-    std::vector<unsigned int> indices;
-    std::vector<CTexture> textures;
+    std::vector<CTexture> textures = LoadMaterialTextures(mesh.MTexturePaths);
+    MMesh = CMeshGeometry(mesh.MVertices, mesh.MVertexCount, mesh.MIndices, mesh.MIndexCount, textures, mesh.MMaterial,
+        MVertexFormat, MESH_RETENTION_DISCARD, minimum, maximum);
+    UpdateBounds();
+}
 
-    for (unsigned int i = 0; i < mesh->mNumVertices; i++)
-    {
-        CVertex vertex;
-        // positions
-        vertex.MPosition = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
-        // normals
-        if (mesh->HasNormals())
-            vertex.MNormal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
-        // texture coordinates
-        if (mesh->mTextureCoords[0]) 
-            vertex.MTextureCoordinates = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
-        else
-            vertex.MTextureCoordinates = glm::vec2(0.0f, 0.0f);
-        vertices.push_back(vertex);
-    }
-    // go through all faces of the node
-    for (unsigned int i = 0; i < mesh->mNumFaces; i++)
-    {
-        aiFace face = mesh->mFaces[i];
-        // retrieve indicies of the face
-        for (unsigned int j = 0; j < face.mNumIndices; j++)
-            indices.push_back(face.mIndices[j]);
-    }
+void CSceneNode::UpdateBounds()
+{
+    const CMeshGeometry& mesh = MStreaming ? gameState.MStreamingLoader.GetPlaceholder() : MMesh;
+    SetBounds(mesh.GetBoundsMinimum(), mesh.GetBoundsMaximum());
+}
 
-    // get material
-    aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-
-    CMaterial mat;
-    aiColor4D ambient;
-    aiColor4D diffuse;
-    aiColor4D specular;
-    float shininess;
-
-    aiGetMaterialColor(material, AI_MATKEY_COLOR_AMBIENT, &ambient);
-    aiGetMaterialColor(material, AI_MATKEY_COLOR_DIFFUSE, &diffuse);
-    aiGetMaterialColor(material, AI_MATKEY_COLOR_SPECULAR, &specular);
-    aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &shininess);
-
-    mat.MKa = glm::vec3(ambient.r, ambient.g, ambient.b);
-    mat.MKd = glm::vec3(diffuse.r, diffuse.g, diffuse.b);
-    mat.MKs = glm::vec3(specular.r, specular.g, specular.b);
-    mat.MNs = shininess;
-
-    // get diffuse texture
-    if (material->GetTextureCount(aiTextureType_DIFFUSE)) {
-        std::vector<CTexture> diffuseMaps = LoadMaterialTextures(material, aiTextureType_DIFFUSE);
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+void CSceneNode::SetBounds(const glm::vec3& minimum, const glm::vec3& maximum)
+{
+    glm::vec3 boundsMinimum = minimum;
+    glm::vec3 boundsMaximum = maximum;
+    if (MCollision)
+    {
+        // the collision sphere's radius is the size's x, the node's space is scaled by the size
+        glm::vec3 size = GetSize();
+        glm::vec3 radius = glm::abs(glm::vec3(size.x) / size);
+        boundsMinimum = glm::min(boundsMinimum, -radius);
+        boundsMaximum = glm::max(boundsMaximum, radius);
     }
+    gameState.MTransforms.SetBounds(GetTransform(), boundsMinimum, boundsMaximum);
+}
 
-    MMesh = CMeshGeometry(vertices, indices, textures, mat);
+void CSceneNode::SetUnbounded()
+{
+    gameState.MTransforms.SetUnbounded(GetTransform());
 }
 
-std::vector<CTexture> CSceneNode::LoadMaterialTextures(aiMaterial* mat, aiTextureType type)
+std::vector<CTexture> CSceneNode::LoadMaterialTextures(const std::vector<std::string>& paths)
 {
     std::vector<CTexture> textures;
-    for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
+    for (const auto& path : paths)
     {
-        aiString str;
-        mat->GetTexture(type, i, &str);
-        CTexture texture(MDirectory + "/" + str.C_Str(), GL_TEXTURE_2D);
-        textures.push_back(texture);
+        textures.push_back(gameState.MTextureRegistry.Acquire(MDirectory + "/" + path, GL_TEXTURE_2D));
     }
     return textures;
 }
 
-void CSceneNode::SetPosition(const glm::vec3& position)
+void CSceneNode::SetVertexFormat(const EVertexFormat& format)
 {
-    MPosition = position;
+    MVertexFormat = format;
     for (const auto& node : MSceneNodes)
-        node->SetPosition(position);
+        node->SetVertexFormat(format);
+}
+
+void CSceneNode::SetPosition(const glm::vec3& position)
+{
+    gameState.MTransforms.SetPosition(GetTransform(), position);
 }
 
 glm::vec3 CSceneNode::GetPosition()
 {
-    return MPosition;
+    return gameState.MTransforms.GetPosition(GetTransform());
 }
 
 void CSceneNode::SetSize(const glm::vec3& scale)
 {
-    MSize = scale;
-    for (const auto& node : MSceneNodes)
-        node->SetSize(scale);
+    gameState.MTransforms.SetSize(GetTransform(), scale);
+    if (MCollision)
+        UpdateBounds();
+}
+
+glm::vec3 CSceneNode::GetSize()
+{
+    return gameState.MTransforms.GetSize(GetTransform());
 }
 
 void CSceneNode::SetDirection(const glm::vec3& direction)
 {
-    MDirection = direction;
-    for (const auto& node : MSceneNodes)
-        node->SetDirection(direction);
+    gameState.MTransforms.SetDirection(GetTransform(), direction);
 }
 
 glm::vec3 CSceneNode::GetDirection()
 {
-    return MDirection;
+    return gameState.MTransforms.GetDirection(GetTransform());
 }
 
 void CSceneNode::SetUpVector(const glm::vec3& upVector)
 {
-    MUpVector = upVector;
-    for (const auto& node : MSceneNodes)
-        node->SetUpVector(upVector);
+    gameState.MTransforms.SetUpVector(GetTransform(), upVector);
+}
+
+glm::vec3 CSceneNode::GetUpVector()
+{
+    return gameState.MTransforms.GetUpVector(GetTransform());
 }
 
 void CSceneNode::SetPickable(const bool& pickable)
@@ -318,6 +496,11 @@ void CSceneNode::SetOn(const bool& on)
     IsOn = on;
 }
 
+void CSceneNode::SetOpaque(const bool& opaque)
+{
+    MOpaque = opaque;
+}
+
 bool CSceneNode::SwitchOn()
 {
     return IsOn = !IsOn;
@@ -334,6 +517,7 @@ void CSceneNode::SetTimeToLive(const float& time)
 void CSceneNode::SetCollision(const bool& collision)
 {
     MCollision = collision;
+    UpdateBounds();
 }
 
 bool CSceneNode::CheckCollision(const glm::vec3& position, const glm::vec3 size)
@@ -342,8 +526,8 @@ bool CSceneNode::CheckCollision(const glm::vec3& position, const glm::vec3 size)
     if (!MCollision || !IsOn)
         return false;
 
-    float distance = glm::distance(position, MPosition);
-    float radiusSum = MSize.x + size.x;
+    float distance = glm::distance(position, GetPosition());
+    float radiusSum = GetSize().x + size.x;
 
     return distance < radiusSum;
 }
@@ -11,6 +11,52 @@
 //----------------------------------------------------------------------------------------
 #include "../include/CShaderProgram.h"
 #include <iostream>
+#include <algorithm>
+
+#include "../include/CGLCallCounter.h"
+
+/**
+ * Help function hashing a uniform's name
+ *
+ * FNV-1a, computed straight from the C string so a lookup does not allocate
+ *
+ * \param name - name of the uniform
+ *
+ * \return hash of the name
+ */
+static unsigned int HashName(const char* name)
+{
+    unsigned int hash = 2166136261u;
+    for (; *name != '\0'; ++name)
+    {
+        hash ^= (unsigned char)*name;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Help function inserting a uniform into a hashed table
+ *
+ * \param    slots - table with at least one empty slot
+ * \param     name - name of the uniform
+ * \param location - location of the uniform
+ */
+static void InsertSlot(std::vector<CUniformSlot>& slots, const std::string& name, const GLint& location)
+{
+    size_t mask = slots.size() - 1;
+    unsigned int hash = HashName(name.c_str());
+    size_t i = hash & mask;
+    while (slots[i].MLocation >= 0)
+    {
+        if (slots[i].MHash == hash && slots[i].MName == name)
+            return;
+        i = (i + 1) & mask;
+    }
+    slots[i].MName = name;
+    slots[i].MHash = hash;
+    slots[i].MLocation = location;
+}
 
 CShaderProgram::CShaderProgram(const std::string& vertexShaderFile, const std::string& fragmentShaderFile)
 {
@@ -23,6 +69,7 @@ CShaderProgram::CShaderProgram(const std::string& vertexShaderFile, const std::s
    
     MProgram = pgr::createProgram(shaders);
     MInitiliazed = true;
+    Introspect();
 }
 
 CShaderProgram::CShaderProgram(const std::string& vertexShaderFile, const std::string& geometryShaderFile, const std::string& fragmentShaderFile)
@@ -36,6 +83,7 @@ CShaderProgram::CShaderProgram(const std::string& vertexShaderFile, const std::s
 
     MProgram = pgr::createProgram(shaders);
     MInitiliazed = true;
+    Introspect();
 }
 
 void CShaderProgram::UseProgram()
@@ -43,52 +91,244 @@ void CShaderProgram::UseProgram()
     if (!MInitiliazed)
         return;
     glUseProgram(MProgram);
+    CGLCallCounter::Add();
 }
 
-void CShaderProgram::SetBool(const std::string& name, bool value) const
+GLuint CShaderProgram::GetProgram() const
 {
-    if (!MInitiliazed)
+    return MInitiliazed ? MProgram : 0;
+}
+
+void CShaderProgram::Introspect()
+{
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(MProgram, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(MProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<std::pair<std::string, GLint>> uniforms;
+    std::vector<char> buffer(std::max(maxLength, 1));
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(MProgram, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+        std::string name(buffer.data(), length);
+        // members of uniform blocks have no location
+        GLint location = glGetUniformLocation(MProgram, name.c_str());
+        if (location < 0)
+            continue;
+        uniforms.emplace_back(name, location);
+
+        // arrays are reported by their first element, every element gets its own slot
+        // and the name without an index refers to the first element like in OpenGL
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+        {
+            std::string base = name.substr(0, name.size() - 3);
+            uniforms.emplace_back(base, location);
+            for (GLint element = 1; element < size; ++element)
+            {
+                std::string elementName = base + "[" + std::to_string(element) + "]";
+                uniforms.emplace_back(elementName, glGetUniformLocation(MProgram, elementName.c_str()));
+            }
+        }
+    }
+
+    // at most half of the slots are used, so every probe ends at an empty slot
+    size_t slotCount = 8;
+    while (slotCount < 2 * uniforms.size())
+        slotCount *= 2;
+    auto slots = std::make_shared<std::vector<CUniformSlot>>(slotCount);
+    for (const auto& uniform : uniforms)
+    {
+        if (uniform.second >= 0)
+            InsertSlot(*slots, uniform.first, uniform.second);
+    }
+    MUniformSlots = slots;
+
+    MUniforms = CShaderUniforms();
+    MUniforms.MModel = GetLocation("model");
+    MUniforms.MTime = GetLocation("time");
+    MUniforms.MInstanced = GetLocation("instanced");
+    for (int i = 0; i < SHADER_TEXTURE_UNITS; ++i)
+        MUniforms.MTextures[i] = GetLocation(("texture_diffuse" + std::to_string(i)).c_str());
+    MUniforms.MTextureUse = GetLocation("textureUse");
+    MUniforms.MMaterialAmbient = GetLocation("material.ambient");
+    MUniforms.MMaterialDiffuse = GetLocation("material.diffuse");
+    MUniforms.MMaterialSpecular = GetLocation("material.specular");
+    MUniforms.MMaterialShininess = GetLocation("material.shininess");
+    MUniforms.MDequantization = GetLocation("dequantization");
+    MUniforms.MOctahedralNormal = GetLocation("octahedralNormal");
+    MUniforms.MNormalMatrix = GetLocation("normalMatrix");
+    MUniforms.MView = GetLocation("view");
+    MUniforms.MProjection = GetLocation("projection");
+    MUniforms.MFlatShading = GetLocation("flatShading");
+    MUniforms.MOceanEnabled = GetLocation("oceanEnabled");
+    MUniforms.MOceanDisplacement = GetLocation("oceanDisplacement");
+    MUniforms.MOceanPatchSize = GetLocation("oceanPatchSize");
+    MUniforms.MGridGap = GetLocation("gridGap");
+    MUniforms.MClipmapLevels = GetLocation("clipmapLevels");
+    MUniforms.MCameraPosition = GetLocation("cameraPosition");
+    MUniforms.MClipmapResolution = GetLocation("clipmapResolution");
+    MUniforms.MClipmapTiles = GetLocation("clipmapTiles");
+    MUniforms.MClipmapOrigins = GetLocation("clipmapOrigins");
+    MUniforms.MBlend = GetLocation("blend");
+    MUniforms.MDay = GetLocation("day");
+}
+
+GLint CShaderProgram::GetLocation(const char* name) const
+{
+    if (!MUniformSlots)
+        return -1;
+    const std::vector<CUniformSlot>& slots = *MUniformSlots;
+    size_t mask = slots.size() - 1;
+    unsigned int hash = HashName(name);
+    for (size_t i = hash & mask; slots[i].MLocation >= 0; i = (i + 1) & mask)
+    {
+        if (slots[i].MHash == hash && slots[i].MName == name)
+            return slots[i].MLocation;
+    }
+    return -1;
+}
+
+const CShaderUniforms& CShaderProgram::GetUniforms() const
+{
+    return MUniforms;
+}
+
+void CShaderProgram::SetBool(const char* name, bool value) const
+{
+    SetBool(GetLocation(name), value);
+}
+
+void CShaderProgram::SetInt(const char* name, int value) const
+{
+    SetInt(GetLocation(name), value);
+}
+
+void CShaderProgram::SetFloat(const char* name, float value) const
+{
+    SetFloat(GetLocation(name), value);
+}
+
+void CShaderProgram::SetVec2(const char* name, glm::vec2 value) const
+{
+    SetVec2(GetLocation(name), value);
+}
+
+void CShaderProgram::SetIVec2(const char* name, glm::ivec2 value) const
+{
+    SetIVec2(GetLocation(name), value);
+}
+
+void CShaderProgram::SetIVec2Array(const char* name, const glm::ivec2* values, const int& count) const
+{
+    SetIVec2Array(GetLocation(name), values, count);
+}
+
+void CShaderProgram::SetVec3(const char* name, glm::vec3 value) const
+{
+    SetVec3(GetLocation(name), value);
+}
+
+void CShaderProgram::SetVec4(const char* name, glm::vec4 value) const
+{
+    GLint location = GetLocation(name);
+    if (location < 0)
+        return;
+    glUniform4fv(location, 1, &value[0]);
+    CGLCallCounter::Add();
+}
+
+void CShaderProgram::SetMat3(const char* name, const glm::mat3& value) const
+{
+    SetMat3(GetLocation(name), value);
+}
+
+void CShaderProgram::SetMat4(const char* name, const glm::mat4& value) const
+{
+    SetMat4(GetLocation(name), value);
+}
+
+void CShaderProgram::SetBool(const GLint& location, bool value) const
+{
+    if (location < 0)
         return;
-    GLint location = glGetUniformLocation(MProgram, name.c_str());
     glUniform1i(location, (int)value);
+    CGLCallCounter::Add();
 }
 
-void CShaderProgram::SetInt(const std::string& name, int value) const
+void CShaderProgram::SetInt(const GLint& location, int value) const
 {
-    if (!MInitiliazed)
+    if (location < 0)
         return;
-    GLint location = glGetUniformLocation(MProgram, name.c_str());
     glUniform1i(location, value);
+    CGLCallCounter::Add();
 }
 
-void CShaderProgram::SetFloat(const std::string& name, float value) const
+void CShaderProgram::SetFloat(const GLint& location, float value) const
 {
-    if (!MInitiliazed)
+    if (location < 0)
         return;
-    GLint location = glGetUniformLocation(MProgram, name.c_str());
     glUniform1f(location, value);
+    CGLCallCounter::Add();
 }
 
-void CShaderProgram::SetVec3(const std::string& name, glm::vec3 value) const
+void CShaderProgram::SetVec2(const GLint& location, glm::vec2 value) const
 {
-    if (!MInitiliazed)
+    if (location < 0)
+        return;
+    glUniform2f(location, value.x, value.y);
+    CGLCallCounter::Add();
+}
+
+void CShaderProgram::SetIVec2(const GLint& location, glm::ivec2 value) const
+{
+    if (location < 0)
+        return;
+    glUniform2i(location, value.x, value.y);
+    CGLCallCounter::Add();
+}
+
+void CShaderProgram::SetIVec2Array(const GLint& location, const glm::ivec2* values, const int& count) const
+{
+    if (location < 0 || count <= 0)
+        return;
+    glUniform2iv(location, count, &values[0].x);
+    CGLCallCounter::Add();
+}
+
+void CShaderProgram::SetVec3(const GLint& location, glm::vec3 value) const
+{
+    if (location < 0)
         return;
-    GLint location = glGetUniformLocation(MProgram, name.c_str());
     glUniform3fv(location, 1, &value[0]);
+    CGLCallCounter::Add();
 }
 
-void CShaderProgram::SetVec4(const std::string& name, glm::vec4 value) const
+void CShaderProgram::SetMat3(const GLint& location, const glm::mat3& value) const
 {
-    if (!MInitiliazed)
+    if (location < 0)
         return;
-    GLint location = glGetUniformLocation(MProgram, name.c_str());
-    glUniform4fv(location, 1, &value[0]);
+    glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
+    CGLCallCounter::Add();
 }
 
-void CShaderProgram::SetMat4(const std::string& name, const glm::mat4& value) const
+void CShaderProgram::SetMat4(const GLint& location, const glm::mat4& value) const
 {
-    if (!MInitiliazed)
+    if (location < 0)
         return;
-    GLint location = glGetUniformLocation(MProgram, name.c_str());
     glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+    CGLCallCounter::Add();
+}
+
+void CShaderProgram::BindUniformBlock(const std::string& name, const GLuint& binding) const
+{
+    if (!MInitiliazed)
+        return;
+    GLuint index = glGetUniformBlockIndex(MProgram, name.c_str());
+    // programs without the block keep their own uniforms
+    if (index == GL_INVALID_INDEX)
+        return;
+    glUniformBlockBinding(MProgram, index, binding);
 }
@@ -20,31 +20,34 @@ CSkyboxSceneNode::CSkyboxSceneNode(const CShaderProgram& program, const float& s
         cubeNVertices, cubeNTriangles,
         cubeVertices, cubeTriangles);
     SetSize(SKYBOX_SIZE);
-    MMesh.PushTexture(CTexture(SKYBOX_FACES));
-    MMesh.PushTexture(CTexture(SKYBOX_MIDNIGHT_FACES));
+    // the cube follows the camera, it is never outside the frustum
+    SetUnbounded();
+    MMesh.PushTexture(gameState.MTextureRegistry.AcquireCubemap(SKYBOX_FACES));
+    MMesh.PushTexture(gameState.MTextureRegistry.AcquireCubemap(SKYBOX_MIDNIGHT_FACES));
 }
 
-void CSkyboxSceneNode::Draw()
+bool CSkyboxSceneNode::IsBatchable() const
 {
-    if (!IsOn)
-        return;
+    return false;
+}
 
+void CSkyboxSceneNode::DrawMesh(CRenderState& state)
+{
     float blend = 0.5f * sin(MTime / MSlow) + 0.5f;
 
-    MShaderProgram.UseProgram();
+    state.UseProgram(MShaderProgram);
 
     // Setup uniform attributes
-    MShaderProgram.SetFloat("blend", blend);
-    MShaderProgram.SetMat4("model", GetModelMatrix());
-    MShaderProgram.SetBool("day", gameState.MDay);
+    const CShaderUniforms& uniforms = MShaderProgram.GetUniforms();
+    MShaderProgram.SetFloat(uniforms.MBlend, blend);
+    MShaderProgram.SetMat4(uniforms.MModel, GetModelMatrix());
+    MShaderProgram.SetBool(uniforms.MDay, gameState.MDay);
 
     // Setup view matrix so that the skybox moves with the camera
     glm::mat4 view = gameState.GetViewMatrix();
     view[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
 
-    MShaderProgram.SetMat4("view", view);
-    MShaderProgram.SetMat4("projection", gameState.GetProjectionMatrix());
-    MMesh.Draw(MShaderProgram);
-    for (const auto& node : MSceneNodes)
-        node->Draw();
+    MShaderProgram.SetMat4(uniforms.MView, view);
+    MShaderProgram.SetMat4(uniforms.MProjection, gameState.GetProjectionMatrix());
+    MMesh.Draw(MShaderProgram, state);
 }
@@ -12,9 +12,10 @@
 #include "../include/CSplineSceneNode.h"
 #include "../include/CGameState.h"
 
-CSplineSceneNode::CSplineSceneNode(const CShaderProgram& program, const CCatmulRomSpline& spline, const float& slow)
+CSplineSceneNode::CSplineSceneNode(const CShaderProgram& program, const CCatmulRomSpline& spline, const float& slow, const float& phase)
 	:CSceneNode(program), MSpline(spline), MSlow(slow)
 {
+    MTime = phase;
     // initial position
     glm::vec3 point = MSpline.GetSplineLoopPoint(MTime);
     glm::vec3 gradient = MSpline.GetSplineLoopGradient(MTime);
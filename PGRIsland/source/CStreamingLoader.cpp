@@ -0,0 +1,177 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CStreamingLoader.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class streaming object geometry in the background
+ *
+ * Imports objects on worker threads and uploads them in small batches every frame
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CStreamingLoader.h"
+#include "../include/CGameState.h"
+
+#include "../include/cube.h"
+
+CStreamingLoader::~CStreamingLoader()
+{
+    for (auto& request : MRequests)
+    {
+        if (request.MJob.valid())
+            request.MJob.wait();
+    }
+}
+
+void CStreamingLoader::Initialize(CThreadPool& pool)
+{
+    MPool = &pool;
+    MStart = std::chrono::steady_clock::now();
+    MReported = false;
+
+    // objects are normalized by the import, so the cube covers their extent
+    std::vector<CVertex> vertices;
+    for (int i = 0; i < cubeNVertices; ++i)
+    {
+        const float* vertexData = cubeVertices + cubeNAttribsPerVertex * i;
+        CVertex vertex;
+        vertex.MPosition = glm::vec3(vertexData[0], vertexData[1], vertexData[2]);
+        vertex.MNormal = glm::vec3(vertexData[3], vertexData[4], vertexData[5]);
+        vertex.MTextureCoordinates = glm::vec2(vertexData[6], vertexData[7]);
+        vertices.push_back(vertex);
+    }
+    std::vector<unsigned int> indices(cubeTriangles, cubeTriangles + cubeNTriangles * 3);
+    MPlaceholder = CMeshGeometry(vertices, indices, {}, {});
+}
+
+void CStreamingLoader::LoadSceneNode(const std::shared_ptr<CSceneNode>& node, const std::string& file)
+{
+    if (!MPool)
+    {
+        node->LoadSceneNode(file);
+        return;
+    }
+
+    MRequests.emplace_back();
+    CRequest& request = MRequests.back();
+    request.MNode = node;
+    request.MStaging = std::make_shared<CSceneNode>(node->MShaderProgram);
+    request.MStaging->MDirectory = file.substr(0, file.find_last_of('/'));
+    request.MStaging->MVertexFormat = node->MVertexFormat;
+    request.MFile = file;
+    node->MStreaming = true;
+    node->UpdateBounds();
+
+    // the request is not moved anymore, so the worker can fill it
+    CRequest* target = &request;
+    request.MJob = MPool->Enqueue([target] {
+        if (!target->MCache.LoadOrImport(target->MFile, MESH_IMPORT_FLAGS))
+            return;
+        target->MBuilt = target->MStaging->BuildSceneNode(target->MCache, target->MMeshes);
+        CSceneNode::GetModelBounds(target->MMeshes, target->MMinimum, target->MMaximum);
+    });
+}
+
+size_t CStreamingLoader::UploadMeshes(CRequest& request, const size_t& budget)
+{
+    size_t uploaded = 0;
+    while (request.MUploaded < request.MMeshes.size() && uploaded < budget)
+    {
+        const CPendingMesh& mesh = request.MMeshes[request.MUploaded++];
+        mesh.MNode->LoadSceneNode(mesh.MMesh, request.MMinimum, request.MMaximum);
+        uploaded += mesh.MMesh.MVertexCount * sizeof(CVertex) + mesh.MMesh.MIndexCount * sizeof(unsigned int);
+    }
+    return uploaded;
+}
+
+void CStreamingLoader::Attach(CRequest& request)
+{
+    std::shared_ptr<CSceneNode>& node = request.MNode;
+    node->MDirectory = request.MStaging->MDirectory;
+    // children follow the node's transform, wherever it has moved since they were built
+    for (auto& child : request.MStaging->MSceneNodes)
+        node->PushSceneNode(child);
+    request.MStaging->MSceneNodes.clear();
+    node->MStreaming = false;
+    // the placeholder's box is replaced by the children's ones
+    node->UpdateBounds();
+
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - MStart;
+    std::cout << "Streamed " << request.MFile << (request.MCache.IsMapped() ? " from mesh cache" : " through ASSIMP")
+        << " after " << duration.count() << " ms" << std::endl;
+}
+
+void CStreamingLoader::Update()
+{
+    if (!MPool || IsIdle())
+        return;
+
+    size_t uploaded = gameState.MTextureRegistry.UploadReady(STREAMING_UPLOAD_BUDGET);
+
+    for (auto request = MRequests.begin(); request != MRequests.end(); )
+    {
+        if (request->MJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++request;
+            continue;
+        }
+
+        if (!request->MBuilt)
+        {
+            std::cerr << "ERROR::STREAMING::failed to load " << request->MFile << std::endl;
+            for (auto& child : request->MStaging->MSceneNodes)
+                child->Destroy();
+            request->MNode->MStreaming = false;
+            request->MNode->UpdateBounds();
+            request = MRequests.erase(request);
+            continue;
+        }
+
+        // a mesh larger than the remaining budget is still uploaded, so streaming cannot stall
+        if (uploaded >= STREAMING_UPLOAD_BUDGET)
+            break;
+        uploaded += UploadMeshes(*request, STREAMING_UPLOAD_BUDGET - uploaded);
+        if (request->MUploaded < request->MMeshes.size())
+            break;
+
+        Attach(*request);
+        request = MRequests.erase(request);
+    }
+
+    if (IsIdle() && !MReported)
+    {
+        std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - MStart;
+        std::cout << "Streaming finished after " << duration.count() << " ms" << std::endl;
+        gameState.MTextureRegistry.UploadPending();
+        gameState.MTextureRegistry.PrintStatistics();
+        gameState.PrintMemoryReport();
+        MReported = true;
+    }
+}
+
+bool CStreamingLoader::IsIdle() const
+{
+    return MRequests.empty() && !gameState.MTextureRegistry.HasPending();
+}
+
+void CStreamingLoader::DrawPlaceholder(CShaderProgram& shader, CRenderState& state)
+{
+    MPlaceholder.Draw(shader, state);
+}
+
+const CMeshGeometry& CStreamingLoader::GetPlaceholder() const
+{
+    return MPlaceholder;
+}
+
+void CStreamingLoader::Destroy()
+{
+    for (auto& request : MRequests)
+    {
+        request.MJob.wait();
+        request.MStaging->Destroy();
+    }
+    MRequests.clear();
+    MPlaceholder.Destroy();
+    MPool = nullptr;
+}
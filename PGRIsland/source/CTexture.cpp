@@ -10,91 +10,208 @@
 */
 //----------------------------------------------------------------------------------------
 #include "../include/CTexture.h"
+#include "../include/CGameState.h"
+
+/**
+ * Help function choosing OpenGL format of an image
+ *
+ * \param nrComponents - number of bytes per pixel
+ *
+ * \return OpenGL format
+ */
+static GLenum ImageFormat(const int& nrComponents)
+{
+    GLenum format = GL_RGB;
+    if (nrComponents == 1)
+        format = GL_RED;
+    else if (nrComponents == 3)
+        format = GL_RGB;
+    else if (nrComponents == 4)
+        format = GL_RGBA;
+    return format;
+}
 
 CTexture::CTexture(const std::string& path, const GLenum& type, const bool& clamp)
 {
-    GLuint textureID;
-    glGenTextures(1, &textureID);
+    Generate(type);
+
+    CTextureImage image;
+    image.MPath = path;
+    Decode(image);
+    Upload(image, clamp);
+    Free(image);
+}
 
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
+CTexture::CTexture(const std::vector<std::string>& faces)
+{
+    Generate(GL_TEXTURE_CUBE_MAP);
+
+    std::vector<CTextureImage> images(faces.size());
+    for (unsigned int i = 0; i < faces.size(); i++)
     {
-        std::cout << "Generating texture at path: " << path << std::endl;
-        GLenum format = GL_RGB;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(type, textureID);
-        glTexImage2D(type, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(type);
-        
-        if (!clamp)
-            glTexParameteri(type, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        else
-            glTexParameteri(type, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(type, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(type, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(type, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        MInitialized = true;
+        images[i].MPath = faces[i];
+        Decode(images[i]);
     }
-    else
+    UploadCubemap(images);
+    for (auto& image : images)
+        Free(image);
+}
+
+bool CTexture::Decode(CTextureImage& image, const bool& cooked)
+{
+    if (cooked && COOKED_TEXTURES_ENABLED)
+    {
+        std::shared_ptr<CCookedTexture> container = std::make_shared<CCookedTexture>();
+        if (container->Load(image.MPath))
+        {
+            image.MCooked = container;
+            image.MWidth = container->GetLevel(0).MWidth;
+            image.MHeight = container->GetLevel(0).MHeight;
+            image.MComponents = container->GetSourceComponents();
+            return true;
+        }
+    }
+    image.MData = stbi_load(image.MPath.c_str(), &image.MWidth, &image.MHeight, &image.MComponents, 0);
+    return image.MData != nullptr;
+}
+
+void CTexture::Free(CTextureImage& image)
+{
+    stbi_image_free(image.MData);
+    image.MData = nullptr;
+    image.MCooked.reset();
+}
+
+size_t CTexture::ComputeSize(int width, int height, const int& nrComponents, const bool& mipmaps)
+{
+    size_t size = 0;
+    while (true)
     {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
+        size += (size_t)width * height * nrComponents;
+        if (!mipmaps || (width == 1 && height == 1))
+            break;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
     }
-    stbi_image_free(data);
-    MID = textureID;
+    return size;
+}
+
+void CTexture::Generate(const GLenum& type)
+{
+    glGenTextures(1, &MID);
     MType = type;
 }
 
-CTexture::CTexture(const std::vector<std::string>& faces)
+void CTexture::Upload(const CTextureImage& image, const bool& clamp)
 {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    if (image.MCooked)
+    {
+        if (image.MCooked->IsSupported())
+        {
+            UploadCooked(image, clamp);
+            return;
+        }
+        // the context cannot sample the cooked format, fall back to the source image
+        CTextureImage source;
+        source.MPath = image.MPath;
+        Decode(source, false);
+        Upload(source, clamp);
+        Free(source);
+        return;
+    }
 
-    int width, height, nrComponents;
-    for (unsigned int i = 0; i < faces.size(); i++)
+    if (!image.MData)
     {
-        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrComponents, 0);
+        std::cout << "Texture failed to load at path: " << image.MPath << std::endl;
+        MInitialized = false;
+        return;
+    }
 
-        GLenum format = GL_RGB;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
+    std::cout << "Generating texture at path: " << image.MPath << std::endl;
+    GLenum format = ImageFormat(image.MComponents);
+
+    glBindTexture(MType, MID);
+    glTexImage2D(MType, 0, format, image.MWidth, image.MHeight, 0, format, GL_UNSIGNED_BYTE, image.MData);
+    glGenerateMipmap(MType);
+    MSize = ComputeSize(image.MWidth, image.MHeight, image.MComponents, true);
+    SetSampling(clamp);
+    MInitialized = true;
+}
+
+void CTexture::UploadCooked(const CTextureImage& image, const bool& clamp)
+{
+    const CCookedTexture& container = *image.MCooked;
+
+    glBindTexture(MType, MID);
+    // levels are pre-built, so no mipmaps are generated
+    MSize = container.Upload(MType, container.GetLevelCount());
+    glTexParameteri(MType, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(MType, GL_TEXTURE_MAX_LEVEL, container.GetLevelCount() - 1);
+    SetSampling(clamp);
+    MInitialized = true;
+
+    size_t uncompressedSize = ComputeSize(image.MWidth, image.MHeight, image.MComponents, true);
+    size_t savedSize = uncompressedSize > MSize ? uncompressedSize - MSize : 0;
+    std::cout << "Generating texture at path: " << image.MPath << " from cooked "
+        << CCookedTexture::GetFormatName(container.GetFormat()) << " container, "
+        << MSize / 1024 << " KiB, " << savedSize / 1024 << " KiB VRAM saved" << std::endl;
+}
 
-        if (data)
+void CTexture::SetSampling(const bool& clamp)
+{
+    if (!clamp)
+        glTexParameteri(MType, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    else
+        glTexParameteri(MType, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(MType, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(MType, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(MType, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+void CTexture::UploadCubemap(const std::vector<CTextureImage>& faces)
+{
+    glBindTexture(GL_TEXTURE_CUBE_MAP, MID);
+
+    MSize = 0;
+    // a single face failing leaves the cubemap incomplete
+    MInitialized = !faces.empty();
+    for (unsigned int i = 0; i < faces.size(); i++)
+    {
+        // the cubemap is not mipmapped, so only base levels of cooked faces are used
+        CTextureImage source;
+        if (faces[i].MCooked && !faces[i].MCooked->IsSupported())
+        {
+            source.MPath = faces[i].MPath;
+            Decode(source, false);
+        }
+        const CTextureImage& face = source.MPath.empty() ? faces[i] : source;
+
+        if (face.MCooked)
         {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-            MInitialized = true;
+            MSize += face.MCooked->Upload(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 1);
+        }
+        else if (face.MData)
+        {
+            GLenum format = ImageFormat(face.MComponents);
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, face.MWidth, face.MHeight, 0, format, GL_UNSIGNED_BYTE, face.MData);
+            MSize += ComputeSize(face.MWidth, face.MHeight, face.MComponents, false);
         }
         else
         {
-            std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-            stbi_image_free(data);
+            std::cout << "Cubemap texture failed to load at path: " << face.MPath << std::endl;
             MInitialized = false;
         }
+        Free(source);
     }
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    MID = textureID;
-    MType = GL_TEXTURE_CUBE_MAP;
 }
 
 void CTexture::Destroy()
 {
     MInitialized = false;
-    glDeleteTextures(1, &MID);
+    gameState.MTextureRegistry.Release(*this);
 }
@@ -0,0 +1,420 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CTextureCooker.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class cooking textures from the command line
+ *
+ * Builds mipmap chains of images offline and stores them block compressed
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CTextureCooker.h"
+#include "../include/CTextureRegistry.h"
+#include "../include/CMeshCache.h"
+#include "../include/HConstants.h"
+
+#include <set>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+
+#include "../dependencies/stb_image.h"
+
+/**
+ * Help function converting a color to 5:6:5 bits
+ *
+ * \param color - 8-bit red, green and blue
+ *
+ * \return packed color
+ */
+static uint16_t PackColor(const int color[3])
+{
+    return (uint16_t)(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255));
+}
+
+/**
+ * Help function expanding a 5:6:5 color to 8 bits per channel like the GPU does
+ *
+ * \param packed - packed color
+ * \param  color - 8-bit red, green and blue
+ */
+static void UnpackColor(const uint16_t& packed, int color[3])
+{
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+/**
+ * Help function encoding colors of a 4x4 block as a BC1 block
+ *
+ * endpoints span the block's bounding box along the diagonal that follows
+ * the correlation of the channels, inset to reduce the error of the extremes
+ *
+ * \param block - 16 RGBA pixels in row order
+ * \param   out - 8 bytes of the encoded block
+ */
+static void EncodeColorBlock(const unsigned char block[16][4], unsigned char* out)
+{
+    int minColor[3] = { 255, 255, 255 }, maxColor[3] = { 0, 0, 0 };
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            minColor[c] = std::min(minColor[c], (int)block[i][c]);
+            maxColor[c] = std::max(maxColor[c], (int)block[i][c]);
+            mean[c] += block[i][c] / 16.0f;
+        }
+    }
+
+    // flip the green and blue extremes when they fall with red
+    float covarianceGreen = 0.0f, covarianceBlue = 0.0f;
+    for (int i = 0; i < 16; ++i)
+    {
+        covarianceGreen += (block[i][0] - mean[0]) * (block[i][1] - mean[1]);
+        covarianceBlue += (block[i][0] - mean[0]) * (block[i][2] - mean[2]);
+    }
+    if (covarianceGreen < 0.0f)
+        std::swap(minColor[1], maxColor[1]);
+    if (covarianceBlue < 0.0f)
+        std::swap(minColor[2], maxColor[2]);
+
+    for (int c = 0; c < 3; ++c)
+    {
+        int inset = (maxColor[c] - minColor[c]) / 16;
+        maxColor[c] -= inset;
+        minColor[c] += inset;
+    }
+
+    uint16_t color0 = PackColor(maxColor);
+    uint16_t color1 = PackColor(minColor);
+    // color0 > color1 selects the four color mode
+    if (color0 < color1)
+        std::swap(color0, color1);
+
+    int palette[4][3];
+    UnpackColor(color0, palette[0]);
+    UnpackColor(color1, palette[1]);
+    for (int c = 0; c < 3; ++c)
+    {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    uint32_t indices = 0;
+    if (color0 != color1)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0, bestError = INT32_MAX;
+            for (int j = 0; j < 4; ++j)
+            {
+                int error = 0;
+                for (int c = 0; c < 3; ++c)
+                    error += (block[i][c] - palette[j][c]) * (block[i][c] - palette[j][c]);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = j;
+                }
+            }
+            indices |= (uint32_t)best << (2 * i);
+        }
+    }
+
+    out[0] = (unsigned char)(color0 & 0xFF);
+    out[1] = (unsigned char)(color0 >> 8);
+    out[2] = (unsigned char)(color1 & 0xFF);
+    out[3] = (unsigned char)(color1 >> 8);
+    for (int i = 0; i < 4; ++i)
+        out[4 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+/**
+ * Help function encoding alpha of a 4x4 block as a BC3 alpha block
+ *
+ * \param block - 16 RGBA pixels in row order
+ * \param   out - 8 bytes of the encoded block
+ */
+static void EncodeAlphaBlock(const unsigned char block[16][4], unsigned char* out)
+{
+    int alpha0 = 0, alpha1 = 255;
+    for (int i = 0; i < 16; ++i)
+    {
+        alpha0 = std::max(alpha0, (int)block[i][3]);
+        alpha1 = std::min(alpha1, (int)block[i][3]);
+    }
+
+    // alpha0 > alpha1 selects eight interpolated values
+    int palette[8] = { alpha0, alpha1 };
+    for (int j = 1; j < 7; ++j)
+        palette[j + 1] = ((7 - j) * alpha0 + j * alpha1) / 7;
+
+    uint64_t indices = 0;
+    if (alpha0 != alpha1)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0, bestError = INT32_MAX;
+            for (int j = 0; j < 8; ++j)
+            {
+                int error = std::abs(block[i][3] - palette[j]);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = j;
+                }
+            }
+            indices |= (uint64_t)best << (3 * i);
+        }
+    }
+
+    out[0] = (unsigned char)alpha0;
+    out[1] = (unsigned char)alpha1;
+    for (int i = 0; i < 6; ++i)
+        out[2 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+/**
+ * Help function encoding a level
+ *
+ * \param format - target format
+ * \param pixels - RGBA pixels of the level
+ * \param  width - width of the level
+ * \param height - height of the level
+ *
+ * \return content of the level in the target format
+ */
+static std::vector<unsigned char> EncodeLevel(const CCookedTexture::EFormat& format,
+    const std::vector<unsigned char>& pixels, const int& width, const int& height)
+{
+    if (format == CCookedTexture::FORMAT_RGBA8)
+        return pixels;
+
+    int blockSize = format == CCookedTexture::FORMAT_BC1 ? 8 : 16;
+    std::vector<unsigned char> encoded((size_t)CCookedTexture::ComputeLevelSize(format, width, height));
+    unsigned char* out = encoded.data();
+    for (int by = 0; by < height; by += 4)
+    {
+        for (int bx = 0; bx < width; bx += 4)
+        {
+            // blocks crossing the border repeat the edge pixels
+            unsigned char block[16][4];
+            for (int i = 0; i < 16; ++i)
+            {
+                int x = std::min(bx + i % 4, width - 1);
+                int y = std::min(by + i / 4, height - 1);
+                std::copy_n(&pixels[((size_t)y * width + x) * 4], 4, block[i]);
+            }
+            if (format == CCookedTexture::FORMAT_BC3)
+            {
+                EncodeAlphaBlock(block, out);
+                EncodeColorBlock(block, out + 8);
+            }
+            else
+                EncodeColorBlock(block, out);
+            out += blockSize;
+        }
+    }
+    return encoded;
+}
+
+/**
+ * Help function halving a level with a box filter
+ *
+ * \param pixels - RGBA pixels of the level, replaced by the next level
+ * \param  width - width of the level, replaced by the next width
+ * \param height - height of the level, replaced by the next height
+ */
+static void DownsampleLevel(std::vector<unsigned char>& pixels, int& width, int& height)
+{
+    int nextWidth = std::max(1, width / 2), nextHeight = std::max(1, height / 2);
+    std::vector<unsigned char> next((size_t)nextWidth * nextHeight * 4);
+    for (int y = 0; y < nextHeight; ++y)
+    {
+        int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+        for (int x = 0; x < nextWidth; ++x)
+        {
+            int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+            for (int c = 0; c < 4; ++c)
+            {
+                int sum = pixels[((size_t)y0 * width + x0) * 4 + c] + pixels[((size_t)y0 * width + x1) * 4 + c]
+                    + pixels[((size_t)y1 * width + x0) * 4 + c] + pixels[((size_t)y1 * width + x1) * 4 + c];
+                next[((size_t)y * nextWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+    pixels.swap(next);
+    width = nextWidth;
+    height = nextHeight;
+}
+
+/**
+ * Help function collecting texture paths of a mesh cache node
+ *
+ * \param     cache - cache positioned at a node record
+ * \param directory - directory of the object
+ * \param     paths - collected paths
+ *
+ * \return true if the whole node was read else false
+ */
+static bool CollectCachedNode(CMeshCache& cache, const std::string& directory, std::vector<std::string>& paths)
+{
+    unsigned int meshCount, childCount;
+    if (!cache.ReadNode(meshCount, childCount))
+        return false;
+    for (unsigned int i = 0; i < meshCount; ++i)
+    {
+        CCachedMesh mesh;
+        if (!cache.ReadMesh(mesh))
+            return false;
+        for (const auto& path : mesh.MTexturePaths)
+            paths.push_back(directory + "/" + path);
+    }
+    for (unsigned int i = 0; i < childCount; ++i)
+    {
+        if (!CollectCachedNode(cache, directory, paths))
+            return false;
+    }
+    return true;
+}
+
+std::vector<std::string> CTextureCooker::CollectScenePaths()
+{
+    std::vector<std::string> paths = { FISH_PATH, FIRE_PATH, EXPLOSION_PATH };
+    paths.insert(paths.end(), SKYBOX_FACES.begin(), SKYBOX_FACES.end());
+    paths.insert(paths.end(), SKYBOX_MIDNIGHT_FACES.begin(), SKYBOX_MIDNIGHT_FACES.end());
+    for (const auto& model : MODEL_PATHS)
+    {
+        CMeshCache cache;
+        if (!cache.LoadOrImport(model, MESH_IMPORT_FLAGS) ||
+            !CollectCachedNode(cache, model.substr(0, model.find_last_of('/')), paths))
+            std::cerr << "Texture cooker failed to read textures of " << model << std::endl;
+    }
+
+    // shared textures are cooked once
+    std::vector<std::string> unique;
+    std::set<std::string> keys;
+    for (const auto& path : paths)
+    {
+        if (keys.insert(CTextureRegistry::CanonicalPath(path)).second)
+            unique.push_back(path);
+    }
+    return unique;
+}
+
+bool CTextureCooker::Cook(const std::string& path, const CCookedTexture::EFormat& format)
+{
+    int width, height, nrComponents;
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
+    if (!data)
+    {
+        std::cerr << "Texture cooker failed to load " << path << std::endl;
+        return false;
+    }
+
+    // expand to RGBA, single channel images stay red like their GL_RED upload
+    std::vector<unsigned char> pixels((size_t)width * height * 4);
+    bool opaque = true;
+    for (size_t i = 0; i < (size_t)width * height; ++i)
+    {
+        const unsigned char* source = data + i * nrComponents;
+        unsigned char* target = &pixels[i * 4];
+        if (nrComponents == 1)
+        {
+            target[0] = source[0];
+            target[1] = target[2] = 0;
+            target[3] = 255;
+        }
+        else if (nrComponents == 2)
+        {
+            target[0] = target[1] = target[2] = source[0];
+            target[3] = source[1];
+        }
+        else
+        {
+            target[0] = source[0];
+            target[1] = source[1];
+            target[2] = source[2];
+            target[3] = nrComponents == 4 ? source[3] : 255;
+        }
+        opaque = opaque && target[3] == 255;
+    }
+    stbi_image_free(data);
+
+    CCookedTexture::EFormat target = format;
+    if (target == CCookedTexture::FORMAT_COUNT)
+        target = opaque ? CCookedTexture::FORMAT_BC1 : CCookedTexture::FORMAT_BC3;
+
+    std::vector<CCookedTexture::CLevel> levels;
+    std::vector<std::vector<unsigned char>> content;
+    int levelWidth = width, levelHeight = height;
+    while (true)
+    {
+        CCookedTexture::CLevel level;
+        level.MWidth = levelWidth;
+        level.MHeight = levelHeight;
+        level.MOffset = 0;
+        level.MSize = CCookedTexture::ComputeLevelSize(target, levelWidth, levelHeight);
+        levels.push_back(level);
+        content.push_back(EncodeLevel(target, pixels, levelWidth, levelHeight));
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+        DownsampleLevel(pixels, levelWidth, levelHeight);
+    }
+
+    if (!CCookedTexture::Save(path, target, nrComponents, levels, content))
+    {
+        std::cerr << "Texture cooker failed to write " << CCookedTexture::GetCookedPath(path) << std::endl;
+        return false;
+    }
+
+    size_t cookedSize = 0;
+    for (const auto& level : levels)
+        cookedSize += (size_t)level.MSize;
+    size_t uncompressedSize = CTexture::ComputeSize(width, height, nrComponents, true);
+    std::cout << "Cooked " << path << ": " << CCookedTexture::GetFormatName(target) << ", "
+        << levels.size() << " levels, " << uncompressedSize / 1024 << " KiB -> " << cookedSize / 1024 << " KiB" << std::endl;
+    return true;
+}
+
+int CTextureCooker::Run(int argc, char* argv[])
+{
+    CCookedTexture::EFormat format = CCookedTexture::FORMAT_COUNT;
+    std::vector<std::string> paths;
+    for (int i = 0; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument != "--format")
+        {
+            paths.push_back(argument);
+            continue;
+        }
+        std::string name = ++i < argc ? argv[i] : "";
+        if (name == "rgba8")
+            format = CCookedTexture::FORMAT_RGBA8;
+        else if (name == "bc1")
+            format = CCookedTexture::FORMAT_BC1;
+        else if (name == "bc3")
+            format = CCookedTexture::FORMAT_BC3;
+        else if (name != "auto")
+        {
+            std::cout << "Usage: " << COOK_TEXTURES_SWITCH << " [--format auto|rgba8|bc1|bc3] [image...]" << std::endl;
+            return 1;
+        }
+    }
+    if (paths.empty())
+        paths = CollectScenePaths();
+
+    int failures = 0;
+    for (const auto& path : paths)
+    {
+        if (!Cook(path, format))
+            ++failures;
+    }
+    return failures ? 1 : 0;
+}
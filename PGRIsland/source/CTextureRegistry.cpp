@@ -0,0 +1,287 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CTextureRegistry.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class sharing loaded textures between scene nodes
+ *
+ * Decodes and uploads every image only once and hands out reference counted textures
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CTextureRegistry.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iomanip>
+#include <iostream>
+
+std::string CTextureRegistry::CanonicalPath(const std::string& path)
+{
+    std::vector<std::string> components;
+    bool absolute = !path.empty() && (path[0] == '/' || path[0] == '\\');
+
+    std::string component;
+    for (size_t i = 0; i <= path.size(); ++i)
+    {
+        if (i < path.size() && path[i] != '/' && path[i] != '\\')
+        {
+            component += path[i];
+            continue;
+        }
+
+        if (component == "..")
+        {
+            if (!components.empty() && components.back() != "..")
+                components.pop_back();
+            else if (!absolute)
+                components.push_back(component);
+        }
+        else if (!component.empty() && component != ".")
+            components.push_back(component);
+        component.clear();
+    }
+
+    std::string canonical = absolute ? "/" : "";
+    for (size_t i = 0; i < components.size(); ++i)
+    {
+        if (i > 0)
+            canonical += '/';
+        canonical += components[i];
+    }
+
+#ifdef _WIN32
+    // file names are case insensitive on Windows
+    for (auto& character : canonical)
+        character = (char)std::tolower((unsigned char)character);
+#endif
+    return canonical;
+}
+
+bool CTextureRegistry::Find(const std::string& key, CTexture& texture)
+{
+    auto entry = MEntries.find(key);
+    if (entry == MEntries.end())
+    {
+        ++MMisses;
+        return false;
+    }
+
+    ++MHits;
+    ++entry->second.MReferences;
+    MBytesSaved += entry->second.MTexture.MSize;
+    texture = entry->second.MTexture;
+    return true;
+}
+
+void CTextureRegistry::Register(const std::string& key, const CTexture& texture)
+{
+    CEntry& entry = MEntries[key];
+    entry.MTexture = texture;
+    entry.MReferences = 1;
+    MKeys[texture.MID] = key;
+}
+
+CTexture CTextureRegistry::Acquire(const std::string& path, const GLenum& type, const bool& clamp)
+{
+    std::string key = CanonicalPath(path) + (clamp ? "|clamp" : "|repeat");
+
+    CTexture texture;
+    if (Find(key, texture))
+        return texture;
+
+    texture = MDecodePool ? Defer({ path }, type, clamp) : CTexture(path, type, clamp);
+    Register(key, texture);
+    return texture;
+}
+
+CTexture CTextureRegistry::AcquireCubemap(const std::vector<std::string>& faces)
+{
+    std::string key;
+    for (const auto& face : faces)
+        key += CanonicalPath(face) + "|";
+    key += "cubemap";
+
+    CTexture texture;
+    if (Find(key, texture))
+        return texture;
+
+    texture = MDecodePool ? Defer(faces, GL_TEXTURE_CUBE_MAP, false) : CTexture(faces);
+    Register(key, texture);
+    return texture;
+}
+
+CTexture CTextureRegistry::Defer(const std::vector<std::string>& paths, const GLenum& type, const bool& clamp)
+{
+    MPending.emplace_back();
+    CPendingTexture& pending = MPending.back();
+    pending.MTexture.Generate(type);
+    pending.MClamp = clamp;
+
+    // only headers are read here, so meshes know right away whether they are textured
+    pending.MTexture.MInitialized = true;
+    pending.MImages.resize(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        int width, height, nrComponents;
+        if (stbi_info(paths[i].c_str(), &width, &height, &nrComponents))
+            pending.MTexture.MSize += CTexture::ComputeSize(width, height, nrComponents, type != GL_TEXTURE_CUBE_MAP);
+        else
+            pending.MTexture.MInitialized = false;
+        pending.MImages[i].MImage.MPath = paths[i];
+    }
+
+    // images are not moved anymore, so the workers can write into them
+    for (auto& image : pending.MImages)
+    {
+        CPendingImage* target = &image;
+        image.MJob = MDecodePool->Enqueue([target] {
+            auto start = std::chrono::steady_clock::now();
+            CTexture::Decode(target->MImage);
+            target->MDecoded = std::chrono::steady_clock::now();
+            target->MDecodeTime = std::chrono::duration<double, std::milli>(target->MDecoded - start).count();
+        });
+    }
+    return pending.MTexture;
+}
+
+void CTextureRegistry::DeferUploads(CThreadPool& pool)
+{
+    MDecodePool = &pool;
+    MDeferStart = std::chrono::steady_clock::now();
+    MDecodeEnd = MDeferStart;
+    MDecodedImages = 0;
+    MDecodeTime = 0.0;
+    MUploadTime = 0.0;
+}
+
+bool CTextureRegistry::IsDecoded(const CPendingTexture& pending)
+{
+    for (const auto& image : pending.MImages)
+    {
+        if (image.MJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return false;
+    }
+    return true;
+}
+
+size_t CTextureRegistry::UploadTexture(CPendingTexture& pending)
+{
+    std::vector<CTextureImage> images;
+    for (auto& image : pending.MImages)
+    {
+        image.MJob.wait();
+        MDecodeTime += image.MDecodeTime;
+        MDecodeEnd = std::max(MDecodeEnd, image.MDecoded);
+        ++MDecodedImages;
+        images.push_back(image.MImage);
+    }
+
+    auto uploadStart = std::chrono::steady_clock::now();
+    size_t size = 0;
+    // a texture released before its upload is already deleted
+    auto key = MKeys.find(pending.MTexture.MID);
+    if (key != MKeys.end())
+    {
+        CTexture& texture = MEntries[key->second].MTexture;
+        if (texture.MType == GL_TEXTURE_CUBE_MAP)
+            texture.UploadCubemap(images);
+        else
+            texture.Upload(images[0], pending.MClamp);
+        size = texture.MSize;
+    }
+    MUploadTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - uploadStart).count();
+
+    for (auto& image : images)
+        CTexture::Free(image);
+    return size;
+}
+
+void CTextureRegistry::UploadPending()
+{
+    if (!MDecodePool)
+        return;
+
+    auto waitStart = std::chrono::steady_clock::now();
+    for (auto& pending : MPending)
+    {
+        for (auto& image : pending.MImages)
+            image.MJob.wait();
+    }
+    auto waitEnd = std::chrono::steady_clock::now();
+
+    for (auto& pending : MPending)
+        UploadTexture(pending);
+    MPending.clear();
+
+    std::cout << std::fixed << std::setprecision(2)
+        << "Texture decoding: " << MDecodedImages << " images on " << MDecodePool->GetThreadCount() << " threads, "
+        << MDecodeTime << " ms of decoding finished within "
+        << std::chrono::duration<double, std::milli>(MDecodeEnd - MDeferStart).count() << " ms, "
+        << std::chrono::duration<double, std::milli>(waitEnd - waitStart).count() << " ms waited" << std::endl
+        << "Texture upload: " << MUploadTime << " ms" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+
+    MDecodePool = nullptr;
+}
+
+size_t CTextureRegistry::UploadReady(const size_t& budget)
+{
+    size_t uploaded = 0;
+    for (auto pending = MPending.begin(); pending != MPending.end() && uploaded < budget; )
+    {
+        if (!IsDecoded(*pending))
+        {
+            ++pending;
+            continue;
+        }
+        uploaded += UploadTexture(*pending);
+        pending = MPending.erase(pending);
+    }
+    return uploaded;
+}
+
+bool CTextureRegistry::HasPending() const
+{
+    return !MPending.empty();
+}
+
+void CTextureRegistry::Release(const CTexture& texture)
+{
+    GLuint id = texture.MID;
+    auto key = MKeys.find(id);
+    if (key == MKeys.end())
+    {
+        glDeleteTextures(1, &id);
+        return;
+    }
+
+    auto entry = MEntries.find(key->second);
+    if (--entry->second.MReferences > 0)
+        return;
+
+    glDeleteTextures(1, &id);
+    MEntries.erase(entry);
+    MKeys.erase(key);
+}
+
+unsigned int CTextureRegistry::GetHits() const
+{
+    return MHits;
+}
+
+unsigned int CTextureRegistry::GetMisses() const
+{
+    return MMisses;
+}
+
+size_t CTextureRegistry::GetBytesSaved() const
+{
+    return MBytesSaved;
+}
+
+void CTextureRegistry::PrintStatistics() const
+{
+    std::cout << "Texture registry: " << MHits << " hits, " << MMisses << " misses, "
+        << MBytesSaved / 1024 << " KiB not decoded and uploaded again" << std::endl;
+}
@@ -0,0 +1,69 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CThreadPool.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class representing a pool of worker threads
+ *
+ * Runs CPU-only jobs like image decoding next to the OpenGL thread
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CThreadPool.h"
+
+#include <memory>
+
+CThreadPool::CThreadPool(const unsigned int& threadCount)
+{
+    unsigned int count = threadCount ? threadCount : std::thread::hardware_concurrency();
+    if (count == 0)
+        count = 1;
+    for (unsigned int i = 0; i < count; ++i)
+        MWorkers.emplace_back(&CThreadPool::WorkerLoop, this);
+}
+
+CThreadPool::~CThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(MMutex);
+        MStopping = true;
+    }
+    MCondition.notify_all();
+    for (auto& worker : MWorkers)
+        worker.join();
+}
+
+void CThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(MMutex);
+            MCondition.wait(lock, [this] { return MStopping || !MJobs.empty(); });
+            if (MJobs.empty())
+                return;
+            job = std::move(MJobs.front());
+            MJobs.pop();
+        }
+        job();
+    }
+}
+
+std::future<void> CThreadPool::Enqueue(const std::function<void()>& job)
+{
+    // std::function has to be copyable, so the task is shared
+    auto task = std::make_shared<std::packaged_task<void()>>(job);
+    std::future<void> result = task->get_future();
+    {
+        std::lock_guard<std::mutex> lock(MMutex);
+        MJobs.push([task] { (*task)(); });
+    }
+    MCondition.notify_one();
+    return result;
+}
+
+unsigned int CThreadPool::GetThreadCount() const
+{
+    return (unsigned int)MWorkers.size();
+}
@@ -0,0 +1,434 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CTransformSystem.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class storing transforms and bounds of all scene nodes
+ *
+ * Keeps local and world transforms and bounding boxes in contiguous arrays and updates only changed subtrees
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CTransformSystem.h"
+#include "../include/CModelMatrixBuilder.h"
+
+#include <algorithm>
+#include <cfloat>
+
+/**
+ * Help function transforming a box into an axis aligned box
+ *
+ * the centre is transformed as a point, the half extent by the absolute values
+ * of the matrix, which gives the tightest box around the transformed corners
+ *
+ * \param        matrix - transform of the box
+ * \param       minimum - minimal corner of the box, the box is empty if it is greater than the maximum
+ * \param       maximum - maximal corner of the box
+ * \param resultMinimum - minimal corner of the transformed box
+ * \param resultMaximum - maximal corner of the transformed box
+ */
+static void TransformBox(const glm::mat4& matrix, const glm::vec3& minimum, const glm::vec3& maximum,
+    glm::vec3& resultMinimum, glm::vec3& resultMaximum)
+{
+    if (minimum.x > maximum.x || minimum.y > maximum.y || minimum.z > maximum.z)
+    {
+        resultMinimum = glm::vec3(FLT_MAX);
+        resultMaximum = glm::vec3(-FLT_MAX);
+        return;
+    }
+    glm::vec3 center = 0.5f * (minimum + maximum);
+    glm::vec3 extent = 0.5f * (maximum - minimum);
+    glm::vec3 worldCenter = glm::vec3(matrix * glm::vec4(center, 1.0f));
+    glm::vec3 worldExtent(0.0f);
+    for (int column = 0; column < 3; ++column)
+        worldExtent += glm::abs(glm::vec3(matrix[column])) * extent[column];
+    resultMinimum = worldCenter - worldExtent;
+    resultMaximum = worldCenter + worldExtent;
+}
+
+void CTransformSystem::MarkDirty(const int& index)
+{
+    MDirty[index] = 1;
+    MFirstDirty = std::min(MFirstDirty, (size_t)index);
+}
+
+int CTransformSystem::Create(CSceneNode* owner)
+{
+    int handle;
+    if (!MFreeHandles.empty())
+    {
+        handle = MFreeHandles.back();
+        MFreeHandles.pop_back();
+    }
+    else
+    {
+        handle = (int)MIndices.size();
+        MIndices.push_back(-1);
+        MOwners.push_back(nullptr);
+        MLeaves.push_back(-1);
+    }
+    MOwners[handle] = owner;
+
+    int index = (int)MHandles.size();
+    MIndices[handle] = index;
+    MHandles.push_back(handle);
+    MParents.push_back(-1);
+    MPositions.push_back(glm::vec3(0.0f));
+    MSizes.push_back(glm::vec3(1.0f));
+    MDirections.push_back(glm::vec3(0.0f, 0.0f, -1.0f));
+    MUpVectors.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
+    MWorldMatrices.push_back(glm::mat4(1.0f));
+    MPreviousMatrices.push_back(glm::mat4(1.0f));
+    MInterpolated.push_back(0);
+    MStepChanged.push_back(0);
+    MLocalMinimums.push_back(glm::vec3(FLT_MAX));
+    MLocalMaximums.push_back(glm::vec3(-FLT_MAX));
+    MWorldMinimums.push_back(glm::vec3(FLT_MAX));
+    MWorldMaximums.push_back(glm::vec3(-FLT_MAX));
+    MSubtreeMinimums.push_back(glm::vec3(FLT_MAX));
+    MSubtreeMaximums.push_back(glm::vec3(-FLT_MAX));
+    MUnbounded.push_back(0);
+    MSubtreeUnbounded.push_back(0);
+    MDirty.push_back(0);
+    MarkDirty(index);
+    return handle;
+}
+
+void CTransformSystem::Release(const int& handle)
+{
+    int index = MIndices[handle];
+    MHandles[index] = -1;
+    MIndices[handle] = -1;
+    MOwners[handle] = nullptr;
+    if (MLeaves[handle] >= 0)
+    {
+        MHierarchy.Remove(MLeaves[handle]);
+        MLeaves[handle] = -1;
+    }
+    MFreeHandles.push_back(handle);
+    // children may still point to the entry, they are fixed by the next reorder
+    MReorder = true;
+}
+
+void CTransformSystem::SetParent(const int& handle, const int& parent)
+{
+    int index = MIndices[handle];
+    MParents[index] = parent < 0 ? -1 : MIndices[parent];
+    if (MParents[index] > index)
+        MReorder = true;
+    MarkDirty(index);
+}
+
+void CTransformSystem::SetPosition(const int& handle, const glm::vec3& position)
+{
+    int index = MIndices[handle];
+    MPositions[index] = position;
+    MarkDirty(index);
+}
+
+void CTransformSystem::SetSize(const int& handle, const glm::vec3& size)
+{
+    int index = MIndices[handle];
+    MSizes[index] = size;
+    MarkDirty(index);
+}
+
+void CTransformSystem::SetDirection(const int& handle, const glm::vec3& direction)
+{
+    int index = MIndices[handle];
+    MDirections[index] = direction;
+    MarkDirty(index);
+}
+
+void CTransformSystem::SetUpVector(const int& handle, const glm::vec3& upVector)
+{
+    int index = MIndices[handle];
+    MUpVectors[index] = upVector;
+    MarkDirty(index);
+}
+
+void CTransformSystem::SetBounds(const int& handle, const glm::vec3& minimum, const glm::vec3& maximum)
+{
+    int index = MIndices[handle];
+    MLocalMinimums[index] = minimum;
+    MLocalMaximums[index] = maximum;
+    MUnbounded[index] = 0;
+    MarkDirty(index);
+}
+
+void CTransformSystem::SetUnbounded(const int& handle)
+{
+    int index = MIndices[handle];
+    MUnbounded[index] = 1;
+    MarkDirty(index);
+}
+
+glm::vec3 CTransformSystem::GetPosition(const int& handle) const
+{
+    return MPositions[MIndices[handle]];
+}
+
+glm::vec3 CTransformSystem::GetSize(const int& handle) const
+{
+    return MSizes[MIndices[handle]];
+}
+
+glm::vec3 CTransformSystem::GetDirection(const int& handle) const
+{
+    return MDirections[MIndices[handle]];
+}
+
+glm::vec3 CTransformSystem::GetUpVector(const int& handle) const
+{
+    return MUpVectors[MIndices[handle]];
+}
+
+const glm::mat4& CTransformSystem::GetWorldMatrix(const int& handle)
+{
+    if (MReorder || MFirstDirty < MDirty.size())
+        Update();
+    return MWorldMatrices[MIndices[handle]];
+}
+
+glm::mat4 CTransformSystem::GetRenderMatrix(const int& handle)
+{
+    if (MReorder || MFirstDirty < MDirty.size())
+        Update();
+    int index = MIndices[handle];
+    // an entry not changed by the step has the same transform before and after it
+    if (!MInterpolated[index] || !MStepChanged[index] || MInterpolation >= 1.0f)
+        return MWorldMatrices[index];
+    return MPreviousMatrices[index] * (1.0f - MInterpolation) + MWorldMatrices[index] * MInterpolation;
+}
+
+void CTransformSystem::BeginStep()
+{
+    if (MReorder || MFirstDirty < MDirty.size())
+        Update();
+    for (int i : MStepUpdated)
+    {
+        MPreviousMatrices[i] = MWorldMatrices[i];
+        MInterpolated[i] = 1;
+        MStepChanged[i] = 0;
+    }
+    MStepUpdated.clear();
+}
+
+void CTransformSystem::SetInterpolation(const float& interpolation)
+{
+    MInterpolation = interpolation;
+}
+
+bool CTransformSystem::GetWorldBounds(const int& handle, glm::vec3& minimum, glm::vec3& maximum)
+{
+    if (MReorder || MFirstDirty < MDirty.size())
+        Update();
+    int index = MIndices[handle];
+    minimum = MWorldMinimums[index];
+    maximum = MWorldMaximums[index];
+    return !MUnbounded[index];
+}
+
+bool CTransformSystem::GetSubtreeBounds(const int& handle, glm::vec3& minimum, glm::vec3& maximum)
+{
+    if (MReorder || MFirstDirty < MDirty.size())
+        Update();
+    int index = MIndices[handle];
+    minimum = MSubtreeMinimums[index];
+    maximum = MSubtreeMaximums[index];
+    return !MSubtreeUnbounded[index];
+}
+
+void CTransformSystem::Reorder()
+{
+    // depth of every live entry, a released parent makes its children roots
+    size_t count = MHandles.size();
+    std::vector<int> depths(count, -1);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (MHandles[i] < 0)
+            continue;
+        int parent = MParents[i];
+        if (parent >= 0 && MHandles[parent] < 0)
+            MParents[i] = -1;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (MHandles[i] < 0 || depths[i] >= 0)
+            continue;
+        // walk up to the first entry of a known depth and assign depths on the way back
+        std::vector<int> chain;
+        int current = (int)i;
+        while (current >= 0 && depths[current] < 0)
+        {
+            chain.push_back(current);
+            current = MParents[current];
+        }
+        int depth = current >= 0 ? depths[current] : -1;
+        for (auto entry = chain.rbegin(); entry != chain.rend(); ++entry)
+            depths[*entry] = ++depth;
+    }
+
+    std::vector<int> order;
+    order.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (MHandles[i] >= 0)
+            order.push_back((int)i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&depths](int a, int b) { return depths[a] < depths[b]; });
+
+    std::vector<int> newIndices(count, -1);
+    for (size_t i = 0; i < order.size(); ++i)
+        newIndices[order[i]] = (int)i;
+
+    std::vector<int> handles(order.size());
+    std::vector<int> parents(order.size());
+    std::vector<glm::vec3> positions(order.size());
+    std::vector<glm::vec3> sizes(order.size());
+    std::vector<glm::vec3> directions(order.size());
+    std::vector<glm::vec3> upVectors(order.size());
+    std::vector<glm::vec3> localMinimums(order.size());
+    std::vector<glm::vec3> localMaximums(order.size());
+    std::vector<unsigned char> unbounded(order.size());
+    std::vector<glm::mat4> previousMatrices(order.size());
+    std::vector<unsigned char> interpolated(order.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        int old = order[i];
+        handles[i] = MHandles[old];
+        parents[i] = MParents[old] < 0 ? -1 : newIndices[MParents[old]];
+        positions[i] = MPositions[old];
+        sizes[i] = MSizes[old];
+        directions[i] = MDirections[old];
+        upVectors[i] = MUpVectors[old];
+        localMinimums[i] = MLocalMinimums[old];
+        localMaximums[i] = MLocalMaximums[old];
+        unbounded[i] = MUnbounded[old];
+        previousMatrices[i] = MPreviousMatrices[old];
+        interpolated[i] = MInterpolated[old];
+        MIndices[handles[i]] = (int)i;
+    }
+    MHandles.swap(handles);
+    MParents.swap(parents);
+    MPositions.swap(positions);
+    MSizes.swap(sizes);
+    MDirections.swap(directions);
+    MUpVectors.swap(upVectors);
+    MLocalMinimums.swap(localMinimums);
+    MLocalMaximums.swap(localMaximums);
+    MUnbounded.swap(unbounded);
+    MPreviousMatrices.swap(previousMatrices);
+    MInterpolated.swap(interpolated);
+    MWorldMatrices.assign(order.size(), glm::mat4(1.0f));
+    MWorldMinimums.assign(order.size(), glm::vec3(FLT_MAX));
+    MWorldMaximums.assign(order.size(), glm::vec3(-FLT_MAX));
+    MSubtreeMinimums.assign(order.size(), glm::vec3(FLT_MAX));
+    MSubtreeMaximums.assign(order.size(), glm::vec3(-FLT_MAX));
+    MSubtreeUnbounded.assign(order.size(), 0);
+    MDirty.assign(order.size(), 1);
+    // every entry is recomputed now and listed again by the update
+    MStepChanged.assign(order.size(), 0);
+    MStepUpdated.clear();
+    MFirstDirty = 0;
+    MReorder = false;
+}
+
+void CTransformSystem::Update()
+{
+    if (MReorder)
+        Reorder();
+
+    size_t count = MDirty.size();
+    // parents precede children, so a parent's flag is final before its children read it
+    MUpdated.clear();
+    for (size_t i = MFirstDirty; i < count; ++i)
+    {
+        int parent = MParents[i];
+        if (parent >= 0 && MDirty[parent])
+            MDirty[i] = 1;
+        if (MDirty[i])
+            MUpdated.push_back((int)i);
+    }
+    if (MFirstDirty < count)
+        std::fill(MDirty.begin() + MFirstDirty, MDirty.end(), 0);
+    MFirstDirty = count;
+
+    // local transforms do not depend on each other, they are built in one batch,
+    // the parents' world transforms are final when their children are reached
+    CModelMatrixBuilder::BuildBatch(MUpdated, MPositions.data(), MSizes.data(), MDirections.data(), MUpVectors.data(), MWorldMatrices.data());
+    for (int i : MUpdated)
+    {
+        int parent = MParents[i];
+        if (parent >= 0)
+            MWorldMatrices[i] = MWorldMatrices[parent] * MWorldMatrices[i];
+        TransformBox(MWorldMatrices[i], MLocalMinimums[i], MLocalMaximums[i], MWorldMinimums[i], MWorldMaximums[i]);
+        UpdateLeaf(i);
+        if (!MStepChanged[i])
+        {
+            MStepChanged[i] = 1;
+            MStepUpdated.push_back(i);
+        }
+    }
+    if (!MUpdated.empty())
+        UpdateSubtreeBounds();
+}
+
+void CTransformSystem::UpdateSubtreeBounds()
+{
+    size_t count = MHandles.size();
+    std::copy(MWorldMinimums.begin(), MWorldMinimums.end(), MSubtreeMinimums.begin());
+    std::copy(MWorldMaximums.begin(), MWorldMaximums.end(), MSubtreeMaximums.begin());
+    std::copy(MUnbounded.begin(), MUnbounded.end(), MSubtreeUnbounded.begin());
+    for (size_t i = count; i-- > 0; )
+    {
+        int parent = MParents[i];
+        if (parent < 0)
+            continue;
+        // empty boxes hold the largest values, so they never widen their parent
+        MSubtreeMinimums[parent] = glm::min(MSubtreeMinimums[parent], MSubtreeMinimums[i]);
+        MSubtreeMaximums[parent] = glm::max(MSubtreeMaximums[parent], MSubtreeMaximums[i]);
+        MSubtreeUnbounded[parent] |= MSubtreeUnbounded[i];
+    }
+}
+
+void CTransformSystem::UpdateLeaf(const int& index)
+{
+    int handle = MHandles[index];
+    int& leaf = MLeaves[handle];
+    const glm::vec3& minimum = MWorldMinimums[index];
+    const glm::vec3& maximum = MWorldMaximums[index];
+    bool bounded = !MUnbounded[index] && minimum.x <= maximum.x && minimum.y <= maximum.y && minimum.z <= maximum.z;
+    if (!bounded)
+    {
+        if (leaf >= 0)
+            MHierarchy.Remove(leaf);
+        leaf = -1;
+    }
+    else if (leaf < 0)
+        leaf = MHierarchy.Insert(minimum, maximum, handle);
+    else
+        MHierarchy.Move(leaf, minimum, maximum);
+}
+
+const CBoundingVolumeHierarchy& CTransformSystem::GetHierarchy()
+{
+    if (MReorder || MFirstDirty < MDirty.size())
+        Update();
+    return MHierarchy;
+}
+
+CSceneNode* CTransformSystem::GetOwner(const int& handle) const
+{
+    return MOwners[handle];
+}
+
+size_t CTransformSystem::GetCount() const
+{
+    return MHandles.size();
+}
+
+size_t CTransformSystem::GetUpdatedCount() const
+{
+    return MUpdated.size();
+}
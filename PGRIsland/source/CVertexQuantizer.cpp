@@ -0,0 +1,232 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CVertexQuantizer.cpp
+ * \author     Hong Son Ngo
+ * \date       2021/05/05
+ * \brief      Class packing vertices into compact formats
+ *
+ * Quantizes positions to the mesh's bounding box, encodes normals octahedrally
+ * and stores texture coordinates as half floats
+ *
+*/
+//----------------------------------------------------------------------------------------
+#include "../include/CVertexQuantizer.h"
+#include "../include/HConstants.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/**
+ * Largest value of a normalized unsigned short
+ */
+static const float POSITION_SCALE = 65535.0f;
+
+/**
+ * Help function packing vertices into one of the packed formats
+ *
+ * \param     vertices - vertices to be packed
+ * \param  vertexCount - number of vertices
+ * \param      minimum - minimal corner of the bounding box
+ * \param       extent - size of the bounding box
+ * \param  normalScale - largest value of the normal components
+ * \param         data - packed vertices
+ */
+template<typename TVertex, typename TNormal>
+static void PackVertices(const CVertex* vertices, const size_t& vertexCount, const glm::vec3& minimum,
+    const glm::vec3& extent, const float& normalScale, std::vector<unsigned char>& data)
+{
+    data.assign(vertexCount * sizeof(TVertex), 0);
+    TVertex* packed = (TVertex*)data.data();
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const CVertex& vertex = vertices[i];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float position = extent[axis] > 0.0f ? (vertex.MPosition[axis] - minimum[axis]) / extent[axis] : 0.0f;
+            packed[i].MPosition[axis] = (uint16_t)std::lround(glm::clamp(position, 0.0f, 1.0f) * POSITION_SCALE);
+        }
+        glm::vec2 normal = CVertexQuantizer::EncodeOctahedral(vertex.MNormal);
+        packed[i].MNormal[0] = (TNormal)std::lround(glm::clamp(normal.x, -1.0f, 1.0f) * normalScale);
+        packed[i].MNormal[1] = (TNormal)std::lround(glm::clamp(normal.y, -1.0f, 1.0f) * normalScale);
+        packed[i].MTextureCoordinates[0] = CVertexQuantizer::FloatToHalf(vertex.MTextureCoordinates.x);
+        packed[i].MTextureCoordinates[1] = CVertexQuantizer::FloatToHalf(vertex.MTextureCoordinates.y);
+    }
+}
+
+/**
+ * Help function unpacking a vertex of one of the packed formats
+ *
+ * \param         vertex - packed vertex
+ * \param dequantization - matrix mapping packed positions back to the mesh space
+ * \param    normalScale - largest value of the normal components
+ *
+ * \return unpacked vertex
+ */
+template<typename TVertex>
+static CVertex UnpackVertex(const unsigned char* vertex, const glm::mat4& dequantization, const float& normalScale)
+{
+    TVertex packed;
+    std::memcpy(&packed, vertex, sizeof(TVertex));
+
+    // same conversions as OpenGL does for normalized attributes
+    CVertex result;
+    glm::vec4 position(packed.MPosition[0] / POSITION_SCALE, packed.MPosition[1] / POSITION_SCALE, packed.MPosition[2] / POSITION_SCALE, 1.0f);
+    result.MPosition = glm::vec3(dequantization * position);
+    result.MNormal = CVertexQuantizer::DecodeOctahedral(glm::vec2(
+        std::max(packed.MNormal[0] / normalScale, -1.0f),
+        std::max(packed.MNormal[1] / normalScale, -1.0f)));
+    result.MTextureCoordinates = glm::vec2(
+        CVertexQuantizer::HalfToFloat(packed.MTextureCoordinates[0]),
+        CVertexQuantizer::HalfToFloat(packed.MTextureCoordinates[1]));
+    return result;
+}
+
+size_t CVertexQuantizer::GetVertexSize(const EVertexFormat& format)
+{
+    switch (format)
+    {
+        case VERTEX_FORMAT_PACKED_8:
+            return sizeof(CPackedVertex8);
+        case VERTEX_FORMAT_PACKED_16:
+            return sizeof(CPackedVertex16);
+        default:
+            return sizeof(CVertex);
+    }
+}
+
+bool CVertexQuantizer::Pack(const EVertexFormat& format, const CVertex* vertices, const size_t& vertexCount,
+    const glm::vec3& minimum, const glm::vec3& maximum, std::vector<unsigned char>& data, glm::mat4& dequantization, CQuantizationError& error)
+{
+    error = CQuantizationError();
+    data.clear();
+    dequantization = glm::mat4(1.0f);
+    if (format == VERTEX_FORMAT_FLOAT)
+        return false;
+    if (vertexCount == 0)
+        return true;
+
+    glm::vec3 extent = maximum - minimum;
+    float largestExtent = std::max(extent.x, std::max(extent.y, extent.z));
+
+    // positions in <0, 1> are moved back to the bounding box
+    dequantization = glm::scale(glm::translate(glm::mat4(1.0f), minimum), extent);
+
+    if (format == VERTEX_FORMAT_PACKED_8)
+        PackVertices<CPackedVertex8, int8_t>(vertices, vertexCount, minimum, extent, 127.0f, data);
+    else
+        PackVertices<CPackedVertex16, int16_t>(vertices, vertexCount, minimum, extent, 32767.0f, data);
+
+    size_t vertexSize = GetVertexSize(format);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const CVertex& original = vertices[i];
+        CVertex unpacked = Unpack(format, &data[i * vertexSize], dequantization);
+
+        float position = glm::length(unpacked.MPosition - original.MPosition);
+        error.MPosition = std::max(error.MPosition, largestExtent > 0.0f ? position / largestExtent : position);
+
+        // meshes without normals have zero vectors, these are not compared
+        float normalLength = glm::length(original.MNormal);
+        if (normalLength > 0.0f)
+        {
+            float cosine = glm::clamp(glm::dot(unpacked.MNormal, original.MNormal / normalLength), -1.0f, 1.0f);
+            error.MNormal = std::max(error.MNormal, glm::degrees(std::acos(cosine)));
+        }
+
+        glm::vec2 textureCoordinates = glm::abs(unpacked.MTextureCoordinates - original.MTextureCoordinates);
+        error.MTextureCoordinates = std::max(error.MTextureCoordinates, std::max(textureCoordinates.x, textureCoordinates.y));
+    }
+
+    // comparisons are written so NaNs fail them
+    return error.MPosition <= VERTEX_POSITION_TOLERANCE &&
+        error.MNormal <= VERTEX_NORMAL_TOLERANCE &&
+        error.MTextureCoordinates <= VERTEX_TEXTURE_COORDINATES_TOLERANCE;
+}
+
+CVertex CVertexQuantizer::Unpack(const EVertexFormat& format, const unsigned char* vertex, const glm::mat4& dequantization)
+{
+    switch (format)
+    {
+        case VERTEX_FORMAT_PACKED_8:
+            return UnpackVertex<CPackedVertex8>(vertex, dequantization, 127.0f);
+        case VERTEX_FORMAT_PACKED_16:
+            return UnpackVertex<CPackedVertex16>(vertex, dequantization, 32767.0f);
+        default:
+        {
+            CVertex result;
+            std::memcpy(&result, vertex, sizeof(CVertex));
+            return result;
+        }
+    }
+}
+
+glm::vec2 CVertexQuantizer::EncodeOctahedral(const glm::vec3& normal)
+{
+    float sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    if (sum == 0.0f)
+        return glm::vec2(0.0f);
+
+    glm::vec2 coordinates = glm::vec2(normal.x, normal.y) / sum;
+    // the lower half is folded over the diagonals
+    if (normal.z < 0.0f)
+    {
+        coordinates = glm::vec2(
+            (1.0f - std::fabs(coordinates.y)) * (coordinates.x >= 0.0f ? 1.0f : -1.0f),
+            (1.0f - std::fabs(coordinates.x)) * (coordinates.y >= 0.0f ? 1.0f : -1.0f));
+    }
+    return coordinates;
+}
+
+glm::vec3 CVertexQuantizer::DecodeOctahedral(const glm::vec2& coordinates)
+{
+    glm::vec3 normal(coordinates.x, coordinates.y, 1.0f - std::fabs(coordinates.x) - std::fabs(coordinates.y));
+    float fold = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+    return glm::normalize(normal);
+}
+
+uint16_t CVertexQuantizer::FloatToHalf(const float& value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    uint32_t magnitude = bits & 0x7fffffff;
+
+    // infinity and NaN
+    if (magnitude >= 0x7f800000)
+        return sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x0200 : 0);
+    // too large values round to infinity
+    if (magnitude >= 0x477ff000)
+        return sign | 0x7c00;
+    // subnormal halves are multiples of 2^-24
+    if (magnitude < 0x38800000)
+        return sign | (uint16_t)std::lround(std::fabs(value) * 16777216.0f);
+
+    // exponent bias changes from 127 to 15, the mantissa is rounded to the nearest even
+    magnitude -= 0x38000000;
+    return sign | (uint16_t)((magnitude + 0x0fff + ((magnitude >> 13) & 1)) >> 13);
+}
+
+float CVertexQuantizer::HalfToFloat(const uint16_t& value)
+{
+    uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x03ff;
+
+    if (exponent == 0)
+    {
+        float result = std::ldexp((float)mantissa, -24);
+        return sign ? -result : result;
+    }
+
+    uint32_t bits;
+    if (exponent == 31)
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    else
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
@@ -12,32 +12,254 @@
 #include "../include/CWaterPlaneSceneNode.h"
 #include "../include/CGameState.h"
 
+#include <algorithm>
+#include <cstring>
+
 CWaterPlaneSceneNode::CWaterPlaneSceneNode(const CShaderProgram& program)
 	: CSceneNode(program)
 {
-	MMesh.GeneratePlaneMesh(WATER_PLANE_SIDE_SIZE, WATER_PLANE_VERTEX_GAP);
+	MTimer.Initialize(GPU_TIMER_QUERIES);
+	// the clipmap follows the camera and culls its own tiles
+	SetUnbounded();
+	if (OCEAN_ENABLED)
+		InitializeOcean();
+	if (!WATER_CLIPMAP_ENABLED)
+	{
+		MMesh.GenerateProceduralPlane(WATER_PLANE_SIDE_SIZE);
+		return;
+	}
+
+	// every level draws all its tiles as triangles, the vertex ID encodes level, tile, quad and corner
+	MClipmapLevels = ComputeClipmapLevels(WATER_PLANE_SIDE_SIZE);
+	MClipmapOrigins.resize(MClipmapLevels);
+	MMesh.GenerateProceduralMesh(GL_TRIANGLES, MClipmapLevels * WATER_CLIPMAP_RESOLUTION * WATER_CLIPMAP_RESOLUTION * 6, 1);
+}
+
+int CWaterPlaneSceneNode::ComputeClipmapLevels(const int& side)
+{
+	// the coarsest level reaches over the whole uniform grid from any camera position on it
+	int levels = 1;
+	while (levels < WATER_CLIPMAP_MAX_LEVELS && (WATER_CLIPMAP_RESOLUTION / 2) * (1 << (levels - 1)) < side)
+		++levels;
+	return levels;
+}
+
+size_t CWaterPlaneSceneNode::ComputeClipmapTriangles(const int& levels)
+{
+	size_t level = (size_t)WATER_CLIPMAP_RESOLUTION * WATER_CLIPMAP_RESOLUTION * 2;
+	size_t hole = level / 4;
+	return levels > 0 ? level + (levels - 1) * (level - hole) : 0;
+}
+
+void CWaterPlaneSceneNode::UpdateClipmap(const glm::vec2& camera)
+{
+	for (int level = 0; level < MClipmapLevels; ++level)
+	{
+		float gap = WATER_PLANE_VERTEX_GAP * (1 << level);
+		MClipmapOrigins[level] = glm::ivec2(
+			2 * (int)std::floor(camera.x / (2.0f * gap)) - WATER_CLIPMAP_RESOLUTION / 2,
+			2 * (int)std::floor(camera.y / (2.0f * gap)) - WATER_CLIPMAP_RESOLUTION / 2);
+	}
+}
+
+void CWaterPlaneSceneNode::CullClipmap(const glm::mat4& clip)
+{
+	CFrustum frustum(clip);
+	const int tileSize = WATER_CLIPMAP_RESOLUTION / WATER_CLIPMAP_TILES;
+	const GLsizei tileVertices = tileSize * tileSize * 6;
+	MTileFirsts.clear();
+	MTileCounts.clear();
+	MCulledTiles = 0;
+	MSubmittedVertices = 0;
+	for (int level = 0; level < MClipmapLevels; ++level)
+	{
+		float gap = WATER_PLANE_VERTEX_GAP * (1 << level);
+		const glm::ivec2& origin = MClipmapOrigins[level];
+		glm::ivec2 hole(0, 0);
+		if (level > 0)
+			hole = glm::ivec2(MClipmapOrigins[level - 1].x / 2 - origin.x, MClipmapOrigins[level - 1].y / 2 - origin.y);
+		for (int tile = 0; tile < WATER_CLIPMAP_TILES * WATER_CLIPMAP_TILES; ++tile)
+		{
+			glm::ivec2 cell((tile % WATER_CLIPMAP_TILES) * tileSize, (tile / WATER_CLIPMAP_TILES) * tileSize);
+			if (level > 0 && cell.x >= hole.x && cell.y >= hole.y &&
+				cell.x + tileSize <= hole.x + WATER_CLIPMAP_RESOLUTION / 2 && cell.y + tileSize <= hole.y + WATER_CLIPMAP_RESOLUTION / 2)
+				continue;
+
+			// morphing moves odd vertices by up to one gap towards lower indices
+			// and the waves by up to MWaveDisplacement to any side
+			glm::vec3 minimum((origin.x + cell.x - 1) * gap - MWaveDisplacement, -MWaveHeight, (origin.y + cell.y - 1) * gap - MWaveDisplacement);
+			glm::vec3 maximum((origin.x + cell.x + tileSize) * gap + MWaveDisplacement, MWaveHeight, (origin.y + cell.y + tileSize) * gap + MWaveDisplacement);
+			if (!frustum.IsBoxVisible(minimum, maximum))
+			{
+				++MCulledTiles;
+				continue;
+			}
+
+			GLint first = (level * WATER_CLIPMAP_TILES * WATER_CLIPMAP_TILES + tile) * tileVertices;
+			if (!MTileFirsts.empty() && MTileFirsts.back() + MTileCounts.back() == first)
+				MTileCounts.back() += tileVertices;
+			else
+			{
+				MTileFirsts.push_back(first);
+				MTileCounts.push_back(tileVertices);
+			}
+			MSubmittedVertices += tileVertices;
+		}
+	}
+}
+
+int CWaterPlaneSceneNode::GetCulledTiles() const
+{
+	return MCulledTiles;
+}
+
+size_t CWaterPlaneSceneNode::GetSubmittedVertices() const
+{
+	return MSubmittedVertices;
 }
 
-void CWaterPlaneSceneNode::Draw()
+void CWaterPlaneSceneNode::InitializeOcean()
 {
-	if (!IsOn)
+	MOcean.Initialize(OCEAN_RESOLUTION, OCEAN_PATCH_SIZE, OCEAN_WIND, OCEAN_AMPLITUDE, OCEAN_CHOPPINESS, OCEAN_SEED,
+		CFourierTransform::GetBestKernel());
+	std::cout << "Ocean " << OCEAN_RESOLUTION << "x" << OCEAN_RESOLUTION << " simulated with "
+		<< CFourierTransform::GetKernelName(MOcean.GetTransform().GetKernel()) << " FFT" << std::endl;
+
+	// calm water until the first step is streamed
+	const std::vector<float>& displacement = MOcean.GetDisplacement();
+	glGenTextures(1, &MOceanTexture);
+	glBindTexture(GL_TEXTURE_2D, MOceanTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, OCEAN_RESOLUTION, OCEAN_RESOLUTION, 0, GL_RGBA, GL_FLOAT, displacement.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenBuffers(2, MOceanBuffers);
+	for (GLuint buffer : MOceanBuffers)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, displacement.size() * sizeof(float), nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	float time = MTime;
+	MOceanJob = gameState.MThreadPool.Enqueue([this, time] { MOcean.Simulate(time, &gameState.MThreadPool); });
+}
+
+void CWaterPlaneSceneNode::UpdateOcean(CRenderState& state)
+{
+	// the buffer filled in the previous frame is copied while the GPU has had a frame to receive it
+	if (MOceanUploadPending)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, MOceanBuffers[MOceanBuffer]);
+		state.BindTexture(0, GL_TEXTURE_2D, MOceanTexture);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, OCEAN_RESOLUTION, OCEAN_RESOLUTION, GL_RGBA, GL_FLOAT, 0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		CGLCallCounter::Add(3);
+		MOceanBuffer = 1 - MOceanBuffer;
+		MOceanUploadPending = false;
+	}
+
+	if (!MOceanJob.valid() || MOceanJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
 		return;
-	MShaderProgram.UseProgram();
-	MShaderProgram.SetFloat("time", MTime);
-	MShaderProgram.SetMat4("model", GetModelMatrix());
-	MShaderProgram.SetMat4("view", gameState.GetViewMatrix());
-	MShaderProgram.SetMat4("projection", gameState.GetProjectionMatrix());
-
-	MShaderProgram.SetVec4("dirLight.vector", gameState.dirLight.MVector);
-	MShaderProgram.SetVec3("dirLight.ambient", gameState.dirLight.MAmbient);
-	MShaderProgram.SetVec3("dirLight.diffuse", gameState.dirLight.MDiffuse);
-	MShaderProgram.SetVec3("dirLight.specular", gameState.dirLight.MSpecular);
-
-	MShaderProgram.SetVec3("cameraDir", gameState.MCamera.MDirection);
-	MShaderProgram.SetFloat("cutOff", CAMERA_LIGHT_CUTOFF);
-	MShaderProgram.SetFloat("outerCutOff", CAMERA_LIGHT_OUTERCUTOFF);
-
-	MMesh.Draw(MShaderProgram);
-	for (const auto& node : MSceneNodes)
-		node->Draw();
+	MOceanJob.get();
+
+	// orphaning the other buffer avoids waiting for the GPU's copy of its previous step
+	const std::vector<float>& displacement = MOcean.GetDisplacement();
+	GLsizeiptr size = displacement.size() * sizeof(float);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, MOceanBuffers[MOceanBuffer]);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	void* data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (data != nullptr)
+	{
+		std::memcpy(data, displacement.data(), size);
+		MOceanUploadPending = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+		CGLCallCounter::Add();
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	CGLCallCounter::Add(4);
+	MWaveHeight = std::max(MWaveHeight, MOcean.GetMaxHeight());
+	MWaveDisplacement = std::max(MWaveDisplacement, MOcean.GetMaxDisplacement());
+
+	// the step owns the simulation's grids until its future is ready
+	float time = MTime;
+	MOceanJob = gameState.MThreadPool.Enqueue([this, time] { MOcean.Simulate(time, &gameState.MThreadPool); });
+}
+
+void CWaterPlaneSceneNode::Destroy()
+{
+	if (MOceanJob.valid())
+		MOceanJob.wait();
+	if (MOceanTexture != 0)
+	{
+		glDeleteTextures(1, &MOceanTexture);
+		glDeleteBuffers(2, MOceanBuffers);
+		MOceanTexture = 0;
+	}
+	MTimer.Destroy();
+	CSceneNode::Destroy();
+}
+
+bool CWaterPlaneSceneNode::SwitchFlatShading()
+{
+	MFlatShading = !MFlatShading;
+	MTimer.Reset();
+	return MFlatShading;
+}
+
+void CWaterPlaneSceneNode::DrawMesh(CRenderState& state)
+{
+	glm::mat4 model = GetModelMatrix();
+	glm::mat4 view = gameState.GetViewMatrix();
+	glm::mat4 projection = gameState.GetProjectionMatrix();
+	if (MOceanTexture != 0)
+		UpdateOcean(state);
+	state.UseProgram(MShaderProgram);
+	const CShaderUniforms& uniforms = MShaderProgram.GetUniforms();
+	MShaderProgram.SetFloat(uniforms.MTime, MTime);
+	MShaderProgram.SetBool(uniforms.MOceanEnabled, MOceanTexture != 0);
+	if (MOceanTexture != 0)
+	{
+		state.BindTexture(0, GL_TEXTURE_2D, MOceanTexture);
+		MShaderProgram.SetInt(uniforms.MOceanDisplacement, 0);
+		MShaderProgram.SetFloat(uniforms.MOceanPatchSize, OCEAN_PATCH_SIZE);
+	}
+	MShaderProgram.SetFloat(uniforms.MGridGap, WATER_PLANE_VERTEX_GAP);
+	MShaderProgram.SetInt(uniforms.MClipmapLevels, MClipmapLevels);
+	if (MClipmapLevels > 0)
+	{
+		glm::vec4 camera = glm::inverse(model) * glm::vec4(gameState.MCamera.MEye, 1.0f);
+		UpdateClipmap(glm::vec2(camera.x, camera.z));
+		CullClipmap(projection * view * model);
+		MShaderProgram.SetVec2(uniforms.MCameraPosition, glm::vec2(camera.x, camera.z));
+		MShaderProgram.SetInt(uniforms.MClipmapResolution, WATER_CLIPMAP_RESOLUTION);
+		MShaderProgram.SetInt(uniforms.MClipmapTiles, WATER_CLIPMAP_TILES);
+		MShaderProgram.SetIVec2Array(uniforms.MClipmapOrigins, MClipmapOrigins.data(), MClipmapLevels);
+	}
+	else
+	{
+		MCulledTiles = 0;
+		MSubmittedVertices = (size_t)2 * WATER_PLANE_SIDE_SIZE * (WATER_PLANE_SIDE_SIZE - 1);
+	}
+	// view, projection, lights and spotlight come from the per-frame uniform buffer
+	MShaderProgram.SetMat4(uniforms.MModel, model);
+	MShaderProgram.SetMat3(uniforms.MNormalMatrix, glm::transpose(glm::inverse(glm::mat3(view * model))));
+	MShaderProgram.SetBool(uniforms.MFlatShading, MFlatShading);
+
+	MTimer.Begin();
+	if (MClipmapLevels > 0)
+		MMesh.DrawRanges(MShaderProgram, state, MTileFirsts, MTileCounts);
+	else
+		MMesh.Draw(MShaderProgram, state);
+	MTimer.End();
+	if (MTimer.GetSamples() >= WATER_TIMER_FRAMES)
+	{
+		std::cout << "Water (" << (MFlatShading ? "flat" : "smooth") << "): " << MTimer.GetAverage()
+			<< " ms GPU per frame over " << MTimer.GetSamples() << " frames, "
+			<< MCulledTiles << " of " << MClipmapLevels * WATER_CLIPMAP_TILES * WATER_CLIPMAP_TILES << " tiles culled, "
+			<< MSubmittedVertices << " vertices submitted" << std::endl;
+		MTimer.Reset();
+	}
 }
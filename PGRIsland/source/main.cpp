@@ -2,8 +2,26 @@
 //
 
 #include "../include/CApplication.h"
+#include "../include/CBenchmark.h"
+#include "../include/CTextureCooker.h"
+
+#include <algorithm>
+#include <cstdlib>
 
 int main(int argc, char* argv[]) {
+	if (argc > 1 && argv[1] == BENCHMARK_SWITCH)
+		return CBenchmark().Run(argc - 2, argv + 2);
+	if (argc > 1 && argv[1] == COOK_TEXTURES_SWITCH)
+		return CTextureCooker().Run(argc - 2, argv + 2);
+	int first = 1;
+	if (argc > 2 && argv[1] == FISH_SCHOOL_SWITCH)
+	{
+		gameState.MFishSchoolSize = std::max(0, std::atoi(argv[2]));
+		first = 3;
+	}
+	// the headless mode gets the switch as its first argument, GLUT takes it for the program name
+	if (argc > first && argv[first] == HEADLESS_SWITCH)
+		return CApplication().HeadlessInit(argc - first, argv + first);
 	return CApplication().WindowInit(argc, argv);
 }
 